@@ -81,6 +81,50 @@ project "slvn-tech"
 		defines {"NDEBUG"}
 		optimize "On"
 		
+project "slvn-tech-benchmark"
+	targetname "slvn-tech-benchmark"
+	kind "ConsoleApp"
+	language "C++"
+	flags { "MultiProcessorCompile" }
+	files { "./slvn-tech/src/benchmark/*.cpp",
+			"./slvn-tech/include/benchmark/*.h",
+			"./slvn-tech/include/*.h",
+			"./slvn-tech/include/*.inl",
+			"./slvn-tech/include/abstract/*.h",
+			"./slvn-tech/src/*.cc"}
+
+	defines { "VK_USE_PLATFORM_WIN32_KHR", "SLVN_BENCHMARK" }
+	links { "vulkan-1.lib", "glfw3.lib" }
+	configuration "x64"
+		libdirs {}
+		
+	configuration "x86"
+		libdirs {}
+		
+	configuration "not macosx"
+		includedirs {	"./slvn-tech/include",
+						"$(VULKAN_SDK)/include",
+						"./slvn-tech/VULKAN_SDK/include",
+						"./slvn-tech/dependencies/glfw/include",
+						"./slvn-tech/dependencies/glm/",
+						"./slvn-tech/dependencies/OBJ-Loader/include",
+						"./VULKAN_SDK/include"}
+		libdirs { 	"$(VULKAN_SDK)/lib",
+					"./slvn-tech/VULKAN_SDK/lib",
+					"./VULKAN_SDK/lib",
+					"./src/Debug",
+					"../slvn-tech-local-dependencies/glfw/precompiled/"}
+		cppdialect "C++17"
+	configuration "macosx"
+
+	configuration "Debug"
+		defines {"DEBUG"}
+		symbols "On"	
+
+	configuration "Release"
+		defines {"NDEBUG"}
+		optimize "On"
+		
 project "slvn-tech-unittest"
 	targetname "slvn-tech-unittest"
 	kind "ConsoleApp"
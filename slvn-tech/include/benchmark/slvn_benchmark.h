@@ -0,0 +1,104 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNBENCHMARK_H
+#define SLVNBENCHMARK_H
+
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+
+namespace slvn_tech
+{
+
+class SlvnBenchmarkTimer
+{
+public:
+    inline SlvnBenchmarkTimer() : mStart(std::chrono::high_resolution_clock::now()) {}
+
+    inline void Reset() { mStart = std::chrono::high_resolution_clock::now(); }
+    inline double ElapsedMs() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - mStart).count();
+    }
+
+private:
+    std::chrono::high_resolution_clock::time_point mStart;
+};
+
+inline void SlvnBenchmarkReport(const std::string& name, const std::string& variant, double value, const std::string& unit)
+{
+    std::cout << std::left << std::setw(32) << name << std::setw(28) << variant
+              << std::right << std::setw(14) << std::fixed << std::setprecision(3) << value << " " << unit << std::endl;
+}
+
+// Unit UV sphere with 2 * rings * segments triangles.
+inline void SlvnBenchmarkMakeSphere(uint32_t rings, uint32_t segments, std::vector<glm::vec3>& positions, std::vector<uint32_t>& indices)
+{
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        float phi = glm::pi<float>() * static_cast<float>(r) / static_cast<float>(rings);
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            float theta = 2.0f * glm::pi<float>() * static_cast<float>(s) / static_cast<float>(segments);
+            positions.push_back(glm::vec3(sin(phi) * cos(theta), cos(phi), sin(phi) * sin(theta)));
+        }
+    }
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t a = r * (segments + 1) + s;
+            uint32_t b = a + segments + 1;
+            indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+        }
+    }
+}
+
+// Benchmark entry points, one per benchmarked subsystem.
+void SlvnBvhBenchmark();
+void SlvnOcclusionBenchmark();
+void SlvnLodBenchmark();
+void SlvnSimplifierBenchmark();
+void SlvnDrawSortBenchmark();
+void SlvnMemoryBenchmark();
+void SlvnGeometryPlacementBenchmark();
+void SlvnFrameRingBenchmark();
+void SlvnVertexFetchBenchmark();
+void SlvnObjParserBenchmark();
+void SlvnVertexWeldBenchmark();
+void SlvnMeshCacheBenchmark();
+void SlvnMeshOptimizerBenchmark();
+void SlvnMeshletBenchmark();
+
+} // slvn_tech
+
+#endif // SLVNBENCHMARK_H
@@ -47,6 +47,7 @@ enum class SlvnResult
     cUnexpectedError,
     cPresentationNotSupportedForThisQueueFamily,
     cInvalidPath,
+    cOutOfMemory,
 };
 
 enum class SlvnState
@@ -75,6 +76,19 @@ struct SlvnThreadPushConstant
     glm::vec3 color;
 };
 
+// Push constants of the vertex pulling pipeline; vertexAddress points at the first vertex of the mesh.
+// positionOffset and positionScale decode quantized positions, w is unused. The members are ordered
+// so that the C++ and std430 offsets agree and the block fits the guaranteed 128 bytes.
+struct SlvnPullPushConstant
+{
+    glm::mat4 mvp;
+    glm::vec4 positionOffset;
+    glm::vec4 positionScale;
+    glm::vec3 color;
+    uint32_t vertexFormat;
+    uint64_t vertexAddress;
+};
+
 struct SlvnMovementKeys
 {
     bool left;
@@ -94,6 +108,8 @@ struct ObjectData
     float deltaT;
     float stateT = 0;
     bool visible = false;
+    uint32_t proxy = UINT32_MAX;
+    uint32_t lod = 0;
 };
 
 struct SlvnMatrices
@@ -132,6 +148,12 @@ struct SlvnVertex
         //mTextureCoordinate.x = vertex.TextureCoordinate.X;
         //mTextureCoordinate.y = vertex.TextureCoordinate.Y;
     }
+    SlvnVertex() : mPosition(0.0f), mNormal(0.0f), mColor(1.0f, 0.0f, 0.0f)
+    {
+    }
+    SlvnVertex(const glm::vec3& position, const glm::vec3& normal) : mPosition(position), mNormal(normal), mColor(1.0f, 0.0f, 0.0f)
+    {
+    }
     glm::vec3 mPosition;
     glm::vec3 mNormal;
     glm::vec3 mColor;
@@ -0,0 +1,147 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNASSETMANAGER_H
+#define SLVNASSETMANAGER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+
+#include <core.h>
+#include <slvn_asset_pipeline.h>
+#include <slvn_geometry_pool.h>
+
+namespace slvn_tech
+{
+
+// Runs on the render thread once the shared asset is ready or has failed; the asset belongs to the manager.
+using SlvnSharedAssetCallback = std::function<void(SlvnAssetHandle, SlvnResult, const SlvnMeshAsset&)>;
+
+struct SlvnAssetCacheStats
+{
+    uint32_t mAssetCount;
+    uint32_t mReferencedCount;
+    uint32_t mCachedCount;
+    uint32_t mLoadingCount;
+    // CPU and pool bytes of ready assets, cached ones are the unreferenced part.
+    uint64_t mResidentBytes;
+    uint64_t mCachedBytes;
+    uint64_t mBudgetBytes;
+
+    // A hit found the asset ready, a join found it still loading, a miss started a load.
+    uint64_t mRequestCount;
+    uint64_t mHitCount;
+    uint64_t mJoinCount;
+    uint64_t mMissCount;
+    uint64_t mEvictionCount;
+};
+
+// @brief
+// SlvnAssetManager shares assets between everyone requesting the same file. Assets are keyed by the
+// hash of their normalized path, Acquire() of a key that is already loading joins that load and one
+// that is ready is handed out again without touching the disk or the geometry pool. Handles are
+// reference counted; an asset whose last reference is released stays cached, pool mesh and CPU data,
+// until the cached bytes exceed the budget or the geometry pool runs short, then the least recently
+// released assets are evicted first. A decode hook belongs to the asset, later requests share what
+// the first one decoded. Render thread only, BeginFrame() follows SlvnAssetPipeline::BeginFrame().
+class SlvnAssetManager
+{
+public:
+    SlvnAssetManager();
+    ~SlvnAssetManager();
+
+    SlvnResult Initialize(SlvnAssetPipeline* pipeline, SlvnGeometryPool* pool, uint64_t cacheBudgetBytes);
+    // Drops every asset, their pool meshes are freed by SlvnAssetPipeline::Deinitialize().
+    SlvnResult Deinitialize();
+
+    static uint64_t MakeKey(const std::string& path);
+
+    // Adds a reference; the callback also runs for an asset that is ready already, from the next BeginFrame().
+    SlvnAssetHandle Acquire(const std::string& path, SlvnSharedAssetCallback callback = nullptr, SlvnAssetDecodeHook hook = nullptr);
+    void AddReference(SlvnAssetHandle handle);
+    // The asset is cached once the last reference is gone, frame lastUse is the last one drawing it.
+    void Release(SlvnAssetHandle handle, uint64_t lastUse);
+    void BeginFrame();
+
+    bool IsReady(SlvnAssetHandle handle) const;
+    inline std::shared_future<SlvnResult> GetFuture(SlvnAssetHandle handle) const { return mPipeline->GetFuture(mAssets[handle].mLoad); }
+    inline uint32_t GetMesh(SlvnAssetHandle handle) const { return mPipeline->GetMesh(mAssets[handle].mLoad); }
+    // CPU side data of a ready asset, without the upload data.
+    inline const SlvnMeshAsset& GetAsset(SlvnAssetHandle handle) const { return mAssets[handle].mAsset; }
+    inline uint32_t GetReferenceCount(SlvnAssetHandle handle) const { return mAssets[handle].mReferenceCount; }
+
+    SlvnAssetCacheStats GetStats() const;
+
+public:
+    uint64_t mCacheBudgetBytes;
+    // Pool usage, relative to its capacity, past which one cached asset is evicted per frame. The
+    // ranges only come back once the deletion queue retires them, so it does not evict in a loop.
+    float mPoolPressure;
+
+private:
+    struct Entry
+    {
+        uint64_t mKey;
+        std::string mPath;
+        SlvnAssetDecodeHook mHook;
+        // Pipeline load of the asset, cInvalidHandle while evicted.
+        SlvnAssetHandle mLoad;
+        uint32_t mReferenceCount;
+        uint64_t mLastUse;
+        uint64_t mBytes;
+        SlvnMeshAsset mAsset;
+        std::vector<SlvnSharedAssetCallback> mCallbacks;
+    };
+
+    void load(SlvnAssetHandle handle);
+    void onLoaded(SlvnAssetHandle handle, SlvnResult result, SlvnMeshAsset& asset);
+    bool evictLeastRecentlyUsed();
+    bool isUnderPoolPressure() const;
+
+private:
+    SlvnAssetPipeline* mPipeline;
+    SlvnGeometryPool* mPool;
+
+    std::deque<Entry> mAssets;
+    std::unordered_map<uint64_t, SlvnAssetHandle> mKeys;
+    // Callbacks of requests that found their asset ready, run from BeginFrame().
+    std::vector<std::pair<SlvnAssetHandle, SlvnSharedAssetCallback>> mReadyCallbacks;
+
+    uint64_t mResidentBytes;
+    uint64_t mCachedBytes;
+    uint64_t mRequestCount;
+    uint64_t mHitCount;
+    uint64_t mJoinCount;
+    uint64_t mMissCount;
+    uint64_t mEvictionCount;
+};
+
+} // slvn_tech
+
+#endif // SLVNASSETMANAGER_H
@@ -0,0 +1,231 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNASSETPIPELINE_H
+#define SLVNASSETPIPELINE_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <functional>
+
+#include <core.h>
+#include <slvn_bounds.h>
+#include <slvn_lod.h>
+#include <slvn_meshlet.h>
+#include <slvn_mapped_file.h>
+#include <slvn_geometry_pool.h>
+#include <slvn_upload_manager.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_mesh_streamer.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+using SlvnAssetHandle = uint32_t;
+
+enum class SlvnAssetState
+{
+    cReading = 0,
+    cDecoding,
+    cUploading,
+    cReady,
+    cFailed
+};
+
+// Cooked mesh as it comes out of the decode stage. mUpload is what goes into the geometry pool,
+// it is encoded from mVertices and mIndices unless a decode hook already filled it.
+struct SlvnMeshAsset
+{
+    std::vector<SlvnVertex> mVertices;
+    std::vector<uint32_t> mIndices;
+    SlvnLodMesh mLods;
+    std::vector<SlvnMeshlet> mMeshlets;
+    SlvnAabb mBounds;
+    SlvnStreamedMeshData mUpload;
+};
+
+// Runs on a decode thread after the mesh has been loaded.
+using SlvnAssetDecodeHook = std::function<SlvnResult(SlvnMeshAsset&)>;
+// Runs on the render thread once the asset is ready or has failed. The CPU side data of the asset is
+// released when the callback returns, whatever has to stay is moved out of it.
+using SlvnAssetCallback = std::function<void(SlvnAssetHandle, SlvnResult, SlvnMeshAsset&)>;
+
+struct SlvnAssetStageStats
+{
+    // Requests waiting for or being processed by the stage.
+    uint32_t mDepth;
+    uint64_t mProcessedCount;
+    // Latency is from entering the stage to leaving it, work only counts the time spent processing.
+    float mAverageLatencyMs;
+    float mMaxLatencyMs;
+    float mAverageWorkMs;
+};
+
+struct SlvnAssetStats
+{
+    SlvnAssetStageStats mIo;
+    SlvnAssetStageStats mDecode;
+    // Work is the copy into staging memory, latency ends when the batch has completed on the GPU.
+    SlvnAssetStageStats mUpload;
+
+    uint64_t mRequestCount;
+    uint64_t mReadyCount;
+    uint64_t mFailedCount;
+    uint64_t mReadBytes;
+    // Last frame.
+    uint32_t mUploadedCount;
+    uint64_t mUploadedBytes;
+    // From the request to the asset being usable.
+    float mAverageLatencyMs;
+    float mMaxLatencyMs;
+
+    inline uint32_t GetPendingCount() const { return mIo.mDepth + mDecode.mDepth + mUpload.mDepth; }
+};
+
+// @brief
+// SlvnAssetPipeline loads meshes in the background while frames keep being rendered. A request
+// goes through three stages: a dedicated I/O thread maps the source file and its cache and reads
+// them in, decode jobs cook the mesh on a threadpool of their own and BeginFrame() on the render
+// thread copies as many decoded meshes into the geometry pool as the upload budget allows and
+// submits them as one batch. Once a batch has completed its assets are ready; their callbacks run
+// and their futures are set from BeginFrame(). Decoding uses its own threads rather than the frame
+// threadpool, whose per-frame Wait() would otherwise stall behind a long cook.
+// Load(), BeginFrame(), Release() and the accessors are called from the render thread, the futures
+// can be waited on anywhere.
+class SlvnAssetPipeline
+{
+public:
+    static constexpr SlvnAssetHandle cInvalidHandle = UINT32_MAX;
+
+    SlvnAssetPipeline();
+    ~SlvnAssetPipeline();
+
+    SlvnResult Initialize(SlvnGeometryPool* pool, SlvnUploadManager* uploader, SlvnDeletionQueue* deletionQueue,
+        SlvnVertexFormat format, uint32_t decodeThreads, uint64_t uploadBudgetBytes);
+    // Waits for the worker stages and releases every ready mesh after frame lastUse.
+    SlvnResult Deinitialize(uint64_t lastUse);
+
+    SlvnAssetHandle Load(const std::string& path, SlvnAssetCallback callback = nullptr, SlvnAssetDecodeHook hook = nullptr);
+    // Has to follow SlvnUploadManager::RecordAcquire() of the frame, frame is the number it will be submitted as.
+    void BeginFrame(uint64_t frame);
+    // Frees the pool mesh of a ready asset once frame lastUse has completed.
+    void Release(SlvnAssetHandle handle, uint64_t lastUse);
+
+    inline SlvnAssetState GetState(SlvnAssetHandle handle) const { return mAssets[handle].mState; }
+    inline bool IsReady(SlvnAssetHandle handle) const { return GetState(handle) == SlvnAssetState::cReady; }
+    inline std::shared_future<SlvnResult> GetFuture(SlvnAssetHandle handle) const { return mAssets[handle].mFuture; }
+    // Pool mesh of a ready asset, cInvalidMesh otherwise.
+    inline uint32_t GetMesh(SlvnAssetHandle handle) const { return mAssets[handle].mPoolMesh; }
+
+    SlvnAssetStats GetStats() const;
+
+public:
+    uint64_t mUploadBudgetBytes;
+
+private:
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct Entry
+    {
+        SlvnAssetHandle mHandle;
+        std::string mPath;
+        SlvnAssetCallback mCallback;
+        SlvnAssetDecodeHook mHook;
+        std::atomic<SlvnAssetState> mState;
+        SlvnResult mResult;
+        std::promise<SlvnResult> mPromise;
+        std::shared_future<SlvnResult> mFuture;
+
+        SlvnMappedFile mSource;
+        SlvnMeshAsset mAsset;
+        uint32_t mPoolMesh;
+        uint64_t mBatch;
+        uint64_t mReadBytes;
+
+        Clock::time_point mRequestTime;
+        Clock::time_point mReadTime;
+        Clock::time_point mDecodeTime;
+        float mIoMs;
+        float mDecodeMs;
+        float mPlaceMs;
+    };
+
+    struct StageTotals
+    {
+        uint64_t mCount;
+        double mLatencyMs;
+        double mWorkMs;
+        float mMaxLatencyMs;
+
+        void Add(float latencyMs, float workMs);
+        void Fill(SlvnAssetStageStats& stats) const;
+    };
+
+    void read(Entry& entry);
+    void decode(Entry& entry);
+    void place(Entry& entry);
+    void complete(SlvnAssetHandle handle);
+
+private:
+    SlvnGeometryPool* mPool;
+    SlvnUploadManager* mUploader;
+    SlvnDeletionQueue* mDeletionQueue;
+    SlvnVertexFormat mFormat;
+
+    // Entries never move, workers hold on to them while the render thread appends.
+    std::deque<Entry> mAssets;
+    uint64_t mFrame;
+
+    std::mutex mMutex;
+    std::deque<Entry*> mDecodeQueue;
+    std::deque<Entry*> mDecoded;
+    std::atomic<uint32_t> mNextDecodeThread;
+    // Placed assets waiting for their batch, render thread only.
+    std::vector<SlvnAssetHandle> mUploading;
+
+    StageTotals mIoTotals;
+    StageTotals mDecodeTotals;
+    StageTotals mUploadTotals;
+    StageTotals mTotals;
+    uint64_t mReadyCount;
+    uint64_t mFailedCount;
+    uint64_t mReadBytes;
+    uint32_t mUploadedCount;
+    uint64_t mUploadedBytes;
+
+    SlvnThread mIoThread;
+    SlvnThreadpool mDecodeThreads;
+};
+
+} // slvn_tech
+
+#endif // SLVNASSETPIPELINE_H
@@ -0,0 +1,192 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNBOUNDS_H
+#define SLVNBOUNDS_H
+
+#include <cfloat>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+namespace slvn_tech
+{
+
+struct SlvnAabb
+{
+    glm::vec3 mMin = glm::vec3(FLT_MAX);
+    glm::vec3 mMax = glm::vec3(-FLT_MAX);
+
+    inline bool IsEmpty() const { return mMin.x > mMax.x || mMin.y > mMax.y || mMin.z > mMax.z; }
+    inline glm::vec3 GetCenter() const { return (mMin + mMax) * 0.5f; }
+    inline glm::vec3 GetExtent() const { return (mMax - mMin) * 0.5f; }
+
+    inline void Grow(const glm::vec3& point)
+    {
+        mMin = glm::min(mMin, point);
+        mMax = glm::max(mMax, point);
+    }
+    inline void Grow(const SlvnAabb& other)
+    {
+        mMin = glm::min(mMin, other.mMin);
+        mMax = glm::max(mMax, other.mMax);
+    }
+    inline float GetSurfaceArea() const
+    {
+        if (IsEmpty())
+            return 0.0f;
+        glm::vec3 d = mMax - mMin;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+    inline bool Contains(const SlvnAabb& other) const
+    {
+        return glm::all(glm::lessThanEqual(mMin, other.mMin)) && glm::all(glm::greaterThanEqual(mMax, other.mMax));
+    }
+};
+
+struct SlvnSphere
+{
+    glm::vec3 mCenter;
+    float mRadius;
+};
+
+struct SlvnRay
+{
+    SlvnRay(glm::vec3 origin, glm::vec3 direction) : mOrigin(origin), mDirection(direction)
+    {
+        mInvDirection = 1.0f / direction;
+    }
+    glm::vec3 mOrigin;
+    glm::vec3 mDirection;
+    glm::vec3 mInvDirection;
+};
+
+// @brief
+// Six clip planes in the form dot(n, p) + d >= 0 for points inside.
+// Order is left, right, bottom, top, near, far.
+struct SlvnFrustum
+{
+    static constexpr uint32_t cPlaneCount = 6;
+    static constexpr uint32_t cAllPlanesMask = (1 << cPlaneCount) - 1;
+
+    glm::vec4 mPlanes[cPlaneCount];
+
+    // Gribb-Hartmann extraction, assumes a 0..1 clip space depth range (GLM_FORCE_DEPTH_ZERO_TO_ONE).
+    inline static SlvnFrustum FromMatrix(const glm::mat4& viewProjection)
+    {
+        glm::mat4 m = glm::transpose(viewProjection);
+        SlvnFrustum frustum;
+        frustum.mPlanes[0] = m[3] + m[0];
+        frustum.mPlanes[1] = m[3] - m[0];
+        frustum.mPlanes[2] = m[3] + m[1];
+        frustum.mPlanes[3] = m[3] - m[1];
+        frustum.mPlanes[4] = m[2];
+        frustum.mPlanes[5] = m[3] - m[2];
+        for (auto& plane : frustum.mPlanes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+};
+
+enum class SlvnContainment
+{
+    cOutside = 0,
+    cIntersecting,
+    cInside
+};
+
+inline bool SlvnOverlaps(const SlvnAabb& a, const SlvnAabb& b)
+{
+    return a.mMin.x <= b.mMax.x && a.mMax.x >= b.mMin.x &&
+           a.mMin.y <= b.mMax.y && a.mMax.y >= b.mMin.y &&
+           a.mMin.z <= b.mMax.z && a.mMax.z >= b.mMin.z;
+}
+
+inline bool SlvnOverlaps(const SlvnAabb& box, const SlvnSphere& sphere)
+{
+    glm::vec3 closest = glm::clamp(sphere.mCenter, box.mMin, box.mMax);
+    glm::vec3 d = closest - sphere.mCenter;
+    return glm::dot(d, d) <= sphere.mRadius * sphere.mRadius;
+}
+
+// Slab test; on hit tNear holds the entry distance along the ray.
+inline bool SlvnIntersect(const SlvnAabb& box, const SlvnRay& ray, float maxDistance, float& tNear)
+{
+    if (box.IsEmpty())
+        return false;
+    glm::vec3 t0 = (box.mMin - ray.mOrigin) * ray.mInvDirection;
+    glm::vec3 t1 = (box.mMax - ray.mOrigin) * ray.mInvDirection;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+    tNear = enter;
+    return enter <= exit;
+}
+
+// Tests the box only against the planes still set in planeMask. Planes the box
+// lies completely inside of are cleared from the mask so that children of a
+// hierarchy do not need to test them again.
+inline SlvnContainment SlvnClassify(const SlvnAabb& box, const SlvnFrustum& frustum, uint32_t& planeMask)
+{
+    glm::vec3 center = box.GetCenter();
+    glm::vec3 extent = box.GetExtent();
+    for (uint32_t i = 0; i < SlvnFrustum::cPlaneCount; i++)
+    {
+        uint32_t bit = 1u << i;
+        if ((planeMask & bit) == 0)
+            continue;
+
+        const glm::vec4& plane = frustum.mPlanes[i];
+        float r = glm::dot(extent, glm::abs(glm::vec3(plane)));
+        float s = glm::dot(glm::vec3(plane), center) + plane.w;
+        if (s + r < 0.0f)
+            return SlvnContainment::cOutside;
+        if (s - r >= 0.0f)
+            planeMask &= ~bit;
+    }
+    return planeMask == 0 ? SlvnContainment::cInside : SlvnContainment::cIntersecting;
+}
+
+inline SlvnAabb SlvnTransformAabb(const SlvnAabb& box, const glm::mat4& transform)
+{
+    // Arvo; transform the center and accumulate the absolute extents per axis.
+    glm::vec3 center = glm::vec3(transform * glm::vec4(box.GetCenter(), 1.0f));
+    glm::vec3 extent = box.GetExtent();
+    glm::vec3 worldExtent = glm::abs(glm::vec3(transform[0])) * extent.x +
+                            glm::abs(glm::vec3(transform[1])) * extent.y +
+                            glm::abs(glm::vec3(transform[2])) * extent.z;
+    SlvnAabb result;
+    result.mMin = center - worldExtent;
+    result.mMax = center + worldExtent;
+    return result;
+}
+
+} // slvn_tech
+
+#endif // SLVNBOUNDS_H
\ No newline at end of file
@@ -32,6 +32,9 @@
 #include <vulkan/vulkan.h>
 
 #include <core.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_upload_manager.h>
+#include <slvn_deletion_queue.h>
 
 namespace slvn_tech
 {
@@ -44,19 +47,31 @@ public:
     ~SlvnBuffer();
 
     SlvnResult Deinitialize(VkDevice* device);
+    // Hands the buffer and its memory to the deletion queue instead of destroying them right away.
+    SlvnResult Release(SlvnDeletionQueue* deletionQueue, uint64_t lastUse);
 
-    SlvnResult Insert(VkDevice* device, VkPhysicalDevice* physDev, uint32_t size, const void* data);
+    // Binds memory without writing to it, for buffers that are filled piece by piece later on.
+    SlvnResult Allocate(SlvnMemoryAllocator* allocator, SlvnMemoryUsage usage, SlvnMemoryCategory category = SlvnMemoryCategory::cOther);
+    SlvnResult Insert(SlvnMemoryAllocator* allocator, uint32_t size, const void* data,
+        SlvnMemoryCategory category = SlvnMemoryCategory::cOther);
+    // Places the buffer in device local memory and queues the data on uploader; needs TRANSFER_DST usage.
+    SlvnResult Upload(SlvnMemoryAllocator* allocator, SlvnUploadManager* uploader, uint32_t size, const void* data,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, SlvnMemoryCategory category = SlvnMemoryCategory::cOther);
+    // Moves the contents to a new buffer in another memory block with a copy recorded into cmd;
+    // the old buffer is released with lastUse. Needs TRANSFER_SRC and TRANSFER_DST usage.
+    SlvnResult Relocate(VkDevice device, VkCommandBuffer cmd, SlvnDeletionQueue* deletionQueue, uint64_t lastUse);
+    bool IsRelocatable() const;
+    const SlvnAllocation& GetAllocation() const { return mAllocation; }
     VkBuffer GetBuffer() const { return mBuffer; }
     uint32_t GetBufferSize() const { return mBufferByteSize; }
 
-private:
-    std::optional<VkDeviceSize> getAllocationSize(VkDevice* device) const;
-    std::optional<uint32_t> getMemoryTypeIndex(VkDevice* device, VkPhysicalDevice* physDev, uint32_t wantedFlags) const;
-
 private:
     VkBuffer mBuffer;
-    VkDeviceMemory mMemory;
+    SlvnMemoryAllocator* mAllocator;
+    SlvnAllocation mAllocation;
     uint32_t mBufferByteSize;
+    VkBufferUsageFlags mUsage;
+    VkSharingMode mSharingMode;
 };
 
 } // slvn_tech
@@ -0,0 +1,167 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNBVH_H
+#define SLVNBVH_H
+
+#include <vector>
+#include <atomic>
+#include <optional>
+
+#include <core.h>
+#include <slvn_bounds.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+struct SlvnBvhNode
+{
+    SlvnAabb mBounds;
+    // Leaf: index of the first proxy in the leaf proxy list. Inner: index of the left child,
+    // right child is always stored right after it.
+    uint32_t mLeftOrFirst;
+    uint32_t mCount;
+
+    inline bool IsLeaf() const { return mCount > 0; }
+};
+
+struct SlvnBvhRayHit
+{
+    uint32_t mProxy;
+    float mDistance;
+};
+
+struct SlvnBvhStats
+{
+    uint32_t mProxyCount;
+    uint32_t mPendingCount;
+    uint32_t mNodeCount;
+    float mBuildCost;
+    float mCurrentCost;
+    // Unnormalized cost of the current tree, updated along the refitted paths.
+    float mCostSum;
+    float mLastRefitMs;
+    float mLastRebuildMs;
+};
+
+// @brief
+// SlvnBvh is a dynamic bounding volume hierarchy over scene object bounds.
+// Proxies are moved with Update() and the tree is refit bottom-up with Refit().
+// When refitting has degraded the tree past a threshold a full binned SAH rebuild
+// is started on a worker thread and swapped in by PollRebuild() once it is done.
+// Proxies inserted after the last build are kept in a pending list and tested
+// linearly until the next rebuild includes them.
+class SlvnBvh
+{
+public:
+    SlvnBvh();
+    ~SlvnBvh();
+
+    uint32_t Insert(const SlvnAabb& bounds);
+    void Remove(uint32_t proxy);
+    // Safe to call concurrently for distinct proxies.
+    void Update(uint32_t proxy, const SlvnAabb& bounds);
+
+    void Refit();
+    void Rebuild();
+    void RequestRebuild();
+    bool PollRebuild();
+    bool NeedsRebuild() const;
+
+    // Queries append matching proxies to result.
+    void QueryFrustum(const SlvnFrustum& frustum, std::vector<uint32_t>& result) const;
+    void QuerySphere(const SlvnSphere& sphere, std::vector<uint32_t>& result) const;
+    void QueryAabb(const SlvnAabb& bounds, std::vector<uint32_t>& result) const;
+    void QueryRay(const SlvnRay& ray, float maxDistance, std::vector<SlvnBvhRayHit>& result) const;
+    std::optional<SlvnBvhRayHit> Raycast(const SlvnRay& ray, float maxDistance) const;
+
+    const SlvnAabb& GetBounds(uint32_t proxy) const { return mProxyBounds[proxy]; }
+    SlvnBvhStats GetStats() const;
+
+public:
+    // Relative SAH cost growth over the last build that triggers a rebuild.
+    float mRebuildThreshold;
+    uint32_t mMaxLeafSize;
+
+private:
+    struct BuildResult
+    {
+        std::vector<SlvnBvhNode> mNodes;
+        std::vector<uint32_t> mLeafProxies;
+        float mCost;
+        float mBuildMs;
+    };
+
+    static void build(const std::vector<SlvnAabb>& bounds, const std::vector<uint8_t>& alive, uint32_t maxLeafSize, BuildResult& result);
+    // SAH cost summed over the nodes, computeCost() normalizes it by the root area.
+    static float sumCost(const std::vector<SlvnBvhNode>& nodes);
+    static float computeCost(const std::vector<SlvnBvhNode>& nodes, float costSum);
+    void adopt(BuildResult& result);
+    void markDirty(uint32_t proxy);
+    void refitLeaf(uint32_t nodeIndex);
+    void refitAll();
+    void collectSubtree(uint32_t nodeIndex, std::vector<uint32_t>& result) const;
+
+    template<typename NodeTest, typename ProxyTest>
+    void query(NodeTest nodeTest, ProxyTest proxyTest, std::vector<uint32_t>& result) const;
+
+private:
+    static constexpr uint32_t cInvalid = UINT32_MAX;
+
+    std::vector<SlvnBvhNode> mNodes;
+    std::vector<uint32_t> mParents;
+    std::vector<uint32_t> mLeafProxies;
+
+    std::vector<SlvnAabb> mProxyBounds;
+    std::vector<uint32_t> mProxyLeaf;
+    std::vector<uint8_t> mProxyAlive;
+    std::vector<uint8_t> mProxyDirty;
+    // Proxies flagged in mProxyDirty, each at most once; the first mDirtyCount entries are valid.
+    std::vector<uint32_t> mDirtyProxies;
+    std::atomic<uint32_t> mDirtyCount;
+    std::vector<uint32_t> mFreeProxies;
+    std::vector<uint32_t> mPending;
+    uint32_t mProxyCount;
+
+    float mBuildCost;
+    float mCurrentCost;
+    // Unnormalized cost of the current tree, updated along the refitted paths.
+    float mCostSum;
+    float mLastRefitMs;
+    float mLastRebuildMs;
+
+    SlvnThread mRebuildWorker;
+    std::vector<SlvnAabb> mSnapshotBounds;
+    std::vector<uint8_t> mSnapshotAlive;
+    BuildResult mRebuildResult;
+    std::atomic<bool> mRebuildRunning;
+    std::atomic<bool> mRebuildDone;
+};
+
+} // slvn_tech
+
+#endif // SLVNBVH_H
@@ -70,7 +70,7 @@ public:
     inline void SetPerspective(float fov, float aspect)
     {
         mFov = fov;
-        mMatrices.perspective = glm::perspective(glm::radians(fov), aspect, 1.0f, 1000.0f);
+        mMatrices.perspective = glm::perspective(glm::radians(fov), aspect, cNear, cFar);
         mMatrices.perspective[1][1] *= -1.0f;
     }
     inline glm::vec3 GetPos() { return mPos; }
@@ -78,6 +78,7 @@ public:
     inline glm::vec3 GetTarget() { return mTarget; }
     inline glm::vec3 GetFront() { return mFront; }
     inline float GetFov() { return mFov; }
+    inline float GetFar() { return cFar; }
     inline glm::vec3 GetUp() { return cUp; }
 
 public:
@@ -90,6 +91,8 @@ private:
     glm::vec3 mFront;
 
     const glm::vec3 cUp = glm::vec3(0.0f, 1.0f, 0.0f);
+    static constexpr float cNear = 1.0f;
+    static constexpr float cFar = 1000.0f;
     float mFov;
 };
 
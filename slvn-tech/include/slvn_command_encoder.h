@@ -0,0 +1,119 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNCOMMANDENCODER_H
+#define SLVNCOMMANDENCODER_H
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+enum class SlvnEncoderCall
+{
+    cSetViewport = 0,
+    cSetScissor,
+    cBindPipeline,
+    cBindVertexBuffer,
+    cBindIndexBuffer,
+    cPushConstants,
+    cDrawIndexed,
+    cCount
+};
+
+struct SlvnEncoderStats
+{
+    uint32_t mIssued[static_cast<uint32_t>(SlvnEncoderCall::cCount)];
+    uint32_t mElided[static_cast<uint32_t>(SlvnEncoderCall::cCount)];
+
+    uint32_t GetIssued() const;
+    uint32_t GetElided() const;
+    void Add(const SlvnEncoderStats& other);
+};
+
+// @brief
+// SlvnCommandEncoder records into one command buffer at a time and remembers the
+// state bound in it, so binds matching the current state are skipped.
+// Viewport and scissor are assumed dynamic in every pipeline, so a pipeline
+// change does not invalidate them.
+class SlvnCommandEncoder
+{
+public:
+    SlvnCommandEncoder();
+    ~SlvnCommandEncoder();
+
+    // Forgets all tracked state, a freshly begun command buffer has nothing bound.
+    void Begin(VkCommandBuffer cmdBuffer);
+
+    void SetViewport(const VkViewport& viewport);
+    void SetScissor(const VkRect2D& scissor);
+    void BindPipeline(VkPipeline pipeline);
+    void BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset);
+    void BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType);
+    void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data);
+    void DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset);
+
+    inline VkCommandBuffer GetCommandBuffer() const { return mCmdBuffer; }
+    inline const SlvnEncoderStats& GetStats() const { return mStats; }
+    void ResetStats();
+
+private:
+    inline void count(SlvnEncoderCall call, bool elided)
+    {
+        uint32_t index = static_cast<uint32_t>(call);
+        elided ? mStats.mElided[index]++ : mStats.mIssued[index]++;
+    }
+
+private:
+    // Guaranteed minimum of maxPushConstantsSize.
+    static constexpr uint32_t cMaxPushConstantSize = 128;
+
+    VkCommandBuffer mCmdBuffer;
+
+    bool mViewportValid;
+    VkViewport mViewport;
+    bool mScissorValid;
+    VkRect2D mScissor;
+    VkPipeline mPipeline;
+    VkBuffer mVertexBuffer;
+    VkDeviceSize mVertexBufferOffset;
+    VkBuffer mIndexBuffer;
+    VkDeviceSize mIndexBufferOffset;
+    VkIndexType mIndexType;
+    VkPipelineLayout mPushLayout;
+    VkShaderStageFlags mPushStages;
+    uint32_t mPushOffset;
+    uint32_t mPushSize;
+    uint8_t mPushData[cMaxPushConstantSize];
+
+    SlvnEncoderStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNCOMMANDENCODER_H
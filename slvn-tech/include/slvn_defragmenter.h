@@ -0,0 +1,114 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNDEFRAGMENTER_H
+#define SLVNDEFRAGMENTER_H
+
+#include <vector>
+#include <optional>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_buffer.h>
+
+namespace slvn_tech
+{
+
+struct SlvnDefragmentationStats
+{
+    // Last Step(), before and after are the same when it moved nothing.
+    uint64_t mBytesMoved;
+    uint32_t mMoveCount;
+    float mFragmentationBefore;
+    float mFragmentationAfter;
+    uint32_t mBlockCountBefore;
+    uint32_t mBlockCountAfter;
+    float mStepMs;
+
+    uint64_t mTotalBytesMoved;
+    uint32_t mTotalMoveCount;
+    uint32_t mFailedMoveCount;
+};
+
+// @brief
+// SlvnDefragmenter incrementally compacts the blocks of SlvnMemoryAllocator. Each Step() picks
+// the emptiest block that has a sibling of the same memory type and moves registered buffers
+// out of it with copies recorded on the frame command buffer, until the per-frame time, byte or
+// move budget runs out. Buffers are patched in place, so anything that asks SlvnBuffer for its
+// VkBuffer while recording sees the new one. Old buffers go to the deletion queue; once the last
+// of them is retired the drained block is released by the allocator.
+class SlvnDefragmenter
+{
+public:
+    SlvnDefragmenter();
+    ~SlvnDefragmenter();
+
+    SlvnResult Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnDeletionQueue* deletionQueue);
+    SlvnResult Deinitialize();
+
+    // Only buffers with TRANSFER_SRC and TRANSFER_DST usage are ever moved, and only while canMove,
+    // when given, returns true.
+    void Register(SlvnBuffer* buffer, std::function<bool()> canMove = nullptr);
+    void Unregister(SlvnBuffer* buffer);
+
+    // Records moves into cmd, which has to be outside of a render pass; lastUse is the frame
+    // number cmd will be submitted as. Returns the amount of buffers moved.
+    uint32_t Step(VkCommandBuffer cmd, uint64_t lastUse);
+    inline const SlvnDefragmentationStats& GetStats() const { return mStats; }
+
+public:
+    float mTimeBudgetMs;
+    VkDeviceSize mMaxBytesPerFrame;
+    uint32_t mMaxMovesPerFrame;
+    // Blocks used above this fraction are not worth draining.
+    float mMaxSourceUtilization;
+
+private:
+    struct Registration
+    {
+        SlvnBuffer* mBuffer;
+        std::function<bool()> mCanMove;
+
+        bool IsMovable() const;
+    };
+
+    std::optional<uint32_t> selectSourceBlock(const std::vector<SlvnMemoryBlockInfo>& blocks) const;
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    SlvnDeletionQueue* mDeletionQueue;
+    std::vector<Registration> mBuffers;
+    SlvnDefragmentationStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNDEFRAGMENTER_H
@@ -0,0 +1,133 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNDELETIONQUEUE_H
+#define SLVNDELETIONQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <functional>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+
+namespace slvn_tech
+{
+
+enum class SlvnDeletionType
+{
+    cBuffer = 0,
+    cImage,
+    cImageView,
+    cSampler,
+    cFramebuffer,
+    cPipeline,
+    cPipelineLayout,
+    cShaderModule,
+    cCommandPool,
+    cDescriptorPool,
+    cQueryPool,
+    cDeviceMemory,
+    cCallback
+};
+
+// @brief
+// SlvnDeletionQueue defers the destruction of Vulkan objects until the GPU has finished the
+// frame that last used them. Every frame the engine passes the newest frame whose fence has
+// signalled to Collect(), which destroys everything recorded for that frame or earlier in one go.
+// Buffers and images may carry their SlvnAllocation, which is returned to the allocator with them.
+// Safe to call from any thread.
+class SlvnDeletionQueue
+{
+public:
+    SlvnDeletionQueue();
+    ~SlvnDeletionQueue();
+
+    SlvnResult Initialize(VkDevice device, SlvnMemoryAllocator* allocator);
+    // Destroys everything left; the device has to be idle.
+    SlvnResult Deinitialize();
+
+    // Named per type, non-dispatchable handles are all uint64_t on 32-bit targets.
+    void DestroyBuffer(uint64_t lastUse, VkBuffer buffer, const SlvnAllocation& allocation = SlvnAllocation());
+    void DestroyImage(uint64_t lastUse, VkImage image, const SlvnAllocation& allocation = SlvnAllocation());
+    void DestroyImageView(uint64_t lastUse, VkImageView view);
+    void DestroySampler(uint64_t lastUse, VkSampler sampler);
+    void DestroyFramebuffer(uint64_t lastUse, VkFramebuffer framebuffer);
+    void DestroyPipeline(uint64_t lastUse, VkPipeline pipeline);
+    void DestroyPipelineLayout(uint64_t lastUse, VkPipelineLayout layout);
+    void DestroyShaderModule(uint64_t lastUse, VkShaderModule module);
+    void DestroyCommandPool(uint64_t lastUse, VkCommandPool pool);
+    void DestroyDescriptorPool(uint64_t lastUse, VkDescriptorPool pool);
+    void DestroyQueryPool(uint64_t lastUse, VkQueryPool pool);
+    void FreeMemory(uint64_t lastUse, VkDeviceMemory memory);
+    // For anything without a handle of its own, e.g. engine side bookkeeping of a streamed asset.
+    void Defer(uint64_t lastUse, std::function<void()> callback);
+
+    // Returns the amount of objects destroyed.
+    uint32_t Collect(uint64_t completedFrame);
+    inline size_t GetPendingCount() { std::lock_guard<std::mutex> lock(mMutex); return mEntries.size(); }
+
+private:
+    struct Entry
+    {
+        uint64_t mLastUse;
+        SlvnDeletionType mType;
+        union
+        {
+            VkBuffer mBuffer;
+            VkImage mImage;
+            VkImageView mImageView;
+            VkSampler mSampler;
+            VkFramebuffer mFramebuffer;
+            VkPipeline mPipeline;
+            VkPipelineLayout mPipelineLayout;
+            VkShaderModule mShaderModule;
+            VkCommandPool mCommandPool;
+            VkDescriptorPool mDescriptorPool;
+            VkQueryPool mQueryPool;
+            VkDeviceMemory mDeviceMemory;
+        };
+        SlvnAllocation mAllocation;
+        std::function<void()> mCallback;
+    };
+
+    void push(Entry& entry);
+    void destroy(Entry& entry);
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    std::mutex mMutex;
+    // Kept in push order. Entries are only freed from the front, so an entry pushed with an
+    // older frame behind a newer one waits for the newer one; late but never early.
+    std::deque<Entry> mEntries;
+};
+
+} // slvn_tech
+
+#endif // SLVNDELETIONQUEUE_H
@@ -47,6 +47,8 @@ public:
     uint8_t GetViableQueueFamilyIndex();
     uint16_t GetViableQueueCount();
     SlvnResult GetDeviceQueue(VkQueue& queue, uint16_t queueIndex);
+    uint8_t GetTransferQueueFamilyIndex();
+    SlvnResult GetTransferQueue(VkQueue& queue);
 
 private:
     SlvnResult checkQueueFamilyProperties();
@@ -61,6 +63,9 @@ public:
 
     bool mPrimaryDevice;
     uint8_t mQueueFamilyIndex;
+    uint8_t mTransferQueueFamilyIndex;
+    // bufferDeviceAddress was supported and enabled on the logical device.
+    bool mBufferDeviceAddress;
 
 private:
     SlvnState mState;
@@ -0,0 +1,157 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNDRAWPACKET_H
+#define SLVNDRAWPACKET_H
+
+#include <vector>
+#include <algorithm>
+
+#include <core.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+enum class SlvnDrawLayer
+{
+    cOpaque = 0,
+    cTransparent
+};
+
+// @brief
+// 64-bit draw sort keys, most significant field first.
+// Opaque:      layer 2 | pipeline 10 | material 12 | mesh 16 | depth 24, front to back within equal state.
+// Transparent: layer 2 | inverted depth 24 | pipeline 10 | material 12 | mesh 16, back to front.
+struct SlvnDrawKey
+{
+    static constexpr uint32_t cPipelineBits = 10;
+    static constexpr uint32_t cMaterialBits = 12;
+    static constexpr uint32_t cMeshBits = 16;
+    static constexpr uint32_t cDepthBits = 24;
+    static constexpr uint32_t cStateBits = cPipelineBits + cMaterialBits + cMeshBits;
+    static constexpr uint32_t cLayerShift = 62;
+
+    // Depth is expected normalized to 0..1.
+    static inline uint64_t QuantizeDepth(float depth)
+    {
+        return static_cast<uint64_t>(std::min(std::max(depth, 0.0f), 1.0f) * static_cast<float>((1 << cDepthBits) - 1));
+    }
+
+    static inline uint64_t PackState(uint32_t pipeline, uint32_t material, uint32_t mesh)
+    {
+        return (uint64_t(pipeline & ((1 << cPipelineBits) - 1)) << (cMaterialBits + cMeshBits)) |
+               (uint64_t(material & ((1 << cMaterialBits) - 1)) << cMeshBits) |
+               uint64_t(mesh & ((1 << cMeshBits) - 1));
+    }
+
+    static inline uint64_t Opaque(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+    {
+        return (uint64_t(SlvnDrawLayer::cOpaque) << cLayerShift) | (PackState(pipeline, material, mesh) << cDepthBits) | QuantizeDepth(depth);
+    }
+
+    static inline uint64_t Transparent(uint32_t pipeline, uint32_t material, uint32_t mesh, float depth)
+    {
+        uint64_t invertedDepth = ((1 << cDepthBits) - 1) - QuantizeDepth(depth);
+        return (uint64_t(SlvnDrawLayer::cTransparent) << cLayerShift) | (invertedDepth << cStateBits) | PackState(pipeline, material, mesh);
+    }
+
+    static inline SlvnDrawLayer GetLayer(uint64_t key) { return static_cast<SlvnDrawLayer>(key >> cLayerShift); }
+    static inline uint64_t GetState(uint64_t key)
+    {
+        uint64_t state = GetLayer(key) == SlvnDrawLayer::cOpaque ? key >> cDepthBits : key;
+        return state & ((uint64_t(1) << cStateBits) - 1);
+    }
+    static inline uint32_t GetPipeline(uint64_t key) { return static_cast<uint32_t>(GetState(key) >> (cMaterialBits + cMeshBits)); }
+    static inline uint32_t GetMaterial(uint64_t key) { return static_cast<uint32_t>(GetState(key) >> cMeshBits) & ((1 << cMaterialBits) - 1); }
+    static inline uint32_t GetMesh(uint64_t key) { return static_cast<uint32_t>(GetState(key)) & ((1 << cMeshBits) - 1); }
+};
+
+struct SlvnDrawPacket
+{
+    uint64_t mKey;
+    uint32_t mWorker;
+    uint32_t mObject;
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+    int32_t mVertexOffset;
+    // Visible meshlet ranges drawn instead of the index range above, when there are any.
+    uint32_t mFirstRange;
+    uint32_t mRangeCount;
+};
+
+struct SlvnDrawStats
+{
+    uint32_t mPacketCount;
+    uint32_t mPipelineChanges;
+    uint32_t mMaterialChanges;
+    uint32_t mMeshChanges;
+    float mSortMs;
+};
+
+// @brief
+// SlvnDrawSorter orders draw packets by key with a stable LSD radix sort, 8 bits per pass.
+// Only key and packet index pairs move during the passes, packets are gathered once at the end.
+// Histograms of all bytes are built per thread in one sweep, scatters run in parallel on
+// the threadpool and passes over bytes that are equal in every key are skipped.
+class SlvnDrawSorter
+{
+public:
+    SlvnDrawSorter();
+    ~SlvnDrawSorter();
+
+    void Sort(std::vector<SlvnDrawPacket>& packets, SlvnThreadpool* threadpool);
+    // State changes a recorder walking the packets in order has to make.
+    SlvnDrawStats CountStateChanges(const std::vector<SlvnDrawPacket>& packets) const;
+
+    inline float GetLastSortMs() const { return mLastSortMs; }
+
+private:
+    struct SortEntry
+    {
+        uint64_t mKey;
+        uint64_t mIndex;
+    };
+
+    void histogram(uint32_t begin, uint32_t end, uint32_t* counts);
+    void scatter(const SortEntry* source, SortEntry* destination, uint32_t begin, uint32_t end, uint32_t shift, uint32_t* offsets);
+
+private:
+    static constexpr uint32_t cRadix = 256;
+    static constexpr uint32_t cPassCount = 8;
+    // Below this many packets a single thread is faster than dispatching jobs.
+    static constexpr uint32_t cParallelThreshold = 16384;
+
+    std::vector<SortEntry> mEntries;
+    std::vector<SortEntry> mEntriesScratch;
+    std::vector<SlvnDrawPacket> mScratch;
+    std::vector<uint32_t> mHistograms;
+    float mLastSortMs;
+};
+
+} // slvn_tech
+
+#endif // SLVNDRAWPACKET_H
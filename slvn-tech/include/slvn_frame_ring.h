@@ -0,0 +1,133 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNFRAMERING_H
+#define SLVNFRAMERING_H
+
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+
+namespace slvn_tech
+{
+
+// @brief
+// Lock-free bump allocator over one frame's part of the ring. Offsets are relative to the region.
+struct SlvnFrameRegion
+{
+    std::atomic<uint64_t> mHead;
+    uint64_t mCapacity;
+    uint64_t mHighWater;
+
+    SlvnFrameRegion() : mHead(0), mCapacity(0), mHighWater(0) {}
+
+    // Returns false when the region is full. Alignment has to be a power of two.
+    inline bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+    {
+        uint64_t head = mHead.load(std::memory_order_relaxed);
+        uint64_t aligned;
+        do
+        {
+            aligned = (head + alignment - 1) & ~(alignment - 1);
+            if (aligned + size > mCapacity)
+                return false;
+        }
+        while (!mHead.compare_exchange_weak(head, aligned + size, std::memory_order_relaxed));
+        offset = aligned;
+        return true;
+    }
+    inline void Reset()
+    {
+        mHighWater = std::max(mHighWater, mHead.load(std::memory_order_relaxed));
+        mHead.store(0, std::memory_order_relaxed);
+    }
+};
+
+struct SlvnRingAllocation
+{
+    VkBuffer mBuffer = VK_NULL_HANDLE;
+    VkDeviceSize mOffset = 0;
+    void* mMapped = nullptr;
+};
+
+struct SlvnFrameRingStats
+{
+    uint64_t mFrameSize;
+    uint64_t mUsed;
+    uint64_t mHighWater;
+    uint32_t mFailedAllocations;
+};
+
+// @brief
+// SlvnFrameRing is one persistently mapped host visible buffer split into a region per frame
+// in flight. Worker threads sub-allocate per-frame data (uniforms, instance data, staging)
+// from the current region without locks and write straight into the mapping. A region is
+// reused by BeginFrame() once the fence of the frame that last used it has signalled.
+class SlvnFrameRing
+{
+public:
+    SlvnFrameRing();
+    ~SlvnFrameRing();
+
+    SlvnResult Initialize(VkDevice device, VkPhysicalDevice physicalDevice, SlvnMemoryAllocator* allocator,
+        uint32_t frameCount, VkDeviceSize frameSize, VkBufferUsageFlags usage);
+    SlvnResult Deinitialize();
+
+    // Only call after the fence of the frame that last used this region has signalled.
+    void BeginFrame(uint32_t frame);
+
+    // Thread safe. On failure the allocation is left empty and the caller has to fall back.
+    SlvnResult Allocate(VkDeviceSize size, VkDeviceSize alignment, SlvnRingAllocation& allocation);
+    inline SlvnResult AllocateUniform(VkDeviceSize size, SlvnRingAllocation& allocation) { return Allocate(size, mUniformAlignment, allocation); }
+    inline SlvnResult AllocateStorage(VkDeviceSize size, SlvnRingAllocation& allocation) { return Allocate(size, mStorageAlignment, allocation); }
+
+    inline VkBuffer GetBuffer() const { return mBuffer; }
+    SlvnFrameRingStats GetStats() const;
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    VkBuffer mBuffer;
+    SlvnAllocation mAllocation;
+    VkDeviceSize mFrameSize;
+    VkDeviceSize mUniformAlignment;
+    VkDeviceSize mStorageAlignment;
+
+    std::unique_ptr<SlvnFrameRegion[]> mRegions;
+    uint32_t mFrameCount;
+    uint32_t mCurrentFrame;
+    std::atomic<uint32_t> mFailedAllocations;
+};
+
+} // slvn_tech
+
+#endif // SLVNFRAMERING_H
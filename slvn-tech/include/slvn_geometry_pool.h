@@ -0,0 +1,161 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNGEOMETRYPOOL_H
+#define SLVNGEOMETRYPOOL_H
+
+#include <vector>
+#include <mutex>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_tlsf.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_upload_manager.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_command_encoder.h>
+#include <slvn_vertex_format.h>
+#include <slvn_buffer.h>
+#include <slvn_defragmenter.h>
+
+namespace slvn_tech
+{
+
+// Draw arguments of a mesh inside SlvnGeometryPool. mVertexOffset is in units of the pool
+// vertex stride and only usable for fixed function fetch when the mesh format has that stride.
+// mFirstIndex counts indices of mIndexType, the index buffer has to be bound with that type.
+struct SlvnMeshRange
+{
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+    int32_t mVertexOffset;
+    uint32_t mVertexCount;
+    VkDeviceSize mVertexByteOffset;
+    SlvnVertexFormat mVertexFormat;
+    SlvnVertexQuantization mQuantization;
+    VkIndexType mIndexType;
+};
+
+struct SlvnGeometryPoolStats
+{
+    uint32_t mMeshCount;
+    uint64_t mVertexCapacity;
+    uint64_t mVertexUsed;
+    uint64_t mLargestVertexRange;
+    uint64_t mIndexCapacity;
+    uint64_t mIndexUsed;
+    uint64_t mLargestIndexRange;
+};
+
+// @brief
+// SlvnGeometryPool packs static meshes into one vertex buffer and one index buffer,
+// so they are bound once per command buffer and drawn with firstIndex and vertexOffset.
+// Free ranges of both buffers are managed with SlvnTlsfAllocator in units of vertices and
+// 32-bit indices. With short indices enabled, meshes of up to 65536 vertices store 16-bit
+// indices, two to a unit, and are drawn with the index buffer bound as VK_INDEX_TYPE_UINT16. Device local pools are filled through SlvnUploadManager, host visible ones directly.
+// Meshes in other vertex formats take as many pool vertices as their bytes need and are read
+// by the vertex pulling pipeline from GetVertexAddress() + mVertexByteOffset.
+// Both buffers can be moved by SlvnDefragmenter, so their handles are read again for every recording.
+class SlvnGeometryPool
+{
+public:
+    static constexpr uint32_t cInvalidMesh = UINT32_MAX;
+
+    SlvnGeometryPool();
+    ~SlvnGeometryPool();
+
+    SlvnResult Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnUploadManager* uploader,
+        uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity, bool deviceLocal, bool deviceAddress = false,
+        bool shortIndices = false);
+    SlvnResult Deinitialize();
+
+    // Indices are relative to the first vertex of the mesh. Device local pools queue the copies on
+    // the upload manager and the caller submits them. Returns cInvalidMesh if the pool is full.
+    uint32_t AddMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+        SlvnVertexFormat format = SlvnVertexFormat::cFloat, const SlvnVertexQuantization& quantization = SlvnVertexQuantization());
+    // The ranges are reused once frame lastUse has completed.
+    void RemoveMesh(uint32_t mesh, uint64_t lastUse, SlvnDeletionQueue* deletionQueue);
+    SlvnMeshRange GetMesh(uint32_t mesh) const;
+
+    // Pulling pipelines have no vertex input, only the index buffer is bound for them.
+    void Bind(SlvnCommandEncoder& encoder, bool vertexInput = true, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const;
+    inline VkBuffer GetVertexBuffer() const { return mVertexBuffer.GetBuffer(); }
+    inline VkDeviceAddress GetVertexAddress() const { return mVertexAddress; }
+    inline VkBuffer GetIndexBuffer() const { return mIndexBuffer.GetBuffer(); }
+    SlvnGeometryPoolStats GetStats() const;
+
+    // The buffers are only moved while none of their uploads is in flight. A move has to follow every
+    // write of the frame, as a write into the new buffer before the copy has run would be overwritten.
+    void Register(SlvnDefragmenter* defragmenter);
+    void Unregister(SlvnDefragmenter* defragmenter);
+    bool HasPendingUploads() const;
+    // Whether adding meshes would stage them into a heap that is near its budget.
+    bool IsNearBudget() const;
+    // Has to follow a SlvnDefragmenter::Step() that moved anything.
+    void UpdateVertexAddress();
+
+private:
+    struct Mesh
+    {
+        SlvnMeshRange mRange;
+        uint32_t mVertexHandle;
+        uint32_t mIndexHandle;
+        bool mAlive;
+    };
+
+    SlvnResult createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, SlvnBuffer& buffer);
+    SlvnResult write(const SlvnBuffer& buffer, VkDeviceSize offset, const void* data, VkDeviceSize size, VkAccessFlags dstAccess);
+    void freeRanges(uint32_t mesh);
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    SlvnUploadManager* mUploader;
+    uint32_t mVertexStride;
+    bool mDeviceLocal;
+
+    bool mDeviceAddress;
+    bool mShortIndices;
+
+    SlvnBuffer mVertexBuffer;
+    VkDeviceAddress mVertexAddress;
+    SlvnBuffer mIndexBuffer;
+    // Batch of the last upload into either buffer.
+    uint64_t mLastBatch;
+
+    // Range frees arrive from the deletion queue.
+    mutable std::mutex mMutex;
+    SlvnTlsfAllocator mVertexRanges;
+    SlvnTlsfAllocator mIndexRanges;
+    std::vector<Mesh> mMeshes;
+    std::vector<uint32_t> mFreeMeshes;
+    uint32_t mMeshCount;
+};
+
+} // slvn_tech
+
+#endif // SLVNGEOMETRYPOOL_H
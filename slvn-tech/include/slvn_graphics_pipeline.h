@@ -36,21 +36,32 @@
 namespace slvn_tech
 {
 
+enum class SlvnVertexFetch
+{
+    // SlvnVertex through vertex input bindings.
+    cFixedFunction = 0,
+    // Vertex shader reads any SlvnVertexFormat from a buffer device address, see SlvnPullPushConstant.
+    cPulling
+};
+
 class SlvnGraphicsPipeline
 {
 public:
     SlvnGraphicsPipeline();
     ~SlvnGraphicsPipeline();
 
-    SlvnResult Initialize(VkDevice& device, VkRenderPass& renderpass);
+    SlvnResult Initialize(VkDevice& device, VkRenderPass& renderpass, SlvnVertexFetch fetch = SlvnVertexFetch::cFixedFunction);
     SlvnResult Deinitialize();
     SlvnResult BindPipeline(VkCommandBuffer& cmdBuffer);
     SlvnResult Draw(VkCommandBuffer& cmdBuffer);
 
     VkPipelineLayout GetLayout() { return mPipelineLayout; }
+    VkPipeline GetPipeline() { return mPipeline; }
+    SlvnVertexFetch GetFetch() const { return mFetch; }
 
 private:
     SlvnState mState;
+    SlvnVertexFetch mFetch;
     VkPipeline mPipeline;
     std::vector<SlvnShaderModule> mShaderModules;
     VkPipelineLayout mPipelineLayout;
@@ -31,6 +31,10 @@
 
 #include <core.h>
 #include <slvn_debug.h>
+#include <slvn_lod.h>
+#include <slvn_mapped_file.h>
+#include <slvn_meshlet.h>
+#include <slvn_threadpool.inl>
 
 namespace slvn_tech
 {
@@ -41,9 +45,22 @@ public:
     SlvnLoader();
     ~SlvnLoader();
 
+    // Appends the mesh and all of its detail levels to indices, lods receives their ranges and
+    // meshlets has the meshlets of every level appended.
     SlvnResult Load(const std::string& objPath,
                     std::vector<SlvnVertex>& vertices,
-                    std::vector<uint32_t>& indices);
+                    std::vector<uint32_t>& indices,
+                    SlvnThreadpool* threadpool = nullptr,
+                    SlvnLodMesh* lods = nullptr,
+                    std::vector<SlvnMeshlet>* meshlets = nullptr);
+    // Same with the source already mapped, e.g. read ahead by an I/O stage; objPath still names the cache.
+    SlvnResult Load(const std::string& objPath,
+                    const SlvnMappedFile& source,
+                    std::vector<SlvnVertex>& vertices,
+                    std::vector<uint32_t>& indices,
+                    SlvnThreadpool* threadpool = nullptr,
+                    SlvnLodMesh* lods = nullptr,
+                    std::vector<SlvnMeshlet>* meshlets = nullptr);
 
 };
 
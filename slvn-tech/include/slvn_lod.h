@@ -0,0 +1,84 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNLOD_H
+#define SLVNLOD_H
+
+#include <vector>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+struct SlvnLodLevel
+{
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+    // Largest object space distance between a vertex and the vertex replacing it.
+    float mError;
+    // Meshlets covering the level, when the mesh has any.
+    uint32_t mFirstMeshlet;
+    uint32_t mMeshletCount;
+};
+
+// @brief
+// Detail levels of one mesh as ranges into a shared index buffer,
+// level 0 is the full detail mesh and every following level is coarser.
+struct SlvnLodMesh
+{
+    std::vector<SlvnLodLevel> mLevels;
+};
+
+// @brief
+// SlvnLodSelector picks the coarsest level whose error projected to the screen
+// stays below a pixel threshold. A level is only changed once the projected error
+// leaves a band of mHysteresis around the threshold, to stop levels popping.
+class SlvnLodSelector
+{
+public:
+    SlvnLodSelector();
+    ~SlvnLodSelector();
+
+    void SetProjection(float fovDegrees, float viewportHeight);
+    uint32_t SelectLevel(const SlvnLodMesh& mesh, float distance, float scale, uint32_t currentLevel) const;
+
+    inline float GetProjectedError(float error, float distance, float scale) const
+    {
+        return error * scale * mScreenScale / distance;
+    }
+
+public:
+    float mPixelThreshold;
+    float mHysteresis;
+
+private:
+    float mScreenScale;
+};
+
+} // slvn_tech
+
+#endif // SLVNLOD_H
@@ -0,0 +1,69 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMAPPEDFILE_H
+#define SLVNMAPPEDFILE_H
+
+#include <string>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+// @brief
+// Read-only view of a whole file through the virtual memory system, pages are read in by the OS
+// on first touch instead of being copied through a stream buffer.
+class SlvnMappedFile
+{
+public:
+    SlvnMappedFile();
+    ~SlvnMappedFile();
+
+    SlvnResult Open(const std::string& path);
+    void Close();
+
+    inline const char* GetData() const { return mData; }
+    inline size_t GetSize() const { return mSize; }
+
+private:
+    SlvnMappedFile(const SlvnMappedFile&) = delete;
+    SlvnMappedFile& operator=(const SlvnMappedFile&) = delete;
+
+private:
+    const char* mData;
+    size_t mSize;
+#ifdef _WIN32
+    void* mFile;
+    void* mMapping;
+#else
+    int mFile;
+#endif
+};
+
+} // slvn_tech
+
+#endif // SLVNMAPPEDFILE_H
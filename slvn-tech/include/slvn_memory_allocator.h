@@ -0,0 +1,225 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMEMORYALLOCATOR_H
+#define SLVNMEMORYALLOCATOR_H
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_tlsf.h>
+
+namespace slvn_tech
+{
+
+enum class SlvnMemoryUsage
+{
+    cGpuOnly = 0,
+    cCpuToGpu,
+    cGpuToCpu
+};
+
+// Buffers and linear images are kept apart from optimal tiling images in separate
+// blocks, so bufferImageGranularity never has to be padded for inside a block.
+enum class SlvnResourceTiling
+{
+    cLinear = 0,
+    cOptimal,
+    cCount
+};
+
+// Engine subsystem an allocation is accounted to.
+enum class SlvnMemoryCategory
+{
+    cMeshes = 0,
+    cStaging,
+    cFrame,
+    cTextures,
+    cOther,
+    cCount
+};
+
+struct SlvnAllocation
+{
+    VkDeviceMemory mMemory = VK_NULL_HANDLE;
+    VkDeviceSize mOffset = 0;
+    VkDeviceSize mSize = 0;
+    // Persistently mapped pointer for host visible memory, nullptr otherwise.
+    void* mMapped = nullptr;
+    uint32_t mMemoryType = 0;
+    uint32_t mBlock = UINT32_MAX;
+    uint32_t mHandle = UINT32_MAX;
+    SlvnMemoryCategory mCategory = SlvnMemoryCategory::cOther;
+
+    inline bool IsDedicated() const { return mBlock == UINT32_MAX; }
+};
+
+struct SlvnMemoryStats
+{
+    uint32_t mBlockCount;
+    uint32_t mDedicatedCount;
+    uint32_t mAllocationCount;
+    uint32_t mDeviceMemoryCount;
+    VkDeviceSize mReservedBytes;
+    VkDeviceSize mUsedBytes;
+    uint32_t mFreeRegionCount;
+    VkDeviceSize mLargestFreeRegion;
+    // 1 - largest free region / total free, 0 when all free memory is contiguous.
+    float mFragmentation;
+};
+
+struct SlvnMemoryBlockInfo
+{
+    uint32_t mBlock;
+    uint32_t mMemoryType;
+    SlvnResourceTiling mTiling;
+    VkDeviceSize mSize;
+    VkDeviceSize mUsed;
+    uint32_t mAllocationCount;
+};
+
+struct SlvnMemoryCounter
+{
+    VkDeviceSize mCurrent = 0;
+    VkDeviceSize mPeak = 0;
+
+    inline void Add(VkDeviceSize size) { mCurrent += size; mPeak = std::max(mPeak, mCurrent); }
+    inline void Remove(VkDeviceSize size) { mCurrent -= size; }
+};
+
+struct SlvnHeapBudget
+{
+    VkDeviceSize mSize;
+    // From VK_EXT_memory_budget when available, otherwise 80% of the heap and our own usage.
+    VkDeviceSize mBudget;
+    VkDeviceSize mUsage;
+    // VkDeviceMemory this allocator holds in the heap.
+    SlvnMemoryCounter mAllocated;
+
+    inline VkDeviceSize GetHeadroom() const { return mBudget > mUsage ? mBudget - mUsage : 0; }
+};
+
+// @brief
+// SlvnMemoryAllocator reserves large VkDeviceMemory blocks per memory type and
+// sub-allocates resources from them with SlvnTlsfAllocator. Resources the driver
+// prefers to have on their own, or that would take a large share of a block, get a
+// dedicated allocation instead. Host visible blocks are mapped once for their lifetime.
+// Usage is accounted per heap, memory type and SlvnMemoryCategory. Near the heap budget new
+// blocks shrink to what the request needs; mesh streaming and asset uploads hold back their staging
+// through SlvnGeometryPool::IsNearBudget().
+class SlvnMemoryAllocator
+{
+public:
+    SlvnMemoryAllocator();
+    ~SlvnMemoryAllocator();
+
+    // With bufferDeviceAddress all memory is allocated with VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT,
+    // so any buffer created with SHADER_DEVICE_ADDRESS usage can be placed in any block.
+    SlvnResult Initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize = cDefaultBlockSize,
+        bool bufferDeviceAddress = false);
+    SlvnResult Deinitialize();
+
+    // Allocates memory for buffer and binds it.
+    SlvnResult AllocateBuffer(VkBuffer buffer, SlvnMemoryUsage usage, SlvnAllocation& allocation,
+        SlvnMemoryCategory category = SlvnMemoryCategory::cOther);
+    SlvnResult AllocateImage(VkImage image, SlvnMemoryUsage usage, SlvnResourceTiling tiling, SlvnAllocation& allocation,
+        SlvnMemoryCategory category = SlvnMemoryCategory::cOther);
+    // Places buffer in a block other than the one of source, of the same memory type, without
+    // reserving new device memory. Used to compact blocks; fails with cOutOfMemory if nothing fits.
+    SlvnResult AllocateBufferForMove(VkBuffer buffer, const SlvnAllocation& source, SlvnAllocation& allocation);
+    void Free(SlvnAllocation& allocation);
+
+    SlvnMemoryStats GetStats();
+    std::vector<SlvnMemoryBlockInfo> GetBlockInfos();
+    inline const VkPhysicalDeviceMemoryProperties& GetMemoryProperties() const { return mMemoryProperties; }
+
+    // Queries the driver budget, called once per frame.
+    void UpdateBudget();
+    SlvnHeapBudget GetHeapBudget(uint32_t heap);
+    SlvnMemoryCounter GetCategoryUsage(SlvnMemoryCategory category);
+    SlvnMemoryCounter GetTypeUsage(uint32_t memoryType);
+    // Budget of the heap resources of the given usage end up in.
+    bool IsNearBudget(SlvnMemoryUsage usage, float fraction = cBudgetWarning);
+    inline bool HasMemoryBudget() const { return mMemoryBudgetSupported; }
+
+public:
+    static constexpr VkDeviceSize cDefaultBlockSize = 64ull * 1024 * 1024;
+    static constexpr float cBudgetWarning = 0.9f;
+
+private:
+    struct Block
+    {
+        VkDeviceMemory mMemory;
+        void* mMapped;
+        VkDeviceSize mSize;
+        uint32_t mMemoryType;
+        SlvnResourceTiling mTiling;
+        SlvnTlsfAllocator mTlsf;
+    };
+
+    SlvnResult allocate(const VkMemoryRequirements& requirements, bool dedicated, VkBuffer buffer, VkImage image,
+        SlvnMemoryUsage usage, SlvnResourceTiling tiling, SlvnAllocation& allocation);
+    SlvnResult allocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryType, VkBuffer buffer, VkImage image,
+        SlvnAllocation& allocation);
+    SlvnResult allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, const void* next, VkDeviceMemory& memory, void*& mapped);
+    void freeDeviceMemory(VkDeviceMemory memory, void* mapped, VkDeviceSize size, uint32_t memoryType);
+    void account(const SlvnAllocation& allocation, bool add);
+    VkDeviceSize getEstimatedUsage(uint32_t heap) const;
+    std::optional<uint32_t> findMemoryType(uint32_t typeBits, SlvnMemoryUsage usage) const;
+    VkDeviceSize getBlockSize(uint32_t memoryType) const;
+
+private:
+    VkDevice mDevice;
+    VkPhysicalDevice mPhysicalDevice;
+    VkPhysicalDeviceMemoryProperties mMemoryProperties;
+    VkDeviceSize mBufferImageGranularity;
+    uint32_t mMaxAllocationCount;
+    VkDeviceSize mBlockSize;
+
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<Block>> mBlocks;
+    uint32_t mDeviceMemoryCount;
+    uint32_t mDedicatedCount;
+    VkDeviceSize mDedicatedBytes;
+
+    bool mBufferDeviceAddress;
+    bool mMemoryBudgetSupported;
+    SlvnHeapBudget mHeapBudgets[VK_MAX_MEMORY_HEAPS];
+    // Allocated bytes per heap at the last UpdateBudget(), to estimate usage in between.
+    VkDeviceSize mHeapAllocatedAtUpdate[VK_MAX_MEMORY_HEAPS];
+    SlvnMemoryCounter mTypeUsage[VK_MAX_MEMORY_TYPES];
+    SlvnMemoryCounter mCategoryUsage[static_cast<uint32_t>(SlvnMemoryCategory::cCount)];
+};
+
+} // slvn_tech
+
+#endif // SLVNMEMORYALLOCATOR_H
@@ -0,0 +1,65 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMEMORYREPORTER_H
+#define SLVNMEMORYREPORTER_H
+
+#include <fstream>
+#include <string>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+
+namespace slvn_tech
+{
+
+// @brief
+// SlvnMemoryReporter appends one CSV row per frame with the budget, usage and peak of
+// every memory heap and the current and peak bytes of every SlvnMemoryCategory, so that
+// memory use over a run can be plotted or diffed between builds.
+class SlvnMemoryReporter
+{
+public:
+    SlvnMemoryReporter();
+    ~SlvnMemoryReporter();
+
+    SlvnResult Initialize(SlvnMemoryAllocator* allocator, const std::string& path);
+    SlvnResult Deinitialize();
+
+    void Report(uint64_t frame);
+    inline bool IsEnabled() const { return mFile.is_open(); }
+
+    static const char* GetCategoryName(SlvnMemoryCategory category);
+
+private:
+    SlvnMemoryAllocator* mAllocator;
+    std::ofstream mFile;
+    uint32_t mHeapCount;
+};
+
+} // slvn_tech
+
+#endif // SLVNMEMORYREPORTER_H
@@ -0,0 +1,123 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMESHCACHE_H
+#define SLVNMESHCACHE_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core.h>
+#include <slvn_bounds.h>
+#include <slvn_lod.h>
+#include <slvn_meshlet.h>
+
+namespace slvn_tech
+{
+
+// Layout of a .slvnmesh file: header, submesh table, meshlet table, vertex blob and index blob.
+// The tables and blobs start at cBlobAlignment aligned offsets so that they can be copied
+// out of the mapped file with wide loads.
+struct SlvnMeshCacheHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    // Hash and size of the source file the cache was built from.
+    uint64_t mSourceHash;
+    uint64_t mSourceSize;
+    glm::vec3 mBoundsMin;
+    glm::vec3 mBoundsMax;
+    uint32_t mVertexStride;
+    uint32_t mVertexCount;
+    uint32_t mIndexCount;
+    uint32_t mSubmeshCount;
+    uint32_t mMeshletCount;
+    uint64_t mSubmeshOffset;
+    uint64_t mMeshletOffset;
+    uint64_t mVertexOffset;
+    uint64_t mIndexOffset;
+};
+
+// One submesh per detail level, level 0 first.
+struct SlvnMeshCacheSubmesh
+{
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+    glm::vec3 mBoundsMin;
+    glm::vec3 mBoundsMax;
+    // Object space error of the level, see SlvnLodLevel.
+    float mError;
+    uint32_t mFirstMeshlet;
+    uint32_t mMeshletCount;
+};
+
+// 64-bit content hash, reads the data a word at a time.
+uint64_t SlvnHashBytes(const void* data, size_t size);
+
+// @brief
+// SlvnMeshCache reads and writes .slvnmesh files, the binary form of a loaded and welded mesh.
+// A cache is only used when its header matches the hash of the current source file, a version
+// bump or an edit of the source makes it stale and it is written again on the next load.
+// Reading maps the file and copies the blobs out, there is no parsing involved.
+class SlvnMeshCache
+{
+public:
+    SlvnMeshCache();
+    ~SlvnMeshCache();
+
+    // Appends to vertices and indices like the OBJ parser. Returns cInvalidPath when there is
+    // no cache and cUnexpectedError when it is stale or broken.
+    SlvnResult Read(const std::string& path, uint64_t sourceHash, uint64_t sourceSize,
+        std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
+    // Writes a submesh per detail level of lods, or the whole mesh as one submesh without them.
+    // Goes through a temporary file so that readers never see half of it.
+    SlvnResult Write(const std::string& path, uint64_t sourceHash, uint64_t sourceSize,
+        const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices, const SlvnLodMesh* lods = nullptr,
+        const std::vector<SlvnMeshlet>* meshlets = nullptr);
+
+    inline const SlvnAabb& GetBounds() const { return mBounds; }
+    inline const std::vector<SlvnMeshCacheSubmesh>& GetSubmeshes() const { return mSubmeshes; }
+    inline const std::vector<SlvnMeshlet>& GetMeshlets() const { return mMeshlets; }
+
+    static std::string GetCachePath(const std::string& sourcePath);
+
+public:
+    static constexpr uint32_t cMagic = 0x4D564C53; // "SLVM"
+    // Bump when the layout or SlvnVertex changes.
+    static constexpr uint32_t cVersion = 4;
+    static constexpr uint64_t cBlobAlignment = 64;
+
+private:
+    SlvnAabb mBounds;
+    std::vector<SlvnMeshCacheSubmesh> mSubmeshes;
+    std::vector<SlvnMeshlet> mMeshlets;
+};
+
+} // slvn_tech
+
+#endif // SLVNMESHCACHE_H
@@ -0,0 +1,104 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMESHOPTIMIZER_H
+#define SLVNMESHOPTIMIZER_H
+
+#include <vector>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+struct SlvnVertexCacheStats
+{
+    // Average cache misses per triangle, 0.5 is the best a regular grid can get and 3 the worst.
+    float mAcmr;
+    // Average misses per referenced vertex, 1 means every vertex is transformed once.
+    float mAtvr;
+};
+
+// FIFO simulation of a post-transform cache with cacheSize entries.
+SlvnVertexCacheStats SlvnAnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize);
+
+struct SlvnMeshOptimizerStats
+{
+    SlvnVertexCacheStats mBefore;
+    SlvnVertexCacheStats mAfter;
+    uint32_t mClusterCount;
+    float mOptimizeMs;
+};
+
+// @brief
+// SlvnMeshOptimizer reorders an indexed triangle list for the GPU in three steps. Triangles are
+// ordered for the post-transform cache with Tipsify (Sander et al. 2007); the runs Tipsify produces
+// are then cut into clusters that each keep the cache efficiency within mOverdrawThreshold, and the
+// clusters are sorted so that those facing away from the mesh center are drawn first, which puts
+// likely occluders early without depending on the view. Finally the vertices are renumbered in
+// the order of first use so that fetches walk the vertex buffer forwards.
+class SlvnMeshOptimizer
+{
+public:
+    SlvnMeshOptimizer();
+    ~SlvnMeshOptimizer();
+
+    // All three steps, the vertex cache statistics before and after are kept in the stats.
+    SlvnResult Optimize(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
+
+    SlvnResult OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+    // Uses the clusters of the last OptimizeVertexCache() on the same indices.
+    SlvnResult OptimizeOverdraw(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
+    // Unreferenced vertices are dropped.
+    SlvnResult OptimizeVertexFetch(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
+
+    inline const SlvnMeshOptimizerStats& GetStats() const { return mStats; }
+
+public:
+    // Cache size Tipsify optimizes for and the statistics are measured with.
+    uint32_t mCacheSize;
+    // Largest ACMR growth, relative to the Tipsify order, accepted for a finer overdraw order.
+    float mOverdrawThreshold;
+
+private:
+    uint32_t getNextVertex(const std::vector<uint32_t>& candidates, uint32_t timestamp, uint32_t& cursor);
+
+private:
+    // Per-vertex triangle lists and Tipsify state.
+    std::vector<uint32_t> mAdjacencyOffsets;
+    std::vector<uint32_t> mAdjacency;
+    std::vector<uint32_t> mLiveTriangles;
+    std::vector<uint32_t> mCacheTime;
+    std::vector<uint32_t> mDeadEnd;
+    // First triangle of every run Tipsify started after a dead end.
+    std::vector<uint32_t> mHardBoundaries;
+
+    SlvnMeshOptimizerStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNMESHOPTIMIZER_H
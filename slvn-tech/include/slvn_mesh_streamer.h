@@ -0,0 +1,185 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMESHSTREAMER_H
+#define SLVNMESHSTREAMER_H
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+#include <core.h>
+#include <slvn_geometry_pool.h>
+#include <slvn_upload_manager.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_vertex_format.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+// CPU side mesh data produced by a streaming loader, vertices are already encoded in mFormat.
+struct SlvnStreamedMeshData
+{
+    std::vector<uint8_t> mVertices;
+    uint32_t mVertexCount;
+    std::vector<uint32_t> mIndices;
+    SlvnVertexFormat mFormat;
+    SlvnVertexQuantization mQuantization;
+};
+
+using SlvnMeshLoader = std::function<SlvnResult(SlvnStreamedMeshData&)>;
+
+struct SlvnStreamingStats
+{
+    uint32_t mMeshCount;
+    uint32_t mResidentCount;
+    uint32_t mLoadingCount;
+    uint64_t mResidentBytes;
+    uint64_t mBudgetBytes;
+
+    // Last frame; a request is one mesh asked for by at least one object.
+    uint32_t mRequestCount;
+    uint32_t mHitCount;
+    uint32_t mLoadCount;
+    uint32_t mEvictionCount;
+
+    uint64_t mTotalRequestCount;
+    uint64_t mTotalHitCount;
+    uint64_t mTotalLoadCount;
+    uint64_t mTotalEvictionCount;
+    // From the first request to the upload being usable.
+    float mAverageLoadMs;
+    float mMaxLoadMs;
+
+    inline float GetHitRate() const { return mTotalRequestCount > 0 ? static_cast<float>(mTotalHitCount) / mTotalRequestCount : 1.0f; }
+};
+
+// @brief
+// SlvnMeshStreamer keeps meshes resident in SlvnGeometryPool only while they are in use. Objects
+// call Request() with their distance during the frame, EndFrame() starts the nearest missing meshes
+// loading on a worker thread and BeginFrame() of a later frame moves the loaded data into the pool.
+// Once the upload has completed Resolve() returns the resident mesh, until then the fallback mesh
+// given at registration, usually a coarse level kept resident for good. When the resident bytes
+// exceed the budget the least recently used meshes not requested this frame are evicted; their
+// pool ranges are freed through the deletion queue once the GPU is done with them. A loaded mesh
+// that does not fit the pool evicts about its own size of meshes not drawn last frame and is
+// loaded again on a later request, once those ranges have come back. While the pool is near its
+// staging memory budget no new loads start and one finished load is placed per frame.
+// Request() and Resolve() are safe to call from worker threads, everything else from the render thread.
+class SlvnMeshStreamer
+{
+public:
+    static constexpr uint32_t cInvalidMesh = UINT32_MAX;
+
+    SlvnMeshStreamer();
+    ~SlvnMeshStreamer();
+
+    SlvnResult Initialize(SlvnGeometryPool* pool, SlvnUploadManager* uploader, SlvnDeletionQueue* deletionQueue,
+        uint64_t budgetBytes, uint32_t maxLoadsInFlight);
+    // Waits for running loads and releases every resident mesh after frame lastUse.
+    SlvnResult Deinitialize(uint64_t lastUse);
+
+    // fallbackMesh is a pool mesh drawn while the streamed one is not resident, may be SlvnGeometryPool::cInvalidMesh.
+    uint32_t AddMesh(SlvnMeshLoader loader, uint32_t fallbackMesh);
+
+    // Has to follow SlvnUploadManager::RecordAcquire() of the frame, frame is the number it will be submitted as.
+    void BeginFrame(uint64_t frame);
+    void Request(uint32_t mesh, float distance);
+    // Pool mesh to draw this frame.
+    uint32_t Resolve(uint32_t mesh) const;
+    inline bool IsResident(uint32_t mesh) const { return mMeshes[mesh].mState == State::cResident; }
+    void EndFrame();
+    // Blocks until the running loads have finished, they are placed by the next BeginFrame().
+    inline void Wait() { mLoader.Wait(); }
+
+    SlvnStreamingStats GetStats() const { return mStats; }
+
+public:
+    uint64_t mBudgetBytes;
+    uint32_t mMaxLoadsInFlight;
+
+private:
+    enum class State
+    {
+        cUnloaded = 0,
+        cLoading,
+        cUploading,
+        cResident
+    };
+
+    struct Entry
+    {
+        SlvnMeshLoader mLoader;
+        uint32_t mFallbackMesh;
+        uint32_t mPoolMesh;
+        State mState;
+        uint64_t mBytes;
+        uint64_t mBatch;
+        uint64_t mLastUsed;
+        std::chrono::high_resolution_clock::time_point mRequestTime;
+
+        // Written by Request() from any thread.
+        std::atomic<uint64_t> mRequestFrame;
+        // Bits of the nearest requested distance, positive floats order like their bits.
+        std::atomic<uint32_t> mNearestBits;
+    };
+
+    struct LoadResult
+    {
+        uint32_t mMesh;
+        SlvnResult mResult;
+        SlvnStreamedMeshData mData;
+    };
+
+    // Meshes used since keepFrame are not evicted to make room.
+    void place(LoadResult& load, uint64_t keepFrame);
+    // Returns the bytes of the evicted mesh, 0 when every resident mesh was used since keepFrame.
+    uint64_t evictLeastRecentlyUsed(uint64_t keepFrame);
+
+private:
+    SlvnGeometryPool* mPool;
+    SlvnUploadManager* mUploader;
+    SlvnDeletionQueue* mDeletionQueue;
+
+    std::deque<Entry> mMeshes;
+    uint64_t mFrame;
+    uint32_t mInFlight;
+    SlvnStreamingStats mStats;
+    double mTotalLoadMs;
+
+    std::mutex mLoadMutex;
+    std::vector<LoadResult> mFinishedLoads;
+    std::vector<uint32_t> mCandidates;
+    SlvnThread mLoader;
+};
+
+} // slvn_tech
+
+#endif // SLVNMESHSTREAMER_H
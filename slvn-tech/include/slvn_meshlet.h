@@ -0,0 +1,139 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNMESHLET_H
+#define SLVNMESHLET_H
+
+#include <vector>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#include <core.h>
+#include <slvn_bounds.h>
+
+namespace slvn_tech
+{
+
+// @brief
+// Small cluster of triangles stored as a contiguous range of a mesh index buffer, with
+// a bounding sphere and a normal cone for culling. The cone is given in the form
+// cull if dot(center - eye, axis) >= cutoff * length(center - eye) + radius, a cutoff
+// of 1 never culls.
+struct SlvnMeshlet
+{
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+    glm::vec3 mCenter;
+    float mRadius;
+    glm::vec3 mConeAxis;
+    float mConeCutoff;
+};
+
+struct SlvnIndexRange
+{
+    uint32_t mFirstIndex;
+    uint32_t mIndexCount;
+};
+
+// @brief
+// SlvnMeshletBuilder splits an index range into meshlets of at most mMaxVertices vertices
+// and mMaxTriangles triangles. A meshlet grows from a seed triangle over shared vertices,
+// preferring triangles that add few new vertices and face the way the meshlet already does,
+// which keeps its bounds small and its normal cone narrow. Triangles of the range are
+// reordered so that every meshlet is contiguous. Front faces are counter clockwise.
+class SlvnMeshletBuilder
+{
+public:
+    SlvnMeshletBuilder();
+    ~SlvnMeshletBuilder();
+
+    // Appends the meshlets of the range to meshlets.
+    SlvnResult Build(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount,
+        std::vector<SlvnMeshlet>& meshlets);
+
+public:
+    uint32_t mMaxVertices;
+    uint32_t mMaxTriangles;
+    // Weight of facing away from the meshlet against adding one more vertex.
+    float mConeWeight;
+};
+
+struct SlvnMeshletCullStats
+{
+    uint32_t mTestedCount;
+    uint32_t mFrustumCulledCount;
+    uint32_t mBackfaceCulledCount;
+    float mCullMs;
+};
+
+// @brief
+// SlvnMeshletCuller tests the meshlets of an object against the view frustum and their
+// normal cones, four meshlets at a time with SSE. Bounds of every four meshlets are kept
+// together in SoA form, so a group is two cache lines read as one stream.
+// Tests run in object space, so model matrices must not shear or scale non-uniformly.
+// Visible meshlets are returned as index ranges, neighbouring ones merged into one range.
+class SlvnMeshletCuller
+{
+public:
+    SlvnMeshletCuller();
+    ~SlvnMeshletCuller();
+
+    void SetMeshlets(const std::vector<SlvnMeshlet>& meshlets);
+
+    // Appends the visible ranges of meshlets [firstMeshlet, firstMeshlet + meshletCount) to ranges and
+    // returns their count. Safe to call concurrently.
+    uint32_t Cull(uint32_t firstMeshlet, uint32_t meshletCount, const glm::mat4& model, const glm::mat4& viewProjection,
+        const glm::vec3& eye, std::vector<SlvnIndexRange>& ranges);
+
+    SlvnMeshletCullStats GetStats() const;
+    void ResetStats();
+
+private:
+    struct BoundsGroup
+    {
+        float mCenterX[4];
+        float mCenterY[4];
+        float mCenterZ[4];
+        float mRadius[4];
+        float mAxisX[4];
+        float mAxisY[4];
+        float mAxisZ[4];
+        float mCutoff[4];
+    };
+
+    std::vector<SlvnIndexRange> mRanges;
+    std::vector<BoundsGroup> mGroups;
+
+    std::atomic<uint32_t> mTestedCount;
+    std::atomic<uint32_t> mFrustumCulledCount;
+    std::atomic<uint32_t> mBackfaceCulledCount;
+    std::atomic<uint64_t> mCullNs;
+};
+
+} // slvn_tech
+
+#endif // SLVNMESHLET_H
@@ -0,0 +1,128 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNOBJPARSER_H
+#define SLVNOBJPARSER_H
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+struct SlvnObjStats
+{
+    uint64_t mFileBytes;
+    uint32_t mLineCount;
+    uint32_t mPositionCount;
+    uint32_t mNormalCount;
+    uint32_t mTexCoordCount;
+    uint32_t mFaceCount;
+    uint32_t mTriangleCount;
+    float mParseMs;
+};
+
+// First occurrence of value in [begin, end), or end. 16 bytes at a time with SSE2 where available.
+const char* SlvnFindByte(const char* begin, const char* end, char value);
+
+// @brief
+// SlvnObjParser reads Wavefront OBJ positions, normals and faces from a memory mapped file.
+// The file is split into line-aligned chunks that are parsed in parallel on the given threadpool;
+// face corners keep their OBJ indices until a prefix sum over the chunk counts gives every chunk
+// its global position, normal, vertex and index bases, after which the chunks resolve their faces
+// and write them into the merged output in parallel as well. Lines are found with SlvnFindByte and
+// numbers are parsed in place with std::from_chars. Like objl every face corner becomes a vertex of
+// its own; polygons are triangulated as fans and faces without normals get the normal of their
+// plane. Texture coordinates are counted, groups and materials are skipped.
+class SlvnObjParser
+{
+public:
+    SlvnObjParser();
+    ~SlvnObjParser();
+
+    // Appends to vertices and indices. Without a threadpool everything runs on the calling thread.
+    // The threadpool must not be running other jobs, Parse() waits for all of them.
+    SlvnResult Parse(const std::string& path, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+        SlvnThreadpool* threadpool = nullptr);
+    SlvnResult Parse(const char* data, size_t size, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+        SlvnThreadpool* threadpool = nullptr);
+
+    inline const SlvnObjStats& GetStats() const { return mStats; }
+
+public:
+    // Smaller files are parsed as one chunk, the fork and merge would cost more than it saves.
+    static constexpr size_t cMinChunkSize = 256 * 1024;
+
+private:
+    // Indices are 0-based; relative OBJ indices are stored relative to the chunk until the bases are known.
+    struct Corner
+    {
+        int32_t mPosition;
+        int32_t mNormal;
+        uint8_t mRelative;
+    };
+
+    struct Chunk
+    {
+        const char* mBegin;
+        const char* mEnd;
+        std::vector<glm::vec3> mPositions;
+        std::vector<glm::vec3> mNormals;
+        std::vector<Corner> mCorners;
+        std::vector<uint32_t> mFaceSizes;
+        uint32_t mTexCoordCount;
+        uint32_t mLineCount;
+        uint32_t mTriangleCount;
+        // Local line of the first error, 0 if there was none.
+        uint32_t mErrorLine;
+
+        uint32_t mLineBase;
+        uint32_t mPositionBase;
+        uint32_t mNormalBase;
+        size_t mVertexBase;
+        size_t mIndexBase;
+    };
+
+    static void scanChunk(Chunk& chunk);
+    bool emitChunk(const Chunk& chunk, SlvnVertex* vertices, uint32_t vertexOffset, uint32_t* indices) const;
+    template<typename Job>
+    void runChunks(SlvnThreadpool* threadpool, Job job);
+
+private:
+    std::vector<Chunk> mChunks;
+    std::vector<glm::vec3> mPositions;
+    std::vector<glm::vec3> mNormals;
+    SlvnObjStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNOBJPARSER_H
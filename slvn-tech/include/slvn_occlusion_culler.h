@@ -0,0 +1,133 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNOCCLUSIONCULLER_H
+#define SLVNOCCLUSIONCULLER_H
+
+#include <vector>
+#include <atomic>
+
+#include <core.h>
+#include <slvn_bounds.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+struct SlvnOcclusionStats
+{
+    uint32_t mOccluderCount;
+    uint32_t mOccluderTriangles;
+    uint32_t mRasterizedTriangles;
+    uint32_t mTestedCount;
+    uint32_t mCulledCount;
+    float mRasterizeMs;
+    float mTestMs;
+};
+
+// @brief
+// SlvnOcclusionCuller rasterizes a small set of occluder meshes into a low resolution
+// depth buffer on the CPU and tests screen space bounds of objects against it.
+// The buffer is split into horizontal bands which are rasterized in parallel on the
+// threadpool, and a max depth per 8x8 tile (hierarchical Z) lets most occluded boxes
+// be rejected without touching individual pixels.
+// Depth follows the 0..1 clip space convention, smaller is closer.
+class SlvnOcclusionCuller
+{
+public:
+    SlvnOcclusionCuller();
+    ~SlvnOcclusionCuller();
+
+    SlvnResult Initialize(uint32_t width, uint32_t height, SlvnThreadpool* threadpool);
+    SlvnResult Deinitialize();
+
+    void BeginFrame(const glm::mat4& viewProjection);
+    // Mesh data has to stay alive until Rasterize() has returned.
+    void AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount, const glm::mat4& model);
+    void Rasterize();
+
+    // Safe to call concurrently once Rasterize() has returned.
+    bool IsVisible(const SlvnAabb& worldBounds);
+
+    SlvnOcclusionStats GetStats() const;
+    inline uint32_t GetWidth() const { return mWidth; }
+    inline uint32_t GetHeight() const { return mHeight; }
+    inline const std::vector<float>& GetDepth() const { return mDepth; }
+
+private:
+    struct Occluder
+    {
+        const std::vector<glm::vec3>* mPositions;
+        const std::vector<uint32_t>* mIndices;
+        uint32_t mFirstIndex;
+        uint32_t mIndexCount;
+        glm::mat4 mModelViewProjection;
+    };
+
+    struct Triangle
+    {
+        float mX[3];
+        float mY[3];
+        float mZ[3];
+        int32_t mMinY;
+        int32_t mMaxY;
+    };
+
+    void setupTriangles(uint32_t threadIndex);
+    void rasterizeBand(uint32_t band);
+    void rasterizeTriangle(const Triangle& triangle, int32_t bandMinY, int32_t bandMaxY);
+    void updateHiZ(uint32_t band);
+
+private:
+    static constexpr uint32_t cTileSize = 8;
+
+    SlvnState mState;
+    SlvnThreadpool* mThreadpool;
+
+    uint32_t mWidth;
+    uint32_t mHeight;
+    uint32_t mTilesX;
+    uint32_t mTilesY;
+    uint32_t mBandCount;
+    uint32_t mBandHeight;
+
+    glm::mat4 mViewProjection;
+    std::vector<Occluder> mOccluders;
+    std::vector<std::vector<Triangle>> mThreadTriangles;
+
+    std::vector<float> mDepth;
+    std::vector<float> mTileMaxDepth;
+
+    uint32_t mOccluderTriangles;
+    float mRasterizeMs;
+    std::atomic<uint32_t> mTestedCount;
+    std::atomic<uint32_t> mCulledCount;
+    std::atomic<uint64_t> mTestNs;
+};
+
+} // slvn_tech
+
+#endif // SLVNOCCLUSIONCULLER_H
@@ -38,6 +38,23 @@
 #include <slvn_threadpool.inl>
 #include <slvn_input_manager.h>
 #include <slvn_buffer.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_memory_reporter.h>
+#include <slvn_upload_manager.h>
+#include <slvn_frame_ring.h>
+#include <slvn_scene_buffer.h>
+#include <slvn_geometry_pool.h>
+#include <slvn_mesh_streamer.h>
+#include <slvn_asset_pipeline.h>
+#include <slvn_asset_manager.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_defragmenter.h>
+#include <slvn_bvh.h>
+#include <slvn_occlusion_culler.h>
+#include <slvn_lod.h>
+#include <slvn_meshlet.h>
+#include <slvn_draw_packet.h>
+#include <slvn_command_encoder.h>
 #include <core.h>
 
 
@@ -61,11 +78,23 @@ private:
     SlvnResult initializeSemaphores();
     SlvnResult initializeThreading();
     SlvnResult initializeSubmitInfo();
-    SlvnResult loadObjects(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
-    SlvnResult prepareBuffers();
+    SlvnResult loadObjects(const std::string& path, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices, SlvnLodMesh& lods,
+        std::vector<SlvnMeshlet>* meshlets, SlvnThreadpool* threadpool);
+    SlvnResult requestAssets();
+    void onMeshLoaded(SlvnAssetHandle handle, SlvnResult result, const SlvnMeshAsset& asset);
+    SlvnResult buildFallbackMesh(SlvnMeshAsset& asset) const;
+    SlvnResult loadStreamedMesh(SlvnStreamedMeshData& data);
+    SlvnVertexFormat getVertexFormat() const;
+    bool isStatsFrame() const;
+    SlvnResult initializeScene();
     void createCommandWorkers();
     void render();
-    void threadRender(uint32_t threadIndex, uint32_t cmdBufferIndex, uint32_t vertexesSize, VkCommandBufferInheritanceInfo inheritanceInfo);
+    void updateObjects(uint32_t threadIndex);
+    void cullObjects();
+    void occludeObjects();
+    void selectLods();
+    void buildDrawPackets();
+    void threadRender(uint32_t threadIndex, uint32_t firstPacket, uint32_t packetCount, VkCommandBufferInheritanceInfo inheritanceInfo);
 
 private:
     VkQueue mQueue;
@@ -88,14 +117,61 @@ private:
 
     SlvnCommandWorker mPrimaryCmdWorker;
     std::vector<SlvnCommandWorker> mSecondaryCmdWorkers;
+    std::vector<SlvnCommandEncoder> mEncoders;
 
     int mIdentifier;
     uint32_t mVerticesAmount;
-    SlvnBuffer mVertexBuffer;
-    SlvnBuffer mIndiceBuffer;
+    SlvnMemoryAllocator mMemoryAllocator;
+    SlvnMemoryReporter mMemoryReporter;
+    SlvnUploadManager mUploadManager;
+    SlvnFrameRing mFrameRing;
+    // One instance record per scene object, indexed by its proxy.
+    SlvnSceneBuffer mSceneBuffer;
+    SlvnDeletionQueue mDeletionQueue;
+    SlvnDefragmenter mDefragmenter;
+    // Frames submitted so far; resources used by the frame being recorded have mFrameNumber + 1 as last use.
+    uint64_t mFrameNumber;
+    SlvnGeometryPool mGeometryPool;
+    // The scene mesh arrives through the asset pipeline, nothing is drawn before it is ready.
+    SlvnAssetPipeline mAssetPipeline;
+    SlvnAssetManager mAssetManager;
+    // Shared through the asset manager, every scene object draws this one mesh.
+    SlvnAssetHandle mMeshAsset;
+    // Resident for good when streaming is off.
+    uint32_t mMesh;
+    SlvnMeshStreamer mMeshStreamer;
+    uint32_t mStreamedMesh;
+    // Coarsest detail level, drawn while the streamed mesh is not resident.
+    uint32_t mFallbackMesh;
+    // Pool mesh the packets of the current frame draw.
+    uint32_t mDrawMesh;
+    bool mVertexPulling;
     VkSubmitInfo mSubmitInfo;
     VkPipelineStageFlags mFlags;
     VkFence mRenderFence;
+
+    SlvnAabb mMeshBounds;
+    SlvnBvh mSceneBvh;
+    std::vector<ObjectData*> mProxyObjects;
+    std::vector<uint32_t> mProxyWorkers;
+    std::vector<uint32_t> mVisibleProxies;
+
+    SlvnOcclusionCuller mOcclusionCuller;
+    std::vector<glm::vec3> mMeshPositions;
+    std::vector<uint32_t> mMeshIndices;
+    std::vector<uint32_t> mOccluderProxies;
+
+    SlvnLodMesh mMeshLods;
+    SlvnLodSelector mLodSelector;
+
+    std::vector<SlvnMeshlet> mMeshlets;
+    SlvnMeshletCuller mMeshletCuller;
+    // Visible meshlet ranges of the frame, packets index into mDrawRanges once the threads are merged.
+    std::vector<std::vector<SlvnIndexRange>> mThreadRanges;
+    std::vector<SlvnIndexRange> mDrawRanges;
+
+    SlvnDrawSorter mDrawSorter;
+    std::vector<SlvnDrawPacket> mDrawPackets;
 };
 
 } // slvn_tech
@@ -0,0 +1,128 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNSCENEBUFFER_H
+#define SLVNSCENEBUFFER_H
+
+#include <vector>
+#include <atomic>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_frame_ring.h>
+#include <slvn_shader_module.h>
+
+namespace slvn_tech
+{
+
+// Per-object GPU record, std430 compatible; scene_scatter.comp declares the same layout.
+struct SlvnInstanceRecord
+{
+    glm::mat4 mModel;
+    glm::vec4 mColor;
+};
+
+struct SlvnSceneBufferStats
+{
+    uint32_t mCapacity;
+    // Last Flush().
+    uint32_t mDirtyCount;
+    uint64_t mUploadedBytes;
+    uint64_t mTotalUploadedBytes;
+    uint32_t mFailedFlushes;
+};
+
+// @brief
+// SlvnSceneBuffer is a persistent DEVICE_LOCAL storage buffer with one SlvnInstanceRecord per object
+// and a CPU mirror of it. Update() marks a record dirty; Flush() packs only the dirty records and
+// their slots into the frame ring and records a compute dispatch that scatters them into place,
+// so the bytes uploaded per frame follow the amount of changed objects rather than the total.
+class SlvnSceneBuffer
+{
+public:
+    SlvnSceneBuffer();
+    ~SlvnSceneBuffer();
+
+    SlvnResult Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnFrameRing* frameRing, uint32_t capacity);
+    SlvnResult Deinitialize();
+
+    // Safe to call concurrently for distinct records.
+    void Update(uint32_t record, const SlvnInstanceRecord& data);
+    inline const SlvnInstanceRecord& Get(uint32_t record) const { return mRecords[record]; }
+
+    // Records the scatter into cmd, which has to be outside of a render pass. The records are
+    // visible to shader reads in dstStage afterwards. When the frame ring is full the records
+    // stay dirty for the next flush.
+    SlvnResult Flush(VkCommandBuffer cmd, VkPipelineStageFlags dstStage);
+
+    inline VkBuffer GetBuffer() const { return mBuffer; }
+    inline uint32_t GetDirtyCount() const { return mDirtyCount.load(std::memory_order_relaxed); }
+    inline SlvnSceneBufferStats GetStats() const { return mStats; }
+
+public:
+    static constexpr uint32_t cGroupSize = 64;
+
+private:
+    struct ScatterPushConstant
+    {
+        uint32_t mCount;
+        // In records and words from the start of the frame ring.
+        uint32_t mFirstRecord;
+        uint32_t mFirstIndex;
+    };
+
+    SlvnResult createPipeline();
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    SlvnFrameRing* mFrameRing;
+    uint32_t mCapacity;
+
+    VkBuffer mBuffer;
+    SlvnAllocation mAllocation;
+
+    std::vector<SlvnInstanceRecord> mRecords;
+    // Distinct records are distinct bytes, concurrent updates need no locking.
+    std::vector<uint8_t> mDirty;
+    std::vector<uint32_t> mDirtyList;
+    std::atomic<uint32_t> mDirtyCount;
+
+    SlvnShaderModule mShader;
+    VkDescriptorSetLayout mDescriptorSetLayout;
+    VkDescriptorPool mDescriptorPool;
+    VkDescriptorSet mDescriptorSet;
+    VkPipelineLayout mPipelineLayout;
+    VkPipeline mPipeline;
+
+    SlvnSceneBufferStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNSCENEBUFFER_H
@@ -63,6 +63,69 @@ public:
 
     uint16_t mMaxThreads;
 
+    // Total amount of scene objects, spread evenly over the render threads.
+    uint32_t mSceneObjectCount;
+
+    bool mOcclusionCulling;
+    uint16_t mOcclusionBufferWidth;
+    uint16_t mOcclusionBufferHeight;
+    // Amount of nearest visible objects rasterized as occluders each frame.
+    uint32_t mOccluderCount;
+
+    // Triangle count of every cooked detail level relative to the source mesh, level 0 first, and the
+    // largest simplification error of a level as a fraction of the mesh size.
+    std::vector<float> mLodTriangleRatios;
+    float mLodMaxError;
+
+    // Meshes are cooked into meshlets of at most this many vertices and triangles. With culling on,
+    // meshlets outside the frustum or facing away from the camera are skipped when drawing.
+    bool mMeshletCulling;
+    uint32_t mMeshletMaxVertices;
+    uint32_t mMeshletMaxTriangles;
+    // Largest allowed projected geometric error of a detail level, in pixels.
+    float mLodPixelError;
+    float mLodHysteresis;
+
+    // Vertex and index data in DEVICE_LOCAL memory through staging uploads, otherwise HOST_VISIBLE.
+    bool mDeviceLocalGeometry;
+    // Capacity of the shared vertex and index buffers all static meshes are packed into.
+    uint32_t mGeometryPoolVertexCount;
+    uint32_t mGeometryPoolIndexCount;
+    // Vertex shader fetches vertices through buffer device addresses when the device supports it,
+    // optionally from the 20 byte compact or the 12 byte quantized format, quantized taking precedence.
+    bool mVertexPulling;
+    bool mCompactVertices;
+    bool mQuantizedVertices;
+    // 16-bit index buffers for meshes of up to 65536 vertices.
+    bool mShortIndices;
+
+    // Bytes of per-frame dynamic data each frame in flight can sub-allocate from the frame ring.
+    uint32_t mFrameRingSize;
+
+    // Frames between two prints of the frame statistics, 0 disables them.
+    uint32_t mStatsInterval;
+
+    // CSV file the per-frame GPU memory report is written to, empty disables the report.
+    std::string mMemoryReportPath;
+
+    // Incremental compaction of memory blocks, bounded per frame.
+    bool mDefragmentation;
+    float mDefragmentationBudgetMs;
+    uint32_t mDefragmentationMaxBytes;
+
+    // Meshes are loaded on demand and evicted least recently used once the streamed bytes exceed the budget;
+    // the coarsest detail level stays resident and is drawn while the full mesh is in flight.
+    bool mMeshStreaming;
+    uint32_t mStreamingBudget;
+    uint32_t mStreamingMaxLoads;
+
+    // Assets load in the background while frames are rendered; files are read ahead on an I/O thread, cooked
+    // on the decode threads and at most the upload budget of bytes per frame goes into the geometry pool.
+    uint32_t mAssetDecodeThreads;
+    uint32_t mAssetUploadBudget;
+    // Bytes of unreferenced assets kept around for the next request of the same file.
+    uint32_t mAssetCacheBudget;
+
 private:
     SlvnSettings();
     ~SlvnSettings();
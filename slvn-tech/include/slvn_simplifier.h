@@ -0,0 +1,97 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNSIMPLIFIER_H
+#define SLVNSIMPLIFIER_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core.h>
+#include <slvn_lod.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+// @brief
+// SlvnMeshSimplifier reduces indexed triangle meshes with quadric error metrics (Garland and
+// Heckbert 1997). Every edge collapse moves a vertex onto one of its neighbours, so the
+// simplified triangles reference the input vertices and all detail levels share one vertex
+// buffer. Collapses run in passes: the cheapest collapse of every vertex is found, the
+// candidates are sorted by error and applied while they stay under the error bound, do not
+// flip a triangle and do not touch a vertex another collapse of the same pass changed.
+// Vertices on attribute seams, where several vertices share a position, and on open borders
+// never move, so seams and silhouettes of open meshes are kept.
+class SlvnMeshSimplifier
+{
+public:
+    SlvnMeshSimplifier();
+    ~SlvnMeshSimplifier();
+
+    // Simplifies towards targetIndexCount indices without exceeding maxError, in object space
+    // distance. error returns the largest error of the applied collapses.
+    SlvnResult Simplify(const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices, uint32_t targetIndexCount,
+        float maxError, std::vector<uint32_t>& result, float& error);
+
+    // Appends a detail level for every ratio after the first to indices; indices must hold only
+    // level 0. Levels are simplified from level 0 in parallel on the threadpool when one is given.
+    // The chain ends early once the error bound stops a level from getting coarser.
+    static SlvnResult BuildLodChain(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+        const std::vector<float>& triangleRatios, float maxError, SlvnLodMesh& mesh, SlvnThreadpool* threadpool = nullptr);
+
+private:
+    // Symmetric 4x4 quadric, area weighted; mWeight is the summed area.
+    struct Quadric
+    {
+        float mA00, mA11, mA22, mA01, mA02, mA12;
+        float mB0, mB1, mB2;
+        float mC;
+        float mWeight;
+    };
+
+    void prepare(const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices);
+    bool flips(uint32_t vertex, uint32_t target, const std::vector<uint32_t>& indices) const;
+
+private:
+    static constexpr uint32_t cInvalid = UINT32_MAX;
+
+    // Positions scaled to the unit cube, and the scale that brings errors back to object space.
+    std::vector<glm::vec3> mPositions;
+    float mScale;
+    // Vertices sharing a position share the one of the lowest index and its quadric.
+    std::vector<uint32_t> mCanonical;
+    std::vector<uint8_t> mLocked;
+    std::vector<Quadric> mQuadrics;
+
+    std::vector<uint32_t> mAdjacencyOffsets;
+    std::vector<uint32_t> mAdjacency;
+};
+
+} // slvn_tech
+
+#endif // SLVNSIMPLIFIER_H
@@ -0,0 +1,110 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNTLSF_H
+#define SLVNTLSF_H
+
+#include <vector>
+#include <stdint.h>
+
+namespace slvn_tech
+{
+
+struct SlvnTlsfStats
+{
+    uint64_t mSize;
+    uint64_t mUsed;
+    uint32_t mAllocationCount;
+    uint32_t mFreeRegionCount;
+    uint64_t mLargestFreeRegion;
+};
+
+// @brief
+// SlvnTlsfAllocator hands out offsets inside a range of fixed size with a two level
+// segregated fit scheme. Free regions are bucketed by the most significant bit of their
+// size and 16 linear subdivisions below it, two bitmaps find a fitting bucket in constant
+// time and neighbouring free regions are merged on free.
+// It never touches the memory itself, so the same allocator serves any kind of heap.
+class SlvnTlsfAllocator
+{
+public:
+    static constexpr uint32_t cInvalid = UINT32_MAX;
+
+    SlvnTlsfAllocator();
+    ~SlvnTlsfAllocator();
+
+    void Initialize(uint64_t size);
+
+    // Returns a handle for Free(), or cInvalid when no free region fits.
+    // Alignment has to be a power of two.
+    uint32_t Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+    void Free(uint32_t handle);
+
+    inline bool IsEmpty() const { return mAllocationCount == 0; }
+    inline uint64_t GetUsed() const { return mUsed; }
+    SlvnTlsfStats GetStats() const;
+
+private:
+    struct Node
+    {
+        uint64_t mOffset;
+        uint64_t mSize;
+        uint32_t mPrevPhysical;
+        uint32_t mNextPhysical;
+        uint32_t mPrevFree;
+        uint32_t mNextFree;
+        bool mFree;
+    };
+
+    uint32_t createNode(uint64_t offset, uint64_t size);
+    void releaseNode(uint32_t node);
+    void insertFree(uint32_t node);
+    void removeFree(uint32_t node);
+    uint32_t findFree(uint64_t size) const;
+    void split(uint32_t node, uint64_t size, bool keepFront);
+
+private:
+    static constexpr uint32_t cSecondLevelBits = 4;
+    static constexpr uint32_t cSecondLevelCount = 1 << cSecondLevelBits;
+    // Every region size is a multiple of the minimum, which keeps bucket math exact.
+    static constexpr uint32_t cMinShift = cSecondLevelBits;
+    static constexpr uint64_t cMinSize = uint64_t(1) << cMinShift;
+    static constexpr uint32_t cFirstLevelCount = 64 - cMinShift;
+
+    std::vector<Node> mNodes;
+    std::vector<uint32_t> mUnusedNodes;
+    uint32_t mFreeHeads[cFirstLevelCount][cSecondLevelCount];
+    uint64_t mFirstLevelBitmap;
+    uint32_t mSecondLevelBitmap[cFirstLevelCount];
+
+    uint64_t mSize;
+    uint64_t mUsed;
+    uint32_t mAllocationCount;
+};
+
+} // slvn_tech
+
+#endif // SLVNTLSF_H
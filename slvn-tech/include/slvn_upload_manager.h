@@ -0,0 +1,120 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNUPLOADMANAGER_H
+#define SLVNUPLOADMANAGER_H
+
+#include <vector>
+#include <deque>
+
+#include <vulkan/vulkan.h>
+
+#include <core.h>
+#include <slvn_memory_allocator.h>
+
+namespace slvn_tech
+{
+
+// @brief
+// SlvnUploadManager copies data into DEVICE_LOCAL buffers through host visible staging memory.
+// Uploads are collected into one command buffer per batch and submitted to the transfer queue,
+// a fence per batch is polled without blocking. When the transfer queue belongs to another
+// queue family the buffers are released there and acquired on the graphics queue by
+// RecordAcquire(), which has to be recorded before the buffers are used.
+// Not thread safe; Upload(), Submit() and RecordAcquire() are called from the render thread.
+class SlvnUploadManager
+{
+public:
+    SlvnUploadManager();
+    ~SlvnUploadManager();
+
+    SlvnResult Initialize(VkDevice device, SlvnMemoryAllocator* allocator, VkQueue transferQueue,
+        uint32_t transferQueueFamilyIndex, uint32_t graphicsQueueFamilyIndex);
+    SlvnResult Deinitialize();
+
+    // Data is copied into staging memory immediately, the copy itself runs on Submit().
+    SlvnResult Upload(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size,
+        VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    // Returns the id of the submitted batch, or the last id if nothing was pending.
+    uint64_t Submit();
+    // Retires finished batches and records their acquire barriers into cmdBuffer.
+    void RecordAcquire(VkCommandBuffer cmdBuffer);
+    inline bool IsComplete(uint64_t batch) const { return batch <= mCompletedBatch; }
+    // Id the uploads queued since the last Submit() will be submitted as.
+    inline uint64_t GetOpenBatch() const { return mNextBatch; }
+    // Blocks until batch has finished on the transfer queue; it still needs RecordAcquire().
+    void Wait(uint64_t batch);
+
+    inline bool IsDedicatedQueue() const { return mTransferQueueFamilyIndex != mGraphicsQueueFamilyIndex; }
+
+public:
+    static constexpr VkDeviceSize cStagingChunkSize = 16ull * 1024 * 1024;
+
+private:
+    struct StagingChunk
+    {
+        VkBuffer mBuffer;
+        SlvnAllocation mAllocation;
+        VkDeviceSize mSize;
+        VkDeviceSize mUsed;
+    };
+
+    struct Batch
+    {
+        uint64_t mId;
+        VkCommandBuffer mCmdBuffer;
+        VkFence mFence;
+        std::vector<StagingChunk> mStaging;
+        std::vector<VkBufferMemoryBarrier> mBarriers;
+        VkPipelineStageFlags mDstStages;
+    };
+
+    SlvnResult beginBatch();
+    SlvnResult reserveStaging(VkDeviceSize size, StagingChunk*& chunk);
+    void retire(Batch& batch);
+
+private:
+    VkDevice mDevice;
+    SlvnMemoryAllocator* mAllocator;
+    VkQueue mTransferQueue;
+    uint32_t mTransferQueueFamilyIndex;
+    uint32_t mGraphicsQueueFamilyIndex;
+    VkCommandPool mCmdPool;
+
+    bool mRecording;
+    Batch mOpenBatch;
+    std::deque<Batch> mInFlight;
+    std::vector<Batch> mFreeBatches;
+    std::vector<VkBufferMemoryBarrier> mPendingAcquires;
+    VkPipelineStageFlags mPendingDstStages;
+
+    uint64_t mNextBatch;
+    uint64_t mCompletedBatch;
+};
+
+} // slvn_tech
+
+#endif // SLVNUPLOADMANAGER_H
@@ -0,0 +1,83 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNVERTEXFORMAT_H
+#define SLVNVERTEXFORMAT_H
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+// Vertex layouts the pulling vertex shader decodes, the values are shared with the shader.
+// cFloat:   SlvnVertex as is, 36 bytes.
+// cCompact: float3 position, octahedral snorm16x2 normal, unorm8x4 color, 20 bytes.
+// cQuantized: unorm16x3 position within the mesh bounds, octahedral snorm16x2 normal, 12 bytes.
+//             The color is left out, shading uses the per draw color anyway.
+enum class SlvnVertexFormat : uint32_t
+{
+    cFloat = 0,
+    cCompact,
+    cQuantized,
+    cCount
+};
+
+// Decodes quantized positions, position = mOffset + mScale * unorm16 position.
+// Identity for the other formats.
+struct SlvnVertexQuantization
+{
+    glm::vec3 mOffset = glm::vec3(0.0f);
+    glm::vec3 mScale = glm::vec3(1.0f);
+};
+
+inline uint32_t SlvnGetVertexStride(SlvnVertexFormat format)
+{
+    switch (format)
+    {
+    case SlvnVertexFormat::cCompact:
+        return 20;
+    case SlvnVertexFormat::cQuantized:
+        return 12;
+    default:
+        return sizeof(SlvnVertex);
+    }
+}
+
+// Octahedral mapping of a unit vector to two snorm16 values packed into one word.
+uint32_t SlvnEncodeOctahedral(const glm::vec3& normal);
+glm::vec3 SlvnDecodeOctahedral(uint32_t packed);
+
+// Quantized vertices are fitted to their bounds, the decode parameters are returned in quantization.
+void SlvnEncodeVertices(SlvnVertexFormat format, const std::vector<SlvnVertex>& vertices, std::vector<uint8_t>& data,
+    SlvnVertexQuantization* quantization = nullptr);
+
+} // slvn_tech
+
+#endif // SLVNVERTEXFORMAT_H
@@ -0,0 +1,75 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SLVNVERTEXWELD_H
+#define SLVNVERTEXWELD_H
+
+#include <vector>
+
+#include <core.h>
+
+namespace slvn_tech
+{
+
+struct SlvnWeldStats
+{
+    uint32_t mInputVertexCount;
+    uint32_t mOutputVertexCount;
+    float mWeldMs;
+
+    inline float GetRatio() const
+    {
+        return mOutputVertexCount > 0 ? static_cast<float>(mInputVertexCount) / static_cast<float>(mOutputVertexCount) : 1.0f;
+    }
+};
+
+// @brief
+// SlvnVertexWelder merges bitwise identical vertices, such as the per corner vertices the OBJ
+// parser emits, into one and remaps the indices to them. Vertices are looked up in an open
+// addressing table with linear probing, sized to twice the vertex count; the surviving vertices
+// keep the order of their first use.
+class SlvnVertexWelder
+{
+public:
+    SlvnVertexWelder();
+    ~SlvnVertexWelder();
+
+    // Compacts vertices in place, indices must only reference vertices in the array.
+    SlvnResult Weld(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices);
+
+    inline const SlvnWeldStats& GetStats() const { return mStats; }
+
+private:
+    static constexpr uint32_t cEmpty = UINT32_MAX;
+
+    std::vector<uint32_t> mTable;
+    std::vector<uint32_t> mRemap;
+    SlvnWeldStats mStats;
+};
+
+} // slvn_tech
+
+#endif // SLVNVERTEXWELD_H
@@ -1,3 +1,5 @@
 C:\VulkanSDK\1.2.176.1\Bin32\glslc.exe default_vertex_shader.vert -o default_vertex_shader.spv
 C:\VulkanSDK\1.2.176.1\Bin32\glslc.exe default_fragment_shader.frag -o default_fragment_shader.spv
+C:\VulkanSDK\1.2.176.1\Bin32\glslc.exe default_vertex_pull_shader.vert -o default_vertex_pull_shader.spv
+C:\VulkanSDK\1.2.176.1\Bin32\glslc.exe scene_scatter.comp -o scene_scatter.spv
 pause
\ No newline at end of file
@@ -0,0 +1,82 @@
+#version 450
+#extension GL_EXT_buffer_reference : require
+
+// Vertices are read from a buffer device address instead of vertex input,
+// the layouts match SlvnVertexFormat.
+layout (buffer_reference, std430, buffer_reference_align = 4) readonly buffer VertexWords
+{
+	uint words[];
+};
+
+layout (push_constant) uniform PushConstants
+{
+	mat4 mvp;
+	vec4 positionOffset;
+	vec4 positionScale;
+	vec3 color;
+	uint vertexFormat;
+	VertexWords vertices;
+} pushConstants;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+layout (location = 3) out vec3 outViewVec;
+layout (location = 4) out vec3 outLightVec;
+
+const uint cFormatFloat = 0;
+const uint cFormatCompact = 1;
+const uint cFormatQuantized = 2;
+
+vec3 readVec3(uint word)
+{
+	return vec3(uintBitsToFloat(pushConstants.vertices.words[word]),
+		uintBitsToFloat(pushConstants.vertices.words[word + 1]),
+		uintBitsToFloat(pushConstants.vertices.words[word + 2]));
+}
+
+vec3 decodeOctahedral(uint packed)
+{
+	vec2 p = unpackSnorm2x16(packed);
+	vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+void main()
+{
+	vec3 inPosition;
+	vec3 inNormal;
+	if (pushConstants.vertexFormat == cFormatCompact)
+	{
+		uint base = gl_VertexIndex * 5;
+		inPosition = readVec3(base);
+		inNormal = decodeOctahedral(pushConstants.vertices.words[base + 3]);
+	}
+	else if (pushConstants.vertexFormat == cFormatQuantized)
+	{
+		uint base = gl_VertexIndex * 3;
+		vec3 quantized = vec3(unpackUnorm2x16(pushConstants.vertices.words[base]),
+			unpackUnorm2x16(pushConstants.vertices.words[base + 1]).x);
+		inPosition = pushConstants.positionOffset.xyz + quantized * pushConstants.positionScale.xyz;
+		inNormal = decodeOctahedral(pushConstants.vertices.words[base + 2]);
+	}
+	else
+	{
+		uint base = gl_VertexIndex * 9;
+		inPosition = readVec3(base);
+		inNormal = readVec3(base + 3);
+	}
+
+	outColor = pushConstants.color;
+
+	gl_Position = pushConstants.mvp * vec4(inPosition, 1.0);
+
+	vec4 pos = pushConstants.mvp * vec4(inPosition, 1.0);
+
+	outNormal = mat3(pushConstants.mvp) * inNormal;
+
+	vec3 lPos = vec3(0.0);
+	outLightVec = lPos - pos.xyz;
+	outViewVec = -pos.xyz;
+}
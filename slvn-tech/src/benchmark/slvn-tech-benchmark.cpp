@@ -0,0 +1,73 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+
+namespace
+{
+
+struct SlvnBenchmarkEntry
+{
+    const char* mName;
+    void (*mFunction)();
+};
+
+const std::vector<SlvnBenchmarkEntry> cBenchmarks =
+{
+    { "bvh", slvn_tech::SlvnBvhBenchmark },
+    { "occlusion", slvn_tech::SlvnOcclusionBenchmark },
+    { "lod", slvn_tech::SlvnLodBenchmark },
+    { "simplify", slvn_tech::SlvnSimplifierBenchmark },
+    { "draw_sort", slvn_tech::SlvnDrawSortBenchmark },
+    { "memory", slvn_tech::SlvnMemoryBenchmark },
+    { "geometry_placement", slvn_tech::SlvnGeometryPlacementBenchmark },
+    { "frame_ring", slvn_tech::SlvnFrameRingBenchmark },
+    { "vertex_fetch", slvn_tech::SlvnVertexFetchBenchmark },
+    { "obj_parser", slvn_tech::SlvnObjParserBenchmark },
+    { "vertex_weld", slvn_tech::SlvnVertexWeldBenchmark },
+    { "mesh_cache", slvn_tech::SlvnMeshCacheBenchmark },
+    { "mesh_optimizer", slvn_tech::SlvnMeshOptimizerBenchmark },
+    { "meshlet", slvn_tech::SlvnMeshletBenchmark },
+};
+
+}
+
+// Usage: slvn-tech-benchmark [name]
+// Runs every benchmark, or only the ones whose name contains the given filter.
+int main(int argc, char** argv)
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    for (auto& benchmark : cBenchmarks)
+    {
+        if (filter != nullptr && std::strstr(benchmark.mName, filter) == nullptr)
+            continue;
+        benchmark.mFunction();
+    }
+    return 0;
+}
@@ -0,0 +1,162 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <random>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_bvh.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+SlvnAabb makeBox(const glm::vec3& center, float halfSize)
+{
+    SlvnAabb box;
+    box.mMin = center - glm::vec3(halfSize);
+    box.mMax = center + glm::vec3(halfSize);
+    return box;
+}
+
+}
+
+void SlvnBvhBenchmark()
+{
+    const uint32_t objectCounts[] = { 10000, 100000, 1000000 };
+    const uint32_t queryCount = 64;
+
+    for (uint32_t objectCount : objectCounts)
+    {
+        std::string variant = std::to_string(objectCount) + " objects";
+
+        // Keep object density constant so query result sizes stay comparable between scene sizes.
+        float worldSize = 20.0f * std::cbrt(static_cast<float>(objectCount));
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> position(-worldSize, worldSize);
+        std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+
+        SlvnBvh bvh;
+        std::vector<uint32_t> proxies(objectCount);
+        std::vector<glm::vec3> centers(objectCount);
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            centers[i] = glm::vec3(position(rng), position(rng), position(rng));
+            proxies[i] = bvh.Insert(makeBox(centers[i], 5.0f));
+        }
+
+        SlvnBenchmarkTimer timer;
+        bvh.Rebuild();
+        SlvnBenchmarkReport("bvh rebuild (SAH)", variant, timer.ElapsedMs(), "ms");
+
+        // Every object moves, as threadRender does each frame.
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            centers[i] += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+            bvh.Update(proxies[i], makeBox(centers[i], 5.0f));
+        }
+        timer.Reset();
+        bvh.Refit();
+        SlvnBenchmarkReport("bvh refit (all moved)", variant, timer.ElapsedMs(), "ms");
+
+        for (uint32_t i = 0; i < objectCount; i += 100)
+        {
+            centers[i] += glm::vec3(jitter(rng), jitter(rng), jitter(rng));
+            bvh.Update(proxies[i], makeBox(centers[i], 5.0f));
+        }
+        timer.Reset();
+        bvh.Refit();
+        SlvnBenchmarkReport("bvh refit (1% moved)", variant, timer.ElapsedMs(), "ms");
+
+        glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+        std::vector<SlvnFrustum> frustums;
+        for (uint32_t i = 0; i < queryCount; i++)
+        {
+            float angle = glm::two_pi<float>() * i / queryCount;
+            glm::vec3 eye = glm::vec3(position(rng), position(rng), position(rng));
+            glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(std::cos(angle), 0.0f, std::sin(angle)), glm::vec3(0.0f, 1.0f, 0.0f));
+            frustums.push_back(SlvnFrustum::FromMatrix(projection * view));
+        }
+
+        std::vector<uint32_t> result;
+        size_t visible = 0;
+        timer.Reset();
+        for (auto& frustum : frustums)
+        {
+            result.clear();
+            bvh.QueryFrustum(frustum, result);
+            visible += result.size();
+        }
+        SlvnBenchmarkReport("bvh frustum query", variant, timer.ElapsedMs() / queryCount, "ms");
+
+        size_t bruteVisible = 0;
+        timer.Reset();
+        for (auto& frustum : frustums)
+        {
+            for (uint32_t proxy : proxies)
+            {
+                uint32_t mask = SlvnFrustum::cAllPlanesMask;
+                if (SlvnClassify(bvh.GetBounds(proxy), frustum, mask) != SlvnContainment::cOutside)
+                    bruteVisible++;
+            }
+        }
+        SlvnBenchmarkReport("linear frustum scan", variant, timer.ElapsedMs() / queryCount, "ms");
+        if (visible != bruteVisible)
+            std::cout << "WARNING; bvh frustum query returned " << visible << " objects, linear scan " << bruteVisible << std::endl;
+
+        timer.Reset();
+        for (uint32_t i = 0; i < queryCount; i++)
+        {
+            result.clear();
+            bvh.QuerySphere({ centers[i], 50.0f }, result);
+        }
+        SlvnBenchmarkReport("bvh sphere query", variant, timer.ElapsedMs() / queryCount * 1000.0, "us");
+
+        timer.Reset();
+        for (uint32_t i = 0; i < queryCount; i++)
+        {
+            result.clear();
+            bvh.QueryAabb(makeBox(centers[i], 50.0f), result);
+        }
+        SlvnBenchmarkReport("bvh aabb query", variant, timer.ElapsedMs() / queryCount * 1000.0, "us");
+
+        timer.Reset();
+        for (uint32_t i = 0; i < queryCount; i++)
+        {
+            glm::vec3 direction = glm::normalize(glm::vec3(jitter(rng), jitter(rng), jitter(rng)) + glm::vec3(0.01f));
+            bvh.Raycast(SlvnRay(centers[i] + direction * 10.0f, direction), 2.0f * worldSize);
+        }
+        SlvnBenchmarkReport("bvh raycast", variant, timer.ElapsedMs() / queryCount * 1000.0, "us");
+    }
+}
+
+} // slvn_tech
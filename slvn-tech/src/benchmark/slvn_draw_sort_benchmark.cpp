@@ -0,0 +1,86 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_draw_packet.h>
+#include <slvn_settings.h>
+
+namespace slvn_tech
+{
+
+void SlvnDrawSortBenchmark()
+{
+    SlvnThreadpool threadpool;
+    threadpool.SetThreadCount(SlvnSettings::GetInstance().mMaxThreads);
+    SlvnDrawSorter sorter;
+
+    const uint32_t packetCounts[] = { 10000, 100000, 1000000 };
+    for (uint32_t packetCount : packetCounts)
+    {
+        // 8 pipelines, 64 materials and 256 meshes in random submission order, a tenth of it transparent.
+        std::mt19937 mt(1234);
+        std::uniform_int_distribution<uint32_t> pipelines(0, 7);
+        std::uniform_int_distribution<uint32_t> materials(0, 63);
+        std::uniform_int_distribution<uint32_t> meshes(0, 255);
+        std::uniform_real_distribution<float> depths(0.0f, 1.0f);
+        std::vector<SlvnDrawPacket> source(packetCount);
+        for (uint32_t i = 0; i < packetCount; i++)
+        {
+            bool transparent = i % 10 == 0;
+            source[i].mKey = transparent ? SlvnDrawKey::Transparent(pipelines(mt), materials(mt), meshes(mt), depths(mt)) :
+                                           SlvnDrawKey::Opaque(pipelines(mt), materials(mt), meshes(mt), depths(mt));
+            source[i].mObject = i;
+        }
+
+        std::string variant = std::to_string(packetCount) + " packets";
+        SlvnDrawStats unsorted = sorter.CountStateChanges(source);
+
+        std::vector<SlvnDrawPacket> packets(source);
+        SlvnBenchmarkTimer timer;
+        sorter.Sort(packets, &threadpool);
+        SlvnBenchmarkReport("radix sort (threadpool)", variant, timer.ElapsedMs(), "ms");
+
+        packets = source;
+        timer.Reset();
+        sorter.Sort(packets, nullptr);
+        SlvnBenchmarkReport("radix sort (single thread)", variant, timer.ElapsedMs(), "ms");
+
+        std::vector<SlvnDrawPacket> reference(source);
+        timer.Reset();
+        std::stable_sort(reference.begin(), reference.end(), [](const SlvnDrawPacket& a, const SlvnDrawPacket& b) { return a.mKey < b.mKey; });
+        SlvnBenchmarkReport("std::stable_sort", variant, timer.ElapsedMs(), "ms");
+
+        SlvnDrawStats sorted = sorter.CountStateChanges(packets);
+        SlvnBenchmarkReport("state changes (unsorted)", variant, unsorted.mPipelineChanges + unsorted.mMaterialChanges + unsorted.mMeshChanges, "binds");
+        SlvnBenchmarkReport("state changes (sorted)", variant, sorted.mPipelineChanges + sorted.mMaterialChanges + sorted.mMeshChanges, "binds");
+    }
+}
+
+} // slvn_tech
@@ -0,0 +1,122 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_frame_ring.h>
+#include <slvn_settings.h>
+#include <slvn_threadpool.inl>
+
+namespace slvn_tech
+{
+
+// Every render thread writes a 128 byte per-object block for its share of the objects,
+// once through the lock-free frame region and once through a mutex guarded bump pointer
+// and a heap allocation per object for comparison. Host memory stands in for the mapping.
+void SlvnFrameRingBenchmark()
+{
+    SlvnThreadpool threadpool;
+    uint32_t threadCount = SlvnSettings::GetInstance().mMaxThreads;
+    threadpool.SetThreadCount(threadCount);
+
+    const uint32_t blockSize = 128;
+    const uint32_t frameCount = 100;
+    const uint32_t objectCounts[] = { 10000, 100000 };
+    for (uint32_t objectCount : objectCounts)
+    {
+        std::string variant = std::to_string(objectCount) + " objects/frame";
+        uint32_t objectsPerThread = (objectCount + threadCount - 1) / threadCount;
+        std::vector<uint8_t> mapping(static_cast<size_t>(objectCount) * 256 + 256);
+        uint8_t source[blockSize] = {};
+
+        auto run = [&](auto allocateAndWrite, auto beginFrame)
+        {
+            SlvnBenchmarkTimer timer;
+            for (uint32_t frame = 0; frame < frameCount; frame++)
+            {
+                beginFrame();
+                for (uint32_t t = 0; t < threadCount; t++)
+                {
+                    threadpool.mThreads[t]->addJob([&, t]
+                        {
+                            uint32_t first = t * objectsPerThread;
+                            uint32_t last = std::min(objectCount, first + objectsPerThread);
+                            for (uint32_t i = first; i < last; i++)
+                            {
+                                allocateAndWrite(i);
+                            }
+                        });
+                }
+                threadpool.Wait();
+            }
+            return timer.ElapsedMs() / frameCount;
+        };
+
+        SlvnFrameRegion region;
+        region.mCapacity = mapping.size();
+        double ringMs = run([&](uint32_t)
+            {
+                uint64_t offset;
+                if (region.Allocate(blockSize, 256, offset))
+                    std::memcpy(mapping.data() + offset, source, blockSize);
+            },
+            [&]() { region.Reset(); });
+
+        std::mutex mutex;
+        uint64_t head = 0;
+        double mutexMs = run([&](uint32_t)
+            {
+                uint64_t offset;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    offset = (head + 255) & ~uint64_t(255);
+                    head = offset + blockSize;
+                }
+                std::memcpy(mapping.data() + offset, source, blockSize);
+            },
+            [&]() { head = 0; });
+
+        // Blocks live until the frame is done, like the ring regions.
+        std::vector<std::unique_ptr<uint8_t[]>> blocks(objectCount);
+        double heapMs = run([&](uint32_t i)
+            {
+                blocks[i].reset(new uint8_t[blockSize]);
+                std::memcpy(blocks[i].get(), source, blockSize);
+            },
+            [&]() { for (auto& block : blocks) block.reset(); });
+
+        SlvnBenchmarkReport("frame ring (atomic bump)", variant, ringMs, "ms/frame");
+        SlvnBenchmarkReport("mutex bump", variant, mutexMs, "ms/frame");
+        SlvnBenchmarkReport("heap block per object", variant, heapMs, "ms/frame");
+    }
+}
+
+} // slvn_tech
@@ -0,0 +1,452 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include <GLFW/glfw3.h>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_instance.h>
+#include <slvn_device_manager.h>
+#include <slvn_device.h>
+#include <slvn_renderpass.h>
+#include <slvn_graphics_pipeline.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_upload_manager.h>
+#include <slvn_buffer.h>
+#include <slvn_geometry_pool.h>
+#include <slvn_vertex_format.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+const uint32_t cTargetSize = 64;
+const uint32_t cInstanceCount = 16;
+const uint32_t cRunCount = 5;
+
+// Headless device, a tiny render target and a timestamp query pool shared by the GPU benchmarks.
+struct GpuContext
+{
+    SlvnInstance mInstance;
+    SlvnDeviceManager mDeviceManager;
+    SlvnDevice* mSlvnDevice;
+    VkDevice mDevice;
+    VkQueue mQueue;
+    VkQueue mTransferQueue;
+    SlvnMemoryAllocator mAllocator;
+    SlvnUploadManager mUploader;
+    SlvnRenderpass mRenderpass;
+    VkImage mImage;
+    SlvnAllocation mImageAllocation;
+    VkImageView mImageView;
+    VkFramebuffer mFramebuffer;
+    VkCommandPool mCmdPool;
+    VkCommandBuffer mCmdBuffer;
+    VkQueryPool mQueryPool;
+    float mTimestampPeriod;
+
+    void Initialize(bool bufferDeviceAddress)
+    {
+        SlvnResult result = mInstance.Initialize();
+        SLVN_ASSERT_RESULT(result);
+        result = mDeviceManager.Initialize(mInstance.mVkInstance);
+        SLVN_ASSERT_RESULT(result);
+        mSlvnDevice = mDeviceManager.GetPrimaryDevice();
+        mDevice = mSlvnDevice->mLogicalDevice;
+
+        mSlvnDevice->GetDeviceQueue(mQueue, 0);
+        mSlvnDevice->GetTransferQueue(mTransferQueue);
+
+        result = mAllocator.Initialize(mDevice, mSlvnDevice->mPhysicalDevice, SlvnMemoryAllocator::cDefaultBlockSize,
+            bufferDeviceAddress && mSlvnDevice->mBufferDeviceAddress);
+        SLVN_ASSERT_RESULT(result);
+        result = mUploader.Initialize(mDevice, &mAllocator, mTransferQueue, mSlvnDevice->GetTransferQueueFamilyIndex(),
+            mSlvnDevice->GetViableQueueFamilyIndex());
+        SLVN_ASSERT_RESULT(result);
+
+        result = mRenderpass.Initialize(mDevice);
+        SLVN_ASSERT_RESULT(result);
+
+        VkImageCreateInfo imageInfo = {};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = VK_FORMAT_B8G8R8A8_UNORM;
+        imageInfo.extent = { cTargetSize, cTargetSize, 1 };
+        imageInfo.mipLevels = 1;
+        imageInfo.arrayLayers = 1;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        VkResult res = vkCreateImage(mDevice, &imageInfo, nullptr, &mImage);
+        assert(res == VK_SUCCESS);
+        result = mAllocator.AllocateImage(mImage, SlvnMemoryUsage::cGpuOnly, SlvnResourceTiling::cOptimal, mImageAllocation);
+        SLVN_ASSERT_RESULT(result);
+
+        VkImageViewCreateInfo viewInfo = {};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = mImage;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = imageInfo.format;
+        viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        res = vkCreateImageView(mDevice, &viewInfo, nullptr, &mImageView);
+        assert(res == VK_SUCCESS);
+
+        VkFramebufferCreateInfo framebufferInfo = {};
+        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebufferInfo.renderPass = mRenderpass.mRenderpass;
+        framebufferInfo.attachmentCount = 1;
+        framebufferInfo.pAttachments = &mImageView;
+        framebufferInfo.width = cTargetSize;
+        framebufferInfo.height = cTargetSize;
+        framebufferInfo.layers = 1;
+        res = vkCreateFramebuffer(mDevice, &framebufferInfo, nullptr, &mFramebuffer);
+        assert(res == VK_SUCCESS);
+
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = mSlvnDevice->GetViableQueueFamilyIndex();
+        res = vkCreateCommandPool(mDevice, &poolInfo, nullptr, &mCmdPool);
+        assert(res == VK_SUCCESS);
+        VkCommandBufferAllocateInfo cmdInfo = {};
+        cmdInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        cmdInfo.commandPool = mCmdPool;
+        cmdInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        cmdInfo.commandBufferCount = 1;
+        res = vkAllocateCommandBuffers(mDevice, &cmdInfo, &mCmdBuffer);
+        assert(res == VK_SUCCESS);
+
+        VkQueryPoolCreateInfo queryInfo = {};
+        queryInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryInfo.queryCount = 2;
+        res = vkCreateQueryPool(mDevice, &queryInfo, nullptr, &mQueryPool);
+        assert(res == VK_SUCCESS);
+        mTimestampPeriod = mSlvnDevice->mPhyProperties.limits.timestampPeriod;
+    }
+
+    void Deinitialize()
+    {
+        vkDestroyQueryPool(mDevice, mQueryPool, nullptr);
+        vkDestroyCommandPool(mDevice, mCmdPool, nullptr);
+        vkDestroyFramebuffer(mDevice, mFramebuffer, nullptr);
+        vkDestroyImageView(mDevice, mImageView, nullptr);
+        vkDestroyImage(mDevice, mImage, nullptr);
+        mAllocator.Free(mImageAllocation);
+        mRenderpass.Deinitialize();
+        mUploader.Deinitialize();
+        mAllocator.Deinitialize();
+        for (auto& deviceEntry : mDeviceManager.mDevices)
+        {
+            deviceEntry->Deinitialize();
+        }
+        mDeviceManager.Deinitialize();
+        mInstance.Deinitialize();
+    }
+};
+
+// Draws indexCount indices cInstanceCount times into the tiny render target so that the
+// GPU time is dominated by index and vertex fetch, and returns the fastest run.
+// bind records the pipeline specific buffer bindings and push constants.
+double measureDraw(GpuContext& context, SlvnGraphicsPipeline& pipeline, uint32_t indexCount, uint32_t firstIndex,
+    const std::function<void(VkCommandBuffer)>& bind)
+{
+    VkCommandBuffer cmdBuffer = context.mCmdBuffer;
+    double best = 1e30;
+    for (uint32_t run = 0; run < cRunCount; run++)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        VkResult res = vkBeginCommandBuffer(cmdBuffer, &beginInfo);
+        assert(res == VK_SUCCESS);
+
+        context.mUploader.RecordAcquire(cmdBuffer);
+        vkCmdResetQueryPool(cmdBuffer, context.mQueryPool, 0, 2);
+
+        VkClearValue clearValue = {};
+        VkRenderPassBeginInfo renderpassInfo = {};
+        renderpassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderpassInfo.renderPass = context.mRenderpass.mRenderpass;
+        renderpassInfo.framebuffer = context.mFramebuffer;
+        renderpassInfo.renderArea = { { 0, 0 }, { cTargetSize, cTargetSize } };
+        renderpassInfo.clearValueCount = 1;
+        renderpassInfo.pClearValues = &clearValue;
+        vkCmdBeginRenderPass(cmdBuffer, &renderpassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport viewport = { 0.0f, 0.0f, static_cast<float>(cTargetSize), static_cast<float>(cTargetSize), 0.0f, 1.0f };
+        VkRect2D scissor = { { 0, 0 }, { cTargetSize, cTargetSize } };
+        vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+        vkCmdBindPipeline(cmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.GetPipeline());
+        bind(cmdBuffer);
+
+        vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, context.mQueryPool, 0);
+        vkCmdDrawIndexed(cmdBuffer, indexCount, cInstanceCount, firstIndex, 0, 0);
+        vkCmdWriteTimestamp(cmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, context.mQueryPool, 1);
+
+        vkCmdEndRenderPass(cmdBuffer);
+        res = vkEndCommandBuffer(cmdBuffer);
+        assert(res == VK_SUCCESS);
+
+        VkSubmitInfo submitInfo = {};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &cmdBuffer;
+        res = vkQueueSubmit(context.mQueue, 1, &submitInfo, VK_NULL_HANDLE);
+        assert(res == VK_SUCCESS);
+        res = vkQueueWaitIdle(context.mQueue);
+        assert(res == VK_SUCCESS);
+
+        uint64_t timestamps[2];
+        res = vkGetQueryPoolResults(context.mDevice, context.mQueryPool, 0, 2, sizeof(timestamps), timestamps, sizeof(uint64_t),
+            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+        assert(res == VK_SUCCESS);
+        best = std::min(best, static_cast<double>(timestamps[1] - timestamps[0]) * context.mTimestampPeriod / 1000000.0);
+    }
+    return best;
+}
+
+// A few pixels on screen, rasterization cost stays negligible.
+SlvnThreadPushConstant makePushConstant()
+{
+    SlvnThreadPushConstant pushConstant = {};
+    pushConstant.mvp = glm::scale(glm::mat4(1.0f), glm::vec3(0.05f));
+    pushConstant.color = glm::vec3(1.0f);
+    return pushConstant;
+}
+
+void makeSphereVertices(uint32_t rings, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::vector<glm::vec3> positions;
+    SlvnBenchmarkMakeSphere(rings, rings * 2, positions, indices);
+    vertices.reserve(positions.size());
+    for (auto& position : positions)
+    {
+        objl::Vertex vertex;
+        vertex.Position = objl::Vector3(position.x, position.y, position.z);
+        vertex.Normal = vertex.Position;
+        vertices.push_back(SlvnVertex(vertex));
+    }
+}
+
+}
+
+// Needs a Vulkan device; run from the repository root so the default shaders are found.
+void SlvnGeometryPlacementBenchmark()
+{
+    if (!glfwInit())
+    {
+        SlvnBenchmarkReport("geometry placement", "skipped, no glfw", 0.0, "");
+        return;
+    }
+
+    GpuContext context;
+    context.Initialize(false);
+    VkDevice device = context.mDevice;
+    SlvnGraphicsPipeline pipeline;
+    SlvnResult result = pipeline.Initialize(device, context.mRenderpass.mRenderpass);
+    SLVN_ASSERT_RESULT(result);
+
+    const uint32_t ringCounts[] = { 128, 512 };
+    for (uint32_t rings : ringCounts)
+    {
+        std::vector<SlvnVertex> vertices;
+        std::vector<uint32_t> indices;
+        makeSphereVertices(rings, vertices, indices);
+        uint32_t vertexSize = static_cast<uint32_t>(vertices.size() * sizeof(SlvnVertex));
+        uint32_t indexSize = static_cast<uint32_t>(indices.size() * sizeof(uint32_t));
+        uint32_t indexCount = static_cast<uint32_t>(indices.size());
+        std::string variant = std::to_string(vertices.size()) + " vertices x" + std::to_string(cInstanceCount);
+
+        VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        VkBufferUsageFlags indexUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        SlvnBuffer hostVertices(&device, vertexSize, vertexUsage, VK_SHARING_MODE_EXCLUSIVE);
+        SlvnBuffer hostIndices(&device, indexSize, indexUsage, VK_SHARING_MODE_EXCLUSIVE);
+        hostVertices.Insert(&context.mAllocator, vertexSize, vertices.data());
+        hostIndices.Insert(&context.mAllocator, indexSize, indices.data());
+
+        SlvnBuffer deviceVertices(&device, vertexSize, vertexUsage, VK_SHARING_MODE_EXCLUSIVE);
+        SlvnBuffer deviceIndices(&device, indexSize, indexUsage, VK_SHARING_MODE_EXCLUSIVE);
+        SlvnBenchmarkTimer timer;
+        deviceVertices.Upload(&context.mAllocator, &context.mUploader, vertexSize, vertices.data(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+        deviceIndices.Upload(&context.mAllocator, &context.mUploader, indexSize, indices.data(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+        uint64_t batch = context.mUploader.Submit();
+        context.mUploader.Wait(batch);
+        SlvnBenchmarkReport("staging upload", variant, timer.ElapsedMs(), "ms");
+
+        SlvnThreadPushConstant pushConstant = makePushConstant();
+        auto bindBuffers = [&](SlvnBuffer& vertexBuffer, SlvnBuffer& indexBuffer)
+        {
+            return [&](VkCommandBuffer cmdBuffer)
+            {
+                vkCmdPushConstants(cmdBuffer, pipeline.GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SlvnThreadPushConstant), &pushConstant);
+                VkBuffer vertexHandle = vertexBuffer.GetBuffer();
+                VkDeviceSize offset = 0;
+                vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexHandle, &offset);
+                vkCmdBindIndexBuffer(cmdBuffer, indexBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+            };
+        };
+        double hostMs = measureDraw(context, pipeline, indexCount, 0, bindBuffers(hostVertices, hostIndices));
+        double deviceMs = measureDraw(context, pipeline, indexCount, 0, bindBuffers(deviceVertices, deviceIndices));
+        SlvnBenchmarkReport("vertex fetch (host visible)", variant, hostMs, "ms");
+        SlvnBenchmarkReport("vertex fetch (device local)", variant, deviceMs, "ms");
+
+        hostVertices.Deinitialize(&device);
+        hostIndices.Deinitialize(&device);
+        deviceVertices.Deinitialize(&device);
+        deviceIndices.Deinitialize(&device);
+    }
+
+    pipeline.Deinitialize();
+    context.Deinitialize();
+    glfwTerminate();
+}
+
+// Fixed function vertex input against the vertex pulling pipeline reading the same mesh from one
+// geometry pool, in the full float and the compact format. Needs bufferDeviceAddress.
+void SlvnVertexFetchBenchmark()
+{
+    if (!glfwInit())
+    {
+        SlvnBenchmarkReport("vertex fetch", "skipped, no glfw", 0.0, "");
+        return;
+    }
+
+    GpuContext context;
+    context.Initialize(true);
+    if (!context.mSlvnDevice->mBufferDeviceAddress)
+    {
+        SlvnBenchmarkReport("vertex fetch", "skipped, no device address", 0.0, "");
+        context.Deinitialize();
+        glfwTerminate();
+        return;
+    }
+    VkDevice device = context.mDevice;
+
+    SlvnGraphicsPipeline fixedPipeline;
+    SlvnResult result = fixedPipeline.Initialize(device, context.mRenderpass.mRenderpass, SlvnVertexFetch::cFixedFunction);
+    SLVN_ASSERT_RESULT(result);
+    SlvnGraphicsPipeline pullPipeline;
+    result = pullPipeline.Initialize(device, context.mRenderpass.mRenderpass, SlvnVertexFetch::cPulling);
+    SLVN_ASSERT_RESULT(result);
+
+    const uint32_t ringCounts[] = { 128, 512 };
+    for (uint32_t rings : ringCounts)
+    {
+        std::vector<SlvnVertex> vertices;
+        std::vector<uint32_t> indices;
+        makeSphereVertices(rings, vertices, indices);
+        uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+        uint32_t indexCount = static_cast<uint32_t>(indices.size());
+        std::string variant = std::to_string(vertexCount) + " vertices x" + std::to_string(cInstanceCount);
+
+        // Every format once with 32-bit and once with 16-bit indices where the mesh allows them.
+        for (bool shortIndices : { false, true })
+        {
+            SlvnGeometryPool pool;
+            result = pool.Initialize(device, &context.mAllocator, &context.mUploader, sizeof(SlvnVertex), 3 * vertexCount + 64,
+                3 * indexCount + 64, true, true, shortIndices);
+            SLVN_ASSERT_RESULT(result);
+            std::vector<uint8_t> compact;
+            std::vector<uint8_t> quantized;
+            SlvnVertexQuantization quantization;
+            SlvnEncodeVertices(SlvnVertexFormat::cCompact, vertices, compact);
+            SlvnEncodeVertices(SlvnVertexFormat::cQuantized, vertices, quantized, &quantization);
+            uint32_t floatMesh = pool.AddMesh(vertices.data(), vertexCount, indices.data(), indexCount);
+            uint32_t compactMesh = pool.AddMesh(compact.data(), vertexCount, indices.data(), indexCount, SlvnVertexFormat::cCompact);
+            uint32_t quantizedMesh = pool.AddMesh(quantized.data(), vertexCount, indices.data(), indexCount, SlvnVertexFormat::cQuantized,
+                quantization);
+            assert(floatMesh != SlvnGeometryPool::cInvalidMesh && compactMesh != SlvnGeometryPool::cInvalidMesh &&
+                quantizedMesh != SlvnGeometryPool::cInvalidMesh);
+            context.mUploader.Wait(context.mUploader.Submit());
+
+            SlvnMeshRange floatRange = pool.GetMesh(floatMesh);
+            bool shortRange = floatRange.mIndexType == VK_INDEX_TYPE_UINT16;
+            if (shortIndices && !shortRange)
+            {
+                pool.Deinitialize();
+                continue;
+            }
+            std::string indexVariant = variant + (shortRange ? ", u16" : ", u32");
+            uint32_t indexSize = shortRange ? sizeof(uint16_t) : sizeof(uint32_t);
+
+            SlvnThreadPushConstant pushConstant = makePushConstant();
+            double fixedMs = measureDraw(context, fixedPipeline, indexCount, floatRange.mFirstIndex, [&](VkCommandBuffer cmdBuffer)
+                {
+                    vkCmdPushConstants(cmdBuffer, fixedPipeline.GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SlvnThreadPushConstant), &pushConstant);
+                    VkBuffer vertexHandle = pool.GetVertexBuffer();
+                    VkDeviceSize offset = floatRange.mVertexByteOffset;
+                    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, &vertexHandle, &offset);
+                    vkCmdBindIndexBuffer(cmdBuffer, pool.GetIndexBuffer(), 0, floatRange.mIndexType);
+                });
+            SlvnBenchmarkReport("vertex fetch (fixed function)", indexVariant, fixedMs, "ms");
+
+            const char* formatNames[] = { "float", "compact", "quantized" };
+            const uint32_t meshes[] = { floatMesh, compactMesh, quantizedMesh };
+            for (uint32_t mesh : meshes)
+            {
+                SlvnMeshRange range = pool.GetMesh(mesh);
+                SlvnPullPushConstant pullConstant = {};
+                pullConstant.mvp = pushConstant.mvp;
+                pullConstant.positionOffset = glm::vec4(range.mQuantization.mOffset, 0.0f);
+                pullConstant.positionScale = glm::vec4(range.mQuantization.mScale, 0.0f);
+                pullConstant.color = pushConstant.color;
+                pullConstant.vertexFormat = static_cast<uint32_t>(range.mVertexFormat);
+                pullConstant.vertexAddress = pool.GetVertexAddress() + range.mVertexByteOffset;
+                double pullMs = measureDraw(context, pullPipeline, indexCount, range.mFirstIndex, [&](VkCommandBuffer cmdBuffer)
+                    {
+                        vkCmdPushConstants(cmdBuffer, pullPipeline.GetLayout(), VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(SlvnPullPushConstant), &pullConstant);
+                        vkCmdBindIndexBuffer(cmdBuffer, pool.GetIndexBuffer(), 0, range.mIndexType);
+                    });
+                std::string formatName = formatNames[static_cast<uint32_t>(range.mVertexFormat)];
+                SlvnBenchmarkReport("vertex fetch (pulled, " + formatName + ")", indexVariant, pullMs, "ms");
+
+                // Memory of the mesh, and what one draw of every instance reads at most.
+                double meshBytes = static_cast<double>(vertexCount) * SlvnGetVertexStride(range.mVertexFormat) +
+                    static_cast<double>(indexCount) * indexSize;
+                SlvnBenchmarkReport("mesh memory (" + formatName + ")", indexVariant, meshBytes / 1024.0, "KB");
+                SlvnBenchmarkReport("fetch bandwidth (" + formatName + ")", indexVariant,
+                    meshBytes * cInstanceCount / (pullMs / 1000.0) / (1024.0 * 1024.0 * 1024.0), "GB/s");
+            }
+
+            pool.Deinitialize();
+        }
+    }
+
+    fixedPipeline.Deinitialize();
+    pullPipeline.Deinitialize();
+    context.Deinitialize();
+    glfwTerminate();
+}
+
+} // slvn_tech
@@ -0,0 +1,198 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_lod.h>
+#include <slvn_settings.h>
+#include <slvn_simplifier.h>
+
+namespace slvn_tech
+{
+
+void SlvnLodBenchmark()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    SlvnBenchmarkMakeSphere(128, 256, positions, indices);
+    std::vector<SlvnVertex> vertices(positions.size());
+    for (size_t v = 0; v < positions.size(); v++)
+    {
+        vertices[v].mPosition = positions[v];
+        vertices[v].mNormal = positions[v];
+    }
+
+    // The sphere is 2 units across.
+    SlvnLodMesh mesh;
+    SlvnBenchmarkTimer timer;
+    SlvnResult result = SlvnMeshSimplifier::BuildLodChain(vertices, indices, settings.mLodTriangleRatios,
+        2.0f * settings.mLodMaxError, mesh);
+    SLVN_ASSERT_RESULT(result);
+    SlvnBenchmarkReport("lod build", std::to_string(mesh.mLevels.size()) + " levels", timer.ElapsedMs(), "ms");
+    for (uint32_t level = 0; level < mesh.mLevels.size(); level++)
+    {
+        SlvnBenchmarkReport("lod triangles", "level " + std::to_string(level) + ", error " + std::to_string(mesh.mLevels[level].mError), mesh.mLevels[level].mIndexCount / 3, "tris");
+    }
+
+    SlvnLodSelector selector;
+    selector.mPixelThreshold = settings.mLodPixelError;
+    selector.mHysteresis = settings.mLodHysteresis;
+    selector.SetProjection(settings.mCameraFov, static_cast<float>(settings.mWindowHeight));
+
+    // Objects spread over the view distance, the way a large scene would see them.
+    const uint32_t objectCount = 100000;
+    std::mt19937 mt(1234);
+    std::uniform_real_distribution<float> distances(5.0f, 500.0f);
+    std::vector<float> objectDistances(objectCount);
+    std::vector<uint32_t> levels(objectCount, 0);
+    for (auto& distance : objectDistances)
+    {
+        distance = distances(mt);
+    }
+
+    // Same scene at a few error thresholds, starting from full detail each time.
+    const float pixelThresholds[] = { settings.mLodPixelError, 2.0f * settings.mLodPixelError, 4.0f * settings.mLodPixelError };
+    for (float pixelThreshold : pixelThresholds)
+    {
+        selector.mPixelThreshold = pixelThreshold;
+        std::fill(levels.begin(), levels.end(), 0);
+
+        timer.Reset();
+        uint64_t fullTriangles = 0;
+        uint64_t lodTriangles = 0;
+        for (uint32_t i = 0; i < objectCount; i++)
+        {
+            levels[i] = selector.SelectLevel(mesh, objectDistances[i], 10.0f, levels[i]);
+            fullTriangles += mesh.mLevels[0].mIndexCount / 3;
+            lodTriangles += mesh.mLevels[levels[i]].mIndexCount / 3;
+        }
+        std::string variant = std::to_string(objectCount) + " objects, " + std::to_string(static_cast<int>(pixelThreshold)) + " px";
+        SlvnBenchmarkReport("lod select", variant, timer.ElapsedMs(), "ms");
+        SlvnBenchmarkReport("scene triangles (full)", variant, static_cast<double>(fullTriangles), "tris");
+        SlvnBenchmarkReport("scene triangles (lod)", variant, static_cast<double>(lodTriangles), "tris");
+        SlvnBenchmarkReport("scene triangle reduction", variant, 100.0 * (1.0 - static_cast<double>(lodTriangles) / fullTriangles), "%");
+    }
+    selector.mPixelThreshold = settings.mLodPixelError;
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        levels[i] = selector.SelectLevel(mesh, objectDistances[i], 10.0f, 0);
+    }
+
+    // Level changes while distances jitter slightly from frame to frame.
+    const float hysteresisValues[] = { 0.0f, settings.mLodHysteresis };
+    std::normal_distribution<float> jitter(0.0f, 0.01f);
+    for (float hysteresis : hysteresisValues)
+    {
+        selector.mHysteresis = hysteresis;
+        std::vector<uint32_t> current(levels);
+        uint64_t changes = 0;
+        for (uint32_t frame = 0; frame < 100; frame++)
+        {
+            for (uint32_t i = 0; i < objectCount; i++)
+            {
+                uint32_t level = selector.SelectLevel(mesh, objectDistances[i] * (1.0f + jitter(mt)), 10.0f, current[i]);
+                changes += level != current[i] ? 1 : 0;
+                current[i] = level;
+            }
+        }
+        SlvnBenchmarkReport("lod changes per frame", "hysteresis " + std::to_string(hysteresis), changes / 100.0, "changes");
+    }
+}
+
+void SlvnSimplifierBenchmark()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+
+    // A scanned asset sized mesh, the UV sphere seam and poles give it locked seam vertices.
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    SlvnBenchmarkMakeSphere(1024, 2048, positions, indices);
+    std::vector<SlvnVertex> vertices(positions.size());
+    for (size_t v = 0; v < positions.size(); v++)
+    {
+        vertices[v].mPosition = positions[v];
+        vertices[v].mNormal = positions[v];
+    }
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    // The sphere is 2 units across.
+    float maxError = 2.0f * settings.mLodMaxError;
+    std::string source = std::to_string(triangleCount) + " tris";
+
+    const float ratios[] = { 0.5f, 0.25f, 0.1f, 0.01f };
+    for (float ratio : ratios)
+    {
+        SlvnMeshSimplifier simplifier;
+        std::vector<uint32_t> result;
+        float error = 0.0f;
+        uint32_t target = static_cast<uint32_t>(ratio * triangleCount) * 3;
+        SlvnBenchmarkTimer timer;
+        SlvnResult status = simplifier.Simplify(vertices, indices, target, maxError, result, error);
+        double ms = timer.ElapsedMs();
+        SLVN_ASSERT_RESULT(status);
+
+        std::string variant = source + ", ratio " + std::to_string(ratio).substr(0, 4);
+        SlvnBenchmarkReport("simplify", variant, ms, "ms");
+        SlvnBenchmarkReport("simplify throughput", variant, triangleCount / (ms * 1000.0), "Mtri/s");
+        SlvnBenchmarkReport("simplify triangles", variant, result.size() / 3, "tris");
+        SlvnBenchmarkReport("simplify error", variant, 100.0 * error / 2.0, "% of size");
+    }
+
+    // The whole chain as the loader cooks it, levels simplified in parallel.
+    std::vector<uint32_t> threadCounts = { 1 };
+    if (std::thread::hardware_concurrency() > 1)
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    for (uint32_t threadCount : threadCounts)
+    {
+        SlvnThreadpool threadpool;
+        threadpool.SetThreadCount(threadCount);
+        std::vector<uint32_t> chain(indices);
+        SlvnLodMesh mesh;
+        SlvnBenchmarkTimer timer;
+        SlvnResult status = SlvnMeshSimplifier::BuildLodChain(vertices, chain, settings.mLodTriangleRatios, maxError,
+            mesh, &threadpool);
+        double ms = timer.ElapsedMs();
+        SLVN_ASSERT_RESULT(status);
+
+        SlvnBenchmarkReport("lod chain", std::to_string(mesh.mLevels.size()) + " levels, " + std::to_string(threadCount) + " threads", ms, "ms");
+        if (threadCount == 1)
+        {
+            for (uint32_t level = 0; level < mesh.mLevels.size(); level++)
+            {
+                SlvnBenchmarkReport("lod chain triangles", "level " + std::to_string(level), mesh.mLevels[level].mIndexCount / 3, "tris");
+                SlvnBenchmarkReport("lod chain error", "level " + std::to_string(level), 100.0 * mesh.mLevels[level].mError / 2.0, "% of size");
+            }
+        }
+    }
+}
+
+} // slvn_tech
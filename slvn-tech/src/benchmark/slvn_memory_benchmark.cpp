@@ -0,0 +1,123 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_tlsf.h>
+
+namespace slvn_tech
+{
+
+// Runs the sub-allocation side of SlvnMemoryAllocator on the CPU: 64MB blocks, buffers
+// between 256B and 1MB with 256B or 4KB alignment, a fourth of the live set replaced per round.
+void SlvnMemoryBenchmark()
+{
+    const uint64_t blockSize = 64ull * 1024 * 1024;
+    const uint32_t liveCounts[] = { 1000, 10000, 50000 };
+    for (uint32_t liveCount : liveCounts)
+    {
+        std::mt19937 mt(1234);
+        std::uniform_real_distribution<float> sizeExponent(8.0f, 20.0f);
+        std::uniform_int_distribution<uint32_t> coin(0, 1);
+
+        struct Allocation
+        {
+            uint32_t mBlock;
+            uint32_t mHandle;
+        };
+        std::vector<std::unique_ptr<SlvnTlsfAllocator>> blocks;
+        std::vector<Allocation> live;
+        uint64_t operationCount = 0;
+
+        auto allocate = [&]()
+        {
+            uint64_t size = static_cast<uint64_t>(std::pow(2.0f, sizeExponent(mt)));
+            uint64_t alignment = coin(mt) ? 256 : 4096;
+            uint64_t offset;
+            for (uint32_t i = 0; i < blocks.size(); i++)
+            {
+                uint32_t handle = blocks[i]->Allocate(size, alignment, offset);
+                if (handle != SlvnTlsfAllocator::cInvalid)
+                {
+                    live.push_back({ i, handle });
+                    return;
+                }
+            }
+            blocks.push_back(std::make_unique<SlvnTlsfAllocator>());
+            blocks.back()->Initialize(blockSize);
+            live.push_back({ static_cast<uint32_t>(blocks.size() - 1), blocks.back()->Allocate(size, alignment, offset) });
+        };
+
+        SlvnBenchmarkTimer timer;
+        for (uint32_t i = 0; i < liveCount; i++)
+        {
+            allocate();
+        }
+        operationCount += liveCount;
+
+        const uint32_t roundCount = 20;
+        for (uint32_t round = 0; round < roundCount; round++)
+        {
+            std::shuffle(live.begin(), live.end(), mt);
+            uint32_t replaced = liveCount / 4;
+            for (uint32_t i = 0; i < replaced; i++)
+            {
+                blocks[live.back().mBlock]->Free(live.back().mHandle);
+                live.pop_back();
+            }
+            for (uint32_t i = 0; i < replaced; i++)
+            {
+                allocate();
+            }
+            operationCount += 2 * replaced;
+        }
+        double elapsedMs = timer.ElapsedMs();
+
+        uint64_t reserved = 0, used = 0, freeBytes = 0, largestFree = 0;
+        for (auto& block : blocks)
+        {
+            SlvnTlsfStats stats = block->GetStats();
+            reserved += stats.mSize;
+            used += stats.mUsed;
+            freeBytes += stats.mSize - stats.mUsed;
+            largestFree = std::max(largestFree, stats.mLargestFreeRegion);
+        }
+
+        std::string variant = std::to_string(liveCount) + " live buffers";
+        SlvnBenchmarkReport("tlsf allocate/free", variant, elapsedMs * 1000000.0 / static_cast<double>(operationCount), "ns/op");
+        SlvnBenchmarkReport("device allocs (per buffer)", variant, liveCount, "allocations");
+        SlvnBenchmarkReport("device allocs (tlsf blocks)", variant, static_cast<double>(blocks.size()), "allocations");
+        SlvnBenchmarkReport("block utilization", variant, 100.0 * static_cast<double>(used) / static_cast<double>(reserved), "%");
+        SlvnBenchmarkReport("fragmentation", variant, freeBytes > 0 ? 100.0 * (1.0 - static_cast<double>(largestFree) / static_cast<double>(freeBytes)) : 0.0, "%");
+    }
+}
+
+} // slvn_tech
@@ -0,0 +1,146 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_mesh_optimizer.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+void reportCache(const std::string& variant, const std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    // 16 is what the optimizer targets, 32 is closer to the caches of current GPUs.
+    for (uint32_t cacheSize : { 16u, 32u })
+    {
+        SlvnVertexCacheStats stats = SlvnAnalyzeVertexCache(indices, vertexCount, cacheSize);
+        std::string cacheVariant = variant + ", cache " + std::to_string(cacheSize);
+        SlvnBenchmarkReport("vertex cache acmr", cacheVariant, stats.mAcmr, "misses/tri");
+        SlvnBenchmarkReport("vertex cache atvr", cacheVariant, stats.mAtvr, "misses/vtx");
+    }
+}
+
+// Bytes read from memory per byte of referenced vertex data. Post-transform cache misses fetch
+// their vertex through a FIFO of 64 byte lines, 16KB in total, like a small texture cache.
+double overfetch(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    const uint32_t cLineSize = 64;
+    const uint32_t cLineCount = 256;
+    const uint32_t cTransformCacheSize = 16;
+    uint32_t stride = sizeof(SlvnVertex);
+    std::vector<uint32_t> vertexTime(vertexCount, 0);
+    std::vector<uint32_t> lineTime((static_cast<size_t>(vertexCount) * stride) / cLineSize + 1, 0);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t vertexClock = cTransformCacheSize + 1;
+    uint32_t lineClock = cLineCount + 1;
+    size_t fetchedLines = 0;
+    size_t uniqueCount = 0;
+    for (uint32_t index : indices)
+    {
+        uniqueCount += referenced[index] ? 0 : 1;
+        referenced[index] = 1;
+        if (vertexClock - vertexTime[index] <= cTransformCacheSize)
+            continue;
+        vertexTime[index] = vertexClock++;
+
+        for (size_t line = (index * stride) / cLineSize; line <= (index * stride + stride - 1) / cLineSize; line++)
+        {
+            if (lineClock - lineTime[line] <= cLineCount)
+                continue;
+            lineTime[line] = lineClock++;
+            fetchedLines++;
+        }
+    }
+    return static_cast<double>(fetchedLines * cLineSize) / static_cast<double>(std::max<size_t>(uniqueCount * stride, 1));
+}
+
+
+}
+
+void SlvnMeshOptimizerBenchmark()
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> gridIndices;
+    SlvnBenchmarkMakeSphere(256, 512, positions, gridIndices);
+    std::vector<SlvnVertex> sourceVertices;
+    for (auto& position : positions)
+    {
+        sourceVertices.push_back(SlvnVertex(position, position));
+    }
+
+    // Triangles in random order stand in for exporters that write faces by material or group.
+    std::vector<uint32_t> triangles(gridIndices.size() / 3);
+    std::iota(triangles.begin(), triangles.end(), 0);
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(7));
+    std::vector<uint32_t> shuffledIndices;
+    for (uint32_t triangle : triangles)
+    {
+        shuffledIndices.insert(shuffledIndices.end(), gridIndices.begin() + triangle * 3, gridIndices.begin() + triangle * 3 + 3);
+    }
+
+    const std::pair<const char*, const std::vector<uint32_t>*> inputs[] = { { "grid", &gridIndices }, { "shuffled", &shuffledIndices } };
+    for (auto& input : inputs)
+    {
+        std::string variant = input.first;
+        uint32_t vertexCount = static_cast<uint32_t>(sourceVertices.size());
+        reportCache(variant + " (input)", *input.second, vertexCount);
+        SlvnBenchmarkReport("vertex overfetch", variant + " (input)", overfetch(*input.second, vertexCount), "x");
+
+        SlvnMeshOptimizer optimizer;
+        std::vector<uint32_t> indices = *input.second;
+        SlvnBenchmarkTimer timer;
+        SlvnResult result = optimizer.OptimizeVertexCache(indices, vertexCount);
+        SLVN_ASSERT_RESULT(result);
+        SlvnBenchmarkReport("tipsify", variant, timer.ElapsedMs(), "ms");
+        reportCache(variant + " (tipsify)", indices, vertexCount);
+
+        std::vector<SlvnVertex> vertices = sourceVertices;
+        timer.Reset();
+        result = optimizer.OptimizeOverdraw(vertices, indices);
+        SLVN_ASSERT_RESULT(result);
+        SlvnBenchmarkReport("overdraw order", variant, timer.ElapsedMs(), "ms");
+        SlvnBenchmarkReport("overdraw clusters", variant, optimizer.GetStats().mClusterCount, "clusters");
+        reportCache(variant + " (overdraw)", indices, vertexCount);
+        SlvnBenchmarkReport("vertex overfetch", variant + " (overdraw)", overfetch(indices, vertexCount), "x");
+
+        timer.Reset();
+        result = optimizer.OptimizeVertexFetch(vertices, indices);
+        SLVN_ASSERT_RESULT(result);
+        SlvnBenchmarkReport("vertex fetch order", variant, timer.ElapsedMs(), "ms");
+        SlvnBenchmarkReport("vertex overfetch", variant + " (fetch order)", overfetch(indices, static_cast<uint32_t>(vertices.size())), "x");
+        assert(indices.size() == input.second->size());
+    }
+}
+
+} // slvn_tech
@@ -0,0 +1,135 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_mesh_optimizer.h>
+#include <slvn_meshlet.h>
+#include <slvn_settings.h>
+
+namespace slvn_tech
+{
+
+void SlvnMeshletBenchmark()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+
+    // Counter clockwise sphere in the order the loader hands it to the builder.
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    SlvnBenchmarkMakeSphere(512, 1024, positions, indices);
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::swap(indices[i + 1], indices[i + 2]);
+    }
+    std::vector<SlvnVertex> vertices;
+    for (auto& position : positions)
+    {
+        vertices.push_back(SlvnVertex(position, position));
+    }
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    SlvnMeshOptimizer optimizer;
+    SlvnResult result = optimizer.OptimizeVertexCache(indices, vertexCount);
+    SLVN_ASSERT_RESULT(result);
+    float acmrBefore = SlvnAnalyzeVertexCache(indices, vertexCount, 16).mAcmr;
+
+    SlvnMeshletBuilder builder;
+    builder.mMaxVertices = settings.mMeshletMaxVertices;
+    builder.mMaxTriangles = settings.mMeshletMaxTriangles;
+    std::vector<SlvnMeshlet> meshlets;
+    std::string source = std::to_string(triangleCount) + " tris";
+    SlvnBenchmarkTimer timer;
+    result = builder.Build(vertices, indices, 0, static_cast<uint32_t>(indices.size()), meshlets);
+    SLVN_ASSERT_RESULT(result);
+    SlvnBenchmarkReport("meshlet build", source, timer.ElapsedMs(), "ms");
+    SlvnBenchmarkReport("meshlet count", source, static_cast<double>(meshlets.size()), "meshlets");
+    SlvnBenchmarkReport("meshlet triangles", source, static_cast<double>(triangleCount) / meshlets.size(), "tris/meshlet");
+    float coneDegrees = 0.0f;
+    for (auto& meshlet : meshlets)
+    {
+        coneDegrees += glm::degrees(std::asin(std::min(meshlet.mConeCutoff, 1.0f)));
+    }
+    SlvnBenchmarkReport("meshlet cone angle", source, coneDegrees / meshlets.size(), "degrees");
+    // Meshlet order costs some vertex reuse over the plain cache optimized order.
+    SlvnBenchmarkReport("vertex cache acmr", "cache optimized", acmrBefore, "misses/tri");
+    SlvnBenchmarkReport("vertex cache acmr", "meshlets", SlvnAnalyzeVertexCache(indices, vertexCount, 16).mAcmr, "misses/tri");
+
+    SlvnMeshletCuller culler;
+    culler.SetMeshlets(meshlets);
+
+    // Objects scattered around a camera looking down -z, a few with their back to it at any time.
+    const uint32_t objectCount = 256;
+    std::mt19937 mt(1234);
+    std::uniform_real_distribution<float> offsets(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> angles(0.0f, glm::two_pi<float>());
+    std::vector<glm::mat4> models(objectCount);
+    for (auto& model : models)
+    {
+        model = glm::translate(glm::mat4(1.0f), glm::vec3(offsets(mt), offsets(mt) * 0.5f, offsets(mt) - 45.0f));
+        model = glm::rotate(model, angles(mt), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
+    glm::vec3 eye(0.0f, 0.0f, 0.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(settings.mCameraFov), 16.0f / 9.0f, 0.1f, 1000.0f);
+    glm::mat4 viewProjection = projection * glm::lookAt(eye, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+    const uint32_t frameCount = 20;
+    std::vector<SlvnIndexRange> ranges;
+    uint64_t drawnIndices = 0;
+    timer.Reset();
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        ranges.clear();
+        for (auto& model : models)
+        {
+            culler.Cull(0, static_cast<uint32_t>(meshlets.size()), model, viewProjection, eye, ranges);
+        }
+    }
+    double frameMs = timer.ElapsedMs() / frameCount;
+    for (auto& range : ranges)
+    {
+        drawnIndices += range.mIndexCount;
+    }
+
+    SlvnMeshletCullStats stats = culler.GetStats();
+    std::string variant = std::to_string(objectCount) + " objects";
+    double tested = static_cast<double>(stats.mTestedCount);
+    SlvnBenchmarkReport("meshlet cull", variant, frameMs, "ms/frame");
+    SlvnBenchmarkReport("meshlet cull per meshlet", variant, 1000000.0 * frameMs * frameCount / tested, "ns");
+    SlvnBenchmarkReport("meshlets culled (frustum)", variant, 100.0 * stats.mFrustumCulledCount / tested, "%");
+    SlvnBenchmarkReport("meshlets culled (backface)", variant, 100.0 * stats.mBackfaceCulledCount / tested, "%");
+    SlvnBenchmarkReport("draw ranges", variant, static_cast<double>(ranges.size()), "draws");
+    SlvnBenchmarkReport("triangles (object culling)", variant, static_cast<double>(triangleCount) * objectCount, "tris");
+    SlvnBenchmarkReport("triangles (meshlet culling)", variant, static_cast<double>(drawnIndices / 3), "tris");
+}
+
+} // slvn_tech
@@ -0,0 +1,220 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_loader.h>
+#include <slvn_mesh_cache.h>
+#include <slvn_obj_parser.h>
+#include <slvn_vertex_format.h>
+#include <slvn_vertex_weld.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+// Sphere with positions, normals and v//vn faces, the layout most exporters write.
+std::string writeSphereObj(uint32_t rings, uint32_t segments)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    SlvnBenchmarkMakeSphere(rings, segments, positions, indices);
+
+    std::string path = (std::filesystem::temp_directory_path() / ("slvn_benchmark_" + std::to_string(rings) + ".obj")).string();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    assert(file != nullptr);
+    for (auto& position : positions)
+    {
+        std::fprintf(file, "v %.6f %.6f %.6f\n", position.x, position.y, position.z);
+    }
+    for (auto& position : positions)
+    {
+        std::fprintf(file, "vn %.6f %.6f %.6f\n", position.x, position.y, position.z);
+    }
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        std::fprintf(file, "f %u//%u %u//%u %u//%u\n", indices[i] + 1, indices[i] + 1, indices[i + 1] + 1, indices[i + 1] + 1,
+            indices[i + 2] + 1, indices[i + 2] + 1);
+    }
+    std::fclose(file);
+    return path;
+}
+
+}
+
+void SlvnObjParserBenchmark()
+{
+    const uint32_t ringCounts[] = { 256, 1024 };
+    for (uint32_t rings : ringCounts)
+    {
+        std::string path = writeSphereObj(rings, rings * 2);
+        double megabytes = static_cast<double>(std::filesystem::file_size(path)) / (1024.0 * 1024.0);
+        std::string variant = std::to_string(2 * rings * rings * 2 / 1000) + "k triangles";
+
+        // objl keeps its own vertex type, SlvnLoader used to convert it afterwards.
+        SlvnBenchmarkTimer timer;
+        objl::Loader loader;
+        bool loaded = loader.LoadFile(path);
+        assert(loaded);
+        double objlMs = timer.ElapsedMs();
+        SlvnBenchmarkReport("obj parse (objl)", variant, objlMs, "ms");
+
+        std::vector<SlvnVertex> vertices;
+        std::vector<uint32_t> indices;
+        SlvnObjParser parser;
+        timer.Reset();
+        SlvnResult result = parser.Parse(path, vertices, indices);
+        SLVN_ASSERT_RESULT(result);
+        double parserMs = timer.ElapsedMs();
+        SlvnBenchmarkReport("obj parse (slvn)", variant, parserMs, "ms");
+        SlvnBenchmarkReport("obj parse (slvn)", variant, megabytes / (parserMs / 1000.0), "MB/s");
+        SlvnBenchmarkReport("obj parse speedup", variant, objlMs / parserMs, "x");
+        assert(loader.LoadedVertices.size() == vertices.size());
+
+        // Chunked parsing on the threadpool, scaling is relative to the single thread pool run
+        // so that the fork and merge overhead shows up at 1 thread.
+        const uint32_t threadCounts[] = { 1, 4, std::max(1u, std::thread::hardware_concurrency()) };
+        double singleThreadMs = 0.0;
+        for (uint32_t threadCount : threadCounts)
+        {
+            SlvnThreadpool threadpool;
+            threadpool.SetThreadCount(threadCount);
+            vertices.clear();
+            indices.clear();
+            timer.Reset();
+            result = parser.Parse(path, vertices, indices, &threadpool);
+            SLVN_ASSERT_RESULT(result);
+            double threadedMs = timer.ElapsedMs();
+            if (threadCount == 1)
+                singleThreadMs = threadedMs;
+
+            std::string threadVariant = variant + ", " + std::to_string(threadCount) + " threads";
+            SlvnBenchmarkReport("obj parse (chunked)", threadVariant, threadedMs, "ms");
+            SlvnBenchmarkReport("obj parse (chunked)", threadVariant, megabytes / (threadedMs / 1000.0), "MB/s");
+            SlvnBenchmarkReport("obj parse thread scaling", threadVariant, singleThreadMs / threadedMs, "x");
+            assert(loader.LoadedVertices.size() == vertices.size());
+        }
+
+        std::filesystem::remove(path);
+    }
+}
+
+void SlvnVertexWeldBenchmark()
+{
+    // The bundled models when run from the repository root, plus a generated sphere that is always there.
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (auto& entry : std::filesystem::directory_iterator("slvn-tech/resources", error))
+    {
+        if (entry.path().extension() == ".obj")
+            paths.push_back(entry.path().string());
+    }
+    std::string spherePath = writeSphereObj(256, 512);
+    paths.push_back(spherePath);
+
+    for (auto& path : paths)
+    {
+        std::vector<SlvnVertex> vertices;
+        std::vector<uint32_t> indices;
+        SlvnObjParser parser;
+        SlvnResult result = parser.Parse(path, vertices, indices);
+        SLVN_ASSERT_RESULT(result);
+
+        std::string variant = std::filesystem::path(path).filename().string();
+        size_t indexBytes = indices.size() * sizeof(uint32_t);
+        size_t vertexCount = vertices.size();
+
+        SlvnVertexWelder welder;
+        result = welder.Weld(vertices, indices);
+        SLVN_ASSERT_RESULT(result);
+        const SlvnWeldStats& stats = welder.GetStats();
+        SlvnBenchmarkReport("weld", variant, stats.mWeldMs, "ms");
+        SlvnBenchmarkReport("weld vertices", variant, static_cast<double>(stats.mOutputVertexCount), "vertices");
+        SlvnBenchmarkReport("weld ratio", variant, stats.GetRatio(), "x");
+
+        // Vertex and index buffer together, as the geometry pool stores them.
+        for (SlvnVertexFormat format : { SlvnVertexFormat::cFloat, SlvnVertexFormat::cCompact })
+        {
+            uint32_t stride = SlvnGetVertexStride(format);
+            double before = static_cast<double>(vertexCount * stride + indexBytes) / (1024.0 * 1024.0);
+            double after = static_cast<double>(vertices.size() * stride + indexBytes) / (1024.0 * 1024.0);
+            std::string formatVariant = variant + (format == SlvnVertexFormat::cFloat ? ", float" : ", compact");
+            SlvnBenchmarkReport("gpu buffers (unwelded)", formatVariant, before, "MB");
+            SlvnBenchmarkReport("gpu buffers (welded)", formatVariant, after, "MB");
+            SlvnBenchmarkReport("gpu buffer reduction", formatVariant, 100.0 * (1.0 - after / before), "%");
+        }
+    }
+    std::filesystem::remove(spherePath);
+}
+
+void SlvnMeshCacheBenchmark()
+{
+    const uint32_t ringCounts[] = { 256, 1024 };
+    for (uint32_t rings : ringCounts)
+    {
+        std::string path = writeSphereObj(rings, rings * 2);
+        std::string cachePath = SlvnMeshCache::GetCachePath(path);
+        std::filesystem::remove(cachePath);
+        std::string variant = std::to_string(2 * rings * rings * 2 / 1000) + "k triangles";
+
+        // Cold parses, welds and writes the cache, warm only hashes the source and copies the cache.
+        SlvnLoader loader;
+        std::vector<SlvnVertex> coldVertices;
+        std::vector<uint32_t> coldIndices;
+        SlvnBenchmarkTimer timer;
+        SlvnResult result = loader.Load(path, coldVertices, coldIndices);
+        SLVN_ASSERT_RESULT(result);
+        double coldMs = timer.ElapsedMs();
+        assert(std::filesystem::exists(cachePath));
+
+        std::vector<SlvnVertex> warmVertices;
+        std::vector<uint32_t> warmIndices;
+        timer.Reset();
+        result = loader.Load(path, warmVertices, warmIndices);
+        SLVN_ASSERT_RESULT(result);
+        double warmMs = timer.ElapsedMs();
+        assert(warmVertices.size() == coldVertices.size() && warmIndices == coldIndices);
+
+        SlvnBenchmarkReport("mesh load (cold)", variant, coldMs, "ms");
+        SlvnBenchmarkReport("mesh load (warm)", variant, warmMs, "ms");
+        SlvnBenchmarkReport("mesh load speedup", variant, coldMs / warmMs, "x");
+        SlvnBenchmarkReport("mesh cache size", variant,
+            static_cast<double>(std::filesystem::file_size(cachePath)) / (1024.0 * 1024.0), "MB");
+
+        std::filesystem::remove(cachePath);
+        std::filesystem::remove(path);
+    }
+}
+
+} // slvn_tech
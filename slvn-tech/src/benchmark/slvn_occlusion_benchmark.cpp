@@ -0,0 +1,109 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <random>
+#include <vector>
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <benchmark/slvn_benchmark.h>
+#include <slvn_occlusion_culler.h>
+#include <slvn_settings.h>
+
+namespace slvn_tech
+{
+
+void SlvnOcclusionBenchmark()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+    SlvnThreadpool threadpool;
+    threadpool.SetThreadCount(settings.mMaxThreads);
+
+    SlvnOcclusionCuller culler;
+    SlvnResult result = culler.Initialize(settings.mOcclusionBufferWidth, settings.mOcclusionBufferHeight, &threadpool);
+    SLVN_ASSERT_RESULT(result);
+
+    glm::mat4 projection = glm::perspective(glm::radians(settings.mCameraFov), 16.0f / 9.0f, 1.0f, 1000.0f);
+    projection[1][1] *= -1.0f;
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, -90.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 viewProjection = projection * view;
+
+    // Objects scattered inside the view volume behind a row of large occluders.
+    std::mt19937 mt(1234);
+    std::uniform_real_distribution<float> spread(-1.0f, 1.0f);
+    std::vector<SlvnAabb> objects(100000);
+    for (auto& object : objects)
+    {
+        glm::vec3 center(spread(mt) * 150.0f, spread(mt) * 80.0f, 20.0f + (spread(mt) + 1.0f) * 200.0f);
+        object.mMin = center - glm::vec3(2.0f);
+        object.mMax = center + glm::vec3(2.0f);
+    }
+
+    const uint32_t sphereDetails[] = { 8, 32, 128 };
+    for (uint32_t detail : sphereDetails)
+    {
+        std::vector<glm::vec3> positions;
+        std::vector<uint32_t> indices;
+        SlvnBenchmarkMakeSphere(detail, detail * 2, positions, indices);
+
+        culler.BeginFrame(viewProjection);
+        for (int i = -3; i <= 3; i++)
+        {
+            glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(i * 24.0f, 0.0f, 0.0f)), glm::vec3(12.0f));
+            culler.AddOccluder(positions, indices, 0, static_cast<uint32_t>(indices.size()), model);
+        }
+
+        SlvnBenchmarkTimer timer;
+        const uint32_t iterations = 20;
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            culler.Rasterize();
+        }
+        double rasterizeMs = timer.ElapsedMs() / iterations;
+
+        timer.Reset();
+        uint32_t culled = 0;
+        for (auto& object : objects)
+        {
+            culled += culler.IsVisible(object) ? 0 : 1;
+        }
+        double testMs = timer.ElapsedMs();
+
+        SlvnOcclusionStats stats = culler.GetStats();
+        std::string variant = std::to_string(stats.mOccluderTriangles) + " occluder tris";
+        SlvnBenchmarkReport("occlusion rasterize", variant, rasterizeMs, "ms");
+        SlvnBenchmarkReport("occlusion test (100k boxes)", variant, testMs, "ms");
+        SlvnBenchmarkReport("occlusion culled", variant, 100.0 * culled / objects.size(), "%");
+    }
+
+    result = culler.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+}
+
+} // slvn_tech
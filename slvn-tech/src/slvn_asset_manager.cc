@@ -0,0 +1,281 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <filesystem>
+
+#include <slvn_asset_manager.h>
+#include <slvn_mesh_cache.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+// Different spellings of the same file share a key.
+std::string normalizePath(const std::string& path)
+{
+    return std::filesystem::path(path).lexically_normal().generic_string();
+}
+
+}
+
+SlvnAssetManager::SlvnAssetManager() : mCacheBudgetBytes(0), mPoolPressure(0.9f), mPipeline(nullptr), mPool(nullptr),
+mResidentBytes(0), mCachedBytes(0), mRequestCount(0), mHitCount(0), mJoinCount(0), mMissCount(0), mEvictionCount(0)
+{
+}
+
+SlvnAssetManager::~SlvnAssetManager()
+{
+}
+
+SlvnResult SlvnAssetManager::Initialize(SlvnAssetPipeline* pipeline, SlvnGeometryPool* pool, uint64_t cacheBudgetBytes)
+{
+    SLVN_PRINT("ENTER");
+
+    mPipeline = pipeline;
+    mPool = pool;
+    mCacheBudgetBytes = cacheBudgetBytes;
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnAssetManager::Deinitialize()
+{
+    mAssets.clear();
+    mKeys.clear();
+    mReadyCallbacks.clear();
+    mResidentBytes = 0;
+    mCachedBytes = 0;
+    return SlvnResult::cOk;
+}
+
+uint64_t SlvnAssetManager::MakeKey(const std::string& path)
+{
+    std::string normalized = normalizePath(path);
+    return SlvnHashBytes(normalized.data(), normalized.size());
+}
+
+SlvnAssetHandle SlvnAssetManager::Acquire(const std::string& path, SlvnSharedAssetCallback callback, SlvnAssetDecodeHook hook)
+{
+    std::string normalized = normalizePath(path);
+    uint64_t key = MakeKey(normalized);
+    mRequestCount++;
+
+    SlvnAssetHandle handle;
+    auto found = mKeys.find(key);
+    if (found == mKeys.end())
+    {
+        handle = static_cast<SlvnAssetHandle>(mAssets.size());
+        mAssets.emplace_back();
+        Entry& entry = mAssets.back();
+        entry.mKey = key;
+        entry.mPath = normalized;
+        entry.mHook = std::move(hook);
+        entry.mLoad = SlvnAssetPipeline::cInvalidHandle;
+        entry.mReferenceCount = 0;
+        entry.mLastUse = 0;
+        entry.mBytes = 0;
+        mKeys.emplace(key, handle);
+    }
+    else
+    {
+        handle = found->second;
+        if (mAssets[handle].mPath != normalized)
+        {
+            SLVN_PRINT("ERROR; key of " << normalized << " collides with " << mAssets[handle].mPath);
+            return SlvnAssetPipeline::cInvalidHandle;
+        }
+    }
+
+    Entry& entry = mAssets[handle];
+    bool ready = IsReady(handle);
+    if (entry.mReferenceCount == 0 && ready)
+        mCachedBytes -= entry.mBytes;
+    entry.mReferenceCount++;
+
+    if (ready)
+    {
+        mHitCount++;
+        if (callback)
+            mReadyCallbacks.emplace_back(handle, std::move(callback));
+        return handle;
+    }
+
+    if (callback)
+        entry.mCallbacks.push_back(std::move(callback));
+    SlvnAssetState state = entry.mLoad != SlvnAssetPipeline::cInvalidHandle ? mPipeline->GetState(entry.mLoad) : SlvnAssetState::cFailed;
+    if (state != SlvnAssetState::cFailed)
+    {
+        mJoinCount++;
+        return handle;
+    }
+
+    // Never loaded, evicted or failed the last time.
+    mMissCount++;
+    load(handle);
+    return handle;
+}
+
+void SlvnAssetManager::AddReference(SlvnAssetHandle handle)
+{
+    Entry& entry = mAssets[handle];
+    if (entry.mReferenceCount == 0 && IsReady(handle))
+        mCachedBytes -= entry.mBytes;
+    entry.mReferenceCount++;
+}
+
+void SlvnAssetManager::Release(SlvnAssetHandle handle, uint64_t lastUse)
+{
+    Entry& entry = mAssets[handle];
+    if (entry.mReferenceCount == 0)
+    {
+        SLVN_PRINT("ERROR; releasing " << entry.mPath << " without a reference");
+        return;
+    }
+
+    entry.mLastUse = std::max(entry.mLastUse, lastUse);
+    entry.mReferenceCount--;
+    if (entry.mReferenceCount == 0 && IsReady(handle))
+        mCachedBytes += entry.mBytes;
+}
+
+bool SlvnAssetManager::IsReady(SlvnAssetHandle handle) const
+{
+    const Entry& entry = mAssets[handle];
+    return entry.mLoad != SlvnAssetPipeline::cInvalidHandle && mPipeline->IsReady(entry.mLoad);
+}
+
+void SlvnAssetManager::load(SlvnAssetHandle handle)
+{
+    Entry& entry = mAssets[handle];
+    entry.mLoad = mPipeline->Load(entry.mPath,
+        [this, handle](SlvnAssetHandle, SlvnResult result, SlvnMeshAsset& asset) { onLoaded(handle, result, asset); },
+        entry.mHook);
+}
+
+void SlvnAssetManager::onLoaded(SlvnAssetHandle handle, SlvnResult result, SlvnMeshAsset& asset)
+{
+    Entry& entry = mAssets[handle];
+    if (result == SlvnResult::cOk)
+    {
+        SlvnMeshRange range = mPool->GetMesh(mPipeline->GetMesh(entry.mLoad));
+        uint64_t indexSize = range.mIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+        entry.mBytes = asset.mUpload.mVertices.size() + asset.mUpload.mIndices.size() * indexSize +
+            asset.mVertices.size() * sizeof(SlvnVertex) + asset.mIndices.size() * sizeof(uint32_t) + asset.mMeshlets.size() * sizeof(SlvnMeshlet);
+        // The upload data is in the pool now, only the CPU side is kept for later requests.
+        asset.mUpload = SlvnStreamedMeshData();
+        entry.mAsset = std::move(asset);
+        mResidentBytes += entry.mBytes;
+        // Every request may have been released while the asset was loading.
+        if (entry.mReferenceCount == 0)
+            mCachedBytes += entry.mBytes;
+    }
+
+    std::vector<SlvnSharedAssetCallback> callbacks;
+    callbacks.swap(entry.mCallbacks);
+    for (auto& callback : callbacks)
+    {
+        callback(handle, result, entry.mAsset);
+    }
+}
+
+void SlvnAssetManager::BeginFrame()
+{
+    // Nothing is evicted between Acquire() and here, so these assets are still ready.
+    std::vector<std::pair<SlvnAssetHandle, SlvnSharedAssetCallback>> readyCallbacks;
+    readyCallbacks.swap(mReadyCallbacks);
+    for (auto& ready : readyCallbacks)
+    {
+        ready.second(ready.first, SlvnResult::cOk, mAssets[ready.first].mAsset);
+    }
+
+    while (mCachedBytes > mCacheBudgetBytes && evictLeastRecentlyUsed())
+    {
+    }
+    if (isUnderPoolPressure())
+        evictLeastRecentlyUsed();
+}
+
+bool SlvnAssetManager::evictLeastRecentlyUsed()
+{
+    Entry* victim = nullptr;
+    for (auto& entry : mAssets)
+    {
+        if (entry.mReferenceCount > 0 || entry.mLoad == SlvnAssetPipeline::cInvalidHandle || !mPipeline->IsReady(entry.mLoad))
+            continue;
+        if (victim == nullptr || entry.mLastUse < victim->mLastUse)
+            victim = &entry;
+    }
+    if (victim == nullptr)
+        return false;
+
+    mPipeline->Release(victim->mLoad, victim->mLastUse);
+    victim->mLoad = SlvnAssetPipeline::cInvalidHandle;
+    victim->mAsset = SlvnMeshAsset();
+    mCachedBytes -= victim->mBytes;
+    mResidentBytes -= victim->mBytes;
+    victim->mBytes = 0;
+    mEvictionCount++;
+    return true;
+}
+
+bool SlvnAssetManager::isUnderPoolPressure() const
+{
+    SlvnGeometryPoolStats stats = mPool->GetStats();
+    return stats.mVertexUsed > stats.mVertexCapacity * mPoolPressure || stats.mIndexUsed > stats.mIndexCapacity * mPoolPressure;
+}
+
+SlvnAssetCacheStats SlvnAssetManager::GetStats() const
+{
+    SlvnAssetCacheStats stats = {};
+    stats.mAssetCount = static_cast<uint32_t>(mAssets.size());
+    for (SlvnAssetHandle handle = 0; handle < mAssets.size(); handle++)
+    {
+        const Entry& entry = mAssets[handle];
+        bool ready = IsReady(handle);
+        if (entry.mReferenceCount > 0)
+            stats.mReferencedCount++;
+        else if (ready)
+            stats.mCachedCount++;
+        if (!ready && entry.mLoad != SlvnAssetPipeline::cInvalidHandle && mPipeline->GetState(entry.mLoad) != SlvnAssetState::cFailed)
+            stats.mLoadingCount++;
+    }
+    stats.mResidentBytes = mResidentBytes;
+    stats.mCachedBytes = mCachedBytes;
+    stats.mBudgetBytes = mCacheBudgetBytes;
+    stats.mRequestCount = mRequestCount;
+    stats.mHitCount = mHitCount;
+    stats.mJoinCount = mJoinCount;
+    stats.mMissCount = mMissCount;
+    stats.mEvictionCount = mEvictionCount;
+    return stats;
+}
+
+} // slvn_tech
@@ -0,0 +1,390 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+
+#include <slvn_asset_pipeline.h>
+#include <slvn_loader.h>
+#include <slvn_mesh_cache.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+constexpr size_t cPageSize = 4096;
+
+inline float elapsedMs(std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end)
+{
+    return std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+// Touches every page of the mapping, so the decode stage finds the file in memory instead of faulting it in.
+uint64_t readAhead(const SlvnMappedFile& file)
+{
+    const volatile char* data = file.GetData();
+    char sum = 0;
+    for (size_t offset = 0; offset < file.GetSize(); offset += cPageSize)
+    {
+        sum ^= data[offset];
+    }
+    (void)sum;
+    return file.GetSize();
+}
+
+inline uint64_t uploadBytes(const SlvnStreamedMeshData& data)
+{
+    return data.mVertices.size() + data.mIndices.size() * sizeof(uint32_t);
+}
+
+}
+
+void SlvnAssetPipeline::StageTotals::Add(float latencyMs, float workMs)
+{
+    mCount++;
+    mLatencyMs += latencyMs;
+    mWorkMs += workMs;
+    mMaxLatencyMs = std::max(mMaxLatencyMs, latencyMs);
+}
+
+void SlvnAssetPipeline::StageTotals::Fill(SlvnAssetStageStats& stats) const
+{
+    stats.mProcessedCount = mCount;
+    stats.mAverageLatencyMs = mCount > 0 ? static_cast<float>(mLatencyMs / mCount) : 0.0f;
+    stats.mAverageWorkMs = mCount > 0 ? static_cast<float>(mWorkMs / mCount) : 0.0f;
+    stats.mMaxLatencyMs = mMaxLatencyMs;
+}
+
+SlvnAssetPipeline::SlvnAssetPipeline() : mUploadBudgetBytes(0), mPool(nullptr), mUploader(nullptr), mDeletionQueue(nullptr),
+mFormat(SlvnVertexFormat::cFloat), mFrame(0), mNextDecodeThread(0), mIoTotals(), mDecodeTotals(), mUploadTotals(), mTotals(),
+mReadyCount(0), mFailedCount(0), mReadBytes(0), mUploadedCount(0), mUploadedBytes(0)
+{
+}
+
+SlvnAssetPipeline::~SlvnAssetPipeline()
+{
+}
+
+SlvnResult SlvnAssetPipeline::Initialize(SlvnGeometryPool* pool, SlvnUploadManager* uploader, SlvnDeletionQueue* deletionQueue,
+    SlvnVertexFormat format, uint32_t decodeThreads, uint64_t uploadBudgetBytes)
+{
+    SLVN_PRINT("ENTER");
+
+    mPool = pool;
+    mUploader = uploader;
+    mDeletionQueue = deletionQueue;
+    mFormat = format;
+    mUploadBudgetBytes = uploadBudgetBytes;
+    mDecodeThreads.SetThreadCount(std::max(1u, decodeThreads));
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnAssetPipeline::Deinitialize(uint64_t lastUse)
+{
+    // Reads queue decode jobs, so the I/O thread has to be idle first.
+    mIoThread.Wait();
+    mDecodeThreads.Wait();
+
+    // Nothing was submitted unless an asset is still uploading.
+    if (!mUploading.empty())
+    {
+        uint64_t lastBatch = 0;
+        for (SlvnAssetHandle handle : mUploading)
+        {
+            lastBatch = std::max(lastBatch, mAssets[handle].mBatch);
+        }
+        mUploader->Wait(lastBatch);
+    }
+
+    for (auto& entry : mAssets)
+    {
+        if (entry.mPoolMesh != SlvnGeometryPool::cInvalidMesh)
+            mPool->RemoveMesh(entry.mPoolMesh, lastUse, mDeletionQueue);
+        // Whoever still waits for an asset that never made it gets an error instead of a broken promise.
+        SlvnAssetState state = entry.mState;
+        if (state != SlvnAssetState::cReady && state != SlvnAssetState::cFailed)
+            entry.mPromise.set_value(SlvnResult::cUnexpectedError);
+    }
+    mAssets.clear();
+    mDecodeQueue.clear();
+    mDecoded.clear();
+    mUploading.clear();
+    return SlvnResult::cOk;
+}
+
+SlvnAssetHandle SlvnAssetPipeline::Load(const std::string& path, SlvnAssetCallback callback, SlvnAssetDecodeHook hook)
+{
+    mAssets.emplace_back();
+    Entry& entry = mAssets.back();
+    entry.mHandle = static_cast<SlvnAssetHandle>(mAssets.size() - 1);
+    entry.mPath = path;
+    entry.mCallback = std::move(callback);
+    entry.mHook = std::move(hook);
+    entry.mState = SlvnAssetState::cReading;
+    entry.mResult = SlvnResult::cOk;
+    entry.mFuture = entry.mPromise.get_future().share();
+    entry.mPoolMesh = SlvnGeometryPool::cInvalidMesh;
+    entry.mBatch = 0;
+    entry.mReadBytes = 0;
+    entry.mRequestTime = Clock::now();
+    entry.mIoMs = 0.0f;
+    entry.mDecodeMs = 0.0f;
+    entry.mPlaceMs = 0.0f;
+
+    Entry* pointer = &entry;
+    mIoThread.addJob([this, pointer] { read(*pointer); });
+    return entry.mHandle;
+}
+
+void SlvnAssetPipeline::read(Entry& entry)
+{
+    auto start = Clock::now();
+    entry.mResult = entry.mSource.Open(entry.mPath);
+    if (entry.mResult == SlvnResult::cOk)
+    {
+        entry.mReadBytes = readAhead(entry.mSource);
+        // A warm start decodes from the cache, which is read ahead as well when there is one.
+        SlvnMappedFile cache;
+        if (cache.Open(SlvnMeshCache::GetCachePath(entry.mPath)) == SlvnResult::cOk)
+            entry.mReadBytes += readAhead(cache);
+    }
+    entry.mReadTime = Clock::now();
+    entry.mIoMs = elapsedMs(start, entry.mReadTime);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (entry.mResult != SlvnResult::cOk)
+    {
+        SLVN_PRINT("ERROR; could not open " << entry.mPath);
+        mDecoded.push_back(&entry);
+        return;
+    }
+
+    // Any decode thread takes the oldest read asset, so a long cook does not hold up the ones behind it.
+    entry.mState = SlvnAssetState::cDecoding;
+    mDecodeQueue.push_back(&entry);
+    uint32_t thread = mNextDecodeThread++ % static_cast<uint32_t>(mDecodeThreads.mThreads.size());
+    mDecodeThreads.mThreads[thread]->addJob([this]
+        {
+            Entry* next;
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                next = mDecodeQueue.front();
+                mDecodeQueue.pop_front();
+            }
+            decode(*next);
+        });
+}
+
+void SlvnAssetPipeline::decode(Entry& entry)
+{
+    auto start = Clock::now();
+    SlvnMeshAsset& asset = entry.mAsset;
+    // One asset per decode thread; parallelism comes from decoding several assets at once.
+    SlvnLoader loader;
+    SlvnResult result = loader.Load(entry.mPath, entry.mSource, asset.mVertices, asset.mIndices, nullptr, &asset.mLods, &asset.mMeshlets);
+    entry.mSource.Close();
+
+    if (result == SlvnResult::cOk)
+    {
+        for (auto& vertex : asset.mVertices)
+        {
+            asset.mBounds.Grow(vertex.mPosition);
+        }
+        if (entry.mHook)
+            result = entry.mHook(asset);
+    }
+    if (result == SlvnResult::cOk && asset.mUpload.mVertices.empty())
+    {
+        asset.mUpload.mFormat = mFormat;
+        asset.mUpload.mVertexCount = static_cast<uint32_t>(asset.mVertices.size());
+        SlvnEncodeVertices(mFormat, asset.mVertices, asset.mUpload.mVertices, &asset.mUpload.mQuantization);
+        asset.mUpload.mIndices = asset.mIndices;
+    }
+    entry.mResult = result;
+    entry.mDecodeTime = Clock::now();
+    entry.mDecodeMs = elapsedMs(start, entry.mDecodeTime);
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (result == SlvnResult::cOk)
+        entry.mState = SlvnAssetState::cUploading;
+    mDecoded.push_back(&entry);
+}
+
+void SlvnAssetPipeline::BeginFrame(uint64_t frame)
+{
+    mFrame = frame;
+    mUploadedCount = 0;
+    mUploadedBytes = 0;
+
+    // Decoded assets in the order they finished until the budget is spent, or only one near the staging
+    // memory budget. The first one always goes, a mesh larger than the budget would never be uploaded otherwise.
+    std::vector<SlvnAssetHandle> placed;
+    while (true)
+    {
+        Entry* entry;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mDecoded.empty())
+                break;
+            entry = mDecoded.front();
+            uint64_t bytes = uploadBytes(entry->mAsset.mUpload);
+            if (mUploadedCount > 0 && (mUploadedBytes + bytes > mUploadBudgetBytes || mPool->IsNearBudget()))
+                break;
+            mDecoded.pop_front();
+        }
+
+        if (entry->mResult == SlvnResult::cOk)
+            place(*entry);
+        if (entry->mResult != SlvnResult::cOk)
+        {
+            complete(entry->mHandle);
+            continue;
+        }
+        placed.push_back(entry->mHandle);
+        mUploadedCount++;
+        mUploadedBytes += uploadBytes(entry->mAsset.mUpload);
+    }
+
+    // Everything placed this frame shares one batch; host visible pools have written already.
+    if (!placed.empty())
+    {
+        uint64_t batch = mUploader->Submit();
+        for (SlvnAssetHandle handle : placed)
+        {
+            mAssets[handle].mBatch = batch;
+            mUploading.push_back(handle);
+        }
+    }
+
+    // Acquire barriers of completed batches were recorded just before, the meshes are usable from here on.
+    auto done = std::remove_if(mUploading.begin(), mUploading.end(), [this](SlvnAssetHandle handle)
+        {
+            if (!mUploader->IsComplete(mAssets[handle].mBatch))
+                return false;
+            complete(handle);
+            return true;
+        });
+    mUploading.erase(done, mUploading.end());
+}
+
+void SlvnAssetPipeline::place(Entry& entry)
+{
+    auto start = Clock::now();
+    const SlvnStreamedMeshData& upload = entry.mAsset.mUpload;
+    entry.mPoolMesh = mPool->AddMesh(upload.mVertices.data(), upload.mVertexCount, upload.mIndices.data(),
+        static_cast<uint32_t>(upload.mIndices.size()), upload.mFormat, upload.mQuantization);
+    if (entry.mPoolMesh == SlvnGeometryPool::cInvalidMesh)
+    {
+        SLVN_PRINT("ERROR; " << entry.mPath << " does not fit the geometry pool");
+        entry.mResult = SlvnResult::cOutOfMemory;
+    }
+    entry.mPlaceMs = elapsedMs(start, Clock::now());
+}
+
+void SlvnAssetPipeline::complete(SlvnAssetHandle handle)
+{
+    Entry& entry = mAssets[handle];
+    auto now = Clock::now();
+    bool decoded = entry.mDecodeTime != Clock::time_point();
+
+    mIoTotals.Add(elapsedMs(entry.mRequestTime, entry.mReadTime), entry.mIoMs);
+    mReadBytes += entry.mReadBytes;
+    if (decoded)
+        mDecodeTotals.Add(elapsedMs(entry.mReadTime, entry.mDecodeTime), entry.mDecodeMs);
+    if (entry.mResult == SlvnResult::cOk)
+    {
+        mUploadTotals.Add(elapsedMs(entry.mDecodeTime, now), entry.mPlaceMs);
+        mTotals.Add(elapsedMs(entry.mRequestTime, now), entry.mIoMs + entry.mDecodeMs + entry.mPlaceMs);
+        mReadyCount++;
+        entry.mState = SlvnAssetState::cReady;
+    }
+    else
+    {
+        SLVN_PRINT("ERROR; loading " << entry.mPath << " failed");
+        mFailedCount++;
+        entry.mState = SlvnAssetState::cFailed;
+    }
+
+    if (entry.mCallback)
+        entry.mCallback(handle, entry.mResult, entry.mAsset);
+    entry.mPromise.set_value(entry.mResult);
+
+    // Only the pool mesh outlives the request.
+    entry.mAsset = SlvnMeshAsset();
+    entry.mCallback = nullptr;
+    entry.mHook = nullptr;
+}
+
+void SlvnAssetPipeline::Release(SlvnAssetHandle handle, uint64_t lastUse)
+{
+    Entry& entry = mAssets[handle];
+    if (entry.mState != SlvnAssetState::cReady || entry.mPoolMesh == SlvnGeometryPool::cInvalidMesh)
+        return;
+
+    mPool->RemoveMesh(entry.mPoolMesh, lastUse, mDeletionQueue);
+    entry.mPoolMesh = SlvnGeometryPool::cInvalidMesh;
+}
+
+SlvnAssetStats SlvnAssetPipeline::GetStats() const
+{
+    SlvnAssetStats stats = {};
+    for (auto& entry : mAssets)
+    {
+        switch (entry.mState.load())
+        {
+        case SlvnAssetState::cReading:
+            stats.mIo.mDepth++;
+            break;
+        case SlvnAssetState::cDecoding:
+            stats.mDecode.mDepth++;
+            break;
+        case SlvnAssetState::cUploading:
+            stats.mUpload.mDepth++;
+            break;
+        default:
+            break;
+        }
+    }
+    mIoTotals.Fill(stats.mIo);
+    mDecodeTotals.Fill(stats.mDecode);
+    mUploadTotals.Fill(stats.mUpload);
+
+    stats.mRequestCount = mAssets.size();
+    stats.mReadyCount = mReadyCount;
+    stats.mFailedCount = mFailedCount;
+    stats.mReadBytes = mReadBytes;
+    stats.mUploadedCount = mUploadedCount;
+    stats.mUploadedBytes = mUploadedBytes;
+    stats.mAverageLatencyMs = mTotals.mCount > 0 ? static_cast<float>(mTotals.mLatencyMs / mTotals.mCount) : 0.0f;
+    stats.mMaxLatencyMs = mTotals.mMaxLatencyMs;
+    return stats;
+}
+
+} // slvn_tech
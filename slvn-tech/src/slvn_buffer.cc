@@ -24,13 +24,16 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <cstring>
+
 #include <slvn_buffer.h>
 #include <slvn_debug.h>
 
 namespace slvn_tech
 {
 
-SlvnBuffer::SlvnBuffer(VkDevice* device, uint32_t bufferSize, VkBufferUsageFlags usage, VkSharingMode sharingMode)
+SlvnBuffer::SlvnBuffer(VkDevice* device, uint32_t bufferSize, VkBufferUsageFlags usage, VkSharingMode sharingMode) : mAllocator(nullptr),
+mBufferByteSize(bufferSize), mUsage(usage), mSharingMode(sharingMode)
 {
     VkBufferCreateInfo info = {};
     info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -42,7 +45,8 @@ SlvnBuffer::SlvnBuffer(VkDevice* device, uint32_t bufferSize, VkBufferUsageFlags
     assert(result == VK_SUCCESS);
 }
 
-SlvnBuffer::SlvnBuffer()
+SlvnBuffer::SlvnBuffer() : mBuffer(VK_NULL_HANDLE), mAllocator(nullptr), mBufferByteSize(0), mUsage(0),
+mSharingMode(VK_SHARING_MODE_EXCLUSIVE)
 {
     SLVN_PRINT("ENTER");
 }
@@ -54,67 +58,86 @@ SlvnBuffer::~SlvnBuffer()
 SlvnResult SlvnBuffer::Deinitialize(VkDevice* device)
 {
     vkDestroyBuffer(*device, mBuffer, nullptr);
-    vkFreeMemory(*device, mMemory, nullptr);
+    if (mAllocator)
+        mAllocator->Free(mAllocation);
     return SlvnResult::cOk;
 }
 
-std::optional<VkDeviceSize> SlvnBuffer::getAllocationSize(VkDevice* device) const
+SlvnResult SlvnBuffer::Release(SlvnDeletionQueue* deletionQueue, uint64_t lastUse)
 {
-    VkMemoryRequirements memReqs;
-    vkGetBufferMemoryRequirements(*device, mBuffer, &memReqs);
-    return std::make_optional<VkDeviceSize>(memReqs.size);
+    deletionQueue->DestroyBuffer(lastUse, mBuffer, mAllocation);
+    mBuffer = VK_NULL_HANDLE;
+    mAllocation = SlvnAllocation();
+    return SlvnResult::cOk;
 }
-   
-std::optional<uint32_t> SlvnBuffer::getMemoryTypeIndex(VkDevice* device, VkPhysicalDevice* physDev, uint32_t wantedFlags) const
-{
-    VkMemoryRequirements memReqs;
-    vkGetBufferMemoryRequirements(*device, mBuffer, &memReqs);
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(*physDev, &memProperties);
 
-    std::optional<uint32_t> value = std::nullopt;
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-    {
-        if ((memReqs.memoryTypeBits & (1 << i)) && ((memProperties.memoryTypes[i].propertyFlags & wantedFlags) == wantedFlags))
-        {
-            value = i;
-            break;
-        }
-    }
-    return value;
+SlvnResult SlvnBuffer::Allocate(SlvnMemoryAllocator* allocator, SlvnMemoryUsage usage, SlvnMemoryCategory category)
+{
+    mAllocator = allocator;
+    return mAllocator->AllocateBuffer(mBuffer, usage, mAllocation, category);
 }
 
-SlvnResult SlvnBuffer::Insert(VkDevice* device, VkPhysicalDevice* physDev, uint32_t size, const void* data)
+SlvnResult SlvnBuffer::Insert(SlvnMemoryAllocator* allocator, uint32_t size, const void* data, SlvnMemoryCategory category)
 {
-    uint32_t memFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    mBufferByteSize = size;
+    mAllocator = allocator;
+
+    SlvnResult result = mAllocator->AllocateBuffer(mBuffer, SlvnMemoryUsage::cCpuToGpu, mAllocation, category);
+    SLVN_ASSERT_RESULT(result);
+
+    // Host visible allocations stay mapped, coherent memory needs no flush.
+    std::memcpy(mAllocation.mMapped, data, size);
+    return SlvnResult::cOk;
+}
 
+SlvnResult SlvnBuffer::Upload(SlvnMemoryAllocator* allocator, SlvnUploadManager* uploader, uint32_t size, const void* data,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, SlvnMemoryCategory category)
+{
     mBufferByteSize = size;
+    mAllocator = allocator;
 
-    std::optional<VkDeviceSize> bufferSize = getAllocationSize(device);
-    assert(bufferSize);
+    SlvnResult result = mAllocator->AllocateBuffer(mBuffer, SlvnMemoryUsage::cGpuOnly, mAllocation, category);
+    SLVN_ASSERT_RESULT(result);
 
-    std::optional<uint32_t> bufferMemIndex = getMemoryTypeIndex(device, physDev, memFlags);
-    assert(bufferMemIndex);
+    return uploader->Upload(mBuffer, 0, data, size, dstStage, dstAccess);
+}
 
-    VkMemoryAllocateInfo allocateInfo = {};
-    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocateInfo.allocationSize = *bufferSize;
-    allocateInfo.memoryTypeIndex = *bufferMemIndex;
+SlvnResult SlvnBuffer::Relocate(VkDevice device, VkCommandBuffer cmd, SlvnDeletionQueue* deletionQueue, uint64_t lastUse)
+{
+    assert(IsRelocatable());
 
-    VkResult result = vkAllocateMemory(*device, &allocateInfo, nullptr, &mMemory);
-    assert(result == VK_SUCCESS);
+    VkBufferCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = mBufferByteSize;
+    info.usage = mUsage;
+    info.sharingMode = mSharingMode;
 
-    result = vkBindBufferMemory(*device, mBuffer, mMemory, 0);
-    assert(result == VK_SUCCESS);
+    VkBuffer buffer;
+    VkResult res = vkCreateBuffer(device, &info, nullptr, &buffer);
+    assert(res == VK_SUCCESS);
 
-    void* bufferMemory;
-    result = vkMapMemory(*device, mMemory, 0, size, 0, &bufferMemory);
-    assert(result == VK_SUCCESS);
+    SlvnAllocation allocation;
+    SlvnResult result = mAllocator->AllocateBufferForMove(buffer, mAllocation, allocation);
+    if (result != SlvnResult::cOk)
+    {
+        vkDestroyBuffer(device, buffer, nullptr);
+        return result;
+    }
 
-    std::memcpy(bufferMemory, data, size);
+    VkBufferCopy region = {};
+    region.size = mBufferByteSize;
+    vkCmdCopyBuffer(cmd, mBuffer, buffer, 1, &region);
 
-    vkUnmapMemory(*device, mMemory);
+    deletionQueue->DestroyBuffer(lastUse, mBuffer, mAllocation);
+    mBuffer = buffer;
+    mAllocation = allocation;
     return SlvnResult::cOk;
 }
 
+bool SlvnBuffer::IsRelocatable() const
+{
+    const VkBufferUsageFlags transfer = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    return mAllocator && mBuffer != VK_NULL_HANDLE && !mAllocation.IsDedicated() && (mUsage & transfer) == transfer;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,738 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+
+#include <slvn_bvh.h>
+#include <slvn_debug.h>
+
+#define SLVN_BVH_BIN_COUNT 16
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline float nodeCost(const SlvnBvhNode& node)
+{
+    float area = node.mBounds.GetSurfaceArea();
+    return node.IsLeaf() ? area * static_cast<float>(node.mCount) : area;
+}
+
+inline bool sameBounds(const SlvnAabb& a, const SlvnAabb& b)
+{
+    return a.mMin == b.mMin && a.mMax == b.mMax;
+}
+
+}
+
+SlvnBvh::SlvnBvh() : mRebuildThreshold(1.5f), mMaxLeafSize(4), mDirtyCount(0), mProxyCount(0), mBuildCost(0.0f), mCurrentCost(0.0f), mCostSum(0.0f),
+mLastRefitMs(0.0f), mLastRebuildMs(0.0f), mRebuildResult(), mRebuildRunning(false), mRebuildDone(false)
+{
+    SLVN_PRINT("Constructing SlvnBvh object");
+}
+
+SlvnBvh::~SlvnBvh()
+{
+    // The worker writes into mRebuildResult, which is destroyed before the worker itself.
+    mRebuildWorker.Wait();
+}
+
+uint32_t SlvnBvh::Insert(const SlvnAabb& bounds)
+{
+    uint32_t proxy;
+    if (!mFreeProxies.empty())
+    {
+        proxy = mFreeProxies.back();
+        mFreeProxies.pop_back();
+    }
+    else
+    {
+        proxy = static_cast<uint32_t>(mProxyBounds.size());
+        mProxyBounds.emplace_back();
+        mProxyLeaf.push_back(cInvalid);
+        mProxyAlive.push_back(0);
+        mProxyDirty.push_back(0);
+        mDirtyProxies.push_back(0);
+    }
+
+    // A reused proxy keeps its dirty flag, it is still listed until the next Refit().
+    mProxyBounds[proxy] = bounds;
+    mProxyLeaf[proxy] = cInvalid;
+    mProxyAlive[proxy] = 1;
+    mPending.push_back(proxy);
+    mProxyCount++;
+    return proxy;
+}
+
+void SlvnBvh::Remove(uint32_t proxy)
+{
+    assert(proxy < mProxyAlive.size() && mProxyAlive[proxy]);
+
+    mProxyAlive[proxy] = 0;
+    // Leaf still references the proxy until the next rebuild, mark it so that the leaf shrinks on refit.
+    markDirty(proxy);
+    if (mProxyLeaf[proxy] == cInvalid)
+    {
+        auto it = std::find(mPending.begin(), mPending.end(), proxy);
+        if (it != mPending.end())
+        {
+            *it = mPending.back();
+            mPending.pop_back();
+        }
+    }
+    mFreeProxies.push_back(proxy);
+    mProxyCount--;
+}
+
+void SlvnBvh::Update(uint32_t proxy, const SlvnAabb& bounds)
+{
+    mProxyBounds[proxy] = bounds;
+    markDirty(proxy);
+}
+
+void SlvnBvh::markDirty(uint32_t proxy)
+{
+    // Only the caller owning the proxy touches its flag, the slot in the list is claimed atomically.
+    if (mProxyDirty[proxy])
+        return;
+    mProxyDirty[proxy] = 1;
+    mDirtyProxies[mDirtyCount.fetch_add(1)] = proxy;
+}
+
+void SlvnBvh::refitLeaf(uint32_t nodeIndex)
+{
+    SlvnBvhNode& node = mNodes[nodeIndex];
+    SlvnAabb bounds;
+    for (uint32_t i = node.mLeftOrFirst; i < node.mLeftOrFirst + node.mCount; i++)
+    {
+        uint32_t proxy = mLeafProxies[i];
+        if (mProxyAlive[proxy] && mProxyLeaf[proxy] == nodeIndex)
+            bounds.Grow(mProxyBounds[proxy]);
+    }
+    node.mBounds = bounds;
+}
+
+void SlvnBvh::refitAll()
+{
+    // Children are always stored after their parent, so a reverse sweep visits them first.
+    for (size_t i = mNodes.size(); i-- > 0;)
+    {
+        SlvnBvhNode& node = mNodes[i];
+        if (node.IsLeaf())
+        {
+            refitLeaf(static_cast<uint32_t>(i));
+        }
+        else
+        {
+            node.mBounds = mNodes[node.mLeftOrFirst].mBounds;
+            node.mBounds.Grow(mNodes[node.mLeftOrFirst + 1].mBounds);
+        }
+    }
+}
+
+void SlvnBvh::Refit()
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint32_t dirtyCount = mDirtyCount.exchange(0);
+    std::vector<uint32_t> dirtyLeaves;
+    for (uint32_t i = 0; i < dirtyCount; i++)
+    {
+        uint32_t proxy = mDirtyProxies[i];
+        mProxyDirty[proxy] = 0;
+        if (mProxyLeaf[proxy] != cInvalid)
+            dirtyLeaves.push_back(mProxyLeaf[proxy]);
+    }
+    if (mNodes.empty())
+        return;
+
+    // When a large share of the scene moved it is cheaper to sweep every node once
+    // than to walk up from each leaf separately.
+    if (dirtyLeaves.size() * 8 > mNodes.size())
+    {
+        refitAll();
+        mCostSum = sumCost(mNodes);
+    }
+    else
+    {
+        std::sort(dirtyLeaves.begin(), dirtyLeaves.end());
+        dirtyLeaves.erase(std::unique(dirtyLeaves.begin(), dirtyLeaves.end()), dirtyLeaves.end());
+        for (uint32_t leaf : dirtyLeaves)
+        {
+            SlvnAabb previous = mNodes[leaf].mBounds;
+            float previousCost = nodeCost(mNodes[leaf]);
+            refitLeaf(leaf);
+            if (sameBounds(previous, mNodes[leaf].mBounds))
+                continue;
+            mCostSum += nodeCost(mNodes[leaf]) - previousCost;
+
+            // Ancestors whose bounds do not change end the walk, the ones above them are unaffected.
+            for (uint32_t parent = mParents[leaf]; parent != cInvalid; parent = mParents[parent])
+            {
+                SlvnBvhNode& node = mNodes[parent];
+                SlvnAabb bounds = mNodes[node.mLeftOrFirst].mBounds;
+                bounds.Grow(mNodes[node.mLeftOrFirst + 1].mBounds);
+                if (sameBounds(bounds, node.mBounds))
+                    break;
+                previousCost = nodeCost(node);
+                node.mBounds = bounds;
+                mCostSum += nodeCost(node) - previousCost;
+            }
+        }
+    }
+
+    mCurrentCost = computeCost(mNodes, mCostSum);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    mLastRefitMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+float SlvnBvh::sumCost(const std::vector<SlvnBvhNode>& nodes)
+{
+    float cost = 0.0f;
+    for (auto& node : nodes)
+    {
+        cost += nodeCost(node);
+    }
+    return cost;
+}
+
+float SlvnBvh::computeCost(const std::vector<SlvnBvhNode>& nodes, float costSum)
+{
+    if (nodes.empty())
+        return 0.0f;
+
+    float rootArea = nodes[0].mBounds.GetSurfaceArea();
+    if (rootArea <= 0.0f)
+        return 0.0f;
+    return costSum / rootArea;
+}
+
+void SlvnBvh::build(const std::vector<SlvnAabb>& bounds, const std::vector<uint8_t>& alive, uint32_t maxLeafSize, BuildResult& result)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    result.mNodes.clear();
+    result.mLeafProxies.clear();
+
+    // Bounds and centroids are partitioned together with the proxy ids so that
+    // every pass over a node range reads memory sequentially.
+    struct Item
+    {
+        SlvnAabb mBounds;
+        glm::vec3 mCentroid;
+        uint32_t mProxy;
+    };
+    std::vector<Item> items;
+    items.reserve(bounds.size());
+    for (uint32_t proxy = 0; proxy < bounds.size(); proxy++)
+    {
+        if (alive[proxy])
+            items.push_back({ bounds[proxy], bounds[proxy].GetCenter(), proxy });
+    }
+
+    uint32_t count = static_cast<uint32_t>(items.size());
+    if (count == 0)
+    {
+        result.mCost = 0.0f;
+        result.mBuildMs = 0.0f;
+        return;
+    }
+
+    result.mNodes.reserve(2 * (count / std::max(1u, maxLeafSize)) + 2);
+    result.mNodes.push_back({ SlvnAabb(), 0, 0 });
+
+    struct Task
+    {
+        uint32_t mNode;
+        uint32_t mBegin;
+        uint32_t mEnd;
+    };
+    std::vector<Task> stack;
+    stack.push_back({ 0, 0, count });
+
+    struct Bin
+    {
+        SlvnAabb mBounds;
+        uint32_t mCount = 0;
+    };
+
+    while (!stack.empty())
+    {
+        Task task = stack.back();
+        stack.pop_back();
+
+        SlvnAabb nodeBounds;
+        SlvnAabb centroidBounds;
+        for (uint32_t i = task.mBegin; i < task.mEnd; i++)
+        {
+            nodeBounds.Grow(items[i].mBounds);
+            centroidBounds.Grow(items[i].mCentroid);
+        }
+        result.mNodes[task.mNode].mBounds = nodeBounds;
+
+        uint32_t nodeCount = task.mEnd - task.mBegin;
+        if (nodeCount <= maxLeafSize)
+        {
+            result.mNodes[task.mNode].mLeftOrFirst = task.mBegin;
+            result.mNodes[task.mNode].mCount = nodeCount;
+            continue;
+        }
+
+        // Binned SAH, all three axes are binned in the same pass over the range.
+        glm::vec3 centroidExtent = centroidBounds.mMax - centroidBounds.mMin;
+        glm::vec3 scale;
+        for (int axis = 0; axis < 3; axis++)
+            scale[axis] = centroidExtent[axis] > 0.0f ? SLVN_BVH_BIN_COUNT / centroidExtent[axis] : 0.0f;
+
+        Bin bins[3][SLVN_BVH_BIN_COUNT];
+        for (uint32_t i = task.mBegin; i < task.mEnd; i++)
+        {
+            glm::vec3 binPosition = (items[i].mCentroid - centroidBounds.mMin) * scale;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                int bin = std::min(SLVN_BVH_BIN_COUNT - 1, static_cast<int>(binPosition[axis]));
+                bins[axis][bin].mCount++;
+                bins[axis][bin].mBounds.Grow(items[i].mBounds);
+            }
+        }
+
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        int bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (centroidExtent[axis] <= 0.0f)
+                continue;
+
+            float leftArea[SLVN_BVH_BIN_COUNT - 1];
+            uint32_t leftCount[SLVN_BVH_BIN_COUNT - 1];
+            SlvnAabb accumulated;
+            uint32_t accumulatedCount = 0;
+            for (int i = 0; i < SLVN_BVH_BIN_COUNT - 1; i++)
+            {
+                accumulated.Grow(bins[axis][i].mBounds);
+                accumulatedCount += bins[axis][i].mCount;
+                leftArea[i] = accumulated.GetSurfaceArea();
+                leftCount[i] = accumulatedCount;
+            }
+
+            accumulated = SlvnAabb();
+            accumulatedCount = 0;
+            for (int i = SLVN_BVH_BIN_COUNT - 1; i > 0; i--)
+            {
+                accumulated.Grow(bins[axis][i].mBounds);
+                accumulatedCount += bins[axis][i].mCount;
+                float cost = leftArea[i - 1] * leftCount[i - 1] + accumulated.GetSurfaceArea() * accumulatedCount;
+                if (leftCount[i - 1] > 0 && accumulatedCount > 0 && cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        uint32_t middle;
+        if (bestAxis >= 0)
+        {
+            float axisScale = scale[bestAxis];
+            float minimum = centroidBounds.mMin[bestAxis];
+            auto it = std::partition(items.begin() + task.mBegin, items.begin() + task.mEnd, [&](const Item& item)
+                {
+                    int bin = std::min(SLVN_BVH_BIN_COUNT - 1, static_cast<int>((item.mCentroid[bestAxis] - minimum) * axisScale));
+                    return bin < bestSplit;
+                });
+            middle = static_cast<uint32_t>(it - items.begin());
+        }
+        else
+        {
+            // All centroids coincide, any split is as good as another.
+            middle = task.mBegin + nodeCount / 2;
+        }
+
+        uint32_t left = static_cast<uint32_t>(result.mNodes.size());
+        result.mNodes[task.mNode].mLeftOrFirst = left;
+        result.mNodes[task.mNode].mCount = 0;
+        result.mNodes.push_back({ SlvnAabb(), 0, 0 });
+        result.mNodes.push_back({ SlvnAabb(), 0, 0 });
+
+        stack.push_back({ left + 1, middle, task.mEnd });
+        stack.push_back({ left, task.mBegin, middle });
+    }
+
+    result.mLeafProxies.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        result.mLeafProxies[i] = items[i].mProxy;
+
+    result.mCost = computeCost(result.mNodes, sumCost(result.mNodes));
+
+    auto end = std::chrono::high_resolution_clock::now();
+    result.mBuildMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void SlvnBvh::adopt(BuildResult& result)
+{
+    mNodes = std::move(result.mNodes);
+    mLeafProxies = std::move(result.mLeafProxies);
+    mLastRebuildMs = result.mBuildMs;
+
+    mParents.assign(mNodes.size(), cInvalid);
+    std::fill(mProxyLeaf.begin(), mProxyLeaf.end(), cInvalid);
+    for (uint32_t i = 0; i < mNodes.size(); i++)
+    {
+        const SlvnBvhNode& node = mNodes[i];
+        if (node.IsLeaf())
+        {
+            for (uint32_t j = node.mLeftOrFirst; j < node.mLeftOrFirst + node.mCount; j++)
+                mProxyLeaf[mLeafProxies[j]] = i;
+        }
+        else
+        {
+            mParents[node.mLeftOrFirst] = i;
+            mParents[node.mLeftOrFirst + 1] = i;
+        }
+    }
+
+    // Proxies can have been inserted or removed while an asynchronous build was running.
+    mPending.clear();
+    for (uint32_t proxy = 0; proxy < mProxyAlive.size(); proxy++)
+    {
+        if (mProxyAlive[proxy] && mProxyLeaf[proxy] == cInvalid)
+            mPending.push_back(proxy);
+    }
+
+    refitAll();
+    std::fill(mProxyDirty.begin(), mProxyDirty.end(), 0);
+    mDirtyCount = 0;
+    mCostSum = sumCost(mNodes);
+    mBuildCost = computeCost(mNodes, mCostSum);
+    mCurrentCost = mBuildCost;
+}
+
+void SlvnBvh::Rebuild()
+{
+    SLVN_PRINT("ENTER");
+
+    if (mRebuildRunning)
+        mRebuildWorker.Wait();
+    mRebuildRunning = false;
+    mRebuildDone = false;
+
+    BuildResult result;
+    build(mProxyBounds, mProxyAlive, mMaxLeafSize, result);
+    adopt(result);
+
+    SLVN_PRINT("EXIT");
+}
+
+void SlvnBvh::RequestRebuild()
+{
+    if (mRebuildRunning)
+        return;
+
+    mSnapshotBounds = mProxyBounds;
+    mSnapshotAlive = mProxyAlive;
+    mRebuildRunning = true;
+    mRebuildWorker.addJob([this]
+        {
+            build(mSnapshotBounds, mSnapshotAlive, mMaxLeafSize, mRebuildResult);
+            mRebuildDone = true;
+        });
+}
+
+bool SlvnBvh::PollRebuild()
+{
+    if (!mRebuildDone)
+        return false;
+
+    adopt(mRebuildResult);
+    mRebuildDone = false;
+    mRebuildRunning = false;
+    return true;
+}
+
+bool SlvnBvh::NeedsRebuild() const
+{
+    if (mRebuildRunning)
+        return false;
+    if (mPending.size() > std::max<size_t>(64, mProxyCount / 8))
+        return true;
+    return mBuildCost > 0.0f && mCurrentCost > mBuildCost * mRebuildThreshold;
+}
+
+void SlvnBvh::collectSubtree(uint32_t nodeIndex, std::vector<uint32_t>& result) const
+{
+    // Subtree proxies are not contiguous in mLeafProxies after removals, so walk the leaves.
+    uint32_t stack[64];
+    uint32_t stackSize = 0;
+    stack[stackSize++] = nodeIndex;
+    while (stackSize > 0)
+    {
+        uint32_t current = stack[--stackSize];
+        const SlvnBvhNode& node = mNodes[current];
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.mLeftOrFirst; i < node.mLeftOrFirst + node.mCount; i++)
+            {
+                uint32_t proxy = mLeafProxies[i];
+                if (mProxyAlive[proxy] && mProxyLeaf[proxy] == current)
+                    result.push_back(proxy);
+            }
+        }
+        else if (stackSize + 2 <= 64)
+        {
+            stack[stackSize++] = node.mLeftOrFirst + 1;
+            stack[stackSize++] = node.mLeftOrFirst;
+        }
+        else
+        {
+            collectSubtree(node.mLeftOrFirst, result);
+            collectSubtree(node.mLeftOrFirst + 1, result);
+        }
+    }
+}
+
+template<typename NodeTest, typename ProxyTest>
+void SlvnBvh::query(NodeTest nodeTest, ProxyTest proxyTest, std::vector<uint32_t>& result) const
+{
+    if (!mNodes.empty())
+    {
+        struct Entry
+        {
+            uint32_t mNode;
+            uint32_t mMask;
+        };
+        std::vector<Entry> stack;
+        stack.reserve(64);
+        stack.push_back({ 0, SlvnFrustum::cAllPlanesMask });
+
+        while (!stack.empty())
+        {
+            Entry entry = stack.back();
+            stack.pop_back();
+
+            const SlvnBvhNode& node = mNodes[entry.mNode];
+            uint32_t mask = entry.mMask;
+            SlvnContainment containment = nodeTest(node.mBounds, mask);
+            if (containment == SlvnContainment::cOutside)
+                continue;
+
+            // Whole subtree accepted without testing any of its children.
+            if (containment == SlvnContainment::cInside)
+            {
+                collectSubtree(entry.mNode, result);
+                continue;
+            }
+
+            if (node.IsLeaf())
+            {
+                for (uint32_t i = node.mLeftOrFirst; i < node.mLeftOrFirst + node.mCount; i++)
+                {
+                    uint32_t proxy = mLeafProxies[i];
+                    if (mProxyAlive[proxy] && mProxyLeaf[proxy] == entry.mNode && proxyTest(mProxyBounds[proxy], mask))
+                        result.push_back(proxy);
+                }
+            }
+            else
+            {
+                stack.push_back({ node.mLeftOrFirst + 1, mask });
+                stack.push_back({ node.mLeftOrFirst, mask });
+            }
+        }
+    }
+
+    for (uint32_t proxy : mPending)
+    {
+        if (proxyTest(mProxyBounds[proxy], SlvnFrustum::cAllPlanesMask))
+            result.push_back(proxy);
+    }
+}
+
+void SlvnBvh::QueryFrustum(const SlvnFrustum& frustum, std::vector<uint32_t>& result) const
+{
+    query([&](const SlvnAabb& bounds, uint32_t& mask)
+        {
+            return SlvnClassify(bounds, frustum, mask);
+        },
+        [&](const SlvnAabb& bounds, uint32_t mask)
+        {
+            return SlvnClassify(bounds, frustum, mask) != SlvnContainment::cOutside;
+        }, result);
+}
+
+void SlvnBvh::QuerySphere(const SlvnSphere& sphere, std::vector<uint32_t>& result) const
+{
+    query([&](const SlvnAabb& bounds, uint32_t&)
+        {
+            if (!SlvnOverlaps(bounds, sphere))
+                return SlvnContainment::cOutside;
+            glm::vec3 farthest = glm::max(glm::abs(bounds.mMin - sphere.mCenter), glm::abs(bounds.mMax - sphere.mCenter));
+            return glm::dot(farthest, farthest) <= sphere.mRadius * sphere.mRadius ? SlvnContainment::cInside : SlvnContainment::cIntersecting;
+        },
+        [&](const SlvnAabb& bounds, uint32_t)
+        {
+            return SlvnOverlaps(bounds, sphere);
+        }, result);
+}
+
+void SlvnBvh::QueryAabb(const SlvnAabb& box, std::vector<uint32_t>& result) const
+{
+    query([&](const SlvnAabb& bounds, uint32_t&)
+        {
+            if (!SlvnOverlaps(bounds, box))
+                return SlvnContainment::cOutside;
+            return box.Contains(bounds) ? SlvnContainment::cInside : SlvnContainment::cIntersecting;
+        },
+        [&](const SlvnAabb& bounds, uint32_t)
+        {
+            return SlvnOverlaps(bounds, box);
+        }, result);
+}
+
+void SlvnBvh::QueryRay(const SlvnRay& ray, float maxDistance, std::vector<SlvnBvhRayHit>& result) const
+{
+    std::vector<uint32_t> proxies;
+    query([&](const SlvnAabb& bounds, uint32_t&)
+        {
+            float t;
+            return SlvnIntersect(bounds, ray, maxDistance, t) ? SlvnContainment::cIntersecting : SlvnContainment::cOutside;
+        },
+        [&](const SlvnAabb& bounds, uint32_t)
+        {
+            float t;
+            return SlvnIntersect(bounds, ray, maxDistance, t);
+        }, proxies);
+
+    for (uint32_t proxy : proxies)
+    {
+        float t = 0.0f;
+        SlvnIntersect(mProxyBounds[proxy], ray, maxDistance, t);
+        result.push_back({ proxy, t });
+    }
+    std::sort(result.begin(), result.end(), [](const SlvnBvhRayHit& a, const SlvnBvhRayHit& b) { return a.mDistance < b.mDistance; });
+}
+
+std::optional<SlvnBvhRayHit> SlvnBvh::Raycast(const SlvnRay& ray, float maxDistance) const
+{
+    std::optional<SlvnBvhRayHit> closest = std::nullopt;
+    float best = maxDistance;
+
+    for (uint32_t proxy : mPending)
+    {
+        float t;
+        if (SlvnIntersect(mProxyBounds[proxy], ray, best, t))
+        {
+            best = t;
+            closest = SlvnBvhRayHit{ proxy, t };
+        }
+    }
+
+    if (mNodes.empty())
+        return closest;
+
+    struct Entry
+    {
+        uint32_t mNode;
+        float mDistance;
+    };
+    std::vector<Entry> stack;
+    stack.reserve(64);
+
+    float rootDistance;
+    if (SlvnIntersect(mNodes[0].mBounds, ray, best, rootDistance))
+        stack.push_back({ 0, rootDistance });
+
+    while (!stack.empty())
+    {
+        Entry entry = stack.back();
+        stack.pop_back();
+        if (entry.mDistance > best)
+            continue;
+
+        const SlvnBvhNode& node = mNodes[entry.mNode];
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.mLeftOrFirst; i < node.mLeftOrFirst + node.mCount; i++)
+            {
+                uint32_t proxy = mLeafProxies[i];
+                float t;
+                if (mProxyAlive[proxy] && mProxyLeaf[proxy] == entry.mNode && SlvnIntersect(mProxyBounds[proxy], ray, best, t))
+                {
+                    best = t;
+                    closest = SlvnBvhRayHit{ proxy, t };
+                }
+            }
+            continue;
+        }
+
+        // Visit the nearer child first so that it can tighten the search distance.
+        float tLeft, tRight;
+        bool hitLeft = SlvnIntersect(mNodes[node.mLeftOrFirst].mBounds, ray, best, tLeft);
+        bool hitRight = SlvnIntersect(mNodes[node.mLeftOrFirst + 1].mBounds, ray, best, tRight);
+        if (hitLeft && hitRight)
+        {
+            if (tLeft <= tRight)
+            {
+                stack.push_back({ node.mLeftOrFirst + 1, tRight });
+                stack.push_back({ node.mLeftOrFirst, tLeft });
+            }
+            else
+            {
+                stack.push_back({ node.mLeftOrFirst, tLeft });
+                stack.push_back({ node.mLeftOrFirst + 1, tRight });
+            }
+        }
+        else if (hitLeft)
+        {
+            stack.push_back({ node.mLeftOrFirst, tLeft });
+        }
+        else if (hitRight)
+        {
+            stack.push_back({ node.mLeftOrFirst + 1, tRight });
+        }
+    }
+    return closest;
+}
+
+SlvnBvhStats SlvnBvh::GetStats() const
+{
+    SlvnBvhStats stats = {};
+    stats.mProxyCount = mProxyCount;
+    stats.mPendingCount = static_cast<uint32_t>(mPending.size());
+    stats.mNodeCount = static_cast<uint32_t>(mNodes.size());
+    stats.mBuildCost = mBuildCost;
+    stats.mCurrentCost = mCurrentCost;
+    stats.mLastRefitMs = mLastRefitMs;
+    stats.mLastRebuildMs = mLastRebuildMs;
+    return stats;
+}
+
+} // slvn_tech
@@ -0,0 +1,179 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <cstring>
+
+#include <slvn_command_encoder.h>
+
+namespace slvn_tech
+{
+
+uint32_t SlvnEncoderStats::GetIssued() const
+{
+    uint32_t total = 0;
+    for (uint32_t count : mIssued)
+    {
+        total += count;
+    }
+    return total;
+}
+
+uint32_t SlvnEncoderStats::GetElided() const
+{
+    uint32_t total = 0;
+    for (uint32_t count : mElided)
+    {
+        total += count;
+    }
+    return total;
+}
+
+void SlvnEncoderStats::Add(const SlvnEncoderStats& other)
+{
+    for (uint32_t i = 0; i < static_cast<uint32_t>(SlvnEncoderCall::cCount); i++)
+    {
+        mIssued[i] += other.mIssued[i];
+        mElided[i] += other.mElided[i];
+    }
+}
+
+SlvnCommandEncoder::SlvnCommandEncoder() : mCmdBuffer(VK_NULL_HANDLE), mStats()
+{
+    Begin(VK_NULL_HANDLE);
+}
+
+SlvnCommandEncoder::~SlvnCommandEncoder()
+{
+}
+
+void SlvnCommandEncoder::Begin(VkCommandBuffer cmdBuffer)
+{
+    mCmdBuffer = cmdBuffer;
+    mViewportValid = false;
+    mScissorValid = false;
+    mPipeline = VK_NULL_HANDLE;
+    mVertexBuffer = VK_NULL_HANDLE;
+    mVertexBufferOffset = 0;
+    mIndexBuffer = VK_NULL_HANDLE;
+    mIndexBufferOffset = 0;
+    mIndexType = VK_INDEX_TYPE_UINT32;
+    mPushLayout = VK_NULL_HANDLE;
+    mPushStages = 0;
+    mPushOffset = 0;
+    mPushSize = 0;
+}
+
+void SlvnCommandEncoder::SetViewport(const VkViewport& viewport)
+{
+    bool elided = mViewportValid && std::memcmp(&mViewport, &viewport, sizeof(VkViewport)) == 0;
+    count(SlvnEncoderCall::cSetViewport, elided);
+    if (elided)
+        return;
+
+    vkCmdSetViewport(mCmdBuffer, 0, 1, &viewport);
+    mViewport = viewport;
+    mViewportValid = true;
+}
+
+void SlvnCommandEncoder::SetScissor(const VkRect2D& scissor)
+{
+    bool elided = mScissorValid && std::memcmp(&mScissor, &scissor, sizeof(VkRect2D)) == 0;
+    count(SlvnEncoderCall::cSetScissor, elided);
+    if (elided)
+        return;
+
+    vkCmdSetScissor(mCmdBuffer, 0, 1, &scissor);
+    mScissor = scissor;
+    mScissorValid = true;
+}
+
+void SlvnCommandEncoder::BindPipeline(VkPipeline pipeline)
+{
+    bool elided = mPipeline == pipeline;
+    count(SlvnEncoderCall::cBindPipeline, elided);
+    if (elided)
+        return;
+
+    vkCmdBindPipeline(mCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    mPipeline = pipeline;
+}
+
+void SlvnCommandEncoder::BindVertexBuffer(VkBuffer buffer, VkDeviceSize offset)
+{
+    bool elided = mVertexBuffer == buffer && mVertexBufferOffset == offset;
+    count(SlvnEncoderCall::cBindVertexBuffer, elided);
+    if (elided)
+        return;
+
+    vkCmdBindVertexBuffers(mCmdBuffer, 0, 1, &buffer, &offset);
+    mVertexBuffer = buffer;
+    mVertexBufferOffset = offset;
+}
+
+void SlvnCommandEncoder::BindIndexBuffer(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
+{
+    bool elided = mIndexBuffer == buffer && mIndexBufferOffset == offset && mIndexType == indexType;
+    count(SlvnEncoderCall::cBindIndexBuffer, elided);
+    if (elided)
+        return;
+
+    vkCmdBindIndexBuffer(mCmdBuffer, buffer, offset, indexType);
+    mIndexBuffer = buffer;
+    mIndexBufferOffset = offset;
+    mIndexType = indexType;
+}
+
+void SlvnCommandEncoder::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stages, uint32_t offset, uint32_t size, const void* data)
+{
+    assert(size <= cMaxPushConstantSize);
+
+    bool elided = mPushLayout == layout && mPushStages == stages && mPushOffset == offset && mPushSize == size &&
+        std::memcmp(mPushData, data, size) == 0;
+    count(SlvnEncoderCall::cPushConstants, elided);
+    if (elided)
+        return;
+
+    vkCmdPushConstants(mCmdBuffer, layout, stages, offset, size, data);
+    mPushLayout = layout;
+    mPushStages = stages;
+    mPushOffset = offset;
+    mPushSize = size;
+    std::memcpy(mPushData, data, size);
+}
+
+void SlvnCommandEncoder::DrawIndexed(uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset)
+{
+    count(SlvnEncoderCall::cDrawIndexed, false);
+    vkCmdDrawIndexed(mCmdBuffer, indexCount, 1, firstIndex, vertexOffset, 0);
+}
+
+void SlvnCommandEncoder::ResetStats()
+{
+    mStats = SlvnEncoderStats();
+}
+
+} // slvn_tech
@@ -0,0 +1,182 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <chrono>
+
+#include <slvn_defragmenter.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnDefragmenter::SlvnDefragmenter() : mTimeBudgetMs(0.25f), mMaxBytesPerFrame(16ull * 1024 * 1024), mMaxMovesPerFrame(64),
+mMaxSourceUtilization(0.75f), mDevice(VK_NULL_HANDLE), mAllocator(nullptr), mDeletionQueue(nullptr), mStats()
+{
+}
+
+SlvnDefragmenter::~SlvnDefragmenter()
+{
+}
+
+SlvnResult SlvnDefragmenter::Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnDeletionQueue* deletionQueue)
+{
+    mDevice = device;
+    mAllocator = allocator;
+    mDeletionQueue = deletionQueue;
+    mStats = SlvnDefragmentationStats();
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnDefragmenter::Deinitialize()
+{
+    if (!mBuffers.empty())
+        SLVN_PRINT("WARNING; " << mBuffers.size() << " buffers still registered");
+    mBuffers.clear();
+    return SlvnResult::cOk;
+}
+
+void SlvnDefragmenter::Register(SlvnBuffer* buffer, std::function<bool()> canMove)
+{
+    mBuffers.push_back({ buffer, std::move(canMove) });
+}
+
+void SlvnDefragmenter::Unregister(SlvnBuffer* buffer)
+{
+    auto it = std::find_if(mBuffers.begin(), mBuffers.end(), [buffer](const Registration& registration) { return registration.mBuffer == buffer; });
+    if (it != mBuffers.end())
+    {
+        *it = mBuffers.back();
+        mBuffers.pop_back();
+    }
+}
+
+uint32_t SlvnDefragmenter::Step(VkCommandBuffer cmd, uint64_t lastUse)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<SlvnMemoryBlockInfo> blocks = mAllocator->GetBlockInfos();
+    std::optional<uint32_t> source = selectSourceBlock(blocks);
+
+    SlvnMemoryStats before = mAllocator->GetStats();
+    uint32_t moveCount = 0;
+    VkDeviceSize bytesMoved = 0;
+    for (const Registration& registration : mBuffers)
+    {
+        SlvnBuffer* buffer = registration.mBuffer;
+        if (!source || !registration.IsMovable() || buffer->GetAllocation().mBlock != *source)
+            continue;
+
+        float elapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        VkDeviceSize size = buffer->GetAllocation().mSize;
+        if (moveCount >= mMaxMovesPerFrame || elapsedMs >= mTimeBudgetMs || (moveCount > 0 && bytesMoved + size > mMaxBytesPerFrame))
+            break;
+
+        if (moveCount == 0)
+        {
+            // Whatever earlier frames wrote to the buffers has to land before it is copied.
+            VkMemoryBarrier barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
+
+        if (buffer->Relocate(mDevice, cmd, mDeletionQueue, lastUse) != SlvnResult::cOk)
+        {
+            // The other blocks are full, try again once something has been freed.
+            mStats.mFailedMoveCount++;
+            break;
+        }
+        moveCount++;
+        bytesMoved += size;
+    }
+
+    if (moveCount > 0)
+    {
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+    // The source ranges stay reserved until the deletion queue retires them, so "after" only
+    // reflects where the moved buffers went; the drained block shows up as released later.
+    SlvnMemoryStats after = moveCount > 0 ? mAllocator->GetStats() : before;
+    mStats.mBytesMoved = bytesMoved;
+    mStats.mMoveCount = moveCount;
+    mStats.mFragmentationBefore = before.mFragmentation;
+    mStats.mFragmentationAfter = after.mFragmentation;
+    mStats.mBlockCountBefore = before.mBlockCount;
+    mStats.mBlockCountAfter = after.mBlockCount;
+    mStats.mStepMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    mStats.mTotalBytesMoved += bytesMoved;
+    mStats.mTotalMoveCount += moveCount;
+    return moveCount;
+}
+
+std::optional<uint32_t> SlvnDefragmenter::selectSourceBlock(const std::vector<SlvnMemoryBlockInfo>& blocks) const
+{
+    std::vector<uint32_t> movableCounts(blocks.empty() ? 0 : blocks.back().mBlock + 1, 0);
+    for (const Registration& registration : mBuffers)
+    {
+        if (registration.IsMovable() && registration.mBuffer->GetAllocation().mBlock < movableCounts.size())
+            movableCounts[registration.mBuffer->GetAllocation().mBlock]++;
+    }
+
+    std::optional<uint32_t> source = std::nullopt;
+    VkDeviceSize sourceUsed = 0;
+    for (const SlvnMemoryBlockInfo& block : blocks)
+    {
+        if (movableCounts[block.mBlock] == 0 || block.mUsed > block.mSize * mMaxSourceUtilization)
+            continue;
+
+        // Only drain a block when its siblings can take everything in it.
+        VkDeviceSize siblingFree = 0;
+        for (const SlvnMemoryBlockInfo& sibling : blocks)
+        {
+            if (sibling.mBlock != block.mBlock && sibling.mMemoryType == block.mMemoryType && sibling.mTiling == block.mTiling)
+                siblingFree += sibling.mSize - sibling.mUsed;
+        }
+        if (siblingFree < block.mUsed)
+            continue;
+
+        if (!source || block.mUsed < sourceUsed)
+        {
+            source = block.mBlock;
+            sourceUsed = block.mUsed;
+        }
+    }
+    return source;
+}
+
+bool SlvnDefragmenter::Registration::IsMovable() const
+{
+    return mBuffer->IsRelocatable() && (!mCanMove || mCanMove());
+}
+
+} // slvn_tech
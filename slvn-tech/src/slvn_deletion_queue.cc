@@ -0,0 +1,186 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <vector>
+
+#include <slvn_deletion_queue.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+#define SLVN_DELETION_QUEUE_DESTROY(name, HandleType, member, type)             \
+void SlvnDeletionQueue::name(uint64_t lastUse, HandleType handle)               \
+{                                                                               \
+    Entry entry = {};                                                           \
+    entry.mLastUse = lastUse;                                                   \
+    entry.mType = type;                                                         \
+    entry.member = handle;                                                      \
+    push(entry);                                                                \
+}
+
+SLVN_DELETION_QUEUE_DESTROY(DestroyImageView, VkImageView, mImageView, SlvnDeletionType::cImageView)
+SLVN_DELETION_QUEUE_DESTROY(DestroySampler, VkSampler, mSampler, SlvnDeletionType::cSampler)
+SLVN_DELETION_QUEUE_DESTROY(DestroyFramebuffer, VkFramebuffer, mFramebuffer, SlvnDeletionType::cFramebuffer)
+SLVN_DELETION_QUEUE_DESTROY(DestroyPipeline, VkPipeline, mPipeline, SlvnDeletionType::cPipeline)
+SLVN_DELETION_QUEUE_DESTROY(DestroyPipelineLayout, VkPipelineLayout, mPipelineLayout, SlvnDeletionType::cPipelineLayout)
+SLVN_DELETION_QUEUE_DESTROY(DestroyShaderModule, VkShaderModule, mShaderModule, SlvnDeletionType::cShaderModule)
+SLVN_DELETION_QUEUE_DESTROY(DestroyCommandPool, VkCommandPool, mCommandPool, SlvnDeletionType::cCommandPool)
+SLVN_DELETION_QUEUE_DESTROY(DestroyDescriptorPool, VkDescriptorPool, mDescriptorPool, SlvnDeletionType::cDescriptorPool)
+SLVN_DELETION_QUEUE_DESTROY(DestroyQueryPool, VkQueryPool, mQueryPool, SlvnDeletionType::cQueryPool)
+SLVN_DELETION_QUEUE_DESTROY(FreeMemory, VkDeviceMemory, mDeviceMemory, SlvnDeletionType::cDeviceMemory)
+
+#undef SLVN_DELETION_QUEUE_DESTROY
+
+SlvnDeletionQueue::SlvnDeletionQueue() : mDevice(VK_NULL_HANDLE), mAllocator(nullptr)
+{
+}
+
+SlvnDeletionQueue::~SlvnDeletionQueue()
+{
+    if (!mEntries.empty())
+        SLVN_PRINT("ERROR; deletion queue destroyed with pending entries, memory leak!");
+}
+
+SlvnResult SlvnDeletionQueue::Initialize(VkDevice device, SlvnMemoryAllocator* allocator)
+{
+    mDevice = device;
+    mAllocator = allocator;
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnDeletionQueue::Deinitialize()
+{
+    Collect(UINT64_MAX);
+    return SlvnResult::cOk;
+}
+
+void SlvnDeletionQueue::DestroyBuffer(uint64_t lastUse, VkBuffer buffer, const SlvnAllocation& allocation)
+{
+    Entry entry = {};
+    entry.mLastUse = lastUse;
+    entry.mType = SlvnDeletionType::cBuffer;
+    entry.mBuffer = buffer;
+    entry.mAllocation = allocation;
+    push(entry);
+}
+
+void SlvnDeletionQueue::DestroyImage(uint64_t lastUse, VkImage image, const SlvnAllocation& allocation)
+{
+    Entry entry = {};
+    entry.mLastUse = lastUse;
+    entry.mType = SlvnDeletionType::cImage;
+    entry.mImage = image;
+    entry.mAllocation = allocation;
+    push(entry);
+}
+
+void SlvnDeletionQueue::Defer(uint64_t lastUse, std::function<void()> callback)
+{
+    Entry entry = {};
+    entry.mLastUse = lastUse;
+    entry.mType = SlvnDeletionType::cCallback;
+    entry.mCallback = std::move(callback);
+    push(entry);
+}
+
+uint32_t SlvnDeletionQueue::Collect(uint64_t completedFrame)
+{
+    // Take the finished entries out under the lock, destroy them outside of it so that
+    // callbacks may queue more work.
+    std::vector<Entry> finished;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        while (!mEntries.empty() && mEntries.front().mLastUse <= completedFrame)
+        {
+            finished.push_back(std::move(mEntries.front()));
+            mEntries.pop_front();
+        }
+    }
+
+    for (auto& entry : finished)
+    {
+        destroy(entry);
+    }
+    return static_cast<uint32_t>(finished.size());
+}
+
+void SlvnDeletionQueue::push(Entry& entry)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEntries.push_back(std::move(entry));
+}
+
+void SlvnDeletionQueue::destroy(Entry& entry)
+{
+    switch (entry.mType)
+    {
+    case SlvnDeletionType::cBuffer:
+        vkDestroyBuffer(mDevice, entry.mBuffer, nullptr);
+        break;
+    case SlvnDeletionType::cImage:
+        vkDestroyImage(mDevice, entry.mImage, nullptr);
+        break;
+    case SlvnDeletionType::cImageView:
+        vkDestroyImageView(mDevice, entry.mImageView, nullptr);
+        break;
+    case SlvnDeletionType::cSampler:
+        vkDestroySampler(mDevice, entry.mSampler, nullptr);
+        break;
+    case SlvnDeletionType::cFramebuffer:
+        vkDestroyFramebuffer(mDevice, entry.mFramebuffer, nullptr);
+        break;
+    case SlvnDeletionType::cPipeline:
+        vkDestroyPipeline(mDevice, entry.mPipeline, nullptr);
+        break;
+    case SlvnDeletionType::cPipelineLayout:
+        vkDestroyPipelineLayout(mDevice, entry.mPipelineLayout, nullptr);
+        break;
+    case SlvnDeletionType::cShaderModule:
+        vkDestroyShaderModule(mDevice, entry.mShaderModule, nullptr);
+        break;
+    case SlvnDeletionType::cCommandPool:
+        vkDestroyCommandPool(mDevice, entry.mCommandPool, nullptr);
+        break;
+    case SlvnDeletionType::cDescriptorPool:
+        vkDestroyDescriptorPool(mDevice, entry.mDescriptorPool, nullptr);
+        break;
+    case SlvnDeletionType::cQueryPool:
+        vkDestroyQueryPool(mDevice, entry.mQueryPool, nullptr);
+        break;
+    case SlvnDeletionType::cDeviceMemory:
+        vkFreeMemory(mDevice, entry.mDeviceMemory, nullptr);
+        break;
+    case SlvnDeletionType::cCallback:
+        entry.mCallback();
+        break;
+    }
+
+    if (entry.mAllocation.mMemory != VK_NULL_HANDLE)
+        mAllocator->Free(entry.mAllocation);
+}
+
+} // slvn_tech
@@ -38,7 +38,9 @@ SlvnDevice::SlvnDevice() : mPhysicalDevice(),
                            mLogicalDevice(), 
                            mPrimaryDevice(false), 
                            mState(SlvnState::cNotInitialized),
-                           mQueueFamilyIndex(255)
+                           mQueueFamilyIndex(255),
+                           mTransferQueueFamilyIndex(255),
+                           mBufferDeviceAddress(false)
 {
     SLVN_PRINT("Constructing SlvnDevice object");
 
@@ -97,6 +99,20 @@ SlvnResult SlvnDevice::GetDeviceQueue(VkQueue& queue, uint16_t queueIndex)
     return SlvnResult::cOk;
 }
 
+SlvnResult SlvnDevice::GetTransferQueue(VkQueue& queue)
+{
+    SLVN_PRINT("ENTER");
+
+    // Falls back to the first queue of the graphics family when there is no separate transfer family.
+    vkGetDeviceQueue(mLogicalDevice,
+        GetTransferQueueFamilyIndex(),
+        0,
+        &queue);
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
 SlvnResult SlvnDevice::CreateLogicalDevice()
 {
     SLVN_PRINT("ENTER");
@@ -106,33 +122,59 @@ SlvnResult SlvnDevice::CreateLogicalDevice()
     queryDeviceExtensions(enabledExtensions, enabledExtensionCount);
 
     uint8_t queueFamilyIndex = GetViableQueueFamilyIndex();
-    VkDeviceQueueCreateInfo queueInfo = {};
+    std::vector<VkDeviceQueueCreateInfo> queueInfos(1);
     uint32_t queueCount = mQueueFamilyProperties[queueFamilyIndex].queueCount;
-    queueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-    queueInfo.flags = 0;
-    queueInfo.queueFamilyIndex = queueFamilyIndex;
-    queueInfo.queueCount = queueCount;
+    queueInfos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+    queueInfos[0].flags = 0;
+    queueInfos[0].queueFamilyIndex = queueFamilyIndex;
+    queueInfos[0].queueCount = queueCount;
    
     // TODO; change default priorities to something that makes more sense.
     std::vector<float> queuePriorities;
     queuePriorities.resize(queueCount, 1.0f);
-    queueInfo.pQueuePriorities = queuePriorities.data();
+    queueInfos[0].pQueuePriorities = queuePriorities.data();
+
+    // One queue from a dedicated transfer family for uploads, if the device has one.
+    uint8_t transferQueueFamilyIndex = GetTransferQueueFamilyIndex();
+    if (transferQueueFamilyIndex != queueFamilyIndex)
+    {
+        VkDeviceQueueCreateInfo transferQueueInfo = {};
+        transferQueueInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        transferQueueInfo.queueFamilyIndex = transferQueueFamilyIndex;
+        transferQueueInfo.queueCount = 1;
+        transferQueueInfo.pQueuePriorities = queuePriorities.data();
+        queueInfos.push_back(transferQueueInfo);
+    }
 
     // TODO CRITICAL; dont blindly enable all features, could come with performance impacts.
     VkPhysicalDeviceFeatures features = {};
     vkGetPhysicalDeviceFeatures(mPhysicalDevice, &features);
 
+    // Buffer device addresses are core in 1.2, used by the vertex pulling path.
+    VkPhysicalDeviceBufferDeviceAddressFeatures addressFeatures = {};
+    addressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+    if (mPhyProperties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &addressFeatures;
+        vkGetPhysicalDeviceFeatures2(mPhysicalDevice, &features2);
+    }
+    addressFeatures.bufferDeviceAddressCaptureReplay = VK_FALSE;
+    addressFeatures.bufferDeviceAddressMultiDevice = VK_FALSE;
+    mBufferDeviceAddress = addressFeatures.bufferDeviceAddress == VK_TRUE;
+
     VkDeviceCreateInfo info = {};
     info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-    info.pNext = nullptr;
+    info.pNext = mBufferDeviceAddress ? &addressFeatures : nullptr;
     info.flags = 0;
     info.enabledExtensionCount = enabledExtensionCount;
     info.enabledLayerCount = 0; 
     info.ppEnabledExtensionNames = enabledExtensions;
     info.ppEnabledLayerNames = nullptr;
-    info.pQueueCreateInfos = &queueInfo;
+    info.pQueueCreateInfos = queueInfos.data();
     info.pEnabledFeatures = &features;
-    info.queueCreateInfoCount = 1;
+    info.queueCreateInfoCount = static_cast<uint32_t>(queueInfos.size());
 
     VkResult result = vkCreateDevice(mPhysicalDevice, &info, nullptr, &mLogicalDevice);
     assert(result == VK_SUCCESS);
@@ -194,6 +236,34 @@ uint8_t SlvnDevice::GetViableQueueFamilyIndex()
     return -1;
 }
 
+uint8_t SlvnDevice::GetTransferQueueFamilyIndex()
+{
+    SLVN_PRINT("ENTER");
+
+    if (mTransferQueueFamilyIndex != 255)
+        return mTransferQueueFamilyIndex;
+
+    // Prefer a transfer only family (the DMA engines on discrete GPUs), then any family without graphics.
+    const VkQueueFlags excludedFlags[] = { VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT };
+    for (VkQueueFlags excluded : excludedFlags)
+    {
+        for (int i = 0; i < mQueueFamilyProperties.size(); i++)
+        {
+            if (mQueueFamilyProperties[i].queueCount > 0 &&
+                (mQueueFamilyProperties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) != 0 &&
+                (mQueueFamilyProperties[i].queueFlags & excluded) == 0)
+            {
+                mTransferQueueFamilyIndex = i;
+                return mTransferQueueFamilyIndex;
+            }
+        }
+    }
+
+    mTransferQueueFamilyIndex = GetViableQueueFamilyIndex();
+    SLVN_PRINT("EXIT");
+    return mTransferQueueFamilyIndex;
+}
+
 uint16_t SlvnDevice::GetViableQueueCount()
 {
     SLVN_PRINT("ENTER");
@@ -0,0 +1,177 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <chrono>
+#include <functional>
+
+#include <slvn_draw_packet.h>
+
+namespace slvn_tech
+{
+
+SlvnDrawSorter::SlvnDrawSorter() : mLastSortMs(0.0f)
+{
+}
+
+SlvnDrawSorter::~SlvnDrawSorter()
+{
+}
+
+void SlvnDrawSorter::Sort(std::vector<SlvnDrawPacket>& packets, SlvnThreadpool* threadpool)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint32_t count = static_cast<uint32_t>(packets.size());
+    if (count < 2)
+    {
+        mLastSortMs = 0.0f;
+        return;
+    }
+
+    uint32_t threadCount = 1;
+    if (threadpool != nullptr && count >= cParallelThreshold)
+        threadCount = static_cast<uint32_t>(threadpool->mThreads.size());
+    uint32_t chunk = (count + threadCount - 1) / threadCount;
+
+    auto run = [&](const std::function<void(uint32_t, uint32_t, uint32_t)>& job)
+    {
+        if (threadCount == 1)
+        {
+            job(0, 0, count);
+            return;
+        }
+        for (uint32_t t = 0; t < threadCount; t++)
+        {
+            threadpool->mThreads[t]->addJob([=]
+                {
+                    job(t, t * chunk, std::min(count, (t + 1) * chunk));
+                });
+        }
+        threadpool->Wait();
+    };
+
+    mEntries.resize(count);
+    mEntriesScratch.resize(count);
+    mHistograms.resize(threadCount * cPassCount * cRadix);
+    run([&](uint32_t t, uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                mEntries[i] = { packets[i].mKey, i };
+            }
+            histogram(begin, end, &mHistograms[t * cPassCount * cRadix]);
+        });
+
+    SortEntry* source = mEntries.data();
+    SortEntry* destination = mEntriesScratch.data();
+    for (uint32_t pass = 0; pass < cPassCount; pass++)
+    {
+        // Exclusive prefix over buckets, threads ordered within a bucket to keep the sort stable.
+        uint32_t offset = 0;
+        bool singleBucket = false;
+        for (uint32_t bucket = 0; bucket < cRadix && !singleBucket; bucket++)
+        {
+            for (uint32_t t = 0; t < threadCount; t++)
+            {
+                uint32_t& counter = mHistograms[(t * cPassCount + pass) * cRadix + bucket];
+                uint32_t bucketCount = counter;
+                singleBucket = singleBucket || (bucketCount == count);
+                counter = offset;
+                offset += bucketCount;
+            }
+        }
+        // Every key has the same byte here, the pass would not move anything.
+        if (singleBucket)
+            continue;
+
+        run([=](uint32_t t, uint32_t begin, uint32_t end)
+            {
+                scatter(source, destination, begin, end, pass * 8, &mHistograms[(t * cPassCount + pass) * cRadix]);
+            });
+        std::swap(source, destination);
+    }
+
+    mScratch.resize(count);
+    run([&](uint32_t, uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; i++)
+            {
+                mScratch[i] = packets[source[i].mIndex];
+            }
+        });
+    packets.swap(mScratch);
+
+    auto end = std::chrono::high_resolution_clock::now();
+    mLastSortMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void SlvnDrawSorter::histogram(uint32_t begin, uint32_t end, uint32_t* counts)
+{
+    std::fill(counts, counts + cPassCount * cRadix, 0);
+    for (uint32_t i = begin; i < end; i++)
+    {
+        uint64_t key = mEntries[i].mKey;
+        for (uint32_t pass = 0; pass < cPassCount; pass++)
+        {
+            counts[pass * cRadix + ((key >> (pass * 8)) & (cRadix - 1))]++;
+        }
+    }
+}
+
+void SlvnDrawSorter::scatter(const SortEntry* source, SortEntry* destination, uint32_t begin, uint32_t end, uint32_t shift, uint32_t* offsets)
+{
+    for (uint32_t i = begin; i < end; i++)
+    {
+        destination[offsets[(source[i].mKey >> shift) & (cRadix - 1)]++] = source[i];
+    }
+}
+
+SlvnDrawStats SlvnDrawSorter::CountStateChanges(const std::vector<SlvnDrawPacket>& packets) const
+{
+    SlvnDrawStats stats = {};
+    stats.mPacketCount = static_cast<uint32_t>(packets.size());
+    stats.mSortMs = mLastSortMs;
+
+    // The first draw always binds everything.
+    if (!packets.empty())
+    {
+        stats.mPipelineChanges = 1;
+        stats.mMaterialChanges = 1;
+        stats.mMeshChanges = 1;
+    }
+    for (size_t i = 1; i < packets.size(); i++)
+    {
+        uint64_t key = packets[i].mKey;
+        uint64_t previous = packets[i - 1].mKey;
+        stats.mPipelineChanges += SlvnDrawKey::GetPipeline(key) != SlvnDrawKey::GetPipeline(previous) ? 1 : 0;
+        stats.mMaterialChanges += SlvnDrawKey::GetMaterial(key) != SlvnDrawKey::GetMaterial(previous) ? 1 : 0;
+        stats.mMeshChanges += SlvnDrawKey::GetMesh(key) != SlvnDrawKey::GetMesh(previous) ? 1 : 0;
+    }
+    return stats;
+}
+
+} // slvn_tech
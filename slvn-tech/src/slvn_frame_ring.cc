@@ -0,0 +1,128 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+
+#include <slvn_frame_ring.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnFrameRing::SlvnFrameRing() : mDevice(VK_NULL_HANDLE), mAllocator(nullptr), mBuffer(VK_NULL_HANDLE), mFrameSize(0),
+mUniformAlignment(256), mStorageAlignment(256), mFrameCount(0), mCurrentFrame(0), mFailedAllocations(0)
+{
+}
+
+SlvnFrameRing::~SlvnFrameRing()
+{
+}
+
+SlvnResult SlvnFrameRing::Initialize(VkDevice device, VkPhysicalDevice physicalDevice, SlvnMemoryAllocator* allocator,
+    uint32_t frameCount, VkDeviceSize frameSize, VkBufferUsageFlags usage)
+{
+    SLVN_PRINT("ENTER");
+
+    mDevice = device;
+    mAllocator = allocator;
+    mFrameCount = frameCount;
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    mUniformAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 16);
+    mStorageAlignment = std::max<VkDeviceSize>(properties.limits.minStorageBufferOffsetAlignment, 16);
+
+    // Keep every region start aligned for any kind of binding.
+    VkDeviceSize regionAlignment = std::max(mUniformAlignment, mStorageAlignment);
+    mFrameSize = (frameSize + regionAlignment - 1) & ~(regionAlignment - 1);
+
+    VkBufferCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = mFrameSize * mFrameCount;
+    info.usage = usage;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult res = vkCreateBuffer(mDevice, &info, nullptr, &mBuffer);
+    assert(res == VK_SUCCESS);
+
+    SlvnResult result = mAllocator->AllocateBuffer(mBuffer, SlvnMemoryUsage::cCpuToGpu, mAllocation, SlvnMemoryCategory::cFrame);
+    if (result != SlvnResult::cOk)
+        return result;
+    assert(mAllocation.mMapped != nullptr);
+
+    mRegions = std::make_unique<SlvnFrameRegion[]>(mFrameCount);
+    for (uint32_t i = 0; i < mFrameCount; i++)
+    {
+        mRegions[i].mCapacity = mFrameSize;
+    }
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnFrameRing::Deinitialize()
+{
+    vkDestroyBuffer(mDevice, mBuffer, nullptr);
+    mAllocator->Free(mAllocation);
+    mRegions.reset();
+    return SlvnResult::cOk;
+}
+
+void SlvnFrameRing::BeginFrame(uint32_t frame)
+{
+    mCurrentFrame = frame % mFrameCount;
+    mRegions[mCurrentFrame].Reset();
+}
+
+SlvnResult SlvnFrameRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, SlvnRingAllocation& allocation)
+{
+    uint64_t offset;
+    if (!mRegions[mCurrentFrame].Allocate(size, alignment, offset))
+    {
+        mFailedAllocations.fetch_add(1, std::memory_order_relaxed);
+        allocation = SlvnRingAllocation();
+        return SlvnResult::cOutOfMemory;
+    }
+
+    allocation.mBuffer = mBuffer;
+    allocation.mOffset = mCurrentFrame * mFrameSize + offset;
+    allocation.mMapped = static_cast<uint8_t*>(mAllocation.mMapped) + allocation.mOffset;
+    return SlvnResult::cOk;
+}
+
+SlvnFrameRingStats SlvnFrameRing::GetStats() const
+{
+    SlvnFrameRingStats stats = {};
+    stats.mFrameSize = mFrameSize;
+    stats.mUsed = mRegions[mCurrentFrame].mHead.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < mFrameCount; i++)
+    {
+        stats.mHighWater = std::max(stats.mHighWater, mRegions[i].mHighWater);
+    }
+    stats.mFailedAllocations = mFailedAllocations.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // slvn_tech
@@ -0,0 +1,269 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <cstring>
+
+#include <slvn_geometry_pool.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnGeometryPool::SlvnGeometryPool() : mDevice(VK_NULL_HANDLE), mAllocator(nullptr), mUploader(nullptr), mVertexStride(0),
+mDeviceLocal(true), mDeviceAddress(false), mShortIndices(false), mVertexBuffer(), mVertexAddress(0), mIndexBuffer(), mLastBatch(0), mMeshCount(0)
+{
+}
+
+SlvnGeometryPool::~SlvnGeometryPool()
+{
+}
+
+SlvnResult SlvnGeometryPool::Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnUploadManager* uploader,
+    uint32_t vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity, bool deviceLocal, bool deviceAddress, bool shortIndices)
+{
+    SLVN_PRINT("ENTER");
+
+    mDevice = device;
+    mAllocator = allocator;
+    mUploader = uploader;
+    mVertexStride = vertexStride;
+    mDeviceLocal = deviceLocal;
+    mDeviceAddress = deviceAddress;
+    mShortIndices = shortIndices;
+
+    // Capacities are rounded down to the range allocator granularity.
+    mVertexRanges.Initialize(vertexCapacity);
+    mIndexRanges.Initialize(indexCapacity);
+
+    VkBufferUsageFlags vertexUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | (deviceAddress ? VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT : 0);
+    SlvnResult result = createBuffer(mVertexRanges.GetStats().mSize * vertexStride, vertexUsage, mVertexBuffer);
+    if (result != SlvnResult::cOk)
+        return result;
+    UpdateVertexAddress();
+    result = createBuffer(mIndexRanges.GetStats().mSize * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, mIndexBuffer);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnGeometryPool::Deinitialize()
+{
+    if (mMeshCount > 0)
+        SLVN_PRINT("WARNING; " << mMeshCount << " meshes left in the geometry pool");
+
+    mVertexBuffer.Deinitialize(&mDevice);
+    mIndexBuffer.Deinitialize(&mDevice);
+    mVertexBuffer = SlvnBuffer();
+    mIndexBuffer = SlvnBuffer();
+    mVertexAddress = 0;
+    mMeshes.clear();
+    mFreeMeshes.clear();
+    mMeshCount = 0;
+    return SlvnResult::cOk;
+}
+
+uint32_t SlvnGeometryPool::AddMesh(const void* vertices, uint32_t vertexCount, const uint32_t* indices, uint32_t indexCount,
+    SlvnVertexFormat format, const SlvnVertexQuantization& quantization)
+{
+    VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexCount) * SlvnGetVertexStride(format);
+    uint64_t vertexUnits = (vertexBytes + mVertexStride - 1) / mVertexStride;
+    bool shortIndices = mShortIndices && vertexCount <= 65536;
+    uint64_t indexUnits = shortIndices ? (static_cast<uint64_t>(indexCount) + 1) / 2 : indexCount;
+
+    Mesh mesh = {};
+    uint32_t meshIndex;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        uint64_t vertexOffset, indexOffset;
+        mesh.mVertexHandle = mVertexRanges.Allocate(vertexUnits, 1, vertexOffset);
+        if (mesh.mVertexHandle == SlvnTlsfAllocator::cInvalid)
+            return cInvalidMesh;
+        mesh.mIndexHandle = mIndexRanges.Allocate(indexUnits, 1, indexOffset);
+        if (mesh.mIndexHandle == SlvnTlsfAllocator::cInvalid)
+        {
+            mVertexRanges.Free(mesh.mVertexHandle);
+            return cInvalidMesh;
+        }
+
+        mesh.mRange.mFirstIndex = static_cast<uint32_t>(shortIndices ? indexOffset * 2 : indexOffset);
+        mesh.mRange.mIndexCount = indexCount;
+        mesh.mRange.mVertexOffset = static_cast<int32_t>(vertexOffset);
+        mesh.mRange.mVertexCount = vertexCount;
+        mesh.mRange.mVertexByteOffset = vertexOffset * mVertexStride;
+        mesh.mRange.mVertexFormat = format;
+        mesh.mRange.mQuantization = quantization;
+        mesh.mRange.mIndexType = shortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        mesh.mAlive = true;
+
+        if (!mFreeMeshes.empty())
+        {
+            meshIndex = mFreeMeshes.back();
+            mFreeMeshes.pop_back();
+            mMeshes[meshIndex] = mesh;
+        }
+        else
+        {
+            meshIndex = static_cast<uint32_t>(mMeshes.size());
+            mMeshes.push_back(mesh);
+        }
+        mMeshCount++;
+    }
+
+    // Pulled vertices are read as storage by the vertex shader.
+    VkAccessFlags vertexAccess = mDeviceAddress ? VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_SHADER_READ_BIT : VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    SlvnResult result = write(mVertexBuffer, mesh.mRange.mVertexByteOffset, vertices, vertexBytes, vertexAccess);
+    SLVN_ASSERT_RESULT(result);
+    if (shortIndices)
+    {
+        std::vector<uint16_t> shortData(indices, indices + indexCount);
+        result = write(mIndexBuffer, static_cast<VkDeviceSize>(mesh.mRange.mFirstIndex) * sizeof(uint16_t),
+            shortData.data(), static_cast<VkDeviceSize>(indexCount) * sizeof(uint16_t), VK_ACCESS_INDEX_READ_BIT);
+    }
+    else
+    {
+        result = write(mIndexBuffer, static_cast<VkDeviceSize>(mesh.mRange.mFirstIndex) * sizeof(uint32_t),
+            indices, static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t), VK_ACCESS_INDEX_READ_BIT);
+    }
+    SLVN_ASSERT_RESULT(result);
+    return meshIndex;
+}
+
+void SlvnGeometryPool::RemoveMesh(uint32_t mesh, uint64_t lastUse, SlvnDeletionQueue* deletionQueue)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        assert(mesh < mMeshes.size() && mMeshes[mesh].mAlive);
+        mMeshes[mesh].mAlive = false;
+    }
+    deletionQueue->Defer(lastUse, [this, mesh]() { freeRanges(mesh); });
+}
+
+SlvnMeshRange SlvnGeometryPool::GetMesh(uint32_t mesh) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    assert(mesh < mMeshes.size() && mMeshes[mesh].mAlive);
+    return mMeshes[mesh].mRange;
+}
+
+void SlvnGeometryPool::Bind(SlvnCommandEncoder& encoder, bool vertexInput, VkIndexType indexType) const
+{
+    if (vertexInput)
+        encoder.BindVertexBuffer(mVertexBuffer.GetBuffer(), 0);
+    encoder.BindIndexBuffer(mIndexBuffer.GetBuffer(), 0, indexType);
+}
+
+SlvnGeometryPoolStats SlvnGeometryPool::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    SlvnTlsfStats vertexStats = mVertexRanges.GetStats();
+    SlvnTlsfStats indexStats = mIndexRanges.GetStats();
+    SlvnGeometryPoolStats stats = {};
+    stats.mMeshCount = mMeshCount;
+    stats.mVertexCapacity = vertexStats.mSize;
+    stats.mVertexUsed = vertexStats.mUsed;
+    stats.mLargestVertexRange = vertexStats.mLargestFreeRegion;
+    stats.mIndexCapacity = indexStats.mSize;
+    stats.mIndexUsed = indexStats.mUsed;
+    stats.mLargestIndexRange = indexStats.mLargestFreeRegion;
+    return stats;
+}
+
+void SlvnGeometryPool::Register(SlvnDefragmenter* defragmenter)
+{
+    defragmenter->Register(&mVertexBuffer, [this] { return !HasPendingUploads(); });
+    defragmenter->Register(&mIndexBuffer, [this] { return !HasPendingUploads(); });
+}
+
+void SlvnGeometryPool::Unregister(SlvnDefragmenter* defragmenter)
+{
+    defragmenter->Unregister(&mVertexBuffer);
+    defragmenter->Unregister(&mIndexBuffer);
+}
+
+bool SlvnGeometryPool::HasPendingUploads() const
+{
+    // A copy out of the buffer would race with the transfer queue still writing into it.
+    return mDeviceLocal && !mUploader->IsComplete(mLastBatch);
+}
+
+bool SlvnGeometryPool::IsNearBudget() const
+{
+    // The buffers themselves are reserved up front, only the staging memory of new meshes grows.
+    return mDeviceLocal && mAllocator->IsNearBudget(SlvnMemoryUsage::cCpuToGpu);
+}
+
+void SlvnGeometryPool::UpdateVertexAddress()
+{
+    if (!mDeviceAddress)
+        return;
+
+    VkBufferDeviceAddressInfo addressInfo = {};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = mVertexBuffer.GetBuffer();
+    mVertexAddress = vkGetBufferDeviceAddress(mDevice, &addressInfo);
+}
+
+SlvnResult SlvnGeometryPool::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, SlvnBuffer& buffer)
+{
+    // Transfer source and destination let SlvnDefragmenter move the buffer.
+    buffer = SlvnBuffer(&mDevice, static_cast<uint32_t>(size), usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VK_SHARING_MODE_EXCLUSIVE);
+
+    SlvnMemoryUsage memoryUsage = mDeviceLocal ? SlvnMemoryUsage::cGpuOnly : SlvnMemoryUsage::cCpuToGpu;
+    return buffer.Allocate(mAllocator, memoryUsage, SlvnMemoryCategory::cMeshes);
+}
+
+SlvnResult SlvnGeometryPool::write(const SlvnBuffer& buffer, VkDeviceSize offset, const void* data, VkDeviceSize size, VkAccessFlags dstAccess)
+{
+    if (size == 0)
+        return SlvnResult::cOk;
+    if (mDeviceLocal)
+    {
+        VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | (mDeviceAddress ? VK_PIPELINE_STAGE_VERTEX_SHADER_BIT : 0);
+        mLastBatch = mUploader->GetOpenBatch();
+        return mUploader->Upload(buffer.GetBuffer(), offset, data, size, dstStage, dstAccess);
+    }
+
+    // Host visible pools stay mapped and coherent.
+    std::memcpy(static_cast<uint8_t*>(buffer.GetAllocation().mMapped) + offset, data, size);
+    return SlvnResult::cOk;
+}
+
+void SlvnGeometryPool::freeRanges(uint32_t mesh)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mVertexRanges.Free(mMeshes[mesh].mVertexHandle);
+    mIndexRanges.Free(mMeshes[mesh].mIndexHandle);
+    mFreeMeshes.push_back(mesh);
+    mMeshCount--;
+}
+
+} // slvn_tech
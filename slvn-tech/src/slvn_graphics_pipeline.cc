@@ -34,7 +34,7 @@
 namespace slvn_tech
 {
 
-SlvnGraphicsPipeline::SlvnGraphicsPipeline() : mState(SlvnState::cNotInitialized)
+SlvnGraphicsPipeline::SlvnGraphicsPipeline() : mState(SlvnState::cNotInitialized), mFetch(SlvnVertexFetch::cFixedFunction)
 {
 
 }
@@ -46,11 +46,13 @@ SlvnGraphicsPipeline::~SlvnGraphicsPipeline()
 }
 
 
-SlvnResult SlvnGraphicsPipeline::Initialize(VkDevice& device, VkRenderPass& renderpass)
+SlvnResult SlvnGraphicsPipeline::Initialize(VkDevice& device, VkRenderPass& renderpass, SlvnVertexFetch fetch)
 {
     SLVN_PRINT("ENTER");
 
     mDevice = &device;
+    mFetch = fetch;
+    bool pulling = fetch == SlvnVertexFetch::cPulling;
 
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
     pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -59,7 +61,7 @@ SlvnResult SlvnGraphicsPipeline::Initialize(VkDevice& device, VkRenderPass& rend
 
     VkPushConstantRange pushConstantRange = {};
     pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-    pushConstantRange.size = sizeof(SlvnThreadPushConstant);
+    pushConstantRange.size = pulling ? sizeof(SlvnPullPushConstant) : sizeof(SlvnThreadPushConstant);
     pushConstantRange.offset = 0;
 
     pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
@@ -68,7 +70,7 @@ SlvnResult SlvnGraphicsPipeline::Initialize(VkDevice& device, VkRenderPass& rend
     VkResult res = vkCreatePipelineLayout(*mDevice, &pipelineLayoutCreateInfo, nullptr, &mPipelineLayout);
     assert(res == VK_SUCCESS);
 
-    std::string vertexShaderPath = "slvn-tech/shaders/default_vertex_shader.spv";
+    std::string vertexShaderPath = pulling ? "slvn-tech/shaders/default_vertex_pull_shader.spv" : "slvn-tech/shaders/default_vertex_shader.spv";
     std::string fragmentShaderPath = "slvn-tech/shaders/default_fragment_shader.spv";
     mShaderModules.resize(2);
     mShaderModules[0].Initialize(*mDevice, vertexShaderPath);
@@ -106,10 +108,11 @@ SlvnResult SlvnGraphicsPipeline::Initialize(VkDevice& device, VkRenderPass& rend
     vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
     vertexInputStateCreateInfo.pNext = nullptr;
     vertexInputStateCreateInfo.flags = 0;
-    vertexInputStateCreateInfo.vertexBindingDescriptionCount = 1;
-    vertexInputStateCreateInfo.pVertexBindingDescriptions = vertexInputBindings;
-    vertexInputStateCreateInfo.vertexAttributeDescriptionCount = 3;
-    vertexInputStateCreateInfo.pVertexAttributeDescriptions = vertexAttributes;
+    // The pulling shader has no vertex inputs at all.
+    vertexInputStateCreateInfo.vertexBindingDescriptionCount = pulling ? 0 : 1;
+    vertexInputStateCreateInfo.pVertexBindingDescriptions = pulling ? nullptr : vertexInputBindings;
+    vertexInputStateCreateInfo.vertexAttributeDescriptionCount = pulling ? 0 : 3;
+    vertexInputStateCreateInfo.pVertexAttributeDescriptions = pulling ? nullptr : vertexAttributes;
 
     VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {};
     inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -24,12 +24,70 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 // OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <chrono>
+
 #include <slvn_loader.h>
+#include <slvn_mapped_file.h>
+#include <slvn_mesh_cache.h>
+#include <slvn_mesh_optimizer.h>
+#include <slvn_meshlet.h>
+#include <slvn_obj_parser.h>
+#include <slvn_settings.h>
+#include <slvn_simplifier.h>
+#include <slvn_vertex_weld.h>
 #include <core.h>
 
 namespace slvn_tech
 {
 
+namespace
+{
+
+inline float elapsedMs(std::chrono::high_resolution_clock::time_point start)
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Detail levels are cooked into the cache, a change of the cook settings makes it stale like an edit of the source.
+uint64_t cookHash(uint64_t sourceHash)
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+    std::vector<float> parameters(settings.mLodTriangleRatios);
+    parameters.push_back(settings.mLodMaxError);
+    parameters.push_back(static_cast<float>(settings.mMeshletMaxVertices));
+    parameters.push_back(static_cast<float>(settings.mMeshletMaxTriangles));
+    uint64_t hashes[2] = { sourceHash, SlvnHashBytes(parameters.data(), parameters.size() * sizeof(float)) };
+    return SlvnHashBytes(hashes, sizeof(hashes));
+}
+
+// Hands the cooked levels and meshlets of a mesh whose indices start at indexBase to the caller.
+void appendLods(const SlvnLodMesh& source, const std::vector<SlvnMeshlet>& sourceMeshlets, uint32_t indexBase,
+    SlvnLodMesh* lods, std::vector<SlvnMeshlet>* meshlets)
+{
+    uint32_t meshletBase = meshlets != nullptr ? static_cast<uint32_t>(meshlets->size()) : 0;
+    if (lods != nullptr)
+    {
+        lods->mLevels = source.mLevels;
+        for (auto& level : lods->mLevels)
+        {
+            level.mFirstIndex += indexBase;
+            level.mFirstMeshlet += meshletBase;
+            level.mMeshletCount = meshlets != nullptr ? level.mMeshletCount : 0;
+        }
+    }
+    if (meshlets != nullptr)
+    {
+        for (auto meshlet : sourceMeshlets)
+        {
+            meshlet.mFirstIndex += indexBase;
+            meshlets->push_back(meshlet);
+        }
+    }
+}
+
+}
+
 SlvnLoader::SlvnLoader()
 {
 
@@ -42,28 +100,140 @@ SlvnLoader::~SlvnLoader()
 
 SlvnResult SlvnLoader::Load(const std::string& objPath,
                             std::vector<SlvnVertex>& vertices,
-                            std::vector<uint32_t>& indices)
+                            std::vector<uint32_t>& indices,
+                            SlvnThreadpool* threadpool,
+                            SlvnLodMesh* lods,
+                            std::vector<SlvnMeshlet>* meshlets)
 {
-    SLVN_PRINT("ENTER");
-
-    objl::Loader loader;
-    bool result = loader.LoadFile(objPath);
+    SlvnMappedFile source;
+    SlvnResult result = source.Open(objPath);
+    if (result != SlvnResult::cOk)
+    {
+        SLVN_PRINT("ERROR; could not open " << objPath);
+        return result;
+    }
+    return Load(objPath, source, vertices, indices, threadpool, lods, meshlets);
+}
 
-    if (!result)
-        return SlvnResult::cInvalidPath;
+SlvnResult SlvnLoader::Load(const std::string& objPath,
+                            const SlvnMappedFile& source,
+                            std::vector<SlvnVertex>& vertices,
+                            std::vector<uint32_t>& indices,
+                            SlvnThreadpool* threadpool,
+                            SlvnLodMesh* lods,
+                            std::vector<SlvnMeshlet>* meshlets)
+{
+    SLVN_PRINT("ENTER");
 
-    for (auto& mesh : loader.LoadedMeshes)
-    {   
-        for (auto& vertex : mesh.Vertices)
-        {
-            vertices.push_back(vertex);
-        }
-        for (auto& indice : mesh.Indices)
+    auto start = std::chrono::high_resolution_clock::now();
+    // Warm path, the cooked mesh of an unchanged source is copied straight out of the cache.
+    SlvnMeshCache cache;
+    std::string cachePath = SlvnMeshCache::GetCachePath(objPath);
+    uint64_t sourceHash = cookHash(SlvnHashBytes(source.GetData(), source.GetSize()));
+    uint32_t indexBase = static_cast<uint32_t>(indices.size());
+    if (cache.Read(cachePath, sourceHash, source.GetSize(), vertices, indices) == SlvnResult::cOk)
+    {
+        SlvnLodMesh cachedLods;
+        for (auto& submesh : cache.GetSubmeshes())
         {
-            indices.push_back(indice);
+            cachedLods.mLevels.push_back({ submesh.mFirstIndex, submesh.mIndexCount, submesh.mError, submesh.mFirstMeshlet, submesh.mMeshletCount });
         }
+        appendLods(cachedLods, cache.GetMeshlets(), indexBase, lods, meshlets);
+        SLVN_PRINT("Loaded " << cachePath << " (warm) in " << elapsedMs(start) << "ms");
+        SLVN_PRINT("EXIT");
+        return SlvnResult::cOk;
     }
 
+    // Cold path; parse, weld, optimize, simplify and write the cache for the next start. The mesh is built on its own
+    // so that welding can not merge it with vertices already in the output.
+    std::vector<SlvnVertex> meshVertices;
+    std::vector<uint32_t> meshIndices;
+    SlvnObjParser parser;
+    SlvnResult result = parser.Parse(source.GetData(), source.GetSize(), meshVertices, meshIndices, threadpool);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    const SlvnObjStats& stats = parser.GetStats();
+    SLVN_PRINT("Parsed " << objPath << ", " << stats.mTriangleCount << " triangles in " << stats.mParseMs << "ms");
+
+    // The parser emits a vertex per face corner, most of them are shared.
+    SlvnVertexWelder welder;
+    result = welder.Weld(meshVertices, meshIndices);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    const SlvnWeldStats& weldStats = welder.GetStats();
+    SLVN_PRINT("Welded " << weldStats.mInputVertexCount << " vertices to " << weldStats.mOutputVertexCount << ", ratio "
+        << weldStats.GetRatio() << " in " << weldStats.mWeldMs << "ms");
+
+    // Cooking for the GPU happens once here, the cache keeps the optimized order.
+    SlvnMeshOptimizer optimizer;
+    result = optimizer.Optimize(meshVertices, meshIndices);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    const SlvnMeshOptimizerStats& optimizerStats = optimizer.GetStats();
+    SLVN_PRINT("Optimized in " << optimizerStats.mOptimizeMs << "ms, ACMR " << optimizerStats.mBefore.mAcmr << " -> "
+        << optimizerStats.mAfter.mAcmr << ", ATVR " << optimizerStats.mBefore.mAtvr << " -> " << optimizerStats.mAfter.mAtvr);
+
+    // Coarser levels share the vertices of level 0 and get their own triangle order.
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+    SlvnAabb bounds;
+    for (auto& vertex : meshVertices)
+    {
+        bounds.Grow(vertex.mPosition);
+    }
+    glm::vec3 size = bounds.mMax - bounds.mMin;
+    float maxError = settings.mLodMaxError * std::max(std::max(size.x, size.y), size.z);
+    auto simplifyStart = std::chrono::high_resolution_clock::now();
+    SlvnLodMesh meshLods;
+    result = SlvnMeshSimplifier::BuildLodChain(meshVertices, meshIndices, settings.mLodTriangleRatios, maxError, meshLods, threadpool);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    for (uint32_t level = 1; level < meshLods.mLevels.size(); level++)
+    {
+        const SlvnLodLevel& lod = meshLods.mLevels[level];
+        std::vector<uint32_t> levelIndices(meshIndices.begin() + lod.mFirstIndex, meshIndices.begin() + lod.mFirstIndex + lod.mIndexCount);
+        result = optimizer.OptimizeVertexCache(levelIndices, static_cast<uint32_t>(meshVertices.size()));
+        if (result != SlvnResult::cOk)
+            return result;
+        std::copy(levelIndices.begin(), levelIndices.end(), meshIndices.begin() + lod.mFirstIndex);
+    }
+    SLVN_PRINT("Simplified to " << meshLods.mLevels.size() << " levels, coarsest " << meshLods.mLevels.back().mIndexCount / 3
+        << " triangles with error " << meshLods.mLevels.back().mError << " in " << elapsedMs(simplifyStart) << "ms");
+
+    // Every level is split into meshlets in place, starting from its cache optimized order.
+    auto meshletStart = std::chrono::high_resolution_clock::now();
+    SlvnMeshletBuilder meshletBuilder;
+    meshletBuilder.mMaxVertices = settings.mMeshletMaxVertices;
+    meshletBuilder.mMaxTriangles = settings.mMeshletMaxTriangles;
+    std::vector<SlvnMeshlet> meshMeshlets;
+    for (auto& level : meshLods.mLevels)
+    {
+        level.mFirstMeshlet = static_cast<uint32_t>(meshMeshlets.size());
+        result = meshletBuilder.Build(meshVertices, meshIndices, level.mFirstIndex, level.mIndexCount, meshMeshlets);
+        if (result != SlvnResult::cOk)
+            return result;
+        level.mMeshletCount = static_cast<uint32_t>(meshMeshlets.size()) - level.mFirstMeshlet;
+    }
+    SLVN_PRINT("Built " << meshMeshlets.size() << " meshlets in " << elapsedMs(meshletStart) << "ms");
+
+    // A missing cache only costs the next start, the mesh itself is fine.
+    if (cache.Write(cachePath, sourceHash, source.GetSize(), meshVertices, meshIndices, &meshLods, &meshMeshlets) != SlvnResult::cOk)
+        SLVN_PRINT("Could not write " << cachePath);
+
+    uint32_t vertexBase = static_cast<uint32_t>(vertices.size());
+    vertices.insert(vertices.end(), meshVertices.begin(), meshVertices.end());
+    indices.reserve(indices.size() + meshIndices.size());
+    for (uint32_t index : meshIndices)
+    {
+        indices.push_back(vertexBase + index);
+    }
+    appendLods(meshLods, meshMeshlets, indexBase, lods, meshlets);
+
+    SLVN_PRINT("Loaded " << objPath << " (cold) in " << elapsedMs(start) << "ms");
+
     SLVN_PRINT("EXIT");
     return SlvnResult::cOk;
 }
@@ -0,0 +1,79 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <cmath>
+
+#include <slvn_lod.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+constexpr float cMinDistance = 0.01f;
+
+}
+
+SlvnLodSelector::SlvnLodSelector() : mPixelThreshold(1.0f), mHysteresis(0.25f), mScreenScale(1.0f)
+{
+}
+
+SlvnLodSelector::~SlvnLodSelector()
+{
+}
+
+void SlvnLodSelector::SetProjection(float fovDegrees, float viewportHeight)
+{
+    // Pixels covered by one world unit at distance one.
+    mScreenScale = viewportHeight / (2.0f * std::tan(glm::radians(fovDegrees) * 0.5f));
+}
+
+uint32_t SlvnLodSelector::SelectLevel(const SlvnLodMesh& mesh, float distance, float scale, uint32_t currentLevel) const
+{
+    assert(!mesh.mLevels.empty());
+
+    uint32_t lastLevel = static_cast<uint32_t>(mesh.mLevels.size()) - 1;
+    uint32_t level = std::min(currentLevel, lastLevel);
+    distance = std::max(distance, cMinDistance);
+
+    float refineThreshold = mPixelThreshold * (1.0f + mHysteresis);
+    float coarsenThreshold = mPixelThreshold * (1.0f - mHysteresis);
+
+    while (level > 0 && GetProjectedError(mesh.mLevels[level].mError, distance, scale) > refineThreshold)
+    {
+        level--;
+    }
+    while (level < lastLevel && GetProjectedError(mesh.mLevels[level + 1].mError, distance, scale) <= coarsenThreshold)
+    {
+        level++;
+    }
+    return level;
+}
+
+} // slvn_tech
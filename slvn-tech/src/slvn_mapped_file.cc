@@ -0,0 +1,151 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include <slvn_mapped_file.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+#ifdef _WIN32
+
+SlvnMappedFile::SlvnMappedFile() : mData(nullptr), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(nullptr)
+{
+}
+
+SlvnResult SlvnMappedFile::Open(const std::string& path)
+{
+    Close();
+
+    mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (mFile == INVALID_HANDLE_VALUE)
+        return SlvnResult::cInvalidPath;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(mFile, &size))
+    {
+        Close();
+        return SlvnResult::cInvalidPath;
+    }
+    mSize = static_cast<size_t>(size.QuadPart);
+    // Empty files cannot be mapped, they are valid and simply have no data.
+    if (mSize == 0)
+        return SlvnResult::cOk;
+
+    mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mMapping == nullptr)
+    {
+        Close();
+        return SlvnResult::cUnexpectedError;
+    }
+    mData = static_cast<const char*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+    if (mData == nullptr)
+    {
+        Close();
+        return SlvnResult::cUnexpectedError;
+    }
+    return SlvnResult::cOk;
+}
+
+void SlvnMappedFile::Close()
+{
+    if (mData != nullptr)
+        UnmapViewOfFile(mData);
+    if (mMapping != nullptr)
+        CloseHandle(mMapping);
+    if (mFile != INVALID_HANDLE_VALUE)
+        CloseHandle(mFile);
+    mData = nullptr;
+    mSize = 0;
+    mMapping = nullptr;
+    mFile = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+SlvnMappedFile::SlvnMappedFile() : mData(nullptr), mSize(0), mFile(-1)
+{
+}
+
+SlvnResult SlvnMappedFile::Open(const std::string& path)
+{
+    Close();
+
+    mFile = open(path.c_str(), O_RDONLY);
+    if (mFile < 0)
+        return SlvnResult::cInvalidPath;
+
+    struct stat info;
+    if (fstat(mFile, &info) != 0)
+    {
+        Close();
+        return SlvnResult::cInvalidPath;
+    }
+    mSize = static_cast<size_t>(info.st_size);
+    if (mSize == 0)
+        return SlvnResult::cOk;
+
+    void* data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return SlvnResult::cUnexpectedError;
+    }
+    madvise(data, mSize, MADV_SEQUENTIAL);
+    mData = static_cast<const char*>(data);
+    return SlvnResult::cOk;
+}
+
+void SlvnMappedFile::Close()
+{
+    if (mData != nullptr)
+        munmap(const_cast<char*>(mData), mSize);
+    if (mFile >= 0)
+        close(mFile);
+    mData = nullptr;
+    mSize = 0;
+    mFile = -1;
+}
+
+#endif
+
+SlvnMappedFile::~SlvnMappedFile()
+{
+    Close();
+}
+
+} // slvn_tech
@@ -0,0 +1,546 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+
+#include <slvn_memory_allocator.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnMemoryAllocator::SlvnMemoryAllocator() : mDevice(VK_NULL_HANDLE), mPhysicalDevice(VK_NULL_HANDLE), mMemoryProperties(),
+mBufferImageGranularity(1), mMaxAllocationCount(0), mBlockSize(cDefaultBlockSize), mDeviceMemoryCount(0), mDedicatedCount(0),
+mDedicatedBytes(0), mBufferDeviceAddress(false), mMemoryBudgetSupported(false), mHeapBudgets(), mHeapAllocatedAtUpdate(), mTypeUsage(), mCategoryUsage()
+{
+}
+
+SlvnMemoryAllocator::~SlvnMemoryAllocator()
+{
+}
+
+SlvnResult SlvnMemoryAllocator::Initialize(VkDevice device, VkPhysicalDevice physicalDevice, VkDeviceSize blockSize,
+    bool bufferDeviceAddress)
+{
+    SLVN_PRINT("ENTER");
+
+    mDevice = device;
+    mPhysicalDevice = physicalDevice;
+    mBlockSize = blockSize;
+    mBufferDeviceAddress = bufferDeviceAddress;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &mMemoryProperties);
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    mBufferImageGranularity = properties.limits.bufferImageGranularity;
+    mMaxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+    // SlvnDevice enables VK_EXT_memory_budget whenever the device exposes it.
+    uint32_t extensionCount = 0;
+    VkResult res = vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+    assert(res == VK_SUCCESS);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    res = vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, extensions.data());
+    assert(res == VK_SUCCESS);
+    mMemoryBudgetSupported = std::any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+        { return std::strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0; });
+    if (!mMemoryBudgetSupported)
+        SLVN_PRINT("VK_EXT_memory_budget not supported, budgets estimated from heap sizes");
+
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; i++)
+    {
+        mHeapBudgets[i].mSize = mMemoryProperties.memoryHeaps[i].size;
+    }
+    UpdateBudget();
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::Deinitialize()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& block : mBlocks)
+    {
+        if (!block)
+            continue;
+        if (!block->mTlsf.IsEmpty())
+            SLVN_PRINT("ERROR; memory block freed with live allocations, memory leak!");
+        freeDeviceMemory(block->mMemory, block->mMapped, block->mSize, block->mMemoryType);
+    }
+    mBlocks.clear();
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::AllocateBuffer(VkBuffer buffer, SlvnMemoryUsage usage, SlvnAllocation& allocation,
+    SlvnMemoryCategory category)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 requirements = {};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    requirements.pNext = &dedicatedRequirements;
+    VkBufferMemoryRequirementsInfo2 info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_REQUIREMENTS_INFO_2;
+    info.buffer = buffer;
+    vkGetBufferMemoryRequirements2(mDevice, &info, &requirements);
+
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    allocation.mCategory = category;
+    SlvnResult result = allocate(requirements.memoryRequirements, dedicated, buffer, VK_NULL_HANDLE, usage, SlvnResourceTiling::cLinear, allocation);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    VkResult res = vkBindBufferMemory(mDevice, buffer, allocation.mMemory, allocation.mOffset);
+    assert(res == VK_SUCCESS);
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::AllocateImage(VkImage image, SlvnMemoryUsage usage, SlvnResourceTiling tiling, SlvnAllocation& allocation,
+    SlvnMemoryCategory category)
+{
+    VkMemoryDedicatedRequirements dedicatedRequirements = {};
+    dedicatedRequirements.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_REQUIREMENTS;
+    VkMemoryRequirements2 requirements = {};
+    requirements.sType = VK_STRUCTURE_TYPE_MEMORY_REQUIREMENTS_2;
+    requirements.pNext = &dedicatedRequirements;
+    VkImageMemoryRequirementsInfo2 info = {};
+    info.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_REQUIREMENTS_INFO_2;
+    info.image = image;
+    vkGetImageMemoryRequirements2(mDevice, &info, &requirements);
+
+    bool dedicated = dedicatedRequirements.prefersDedicatedAllocation || dedicatedRequirements.requiresDedicatedAllocation;
+    allocation.mCategory = category;
+    SlvnResult result = allocate(requirements.memoryRequirements, dedicated, VK_NULL_HANDLE, image, usage, tiling, allocation);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    VkResult res = vkBindImageMemory(mDevice, image, allocation.mMemory, allocation.mOffset);
+    assert(res == VK_SUCCESS);
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::AllocateBufferForMove(VkBuffer buffer, const SlvnAllocation& source, SlvnAllocation& allocation)
+{
+    if (source.IsDedicated())
+        return SlvnResult::cUnexpectedError;
+
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(mDevice, buffer, &requirements);
+    assert(requirements.memoryTypeBits & (1 << source.mMemoryType));
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        SlvnResourceTiling tiling = mBlocks[source.mBlock]->mTiling;
+
+        // Fill the fullest blocks first so that the emptiest ones drain.
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < mBlocks.size(); i++)
+        {
+            if (i != source.mBlock && mBlocks[i] && mBlocks[i]->mMemoryType == source.mMemoryType && mBlocks[i]->mTiling == tiling)
+                candidates.push_back(i);
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b)
+            { return mBlocks[a]->mTlsf.GetUsed() > mBlocks[b]->mTlsf.GetUsed(); });
+
+        bool placed = false;
+        for (uint32_t i : candidates)
+        {
+            Block* block = mBlocks[i].get();
+            VkDeviceSize offset;
+            uint32_t handle = block->mTlsf.Allocate(requirements.size, requirements.alignment, offset);
+            if (handle == SlvnTlsfAllocator::cInvalid)
+                continue;
+
+            allocation.mMemory = block->mMemory;
+            allocation.mOffset = offset;
+            allocation.mSize = requirements.size;
+            allocation.mMapped = block->mMapped ? static_cast<uint8_t*>(block->mMapped) + offset : nullptr;
+            allocation.mMemoryType = source.mMemoryType;
+            allocation.mBlock = i;
+            allocation.mHandle = handle;
+            allocation.mCategory = source.mCategory;
+            account(allocation, true);
+            placed = true;
+            break;
+        }
+        if (!placed)
+            return SlvnResult::cOutOfMemory;
+    }
+
+    VkResult res = vkBindBufferMemory(mDevice, buffer, allocation.mMemory, allocation.mOffset);
+    assert(res == VK_SUCCESS);
+    return SlvnResult::cOk;
+}
+
+void SlvnMemoryAllocator::Free(SlvnAllocation& allocation)
+{
+    if (allocation.mMemory == VK_NULL_HANDLE)
+        return;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    account(allocation, false);
+    if (allocation.IsDedicated())
+    {
+        freeDeviceMemory(allocation.mMemory, allocation.mMapped, allocation.mSize, allocation.mMemoryType);
+        mDedicatedCount--;
+        mDedicatedBytes -= allocation.mSize;
+    }
+    else
+    {
+        Block* block = mBlocks[allocation.mBlock].get();
+        block->mTlsf.Free(allocation.mHandle);
+
+        // Keep one block per memory type and tiling around, so that a resource
+        // freed and created every frame does not reallocate device memory.
+        if (block->mTlsf.IsEmpty())
+        {
+            for (uint32_t i = 0; i < mBlocks.size(); i++)
+            {
+                if (i != allocation.mBlock && mBlocks[i] && mBlocks[i]->mMemoryType == block->mMemoryType && mBlocks[i]->mTiling == block->mTiling)
+                {
+                    freeDeviceMemory(block->mMemory, block->mMapped, block->mSize, block->mMemoryType);
+                    mBlocks[allocation.mBlock].reset();
+                    break;
+                }
+            }
+        }
+    }
+    allocation = SlvnAllocation();
+}
+
+SlvnMemoryStats SlvnMemoryAllocator::GetStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    SlvnMemoryStats stats = {};
+    VkDeviceSize freeBytes = 0;
+    for (auto& block : mBlocks)
+    {
+        if (!block)
+            continue;
+        SlvnTlsfStats blockStats = block->mTlsf.GetStats();
+        stats.mBlockCount++;
+        stats.mAllocationCount += blockStats.mAllocationCount;
+        stats.mReservedBytes += blockStats.mSize;
+        stats.mUsedBytes += blockStats.mUsed;
+        stats.mFreeRegionCount += blockStats.mFreeRegionCount;
+        stats.mLargestFreeRegion = std::max(stats.mLargestFreeRegion, blockStats.mLargestFreeRegion);
+        freeBytes += blockStats.mSize - blockStats.mUsed;
+    }
+    stats.mDedicatedCount = mDedicatedCount;
+    stats.mAllocationCount += mDedicatedCount;
+    stats.mReservedBytes += mDedicatedBytes;
+    stats.mUsedBytes += mDedicatedBytes;
+    stats.mDeviceMemoryCount = mDeviceMemoryCount;
+    stats.mFragmentation = freeBytes > 0 ? 1.0f - static_cast<float>(stats.mLargestFreeRegion) / static_cast<float>(freeBytes) : 0.0f;
+    return stats;
+}
+
+std::vector<SlvnMemoryBlockInfo> SlvnMemoryAllocator::GetBlockInfos()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    std::vector<SlvnMemoryBlockInfo> infos;
+    for (uint32_t i = 0; i < mBlocks.size(); i++)
+    {
+        if (!mBlocks[i])
+            continue;
+        SlvnTlsfStats stats = mBlocks[i]->mTlsf.GetStats();
+        infos.push_back({ i, mBlocks[i]->mMemoryType, mBlocks[i]->mTiling, stats.mSize, stats.mUsed, stats.mAllocationCount });
+    }
+    return infos;
+}
+
+void SlvnMemoryAllocator::UpdateBudget()
+{
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties = {};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    if (mMemoryBudgetSupported)
+    {
+        VkPhysicalDeviceMemoryProperties2 properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budgetProperties;
+        vkGetPhysicalDeviceMemoryProperties2(mPhysicalDevice, &properties);
+    }
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (uint32_t i = 0; i < mMemoryProperties.memoryHeapCount; i++)
+    {
+        SlvnHeapBudget& heap = mHeapBudgets[i];
+        if (mMemoryBudgetSupported)
+        {
+            heap.mBudget = budgetProperties.heapBudget[i];
+            heap.mUsage = budgetProperties.heapUsage[i];
+        }
+        else
+        {
+            // Leave room for other processes and driver internal allocations.
+            heap.mBudget = heap.mSize / 10 * 8;
+            heap.mUsage = heap.mAllocated.mCurrent;
+        }
+        mHeapAllocatedAtUpdate[i] = heap.mAllocated.mCurrent;
+    }
+}
+
+SlvnHeapBudget SlvnMemoryAllocator::GetHeapBudget(uint32_t heap)
+{
+    assert(heap < mMemoryProperties.memoryHeapCount);
+    std::lock_guard<std::mutex> lock(mMutex);
+    SlvnHeapBudget budget = mHeapBudgets[heap];
+    budget.mUsage = getEstimatedUsage(heap);
+    return budget;
+}
+
+SlvnMemoryCounter SlvnMemoryAllocator::GetCategoryUsage(SlvnMemoryCategory category)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCategoryUsage[static_cast<uint32_t>(category)];
+}
+
+SlvnMemoryCounter SlvnMemoryAllocator::GetTypeUsage(uint32_t memoryType)
+{
+    assert(memoryType < mMemoryProperties.memoryTypeCount);
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mTypeUsage[memoryType];
+}
+
+bool SlvnMemoryAllocator::IsNearBudget(SlvnMemoryUsage usage, float fraction)
+{
+    std::optional<uint32_t> memoryType = findMemoryType(UINT32_MAX, usage);
+    if (!memoryType)
+        return true;
+
+    uint32_t heap = mMemoryProperties.memoryTypes[*memoryType].heapIndex;
+    std::lock_guard<std::mutex> lock(mMutex);
+    return getEstimatedUsage(heap) >= static_cast<VkDeviceSize>(mHeapBudgets[heap].mBudget * static_cast<double>(fraction));
+}
+
+SlvnResult SlvnMemoryAllocator::allocate(const VkMemoryRequirements& requirements, bool dedicated, VkBuffer buffer, VkImage image,
+    SlvnMemoryUsage usage, SlvnResourceTiling tiling, SlvnAllocation& allocation)
+{
+    std::optional<uint32_t> memoryType = findMemoryType(requirements.memoryTypeBits, usage);
+    if (!memoryType)
+        return SlvnResult::cUnexpectedError;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+
+    // Anything above half a block would waste most of a block for itself.
+    VkDeviceSize blockSize = getBlockSize(*memoryType);
+    if (dedicated || requirements.size > blockSize / 2)
+        return allocateDedicated(requirements, *memoryType, buffer, image, allocation);
+
+    for (uint32_t i = 0; i < mBlocks.size(); i++)
+    {
+        Block* block = mBlocks[i].get();
+        if (!block || block->mMemoryType != *memoryType || block->mTiling != tiling)
+            continue;
+
+        VkDeviceSize offset;
+        uint32_t handle = block->mTlsf.Allocate(requirements.size, requirements.alignment, offset);
+        if (handle == SlvnTlsfAllocator::cInvalid)
+            continue;
+
+        allocation.mMemory = block->mMemory;
+        allocation.mOffset = offset;
+        allocation.mSize = requirements.size;
+        allocation.mMapped = block->mMapped ? static_cast<uint8_t*>(block->mMapped) + offset : nullptr;
+        allocation.mMemoryType = *memoryType;
+        allocation.mBlock = i;
+        allocation.mHandle = handle;
+        account(allocation, true);
+        return SlvnResult::cOk;
+    }
+
+    // A fresh block that would push the heap over its budget reserves mostly unused memory,
+    // only take what this resource needs until something is released.
+    uint32_t heap = mMemoryProperties.memoryTypes[*memoryType].heapIndex;
+    if (getEstimatedUsage(heap) + blockSize > mHeapBudgets[heap].mBudget)
+    {
+        SLVN_PRINT("WARNING; memory heap " << heap << " near budget, allocating without a block");
+        return allocateDedicated(requirements, *memoryType, buffer, image, allocation);
+    }
+
+    auto block = std::make_unique<Block>();
+    SlvnResult result = allocateDeviceMemory(blockSize, *memoryType, nullptr, block->mMemory, block->mMapped);
+    if (result != SlvnResult::cOk)
+        return allocateDedicated(requirements, *memoryType, buffer, image, allocation);
+    block->mSize = blockSize;
+    block->mMemoryType = *memoryType;
+    block->mTiling = tiling;
+    block->mTlsf.Initialize(blockSize);
+
+    VkDeviceSize offset;
+    uint32_t handle = block->mTlsf.Allocate(requirements.size, requirements.alignment, offset);
+    assert(handle != SlvnTlsfAllocator::cInvalid);
+
+    allocation.mMemory = block->mMemory;
+    allocation.mOffset = offset;
+    allocation.mSize = requirements.size;
+    allocation.mMapped = block->mMapped ? static_cast<uint8_t*>(block->mMapped) + offset : nullptr;
+    allocation.mMemoryType = *memoryType;
+    allocation.mHandle = handle;
+
+    auto slot = std::find_if(mBlocks.begin(), mBlocks.end(), [](const std::unique_ptr<Block>& b) { return !b; });
+    if (slot == mBlocks.end())
+        slot = mBlocks.insert(mBlocks.end(), nullptr);
+    allocation.mBlock = static_cast<uint32_t>(slot - mBlocks.begin());
+    *slot = std::move(block);
+    account(allocation, true);
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::allocateDedicated(const VkMemoryRequirements& requirements, uint32_t memoryType, VkBuffer buffer, VkImage image,
+    SlvnAllocation& allocation)
+{
+    VkMemoryDedicatedAllocateInfo dedicatedInfo = {};
+    dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO;
+    dedicatedInfo.buffer = buffer;
+    dedicatedInfo.image = image;
+
+    SlvnResult result = allocateDeviceMemory(requirements.size, memoryType, &dedicatedInfo, allocation.mMemory, allocation.mMapped);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    allocation.mOffset = 0;
+    allocation.mSize = requirements.size;
+    allocation.mMemoryType = memoryType;
+    allocation.mBlock = UINT32_MAX;
+    allocation.mHandle = UINT32_MAX;
+    mDedicatedCount++;
+    mDedicatedBytes += requirements.size;
+    account(allocation, true);
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryAllocator::allocateDeviceMemory(VkDeviceSize size, uint32_t memoryType, const void* next, VkDeviceMemory& memory, void*& mapped)
+{
+    if (mDeviceMemoryCount >= mMaxAllocationCount)
+    {
+        SLVN_PRINT("ERROR; maxMemoryAllocationCount reached");
+        return SlvnResult::cOutOfMemory;
+    }
+
+    VkMemoryAllocateFlagsInfo flagsInfo = {};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    flagsInfo.pNext = next;
+    flagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+
+    VkMemoryAllocateInfo allocateInfo = {};
+    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocateInfo.pNext = mBufferDeviceAddress ? &flagsInfo : next;
+    allocateInfo.allocationSize = size;
+    allocateInfo.memoryTypeIndex = memoryType;
+
+    VkResult res = vkAllocateMemory(mDevice, &allocateInfo, nullptr, &memory);
+    if (res != VK_SUCCESS)
+        return SlvnResult::cOutOfMemory;
+    mDeviceMemoryCount++;
+    mHeapBudgets[mMemoryProperties.memoryTypes[memoryType].heapIndex].mAllocated.Add(size);
+
+    mapped = nullptr;
+    if (mMemoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        res = vkMapMemory(mDevice, memory, 0, VK_WHOLE_SIZE, 0, &mapped);
+        assert(res == VK_SUCCESS);
+    }
+    return SlvnResult::cOk;
+}
+
+void SlvnMemoryAllocator::freeDeviceMemory(VkDeviceMemory memory, void* mapped, VkDeviceSize size, uint32_t memoryType)
+{
+    if (mapped)
+        vkUnmapMemory(mDevice, memory);
+    vkFreeMemory(mDevice, memory, nullptr);
+    mDeviceMemoryCount--;
+    mHeapBudgets[mMemoryProperties.memoryTypes[memoryType].heapIndex].mAllocated.Remove(size);
+}
+
+void SlvnMemoryAllocator::account(const SlvnAllocation& allocation, bool add)
+{
+    SlvnMemoryCounter& type = mTypeUsage[allocation.mMemoryType];
+    SlvnMemoryCounter& category = mCategoryUsage[static_cast<uint32_t>(allocation.mCategory)];
+    if (add)
+    {
+        type.Add(allocation.mSize);
+        category.Add(allocation.mSize);
+    }
+    else
+    {
+        type.Remove(allocation.mSize);
+        category.Remove(allocation.mSize);
+    }
+}
+
+VkDeviceSize SlvnMemoryAllocator::getEstimatedUsage(uint32_t heap) const
+{
+    // The driver usage is only refreshed by UpdateBudget(), add what we allocated or freed since.
+    const SlvnHeapBudget& budget = mHeapBudgets[heap];
+    int64_t delta = static_cast<int64_t>(budget.mAllocated.mCurrent) - static_cast<int64_t>(mHeapAllocatedAtUpdate[heap]);
+    return static_cast<VkDeviceSize>(std::max<int64_t>(static_cast<int64_t>(budget.mUsage) + delta, 0));
+}
+
+std::optional<uint32_t> SlvnMemoryAllocator::findMemoryType(uint32_t typeBits, SlvnMemoryUsage usage) const
+{
+    VkMemoryPropertyFlags required = 0;
+    VkMemoryPropertyFlags preferred = 0;
+    switch (usage)
+    {
+    case SlvnMemoryUsage::cGpuOnly:
+        required = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        break;
+    case SlvnMemoryUsage::cCpuToGpu:
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        break;
+    case SlvnMemoryUsage::cGpuToCpu:
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    }
+
+    std::optional<uint32_t> value = std::nullopt;
+    for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags flags = mMemoryProperties.memoryTypes[i].propertyFlags;
+        if ((typeBits & (1 << i)) == 0 || (flags & required) != required)
+            continue;
+        if ((flags & preferred) == preferred)
+            return i;
+        if (!value)
+            value = i;
+    }
+    return value;
+}
+
+VkDeviceSize SlvnMemoryAllocator::getBlockSize(uint32_t memoryType) const
+{
+    // Small heaps (e.g. the 256MB host visible device local heap) get smaller blocks.
+    VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[mMemoryProperties.memoryTypes[memoryType].heapIndex].size;
+    return std::min(mBlockSize, heapSize / 8);
+}
+
+} // slvn_tech
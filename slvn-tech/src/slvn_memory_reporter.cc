@@ -0,0 +1,112 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <slvn_memory_reporter.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnMemoryReporter::SlvnMemoryReporter() : mAllocator(nullptr), mHeapCount(0)
+{
+}
+
+SlvnMemoryReporter::~SlvnMemoryReporter()
+{
+}
+
+SlvnResult SlvnMemoryReporter::Initialize(SlvnMemoryAllocator* allocator, const std::string& path)
+{
+    mAllocator = allocator;
+    mHeapCount = allocator->GetMemoryProperties().memoryHeapCount;
+    if (path.empty())
+        return SlvnResult::cOk;
+
+    mFile.open(path, std::ios::out | std::ios::trunc);
+    if (!mFile.is_open())
+    {
+        SLVN_PRINT("ERROR; could not open memory report " << path.c_str());
+        return SlvnResult::cUnexpectedError;
+    }
+
+    mFile << "frame";
+    for (uint32_t i = 0; i < mHeapCount; i++)
+    {
+        mFile << ",heap" << i << "_budget,heap" << i << "_usage,heap" << i << "_allocated,heap" << i << "_peak";
+    }
+    for (uint32_t i = 0; i < static_cast<uint32_t>(SlvnMemoryCategory::cCount); i++)
+    {
+        const char* name = GetCategoryName(static_cast<SlvnMemoryCategory>(i));
+        mFile << "," << name << "_current," << name << "_peak";
+    }
+    mFile << "\n";
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMemoryReporter::Deinitialize()
+{
+    if (mFile.is_open())
+        mFile.close();
+    return SlvnResult::cOk;
+}
+
+void SlvnMemoryReporter::Report(uint64_t frame)
+{
+    if (!mFile.is_open())
+        return;
+
+    mFile << frame;
+    for (uint32_t i = 0; i < mHeapCount; i++)
+    {
+        SlvnHeapBudget budget = mAllocator->GetHeapBudget(i);
+        mFile << "," << budget.mBudget << "," << budget.mUsage << "," << budget.mAllocated.mCurrent << "," << budget.mAllocated.mPeak;
+    }
+    for (uint32_t i = 0; i < static_cast<uint32_t>(SlvnMemoryCategory::cCount); i++)
+    {
+        SlvnMemoryCounter usage = mAllocator->GetCategoryUsage(static_cast<SlvnMemoryCategory>(i));
+        mFile << "," << usage.mCurrent << "," << usage.mPeak;
+    }
+    mFile << "\n";
+}
+
+const char* SlvnMemoryReporter::GetCategoryName(SlvnMemoryCategory category)
+{
+    switch (category)
+    {
+    case SlvnMemoryCategory::cMeshes:
+        return "meshes";
+    case SlvnMemoryCategory::cStaging:
+        return "staging";
+    case SlvnMemoryCategory::cFrame:
+        return "frame";
+    case SlvnMemoryCategory::cTextures:
+        return "textures";
+    default:
+        return "other";
+    }
+}
+
+} // slvn_tech
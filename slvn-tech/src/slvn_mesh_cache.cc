@@ -0,0 +1,239 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include <slvn_mesh_cache.h>
+#include <slvn_mapped_file.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline uint64_t alignOffset(uint64_t offset)
+{
+    return (offset + SlvnMeshCache::cBlobAlignment - 1) & ~(SlvnMeshCache::cBlobAlignment - 1);
+}
+
+inline uint64_t mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+}
+
+uint64_t SlvnHashBytes(const void* data, size_t size)
+{
+    // Four independent lanes keep the multiplies from waiting on each other.
+    const uint64_t cPrime = 0x9E3779B97F4A7C15ull;
+    const char* bytes = static_cast<const char*>(data);
+    uint64_t lanes[4] = { cPrime, cPrime * 2, cPrime * 3, cPrime * 4 };
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32)
+    {
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset + lane * 8, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * cPrime;
+            lanes[lane] ^= lanes[lane] >> 31;
+        }
+    }
+
+    uint64_t hash = size;
+    for (uint64_t lane : lanes)
+    {
+        hash = mix(hash ^ lane);
+    }
+    for (; offset < size; offset++)
+    {
+        hash = (hash ^ static_cast<uint8_t>(bytes[offset])) * cPrime;
+    }
+    return mix(hash);
+}
+
+SlvnMeshCache::SlvnMeshCache()
+{
+}
+
+SlvnMeshCache::~SlvnMeshCache()
+{
+}
+
+std::string SlvnMeshCache::GetCachePath(const std::string& sourcePath)
+{
+    return std::filesystem::path(sourcePath).replace_extension(".slvnmesh").string();
+}
+
+SlvnResult SlvnMeshCache::Read(const std::string& path, uint64_t sourceHash, uint64_t sourceSize,
+    std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    std::error_code error;
+    if (!std::filesystem::exists(path, error))
+        return SlvnResult::cInvalidPath;
+
+    SlvnMappedFile file;
+    SlvnResult result = file.Open(path);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    SlvnMeshCacheHeader header;
+    if (file.GetSize() < sizeof(header))
+        return SlvnResult::cUnexpectedError;
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (header.mMagic != cMagic || header.mVersion != cVersion || header.mVertexStride != sizeof(SlvnVertex))
+        return SlvnResult::cUnexpectedError;
+    if (header.mSourceHash != sourceHash || header.mSourceSize != sourceSize)
+        return SlvnResult::cUnexpectedError;
+
+    uint64_t submeshBytes = static_cast<uint64_t>(header.mSubmeshCount) * sizeof(SlvnMeshCacheSubmesh);
+    uint64_t meshletBytes = static_cast<uint64_t>(header.mMeshletCount) * sizeof(SlvnMeshlet);
+    uint64_t vertexBytes = static_cast<uint64_t>(header.mVertexCount) * sizeof(SlvnVertex);
+    uint64_t indexBytes = static_cast<uint64_t>(header.mIndexCount) * sizeof(uint32_t);
+    if (header.mSubmeshOffset + submeshBytes > file.GetSize() || header.mMeshletOffset + meshletBytes > file.GetSize() ||
+        header.mVertexOffset + vertexBytes > file.GetSize() || header.mIndexOffset + indexBytes > file.GetSize())
+    {
+        SLVN_PRINT("ERROR; " << path << " is truncated");
+        return SlvnResult::cUnexpectedError;
+    }
+
+    mBounds.mMin = header.mBoundsMin;
+    mBounds.mMax = header.mBoundsMax;
+    mSubmeshes.resize(header.mSubmeshCount);
+    std::memcpy(mSubmeshes.data(), file.GetData() + header.mSubmeshOffset, submeshBytes);
+    mMeshlets.resize(header.mMeshletCount);
+    std::memcpy(mMeshlets.data(), file.GetData() + header.mMeshletOffset, meshletBytes);
+
+    size_t vertexBase = vertices.size();
+    size_t indexBase = indices.size();
+    vertices.resize(vertexBase + header.mVertexCount);
+    indices.resize(indexBase + header.mIndexCount);
+    std::memcpy(vertices.data() + vertexBase, file.GetData() + header.mVertexOffset, vertexBytes);
+    std::memcpy(indices.data() + indexBase, file.GetData() + header.mIndexOffset, indexBytes);
+    if (vertexBase > 0)
+    {
+        for (size_t i = indexBase; i < indices.size(); i++)
+        {
+            indices[i] += static_cast<uint32_t>(vertexBase);
+        }
+    }
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMeshCache::Write(const std::string& path, uint64_t sourceHash, uint64_t sourceSize,
+    const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices, const SlvnLodMesh* lods,
+    const std::vector<SlvnMeshlet>* meshlets)
+{
+    mBounds = SlvnAabb();
+    for (auto& vertex : vertices)
+    {
+        mBounds.Grow(vertex.mPosition);
+    }
+    mSubmeshes.clear();
+    if (lods == nullptr)
+    {
+        mSubmeshes.push_back({ 0, static_cast<uint32_t>(indices.size()), mBounds.mMin, mBounds.mMax, 0.0f, 0, 0 });
+    }
+    else
+    {
+        for (auto& level : lods->mLevels)
+        {
+            SlvnAabb bounds;
+            for (uint32_t i = level.mFirstIndex; i < level.mFirstIndex + level.mIndexCount; i++)
+            {
+                bounds.Grow(vertices[indices[i]].mPosition);
+            }
+            mSubmeshes.push_back({ level.mFirstIndex, level.mIndexCount, bounds.mMin, bounds.mMax, level.mError, level.mFirstMeshlet, level.mMeshletCount });
+        }
+    }
+    mMeshlets.clear();
+    if (meshlets != nullptr)
+        mMeshlets = *meshlets;
+
+    SlvnMeshCacheHeader header = {};
+    header.mMagic = cMagic;
+    header.mVersion = cVersion;
+    header.mSourceHash = sourceHash;
+    header.mSourceSize = sourceSize;
+    header.mBoundsMin = mBounds.mMin;
+    header.mBoundsMax = mBounds.mMax;
+    header.mVertexStride = sizeof(SlvnVertex);
+    header.mVertexCount = static_cast<uint32_t>(vertices.size());
+    header.mIndexCount = static_cast<uint32_t>(indices.size());
+    header.mSubmeshCount = static_cast<uint32_t>(mSubmeshes.size());
+    header.mMeshletCount = static_cast<uint32_t>(mMeshlets.size());
+    header.mSubmeshOffset = alignOffset(sizeof(header));
+    header.mMeshletOffset = alignOffset(header.mSubmeshOffset + mSubmeshes.size() * sizeof(SlvnMeshCacheSubmesh));
+    header.mVertexOffset = alignOffset(header.mMeshletOffset + mMeshlets.size() * sizeof(SlvnMeshlet));
+    header.mIndexOffset = alignOffset(header.mVertexOffset + vertices.size() * sizeof(SlvnVertex));
+
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            SLVN_PRINT("ERROR; could not create " << temporaryPath);
+            return SlvnResult::cInvalidPath;
+        }
+
+        const char padding[cBlobAlignment] = {};
+        auto pad = [&](uint64_t offset) { file.write(padding, static_cast<std::streamsize>(offset - static_cast<uint64_t>(file.tellp()))); };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        pad(header.mSubmeshOffset);
+        file.write(reinterpret_cast<const char*>(mSubmeshes.data()), mSubmeshes.size() * sizeof(SlvnMeshCacheSubmesh));
+        pad(header.mMeshletOffset);
+        file.write(reinterpret_cast<const char*>(mMeshlets.data()), mMeshlets.size() * sizeof(SlvnMeshlet));
+        pad(header.mVertexOffset);
+        file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(SlvnVertex));
+        pad(header.mIndexOffset);
+        file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(uint32_t));
+        if (!file.good())
+        {
+            SLVN_PRINT("ERROR; could not write " << temporaryPath);
+            return SlvnResult::cUnexpectedError;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        SLVN_PRINT("ERROR; could not replace " << path << ", " << error.message());
+        std::filesystem::remove(temporaryPath, error);
+        return SlvnResult::cUnexpectedError;
+    }
+    return SlvnResult::cOk;
+}
+
+} // slvn_tech
@@ -0,0 +1,361 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+
+#include <glm/glm.hpp>
+
+#include <slvn_mesh_optimizer.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+constexpr uint32_t cInvalid = UINT32_MAX;
+
+// FIFO cache; entries older than cacheSize insertions have been evicted.
+class FifoCache
+{
+public:
+    FifoCache(uint32_t vertexCount, uint32_t cacheSize) : mInsertTime(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize) {}
+
+    inline bool Access(uint32_t vertex)
+    {
+        if (mTime - mInsertTime[vertex] <= mCacheSize)
+            return true;
+        mInsertTime[vertex] = mTime++;
+        return false;
+    }
+    inline void Reset() { mTime += mCacheSize + 1; }
+
+private:
+    std::vector<uint32_t> mInsertTime;
+    uint32_t mTime;
+    uint32_t mCacheSize;
+};
+
+inline bool validIndices(const std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    return indices.size() % 3 == 0 && std::all_of(indices.begin(), indices.end(), [=](uint32_t index) { return index < vertexCount; });
+}
+
+}
+
+SlvnVertexCacheStats SlvnAnalyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize)
+{
+    FifoCache cache(vertexCount, cacheSize);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    uint32_t misses = 0;
+    uint32_t uniqueCount = 0;
+    for (uint32_t index : indices)
+    {
+        misses += cache.Access(index) ? 0 : 1;
+        uniqueCount += referenced[index] ? 0 : 1;
+        referenced[index] = 1;
+    }
+
+    SlvnVertexCacheStats stats = {};
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    stats.mAcmr = triangleCount > 0 ? static_cast<float>(misses) / static_cast<float>(triangleCount) : 0.0f;
+    stats.mAtvr = uniqueCount > 0 ? static_cast<float>(misses) / static_cast<float>(uniqueCount) : 0.0f;
+    return stats;
+}
+
+SlvnMeshOptimizer::SlvnMeshOptimizer() : mCacheSize(16), mOverdrawThreshold(1.05f), mStats()
+{
+}
+
+SlvnMeshOptimizer::~SlvnMeshOptimizer()
+{
+}
+
+SlvnResult SlvnMeshOptimizer::Optimize(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    mStats.mBefore = SlvnAnalyzeVertexCache(indices, vertexCount, mCacheSize);
+
+    SlvnResult result = OptimizeVertexCache(indices, vertexCount);
+    if (result != SlvnResult::cOk)
+        return result;
+    result = OptimizeOverdraw(vertices, indices);
+    if (result != SlvnResult::cOk)
+        return result;
+    result = OptimizeVertexFetch(vertices, indices);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    mStats.mAfter = SlvnAnalyzeVertexCache(indices, static_cast<uint32_t>(vertices.size()), mCacheSize);
+    mStats.mOptimizeMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMeshOptimizer::OptimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount)
+{
+    if (!validIndices(indices, vertexCount))
+    {
+        SLVN_PRINT("ERROR; indices do not form triangles of the given vertices");
+        return SlvnResult::cUnexpectedError;
+    }
+
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    mHardBoundaries.clear();
+    if (triangleCount == 0)
+        return SlvnResult::cOk;
+
+    mLiveTriangles.assign(vertexCount, 0);
+    for (uint32_t index : indices)
+    {
+        mLiveTriangles[index]++;
+    }
+    mAdjacencyOffsets.resize(vertexCount + 1);
+    mAdjacencyOffsets[0] = 0;
+    std::partial_sum(mLiveTriangles.begin(), mLiveTriangles.end(), mAdjacencyOffsets.begin() + 1);
+    mAdjacency.resize(indices.size());
+    std::vector<uint32_t> fill(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indices.size(); i++)
+    {
+        mAdjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    mCacheTime.assign(vertexCount, 0);
+    mDeadEnd.clear();
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    std::vector<uint32_t> candidates;
+
+    uint32_t timestamp = mCacheSize + 1;
+    uint32_t cursor = 0;
+    uint32_t fanning = 0;
+    bool hardBoundary = true;
+    while (fanning != cInvalid)
+    {
+        // Emit every remaining triangle around the fanning vertex.
+        candidates.clear();
+        for (uint32_t a = mAdjacencyOffsets[fanning]; a < mAdjacencyOffsets[fanning + 1]; a++)
+        {
+            uint32_t triangle = mAdjacency[a];
+            if (emitted[triangle])
+                continue;
+
+            if (hardBoundary)
+            {
+                mHardBoundaries.push_back(static_cast<uint32_t>(output.size() / 3));
+                hardBoundary = false;
+            }
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                uint32_t vertex = indices[triangle * 3 + c];
+                output.push_back(vertex);
+                mDeadEnd.push_back(vertex);
+                candidates.push_back(vertex);
+                mLiveTriangles[vertex]--;
+                if (timestamp - mCacheTime[vertex] > mCacheSize)
+                    mCacheTime[vertex] = timestamp++;
+            }
+            emitted[triangle] = 1;
+        }
+
+        fanning = getNextVertex(candidates, timestamp, cursor);
+        // Nothing around the last fan was in the cache any more, the next one starts cold.
+        if (fanning != cInvalid && timestamp - mCacheTime[fanning] > mCacheSize)
+            hardBoundary = true;
+    }
+
+    assert(output.size() == indices.size());
+    indices.swap(output);
+    return SlvnResult::cOk;
+}
+
+uint32_t SlvnMeshOptimizer::getNextVertex(const std::vector<uint32_t>& candidates, uint32_t timestamp, uint32_t& cursor)
+{
+    // Prefer the candidate that is oldest in the cache while its whole fan still fits in it.
+    uint32_t best = cInvalid;
+    int32_t bestPriority = -1;
+    for (uint32_t vertex : candidates)
+    {
+        if (mLiveTriangles[vertex] == 0)
+            continue;
+
+        int32_t priority = 0;
+        uint32_t age = timestamp - mCacheTime[vertex];
+        if (age + 2 * mLiveTriangles[vertex] <= mCacheSize)
+            priority = static_cast<int32_t>(age);
+        if (priority > bestPriority)
+        {
+            bestPriority = priority;
+            best = vertex;
+        }
+    }
+    if (best != cInvalid)
+        return best;
+
+    // Dead end; go back through recently emitted vertices, then scan for any vertex left.
+    while (!mDeadEnd.empty())
+    {
+        uint32_t vertex = mDeadEnd.back();
+        mDeadEnd.pop_back();
+        if (mLiveTriangles[vertex] > 0)
+            return vertex;
+    }
+    while (cursor < mLiveTriangles.size())
+    {
+        if (mLiveTriangles[cursor] > 0)
+            return cursor;
+        cursor++;
+    }
+    return cInvalid;
+}
+
+SlvnResult SlvnMeshOptimizer::OptimizeOverdraw(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+    if (!validIndices(indices, vertexCount))
+        return SlvnResult::cUnexpectedError;
+    if (mHardBoundaries.empty() || mHardBoundaries.front() != 0 || mHardBoundaries.back() >= std::max(triangleCount, 1u))
+    {
+        SLVN_PRINT("ERROR; OptimizeVertexCache() has not been run on these indices");
+        return SlvnResult::cUnexpectedError;
+    }
+
+    // Cut the runs further wherever the cache efficiency so far is within the threshold of the
+    // whole run, every cluster then starts with a cold cache without costing more than that.
+    std::vector<uint32_t> clusters;
+    FifoCache cache(vertexCount, mCacheSize);
+    for (size_t h = 0; h < mHardBoundaries.size(); h++)
+    {
+        uint32_t begin = mHardBoundaries[h];
+        uint32_t end = h + 1 < mHardBoundaries.size() ? mHardBoundaries[h + 1] : triangleCount;
+
+        cache.Reset();
+        uint32_t runMisses = 0;
+        for (uint32_t i = begin * 3; i < end * 3; i++)
+        {
+            runMisses += cache.Access(indices[i]) ? 0 : 1;
+        }
+        float runAcmr = static_cast<float>(runMisses) / static_cast<float>(end - begin);
+
+        cache.Reset();
+        clusters.push_back(begin);
+        uint32_t clusterStart = begin;
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = begin; t < end; t++)
+        {
+            for (uint32_t c = 0; c < 3; c++)
+            {
+                clusterMisses += cache.Access(indices[t * 3 + c]) ? 0 : 1;
+            }
+            float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(t + 1 - clusterStart);
+            if (t + 1 < end && clusterAcmr <= runAcmr * mOverdrawThreshold)
+            {
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                clusters.push_back(clusterStart);
+                cache.Reset();
+            }
+        }
+    }
+    mStats.mClusterCount = static_cast<uint32_t>(clusters.size());
+
+    glm::vec3 meshCenter(0.0f);
+    float meshArea = 0.0f;
+    std::vector<float> sortKeys(clusters.size());
+    std::vector<glm::vec3> clusterCenters(clusters.size(), glm::vec3(0.0f));
+    std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+    std::vector<float> clusterAreas(clusters.size(), 0.0f);
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        for (uint32_t t = clusters[c]; t < end; t++)
+        {
+            const glm::vec3& p0 = vertices[indices[t * 3]].mPosition;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].mPosition;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].mPosition;
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            clusterCenters[c] += (p0 + p1 + p2) * (area / 3.0f);
+            clusterNormals[c] += normal;
+            clusterAreas[c] += area;
+        }
+        meshCenter += clusterCenters[c];
+        meshArea += clusterAreas[c];
+    }
+    meshCenter = meshArea > 0.0f ? meshCenter / meshArea : meshCenter;
+
+    // Clusters facing away from the center are the outer shell and tend to hide the rest.
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        glm::vec3 center = clusterAreas[c] > 0.0f ? clusterCenters[c] / clusterAreas[c] : meshCenter;
+        float length = glm::length(clusterNormals[c]);
+        glm::vec3 normal = length > 0.0f ? clusterNormals[c] / length : glm::vec3(0.0f);
+        sortKeys[c] = glm::dot(center - meshCenter, normal);
+    }
+    std::vector<uint32_t> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for (uint32_t c : order)
+    {
+        uint32_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + end * 3);
+    }
+    indices.swap(output);
+    mHardBoundaries.clear();
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMeshOptimizer::OptimizeVertexFetch(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (!validIndices(indices, vertexCount))
+        return SlvnResult::cUnexpectedError;
+
+    std::vector<uint32_t> remap(vertexCount, cInvalid);
+    std::vector<SlvnVertex> output;
+    output.reserve(vertexCount);
+    for (uint32_t& index : indices)
+    {
+        if (remap[index] == cInvalid)
+        {
+            remap[index] = static_cast<uint32_t>(output.size());
+            output.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(output);
+    return SlvnResult::cOk;
+}
+
+} // slvn_tech
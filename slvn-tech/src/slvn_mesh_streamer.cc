@@ -0,0 +1,312 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <cfloat>
+#include <cstring>
+#include <algorithm>
+#include <iterator>
+
+#include <slvn_mesh_streamer.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+uint32_t floatBits(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits)
+{
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+SlvnMeshStreamer::SlvnMeshStreamer() : mBudgetBytes(0), mMaxLoadsInFlight(1), mPool(nullptr), mUploader(nullptr),
+mDeletionQueue(nullptr), mFrame(0), mInFlight(0), mStats(), mTotalLoadMs(0.0)
+{
+}
+
+SlvnMeshStreamer::~SlvnMeshStreamer()
+{
+}
+
+SlvnResult SlvnMeshStreamer::Initialize(SlvnGeometryPool* pool, SlvnUploadManager* uploader, SlvnDeletionQueue* deletionQueue,
+    uint64_t budgetBytes, uint32_t maxLoadsInFlight)
+{
+    SLVN_PRINT("ENTER");
+
+    mPool = pool;
+    mUploader = uploader;
+    mDeletionQueue = deletionQueue;
+    mBudgetBytes = budgetBytes;
+    mMaxLoadsInFlight = std::max(1u, maxLoadsInFlight);
+    mStats = SlvnStreamingStats();
+    mTotalLoadMs = 0.0;
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMeshStreamer::Deinitialize(uint64_t lastUse)
+{
+    mLoader.Wait();
+    for (auto& entry : mMeshes)
+    {
+        // Uploads still running finish before the deletion queue gets to the ranges.
+        if (entry.mState == State::cResident || entry.mState == State::cUploading)
+            mPool->RemoveMesh(entry.mPoolMesh, std::max(entry.mLastUsed, lastUse), mDeletionQueue);
+    }
+    mMeshes.clear();
+    mFinishedLoads.clear();
+    mInFlight = 0;
+    return SlvnResult::cOk;
+}
+
+uint32_t SlvnMeshStreamer::AddMesh(SlvnMeshLoader loader, uint32_t fallbackMesh)
+{
+    mMeshes.emplace_back();
+    Entry& entry = mMeshes.back();
+    entry.mLoader = std::move(loader);
+    entry.mFallbackMesh = fallbackMesh;
+    entry.mPoolMesh = SlvnGeometryPool::cInvalidMesh;
+    entry.mState = State::cUnloaded;
+    entry.mBytes = 0;
+    entry.mBatch = 0;
+    entry.mLastUsed = 0;
+    entry.mRequestFrame = 0;
+    entry.mNearestBits = floatBits(FLT_MAX);
+    return static_cast<uint32_t>(mMeshes.size() - 1);
+}
+
+void SlvnMeshStreamer::BeginFrame(uint64_t frame)
+{
+    // Nothing has been requested yet, the meshes drawn last frame are the ones on screen.
+    uint64_t lastFrame = mFrame;
+    mFrame = frame;
+    mStats.mLoadCount = 0;
+    mStats.mEvictionCount = 0;
+
+    std::vector<LoadResult> finished;
+    {
+        std::lock_guard<std::mutex> lock(mLoadMutex);
+        finished.swap(mFinishedLoads);
+    }
+    // Placing a mesh stages its data, near the budget the rest wait for a later frame.
+    for (size_t i = 0; i < finished.size(); i++)
+    {
+        if (i > 0 && mPool->IsNearBudget())
+        {
+            std::lock_guard<std::mutex> lock(mLoadMutex);
+            mFinishedLoads.insert(mFinishedLoads.begin(), std::make_move_iterator(finished.begin() + i),
+                std::make_move_iterator(finished.end()));
+            break;
+        }
+        place(finished[i], lastFrame);
+    }
+
+    // Acquire barriers of completed batches were recorded just before, the meshes are usable from here on.
+    auto now = std::chrono::high_resolution_clock::now();
+    for (auto& entry : mMeshes)
+    {
+        if (entry.mState != State::cUploading || !mUploader->IsComplete(entry.mBatch))
+            continue;
+
+        entry.mState = State::cResident;
+        mInFlight--;
+        float loadMs = std::chrono::duration<float, std::milli>(now - entry.mRequestTime).count();
+        mTotalLoadMs += loadMs;
+        mStats.mMaxLoadMs = std::max(mStats.mMaxLoadMs, loadMs);
+        mStats.mLoadCount++;
+        mStats.mTotalLoadCount++;
+        mStats.mAverageLoadMs = static_cast<float>(mTotalLoadMs / mStats.mTotalLoadCount);
+    }
+}
+
+void SlvnMeshStreamer::place(LoadResult& load, uint64_t keepFrame)
+{
+    Entry& entry = mMeshes[load.mMesh];
+    if (load.mResult != SlvnResult::cOk)
+    {
+        SLVN_PRINT("ERROR; loading streamed mesh " << load.mMesh << " failed");
+        entry.mState = State::cUnloaded;
+        mInFlight--;
+        return;
+    }
+
+    SlvnStreamedMeshData& data = load.mData;
+    uint32_t poolMesh = mPool->AddMesh(data.mVertices.data(), data.mVertexCount, data.mIndices.data(),
+        static_cast<uint32_t>(data.mIndices.size()), data.mFormat, data.mQuantization);
+
+    // Evicted ranges only come back once the deletion queue retires their frames, so only as many bytes
+    // as the mesh needs are evicted and the load is retried on a later request.
+    if (poolMesh == SlvnGeometryPool::cInvalidMesh)
+    {
+        uint64_t needed = data.mVertices.size() + data.mIndices.size() * sizeof(uint32_t);
+        uint64_t evicted = 0;
+        while (evicted < needed)
+        {
+            uint64_t bytes = evictLeastRecentlyUsed(keepFrame);
+            if (bytes == 0)
+                break;
+            evicted += bytes;
+        }
+        SLVN_PRINT("WARNING; streamed mesh " << load.mMesh << " does not fit the geometry pool, evicted " << evicted << " bytes");
+        entry.mState = State::cUnloaded;
+        mInFlight--;
+        return;
+    }
+
+    entry.mPoolMesh = poolMesh;
+    uint32_t indexSize = mPool->GetMesh(poolMesh).mIndexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    entry.mBytes = data.mVertices.size() + data.mIndices.size() * indexSize;
+    entry.mLastUsed = mFrame;
+    entry.mState = State::cUploading;
+    // Host visible pools write directly, Submit() then returns a batch that is already complete or about to.
+    entry.mBatch = mUploader->Submit();
+    mStats.mResidentBytes += entry.mBytes;
+}
+
+void SlvnMeshStreamer::Request(uint32_t mesh, float distance)
+{
+    Entry& entry = mMeshes[mesh];
+    entry.mRequestFrame.store(mFrame, std::memory_order_relaxed);
+
+    uint32_t bits = floatBits(std::max(distance, 0.0f));
+    uint32_t nearest = entry.mNearestBits.load(std::memory_order_relaxed);
+    while (bits < nearest && !entry.mNearestBits.compare_exchange_weak(nearest, bits, std::memory_order_relaxed))
+    {
+    }
+}
+
+uint32_t SlvnMeshStreamer::Resolve(uint32_t mesh) const
+{
+    const Entry& entry = mMeshes[mesh];
+    return entry.mState == State::cResident ? entry.mPoolMesh : entry.mFallbackMesh;
+}
+
+void SlvnMeshStreamer::EndFrame()
+{
+    mStats.mRequestCount = 0;
+    mStats.mHitCount = 0;
+    mCandidates.clear();
+    for (uint32_t i = 0; i < mMeshes.size(); i++)
+    {
+        Entry& entry = mMeshes[i];
+        if (entry.mRequestFrame.load(std::memory_order_relaxed) != mFrame)
+            continue;
+
+        mStats.mRequestCount++;
+        if (entry.mState == State::cResident || entry.mState == State::cUploading)
+            entry.mLastUsed = mFrame;
+        if (entry.mState == State::cResident)
+            mStats.mHitCount++;
+        else if (entry.mState == State::cUnloaded)
+            mCandidates.push_back(i);
+    }
+    mStats.mTotalRequestCount += mStats.mRequestCount;
+    mStats.mTotalHitCount += mStats.mHitCount;
+
+    // Nearest first; the load slots are few and the closest misses are the most visible.
+    std::sort(mCandidates.begin(), mCandidates.end(), [this](uint32_t a, uint32_t b)
+        {
+            return bitsFloat(mMeshes[a].mNearestBits) < bitsFloat(mMeshes[b].mNearestBits);
+        });
+    auto now = std::chrono::high_resolution_clock::now();
+    bool nearBudget = mPool->IsNearBudget();
+    for (uint32_t mesh : mCandidates)
+    {
+        if (nearBudget || mInFlight >= mMaxLoadsInFlight)
+            break;
+
+        Entry& entry = mMeshes[mesh];
+        entry.mState = State::cLoading;
+        entry.mRequestTime = now;
+        mInFlight++;
+        mLoader.addJob([this, mesh]
+            {
+                LoadResult load = {};
+                load.mMesh = mesh;
+                load.mResult = mMeshes[mesh].mLoader(load.mData);
+                std::lock_guard<std::mutex> lock(mLoadMutex);
+                mFinishedLoads.push_back(std::move(load));
+            });
+    }
+
+    while (mStats.mResidentBytes > mBudgetBytes && evictLeastRecentlyUsed(mFrame) > 0)
+    {
+    }
+
+    for (auto& entry : mMeshes)
+    {
+        entry.mNearestBits.store(floatBits(FLT_MAX), std::memory_order_relaxed);
+    }
+
+    mStats.mMeshCount = static_cast<uint32_t>(mMeshes.size());
+    mStats.mResidentCount = 0;
+    for (auto& entry : mMeshes)
+    {
+        if (entry.mState == State::cResident)
+            mStats.mResidentCount++;
+    }
+    mStats.mLoadingCount = mInFlight;
+    mStats.mBudgetBytes = mBudgetBytes;
+}
+
+uint64_t SlvnMeshStreamer::evictLeastRecentlyUsed(uint64_t keepFrame)
+{
+    // Meshes used since keepFrame or still uploading stay.
+    Entry* victim = nullptr;
+    for (auto& entry : mMeshes)
+    {
+        if (entry.mState != State::cResident || entry.mLastUsed >= keepFrame)
+            continue;
+        if (victim == nullptr || entry.mLastUsed < victim->mLastUsed)
+            victim = &entry;
+    }
+    if (victim == nullptr)
+        return 0;
+
+    mPool->RemoveMesh(victim->mPoolMesh, victim->mLastUsed, mDeletionQueue);
+    victim->mPoolMesh = SlvnGeometryPool::cInvalidMesh;
+    victim->mState = State::cUnloaded;
+    mStats.mResidentBytes -= victim->mBytes;
+    mStats.mEvictionCount++;
+    mStats.mTotalEvictionCount++;
+    return victim->mBytes;
+}
+
+} // slvn_tech
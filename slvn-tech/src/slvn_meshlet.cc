@@ -0,0 +1,402 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <emmintrin.h>
+
+#include <slvn_meshlet.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+// Set bits of a four lane mask.
+constexpr uint32_t cLaneCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+}
+
+SlvnMeshletBuilder::SlvnMeshletBuilder() : mMaxVertices(64), mMaxTriangles(124), mConeWeight(0.5f)
+{
+}
+
+SlvnMeshletBuilder::~SlvnMeshletBuilder()
+{
+}
+
+SlvnResult SlvnMeshletBuilder::Build(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices, uint32_t firstIndex,
+    uint32_t indexCount, std::vector<SlvnMeshlet>& meshlets)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (indexCount % 3 != 0 || firstIndex + indexCount > indices.size() || mMaxVertices < 3 || mMaxTriangles < 1)
+    {
+        SLVN_PRINT("ERROR; invalid meshlet range or limits");
+        return SlvnResult::cUnexpectedError;
+    }
+    const uint32_t* source = indices.data() + firstIndex;
+    if (std::any_of(source, source + indexCount, [=](uint32_t index) { return index >= vertexCount; }))
+    {
+        SLVN_PRINT("ERROR; index out of range");
+        return SlvnResult::cUnexpectedError;
+    }
+
+    // Vertex to triangle adjacency of the range, and unit triangle normals.
+    uint32_t triangleCount = indexCount / 3;
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (uint32_t i = 0; i < indexCount; i++)
+    {
+        adjacencyOffsets[source[i] + 1]++;
+    }
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+    }
+    std::vector<uint32_t> adjacency(indexCount);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t i = 0; i < indexCount; i++)
+    {
+        adjacency[fill[source[i]]++] = i / 3;
+    }
+    std::vector<glm::vec3> normals(triangleCount);
+    std::vector<glm::vec3> centroids(triangleCount);
+    float area = 0.0f;
+    for (uint32_t t = 0; t < triangleCount; t++)
+    {
+        const glm::vec3& p0 = vertices[source[t * 3]].mPosition;
+        const glm::vec3& p1 = vertices[source[t * 3 + 1]].mPosition;
+        const glm::vec3& p2 = vertices[source[t * 3 + 2]].mPosition;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float length = glm::length(normal);
+        normals[t] = length > 0.0f ? normal / length : glm::vec3(0.0f);
+        centroids[t] = (p0 + p1 + p2) / 3.0f;
+        area += length * 0.5f;
+    }
+    // Radius a meshlet of mMaxTriangles average triangles would have, scales the distance term.
+    float expectedRadius = std::max(std::sqrt(area / static_cast<float>(std::max(triangleCount, 1u)) * static_cast<float>(mMaxTriangles)) * 0.5f, FLT_MIN);
+
+    std::vector<uint8_t> used(triangleCount, 0);
+    // Unused triangles around every vertex.
+    std::vector<uint32_t> live(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        live[v] = adjacencyOffsets[v + 1] - adjacencyOffsets[v];
+    }
+    // Meshlet a vertex was last added to, so that membership needs no clearing between meshlets.
+    std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);
+    std::vector<uint32_t> ordered;
+    ordered.reserve(indexCount);
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> meshletTriangles;
+
+    uint32_t meshletId = 0;
+    uint32_t meshletVertices = 0;
+    glm::vec3 normalSum(0.0f);
+    glm::vec3 positionSum(0.0f);
+    auto addTriangle = [&](uint32_t triangle)
+    {
+        used[triangle] = 1;
+        live[source[triangle * 3]]--;
+        live[source[triangle * 3 + 1]]--;
+        live[source[triangle * 3 + 2]]--;
+        meshletTriangles.push_back(triangle);
+        normalSum += normals[triangle];
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            uint32_t vertex = source[triangle * 3 + c];
+            ordered.push_back(vertex);
+            if (vertexMeshlet[vertex] == meshletId)
+                continue;
+            vertexMeshlet[vertex] = meshletId;
+            meshletVertices++;
+            positionSum += vertices[vertex].mPosition;
+            for (uint32_t a = adjacencyOffsets[vertex]; a < adjacencyOffsets[vertex + 1]; a++)
+            {
+                if (!used[adjacency[a]])
+                    candidates.push_back(adjacency[a]);
+            }
+        }
+    };
+    auto finishMeshlet = [&]()
+    {
+        SlvnMeshlet meshlet = {};
+        meshlet.mFirstIndex = firstIndex + static_cast<uint32_t>(ordered.size()) - static_cast<uint32_t>(meshletTriangles.size()) * 3;
+        meshlet.mIndexCount = static_cast<uint32_t>(meshletTriangles.size()) * 3;
+
+        SlvnAabb bounds;
+        for (uint32_t i = meshlet.mFirstIndex - firstIndex; i < ordered.size(); i++)
+        {
+            bounds.Grow(vertices[ordered[i]].mPosition);
+        }
+        meshlet.mCenter = bounds.GetCenter();
+        for (uint32_t i = meshlet.mFirstIndex - firstIndex; i < ordered.size(); i++)
+        {
+            meshlet.mRadius = std::max(meshlet.mRadius, glm::length(vertices[ordered[i]].mPosition - meshlet.mCenter));
+        }
+
+        // The cone opens as wide as the normal furthest from the average, past 90 degrees nothing can be culled.
+        float axisLength = glm::length(normalSum);
+        meshlet.mConeAxis = axisLength > 0.0f ? normalSum / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+        float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+        for (uint32_t triangle : meshletTriangles)
+        {
+            if (normals[triangle] != glm::vec3(0.0f))
+                minDot = std::min(minDot, glm::dot(normals[triangle], meshlet.mConeAxis));
+        }
+        meshlet.mConeCutoff = minDot <= 0.0f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+        meshlets.push_back(meshlet);
+
+        meshletTriangles.clear();
+        meshletVertices = 0;
+        normalSum = glm::vec3(0.0f);
+        positionSum = glm::vec3(0.0f);
+        meshletId++;
+    };
+
+    uint32_t seed = 0;
+    while (true)
+    {
+        if (meshletTriangles.empty())
+        {
+            // The next meshlet starts on the border of the last one, at the triangle with the fewest
+            // unused neighbours, so that no small islands are left behind.
+            uint32_t start = UINT32_MAX;
+            uint32_t startLive = UINT32_MAX;
+            for (uint32_t triangle : candidates)
+            {
+                uint32_t neighbours = live[source[triangle * 3]] + live[source[triangle * 3 + 1]] + live[source[triangle * 3 + 2]];
+                if (!used[triangle] && neighbours < startLive)
+                {
+                    start = triangle;
+                    startLive = neighbours;
+                }
+            }
+            candidates.clear();
+            if (start == UINT32_MAX)
+            {
+                while (seed < triangleCount && used[seed])
+                    seed++;
+                if (seed == triangleCount)
+                    break;
+                start = seed;
+            }
+            addTriangle(start);
+            continue;
+        }
+
+        // Best candidate sharing vertices with the meshlet, used ones are dropped on the way. Triangles adding
+        // no vertex come first, then ones that are the last unused triangle of a vertex, which would otherwise
+        // be left as an island, then by new vertices. Within a class triangles close to the meshlet center and
+        // facing along its cone win.
+        glm::vec3 axis = glm::length(normalSum) > 0.0f ? glm::normalize(normalSum) : glm::vec3(0.0f);
+        glm::vec3 center = positionSum / static_cast<float>(meshletVertices);
+        uint32_t best = UINT32_MAX;
+        uint32_t bestPriority = UINT32_MAX;
+        float bestScore = FLT_MAX;
+        for (size_t c = 0; c < candidates.size();)
+        {
+            uint32_t triangle = candidates[c];
+            if (used[triangle])
+            {
+                candidates[c] = candidates.back();
+                candidates.pop_back();
+                continue;
+            }
+            c++;
+
+            uint32_t newVertices = 0;
+            bool dangling = false;
+            for (uint32_t corner = 0; corner < 3; corner++)
+            {
+                uint32_t vertex = source[triangle * 3 + corner];
+                newVertices += vertexMeshlet[vertex] != meshletId ? 1 : 0;
+                dangling |= live[vertex] == 1;
+            }
+            if (meshletVertices + newVertices > mMaxVertices)
+                continue;
+            uint32_t priority = newVertices == 0 ? 0 : (dangling ? 1 : newVertices + 1);
+            float cone = std::max(1.0f - glm::dot(normals[triangle], axis) * mConeWeight, 1e-3f);
+            float score = (1.0f + glm::length(centroids[triangle] - center) / expectedRadius * (1.0f - mConeWeight)) * cone;
+            if (priority < bestPriority || (priority == bestPriority && score < bestScore))
+            {
+                bestPriority = priority;
+                bestScore = score;
+                best = triangle;
+            }
+        }
+
+        if (best == UINT32_MAX)
+        {
+            finishMeshlet();
+            continue;
+        }
+        addTriangle(best);
+        if (meshletTriangles.size() == mMaxTriangles)
+            finishMeshlet();
+    }
+    if (!meshletTriangles.empty())
+        finishMeshlet();
+
+    std::copy(ordered.begin(), ordered.end(), indices.begin() + firstIndex);
+    return SlvnResult::cOk;
+}
+
+SlvnMeshletCuller::SlvnMeshletCuller() :
+mTestedCount(0), mFrustumCulledCount(0), mBackfaceCulledCount(0), mCullNs(0)
+{
+}
+
+SlvnMeshletCuller::~SlvnMeshletCuller()
+{
+}
+
+void SlvnMeshletCuller::SetMeshlets(const std::vector<SlvnMeshlet>& meshlets)
+{
+    // Lanes past the last meshlet are masked off in Cull().
+    mGroups.assign((meshlets.size() + 3) / 4, BoundsGroup());
+    for (size_t m = 0; m < meshlets.size(); m++)
+    {
+        BoundsGroup& group = mGroups[m / 4];
+        size_t lane = m % 4;
+        group.mCenterX[lane] = meshlets[m].mCenter.x;
+        group.mCenterY[lane] = meshlets[m].mCenter.y;
+        group.mCenterZ[lane] = meshlets[m].mCenter.z;
+        group.mRadius[lane] = meshlets[m].mRadius;
+        group.mAxisX[lane] = meshlets[m].mConeAxis.x;
+        group.mAxisY[lane] = meshlets[m].mConeAxis.y;
+        group.mAxisZ[lane] = meshlets[m].mConeAxis.z;
+        group.mCutoff[lane] = meshlets[m].mConeCutoff;
+    }
+    mRanges.clear();
+    mRanges.reserve(meshlets.size());
+    for (auto& meshlet : meshlets)
+    {
+        mRanges.push_back({ meshlet.mFirstIndex, meshlet.mIndexCount });
+    }
+}
+
+uint32_t SlvnMeshletCuller::Cull(uint32_t firstMeshlet, uint32_t meshletCount, const glm::mat4& model, const glm::mat4& viewProjection,
+    const glm::vec3& eye, std::vector<SlvnIndexRange>& ranges)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // Planes of the object space frustum, normalized so that distances are in object units.
+    SlvnFrustum frustum = SlvnFrustum::FromMatrix(viewProjection * model);
+    glm::vec3 localEye = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+    __m128 eyeX = _mm_set1_ps(localEye.x);
+    __m128 eyeY = _mm_set1_ps(localEye.y);
+    __m128 eyeZ = _mm_set1_ps(localEye.z);
+    __m128 zero = _mm_setzero_ps();
+
+    uint32_t rangeCount = 0;
+    uint32_t frustumCulled = 0;
+    uint32_t backfaceCulled = 0;
+    uint32_t end = firstMeshlet + meshletCount;
+    for (uint32_t base = firstMeshlet & ~3u; base < end; base += 4)
+    {
+        const BoundsGroup& group = mGroups[base / 4];
+        __m128 centerX = _mm_loadu_ps(group.mCenterX);
+        __m128 centerY = _mm_loadu_ps(group.mCenterY);
+        __m128 centerZ = _mm_loadu_ps(group.mCenterZ);
+        __m128 radius = _mm_loadu_ps(group.mRadius);
+
+        // Outside once the sphere is fully behind any plane.
+        __m128 outside = zero;
+        for (const glm::vec4& plane : frustum.mPlanes)
+        {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(centerX, _mm_set1_ps(plane.x)), _mm_mul_ps(centerY, _mm_set1_ps(plane.y))),
+                _mm_add_ps(_mm_mul_ps(centerZ, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+        }
+
+        // Backfacing once every normal in the cone points away from the eye.
+        __m128 toX = _mm_sub_ps(centerX, eyeX);
+        __m128 toY = _mm_sub_ps(centerY, eyeY);
+        __m128 toZ = _mm_sub_ps(centerZ, eyeZ);
+        __m128 along = _mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, _mm_loadu_ps(group.mAxisX)), _mm_mul_ps(toY, _mm_loadu_ps(group.mAxisY))),
+            _mm_mul_ps(toZ, _mm_loadu_ps(group.mAxisZ)));
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(toX, toX), _mm_mul_ps(toY, toY)), _mm_mul_ps(toZ, toZ)));
+        __m128 backface = _mm_cmpge_ps(along, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(group.mCutoff), distance), radius));
+
+        // Lanes of other objects only occur in the first and the last group.
+        uint32_t laneMask = 0xF;
+        if (base < firstMeshlet)
+            laneMask &= 0xFu << (firstMeshlet - base);
+        if (base + 4 > end)
+            laneMask &= 0xFu >> (base + 4 - end);
+        uint32_t outsideMask = static_cast<uint32_t>(_mm_movemask_ps(outside)) & laneMask;
+        uint32_t backfaceMask = static_cast<uint32_t>(_mm_movemask_ps(backface)) & laneMask & ~outsideMask;
+        uint32_t visibleMask = laneMask & ~(outsideMask | backfaceMask);
+        frustumCulled += cLaneCounts[outsideMask];
+        backfaceCulled += cLaneCounts[backfaceMask];
+        for (uint32_t lane = 0; visibleMask != 0; lane++, visibleMask >>= 1)
+        {
+            if ((visibleMask & 1) == 0)
+                continue;
+
+            // Meshlets are stored back to back, a visible neighbour extends the last range.
+            const SlvnIndexRange& range = mRanges[base + lane];
+            if (rangeCount > 0 && ranges.back().mFirstIndex + ranges.back().mIndexCount == range.mFirstIndex)
+            {
+                ranges.back().mIndexCount += range.mIndexCount;
+                continue;
+            }
+            ranges.push_back(range);
+            rangeCount++;
+        }
+    }
+
+    mTestedCount += meshletCount;
+    mFrustumCulledCount += frustumCulled;
+    mBackfaceCulledCount += backfaceCulled;
+    auto stop = std::chrono::high_resolution_clock::now();
+    mCullNs += std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+    return rangeCount;
+}
+
+SlvnMeshletCullStats SlvnMeshletCuller::GetStats() const
+{
+    SlvnMeshletCullStats stats = {};
+    stats.mTestedCount = mTestedCount.load();
+    stats.mFrustumCulledCount = mFrustumCulledCount.load();
+    stats.mBackfaceCulledCount = mBackfaceCulledCount.load();
+    stats.mCullMs = static_cast<float>(mCullNs.load()) / 1000000.0f;
+    return stats;
+}
+
+void SlvnMeshletCuller::ResetStats()
+{
+    mTestedCount = 0;
+    mFrustumCulledCount = 0;
+    mBackfaceCulledCount = 0;
+    mCullNs = 0;
+}
+
+} // slvn_tech
@@ -0,0 +1,415 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SLVN_OBJ_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#include <slvn_obj_parser.h>
+#include <slvn_mapped_file.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline bool isBlank(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end)
+{
+    while (p < end && isBlank(*p))
+        p++;
+    return p;
+}
+
+// from_chars does not take a leading plus, which some exporters write.
+inline const char* parseFloat(const char* p, const char* end, float& value)
+{
+    p = skipBlanks(p, end);
+    if (p < end && *p == '+')
+        p++;
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+inline const char* parseInt(const char* p, const char* end, int32_t& value)
+{
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+}
+
+
+}
+
+const char* SlvnFindByte(const char* begin, const char* end, char value)
+{
+    const char* p = begin;
+#ifdef SLVN_OBJ_SSE2
+    __m128i pattern = _mm_set1_epi8(value);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern));
+        if (mask != 0)
+        {
+#ifdef _MSC_VER
+            unsigned long offset;
+            _BitScanForward(&offset, static_cast<unsigned long>(mask));
+#else
+            int offset = __builtin_ctz(static_cast<unsigned int>(mask));
+#endif
+            return p + offset;
+        }
+        p += 16;
+    }
+#endif
+    while (p < end && *p != value)
+        p++;
+    return p;
+}
+
+SlvnObjParser::SlvnObjParser() : mStats()
+{
+}
+
+SlvnObjParser::~SlvnObjParser()
+{
+}
+
+SlvnResult SlvnObjParser::Parse(const std::string& path, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+    SlvnThreadpool* threadpool)
+{
+    SlvnMappedFile file;
+    SlvnResult result = file.Open(path);
+    if (result != SlvnResult::cOk)
+    {
+        SLVN_PRINT("ERROR; could not open " << path);
+        return result;
+    }
+    return Parse(file.GetData(), file.GetSize(), vertices, indices, threadpool);
+}
+
+template<typename Job>
+void SlvnObjParser::runChunks(SlvnThreadpool* threadpool, Job job)
+{
+    uint32_t chunkCount = static_cast<uint32_t>(mChunks.size());
+    if (threadpool == nullptr || chunkCount == 1)
+    {
+        for (uint32_t c = 0; c < chunkCount; c++)
+        {
+            job(c);
+        }
+        return;
+    }
+
+    uint32_t threadCount = static_cast<uint32_t>(threadpool->mThreads.size());
+    for (uint32_t c = 0; c < chunkCount; c++)
+    {
+        threadpool->mThreads[c % threadCount]->addJob([&job, c] { job(c); });
+    }
+    threadpool->Wait();
+}
+
+SlvnResult SlvnObjParser::Parse(const char* data, size_t size, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+    SlvnThreadpool* threadpool)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    mStats = SlvnObjStats();
+    mStats.mFileBytes = size;
+
+    // A few chunks per thread even out chunks heavy on faces against ones heavy on positions.
+    uint32_t threadCount = threadpool != nullptr ? static_cast<uint32_t>(threadpool->mThreads.size()) : 1;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount > 1 ? threadCount * 4 : 1, size / cMinChunkSize));
+    size_t chunkSize = size / chunkCount;
+    mChunks.clear();
+    mChunks.resize(chunkCount);
+    const char* end = data + size;
+    const char* begin = data;
+    for (size_t c = 0; c < chunkCount; c++)
+    {
+        // Every chunk but the last ends right after a line break.
+        const char* chunkEnd = c + 1 == chunkCount ? end : SlvnFindByte(std::max(begin, data + (c + 1) * chunkSize), end, '\n');
+        if (chunkEnd < end)
+            chunkEnd++;
+        mChunks[c].mBegin = begin;
+        mChunks[c].mEnd = chunkEnd;
+        begin = chunkEnd;
+    }
+
+    runChunks(threadpool, [this](uint32_t c) { scanChunk(mChunks[c]); });
+
+    // Prefix sums over the chunk counts give every chunk its place in the merged arrays.
+    uint32_t positionCount = 0;
+    uint32_t normalCount = 0;
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    for (Chunk& chunk : mChunks)
+    {
+        chunk.mLineBase = mStats.mLineCount;
+        chunk.mPositionBase = positionCount;
+        chunk.mNormalBase = normalCount;
+        chunk.mVertexBase = vertexCount;
+        chunk.mIndexBase = indexCount;
+        if (chunk.mErrorLine != 0)
+        {
+            SLVN_PRINT("ERROR; malformed line " << chunk.mLineBase + chunk.mErrorLine);
+            return SlvnResult::cUnexpectedError;
+        }
+
+        mStats.mLineCount += chunk.mLineCount;
+        mStats.mTexCoordCount += chunk.mTexCoordCount;
+        mStats.mFaceCount += static_cast<uint32_t>(chunk.mFaceSizes.size());
+        mStats.mTriangleCount += chunk.mTriangleCount;
+        positionCount += static_cast<uint32_t>(chunk.mPositions.size());
+        normalCount += static_cast<uint32_t>(chunk.mNormals.size());
+        vertexCount += chunk.mCorners.size();
+        indexCount += static_cast<size_t>(chunk.mTriangleCount) * 3;
+    }
+    mStats.mPositionCount = positionCount;
+    mStats.mNormalCount = normalCount;
+
+    mPositions.resize(positionCount);
+    mNormals.resize(normalCount);
+    size_t vertexOffset = vertices.size();
+    size_t indexOffset = indices.size();
+    vertices.resize(vertexOffset + vertexCount);
+    indices.resize(indexOffset + indexCount);
+
+    runChunks(threadpool, [this](uint32_t c)
+        {
+            Chunk& chunk = mChunks[c];
+            std::copy(chunk.mPositions.begin(), chunk.mPositions.end(), mPositions.begin() + chunk.mPositionBase);
+            std::copy(chunk.mNormals.begin(), chunk.mNormals.end(), mNormals.begin() + chunk.mNormalBase);
+        });
+
+    std::vector<uint8_t> failed(mChunks.size(), 0);
+    SlvnVertex* outVertices = vertices.data() + vertexOffset;
+    uint32_t* outIndices = indices.data() + indexOffset;
+    runChunks(threadpool, [&, this](uint32_t c)
+        {
+            failed[c] = emitChunk(mChunks[c], outVertices, static_cast<uint32_t>(vertexOffset), outIndices) ? 0 : 1;
+        });
+
+    bool valid = std::find(failed.begin(), failed.end(), 1) == failed.end();
+    mChunks.clear();
+    if (!valid)
+    {
+        SLVN_PRINT("ERROR; face references a missing position or normal");
+        vertices.resize(vertexOffset);
+        indices.resize(indexOffset);
+        return SlvnResult::cUnexpectedError;
+    }
+
+    mStats.mParseMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return SlvnResult::cOk;
+}
+
+void SlvnObjParser::scanChunk(Chunk& chunk)
+{
+    chunk.mTexCoordCount = 0;
+    chunk.mLineCount = 0;
+    chunk.mTriangleCount = 0;
+    chunk.mErrorLine = 0;
+
+    bool valid = true;
+    // Typical exports spend roughly 30 bytes per face line, most of the file.
+    size_t estimatedFaces = static_cast<size_t>(chunk.mEnd - chunk.mBegin) / 32;
+    chunk.mCorners.reserve(estimatedFaces * 3);
+    chunk.mFaceSizes.reserve(estimatedFaces);
+
+    const char* line = chunk.mBegin;
+    while (line < chunk.mEnd)
+    {
+        const char* lineEnd = SlvnFindByte(line, chunk.mEnd, '\n');
+        const char* p = skipBlanks(line, lineEnd);
+        chunk.mLineCount++;
+        line = lineEnd + 1;
+
+        if (lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1]))
+        {
+            glm::vec3 position;
+            p = parseFloat(p + 2, lineEnd, position.x);
+            p = p ? parseFloat(p, lineEnd, position.y) : nullptr;
+            p = p ? parseFloat(p, lineEnd, position.z) : nullptr;
+            if (p == nullptr)
+            {
+                valid = false;
+                break;
+            }
+            chunk.mPositions.push_back(position);
+        }
+        else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2]))
+        {
+            glm::vec3 normal;
+            p = parseFloat(p + 3, lineEnd, normal.x);
+            p = p ? parseFloat(p, lineEnd, normal.y) : nullptr;
+            p = p ? parseFloat(p, lineEnd, normal.z) : nullptr;
+            if (p == nullptr)
+            {
+                valid = false;
+                break;
+            }
+            chunk.mNormals.push_back(normal);
+        }
+        else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2]))
+        {
+            chunk.mTexCoordCount++;
+        }
+        else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1]))
+        {
+            // Corners are v, v/vt, v//vn or v/vt/vn.
+            p += 2;
+            uint32_t cornerCount = 0;
+            while (p != nullptr)
+            {
+                p = skipBlanks(p, lineEnd);
+                if (p >= lineEnd)
+                    break;
+
+                int32_t index;
+                p = parseInt(p, lineEnd, index);
+                if (p == nullptr || index == 0)
+                {
+                    p = nullptr;
+                    break;
+                }
+                // Relative indices count back from the elements this chunk has read so far.
+                Corner corner = {};
+                corner.mPosition = index > 0 ? index - 1 : static_cast<int32_t>(chunk.mPositions.size()) + index;
+                corner.mNormal = -1;
+                corner.mRelative = index < 0 ? 1 : 0;
+
+                if (p < lineEnd && *p == '/')
+                {
+                    p++;
+                    if (p < lineEnd && *p != '/')
+                        p = parseInt(p, lineEnd, index);
+                    if (p != nullptr && p < lineEnd && *p == '/')
+                    {
+                        p = parseInt(p + 1, lineEnd, index);
+                        if (p == nullptr || index == 0)
+                        {
+                            p = nullptr;
+                            break;
+                        }
+                        corner.mNormal = index > 0 ? index - 1 : static_cast<int32_t>(chunk.mNormals.size()) + index;
+                        corner.mRelative |= index < 0 ? 2 : 0;
+                    }
+                }
+                chunk.mCorners.push_back(corner);
+                cornerCount++;
+            }
+            if (p == nullptr || cornerCount == 1 || cornerCount == 2)
+            {
+                valid = false;
+                break;
+            }
+            if (cornerCount > 0)
+            {
+                chunk.mFaceSizes.push_back(cornerCount);
+                chunk.mTriangleCount += cornerCount - 2;
+            }
+        }
+    }
+
+    if (!valid)
+        chunk.mErrorLine = chunk.mLineCount;
+}
+
+bool SlvnObjParser::emitChunk(const Chunk& chunk, SlvnVertex* vertices, uint32_t vertexOffset, uint32_t* indices) const
+{
+    int32_t positionCount = static_cast<int32_t>(mPositions.size());
+    int32_t normalCount = static_cast<int32_t>(mNormals.size());
+
+    size_t corner = 0;
+    size_t vertex = chunk.mVertexBase;
+    size_t index = chunk.mIndexBase;
+    for (uint32_t faceSize : chunk.mFaceSizes)
+    {
+        const Corner* corners = &chunk.mCorners[corner];
+        bool hasNormals = true;
+        for (uint32_t i = 0; i < faceSize; i++)
+        {
+            int32_t position = corners[i].mPosition + ((corners[i].mRelative & 1) ? static_cast<int32_t>(chunk.mPositionBase) : 0);
+            if (position < 0 || position >= positionCount)
+                return false;
+            int32_t normal = corners[i].mNormal;
+            if (normal >= 0 || (corners[i].mRelative & 2))
+            {
+                normal += (corners[i].mRelative & 2) ? static_cast<int32_t>(chunk.mNormalBase) : 0;
+                if (normal < 0 || normal >= normalCount)
+                    return false;
+                vertices[vertex + i] = SlvnVertex(mPositions[position], mNormals[normal]);
+            }
+            else
+            {
+                hasNormals = false;
+                vertices[vertex + i] = SlvnVertex(mPositions[position], glm::vec3(0.0f));
+            }
+        }
+
+        if (!hasNormals)
+        {
+            glm::vec3 a = vertices[vertex].mPosition - vertices[vertex + 1].mPosition;
+            glm::vec3 b = vertices[vertex + 2].mPosition - vertices[vertex + 1].mPosition;
+            glm::vec3 faceNormal = glm::cross(a, b);
+            float length = glm::length(faceNormal);
+            if (length > 0.0f)
+                faceNormal /= length;
+            for (uint32_t i = 0; i < faceSize; i++)
+            {
+                vertices[vertex + i].mNormal = faceNormal;
+            }
+        }
+
+        uint32_t first = vertexOffset + static_cast<uint32_t>(vertex);
+        for (uint32_t i = 1; i + 1 < faceSize; i++)
+        {
+            indices[index++] = first;
+            indices[index++] = first + i;
+            indices[index++] = first + i + 1;
+        }
+        corner += faceSize;
+        vertex += faceSize;
+    }
+    return true;
+}
+
+} // slvn_tech
@@ -0,0 +1,412 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <emmintrin.h>
+
+#include <slvn_occlusion_culler.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+// Triangles reaching further than this from the screen are dropped instead of
+// rasterized, skipping an occluder is always conservative.
+constexpr float cGuardBand = 16384.0f;
+constexpr float cMinW = 1e-4f;
+
+}
+
+SlvnOcclusionCuller::SlvnOcclusionCuller() : mState(SlvnState::cNotInitialized), mThreadpool(nullptr), mWidth(0), mHeight(0),
+mTilesX(0), mTilesY(0), mBandCount(0), mBandHeight(0), mViewProjection(1.0f), mOccluderTriangles(0), mRasterizeMs(0.0f),
+mTestedCount(0), mCulledCount(0), mTestNs(0)
+{
+}
+
+SlvnOcclusionCuller::~SlvnOcclusionCuller()
+{
+    if (mState != SlvnState::cNotInitialized && mState != SlvnState::cDeinitialized)
+        SLVN_PRINT("ERROR; deconstructor called even though state was not deinitialized!");
+}
+
+SlvnResult SlvnOcclusionCuller::Initialize(uint32_t width, uint32_t height, SlvnThreadpool* threadpool)
+{
+    SLVN_PRINT("ENTER");
+    assert(threadpool != nullptr && !threadpool->mThreads.empty());
+
+    mThreadpool = threadpool;
+
+    // Both dimensions are rounded up to whole tiles, which also keeps rows SIMD aligned.
+    mTilesX = std::max(1u, (width + cTileSize - 1) / cTileSize);
+    mTilesY = std::max(1u, (height + cTileSize - 1) / cTileSize);
+    mWidth = mTilesX * cTileSize;
+    mHeight = mTilesY * cTileSize;
+
+    uint32_t threadCount = static_cast<uint32_t>(mThreadpool->mThreads.size());
+    uint32_t tilesPerBand = (mTilesY + threadCount - 1) / threadCount;
+    mBandHeight = tilesPerBand * cTileSize;
+    mBandCount = (mTilesY + tilesPerBand - 1) / tilesPerBand;
+
+    mDepth.assign(mWidth * mHeight, 1.0f);
+    mTileMaxDepth.assign(mTilesX * mTilesY, 1.0f);
+    mThreadTriangles.resize(threadCount);
+
+    mState = SlvnState::cInitialized;
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnOcclusionCuller::Deinitialize()
+{
+    SLVN_PRINT("ENTER");
+
+    mOccluders.clear();
+    mThreadTriangles.clear();
+    mDepth.clear();
+    mTileMaxDepth.clear();
+    mThreadpool = nullptr;
+
+    mState = SlvnState::cDeinitialized;
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+void SlvnOcclusionCuller::BeginFrame(const glm::mat4& viewProjection)
+{
+    mViewProjection = viewProjection;
+    mOccluders.clear();
+    mOccluderTriangles = 0;
+    mTestedCount = 0;
+    mCulledCount = 0;
+    mTestNs = 0;
+}
+
+void SlvnOcclusionCuller::AddOccluder(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, uint32_t firstIndex, uint32_t indexCount, const glm::mat4& model)
+{
+    assert(firstIndex + indexCount <= indices.size());
+    mOccluders.push_back({ &positions, &indices, firstIndex, indexCount, mViewProjection * model });
+    mOccluderTriangles += indexCount / 3;
+}
+
+void SlvnOcclusionCuller::Rasterize()
+{
+    assert(mState == SlvnState::cInitialized);
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint32_t threadCount = static_cast<uint32_t>(mThreadpool->mThreads.size());
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        mThreadpool->mThreads[t]->addJob([=]
+            {
+                setupTriangles(t);
+            });
+    }
+    mThreadpool->Wait();
+
+    for (uint32_t band = 0; band < mBandCount; band++)
+    {
+        mThreadpool->mThreads[band % threadCount]->addJob([=]
+            {
+                rasterizeBand(band);
+            });
+    }
+    mThreadpool->Wait();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    mRasterizeMs = std::chrono::duration<float, std::milli>(end - start).count();
+}
+
+void SlvnOcclusionCuller::setupTriangles(uint32_t threadIndex)
+{
+    std::vector<Triangle>& triangles = mThreadTriangles[threadIndex];
+    triangles.clear();
+
+    float halfWidth = static_cast<float>(mWidth) * 0.5f;
+    float halfHeight = static_cast<float>(mHeight) * 0.5f;
+    uint32_t threadCount = static_cast<uint32_t>(mThreadTriangles.size());
+
+    for (uint32_t o = threadIndex; o < mOccluders.size(); o += threadCount)
+    {
+        const Occluder& occluder = mOccluders[o];
+        const std::vector<glm::vec3>& positions = *occluder.mPositions;
+        const std::vector<uint32_t>& indices = *occluder.mIndices;
+
+        for (uint32_t i = occluder.mFirstIndex; i + 2 < occluder.mFirstIndex + occluder.mIndexCount; i += 3)
+        {
+            Triangle triangle;
+            bool valid = true;
+            for (uint32_t v = 0; v < 3 && valid; v++)
+            {
+                glm::vec4 clip = occluder.mModelViewProjection * glm::vec4(positions[indices[i + v]], 1.0f);
+                // Triangles crossing the near plane are not clipped, just left out.
+                if (clip.w < cMinW)
+                {
+                    valid = false;
+                    break;
+                }
+                float invW = 1.0f / clip.w;
+                triangle.mX[v] = (clip.x * invW + 1.0f) * halfWidth;
+                triangle.mY[v] = (clip.y * invW + 1.0f) * halfHeight;
+                triangle.mZ[v] = clip.z * invW;
+                valid = std::fabs(triangle.mX[v]) < cGuardBand && std::fabs(triangle.mY[v]) < cGuardBand;
+            }
+            if (!valid)
+                continue;
+
+            float minX = std::min(std::min(triangle.mX[0], triangle.mX[1]), triangle.mX[2]);
+            float maxX = std::max(std::max(triangle.mX[0], triangle.mX[1]), triangle.mX[2]);
+            float minY = std::min(std::min(triangle.mY[0], triangle.mY[1]), triangle.mY[2]);
+            float maxY = std::max(std::max(triangle.mY[0], triangle.mY[1]), triangle.mY[2]);
+            if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(mWidth) || minY >= static_cast<float>(mHeight))
+                continue;
+
+            triangle.mMinY = std::max(0, static_cast<int32_t>(std::floor(minY)));
+            triangle.mMaxY = std::min(static_cast<int32_t>(mHeight) - 1, static_cast<int32_t>(std::floor(maxY)));
+            triangles.push_back(triangle);
+        }
+    }
+}
+
+void SlvnOcclusionCuller::rasterizeBand(uint32_t band)
+{
+    int32_t bandMinY = static_cast<int32_t>(band * mBandHeight);
+    int32_t bandMaxY = std::min(static_cast<int32_t>(mHeight), bandMinY + static_cast<int32_t>(mBandHeight)) - 1;
+
+    std::fill(mDepth.begin() + bandMinY * mWidth, mDepth.begin() + (bandMaxY + 1) * mWidth, 1.0f);
+
+    for (auto& triangles : mThreadTriangles)
+    {
+        for (auto& triangle : triangles)
+        {
+            if (triangle.mMaxY < bandMinY || triangle.mMinY > bandMaxY)
+                continue;
+            rasterizeTriangle(triangle, bandMinY, bandMaxY);
+        }
+    }
+
+    updateHiZ(band);
+}
+
+void SlvnOcclusionCuller::rasterizeTriangle(const Triangle& triangle, int32_t bandMinY, int32_t bandMaxY)
+{
+    float x0 = triangle.mX[0], y0 = triangle.mY[0], z0 = triangle.mZ[0];
+    float x1 = triangle.mX[1], y1 = triangle.mY[1], z1 = triangle.mZ[1];
+    float x2 = triangle.mX[2], y2 = triangle.mY[2], z2 = triangle.mZ[2];
+
+    float area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (std::fabs(area) < 1e-6f)
+        return;
+    // Occluders are rendered double sided, flip winding so that inside is positive.
+    if (area < 0.0f)
+    {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        std::swap(z1, z2);
+        area = -area;
+    }
+
+    int32_t minX = std::max(0, static_cast<int32_t>(std::floor(std::min(std::min(x0, x1), x2))));
+    int32_t maxX = std::min(static_cast<int32_t>(mWidth) - 1, static_cast<int32_t>(std::floor(std::max(std::max(x0, x1), x2))));
+    int32_t minY = std::max(bandMinY, triangle.mMinY);
+    int32_t maxY = std::min(bandMaxY, triangle.mMaxY);
+    if (minX > maxX || minY > maxY)
+        return;
+    minX &= ~3;
+
+    // Edge function of edge a->b is (xb - xa) * (py - ya) - (yb - ya) * (px - xa),
+    // positive on the inside for every edge after the winding flip above.
+    float invArea = 1.0f / area;
+    __m128 stepX01 = _mm_set1_ps(-(y1 - y0) * 4.0f);
+    __m128 stepX12 = _mm_set1_ps(-(y2 - y1) * 4.0f);
+    __m128 stepX20 = _mm_set1_ps(-(y0 - y2) * 4.0f);
+    __m128 pixelOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+    __m128 zero = _mm_setzero_ps();
+    __m128 weight0 = _mm_set1_ps(z0 * invArea);
+    __m128 weight1 = _mm_set1_ps(z1 * invArea);
+    __m128 weight2 = _mm_set1_ps(z2 * invArea);
+
+    for (int32_t y = minY; y <= maxY; y++)
+    {
+        float py = static_cast<float>(y) + 0.5f;
+        __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), pixelOffset);
+
+        __m128 e01 = _mm_sub_ps(_mm_set1_ps((x1 - x0) * (py - y0)), _mm_mul_ps(_mm_set1_ps(y1 - y0), _mm_sub_ps(px, _mm_set1_ps(x0))));
+        __m128 e12 = _mm_sub_ps(_mm_set1_ps((x2 - x1) * (py - y1)), _mm_mul_ps(_mm_set1_ps(y2 - y1), _mm_sub_ps(px, _mm_set1_ps(x1))));
+        __m128 e20 = _mm_sub_ps(_mm_set1_ps((x0 - x2) * (py - y2)), _mm_mul_ps(_mm_set1_ps(y0 - y2), _mm_sub_ps(px, _mm_set1_ps(x2))));
+
+        float* row = &mDepth[y * mWidth];
+        for (int32_t x = minX; x <= maxX; x += 4)
+        {
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e01, zero), _mm_cmpge_ps(e12, zero)), _mm_cmpge_ps(e20, zero));
+            if (_mm_movemask_ps(inside) != 0)
+            {
+                // Barycentric interpolation, each vertex is weighted by the opposite edge.
+                __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e12, weight0), _mm_mul_ps(e20, weight1)), _mm_mul_ps(e01, weight2));
+                __m128 depth = _mm_loadu_ps(row + x);
+                __m128 closer = _mm_and_ps(inside, _mm_cmplt_ps(z, depth));
+                depth = _mm_or_ps(_mm_and_ps(closer, z), _mm_andnot_ps(closer, depth));
+                _mm_storeu_ps(row + x, depth);
+            }
+            e01 = _mm_add_ps(e01, stepX01);
+            e12 = _mm_add_ps(e12, stepX12);
+            e20 = _mm_add_ps(e20, stepX20);
+        }
+    }
+}
+
+void SlvnOcclusionCuller::updateHiZ(uint32_t band)
+{
+    uint32_t firstTileY = band * mBandHeight / cTileSize;
+    uint32_t lastTileY = std::min(mTilesY, firstTileY + mBandHeight / cTileSize);
+
+    for (uint32_t ty = firstTileY; ty < lastTileY; ty++)
+    {
+        for (uint32_t tx = 0; tx < mTilesX; tx++)
+        {
+            __m128 tileMax = _mm_setzero_ps();
+            for (uint32_t y = ty * cTileSize; y < (ty + 1) * cTileSize; y++)
+            {
+                const float* row = &mDepth[y * mWidth + tx * cTileSize];
+                tileMax = _mm_max_ps(tileMax, _mm_max_ps(_mm_loadu_ps(row), _mm_loadu_ps(row + 4)));
+            }
+            tileMax = _mm_max_ps(tileMax, _mm_shuffle_ps(tileMax, tileMax, _MM_SHUFFLE(1, 0, 3, 2)));
+            tileMax = _mm_max_ps(tileMax, _mm_shuffle_ps(tileMax, tileMax, _MM_SHUFFLE(2, 3, 0, 1)));
+            mTileMaxDepth[ty * mTilesX + tx] = _mm_cvtss_f32(tileMax);
+        }
+    }
+}
+
+bool SlvnOcclusionCuller::IsVisible(const SlvnAabb& worldBounds)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    mTestedCount++;
+
+    float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+    float maxX = -FLT_MAX, maxY = -FLT_MAX;
+    bool visible = false;
+
+    // One full transform, the other corners are reached by adding scaled matrix columns.
+    glm::vec3 size = worldBounds.mMax - worldBounds.mMin;
+    glm::vec4 base = mViewProjection * glm::vec4(worldBounds.mMin, 1.0f);
+    glm::vec4 axisX = mViewProjection[0] * size.x;
+    glm::vec4 axisY = mViewProjection[1] * size.y;
+    glm::vec4 axisZ = mViewProjection[2] * size.z;
+    for (uint32_t corner = 0; corner < 8 && !visible; corner++)
+    {
+        glm::vec4 clip = base;
+        if (corner & 1)
+            clip += axisX;
+        if (corner & 2)
+            clip += axisY;
+        if (corner & 4)
+            clip += axisZ;
+        // Boxes reaching behind the near plane are never culled.
+        if (clip.w < cMinW)
+        {
+            visible = true;
+            break;
+        }
+        float invW = 1.0f / clip.w;
+        float x = (clip.x * invW + 1.0f) * 0.5f * static_cast<float>(mWidth);
+        float y = (clip.y * invW + 1.0f) * 0.5f * static_cast<float>(mHeight);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minZ = std::min(minZ, clip.z * invW);
+    }
+
+    // Boxes outside the buffer are left for the frustum test to decide.
+    if (!visible && (minZ <= 0.0f || maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(mWidth) || minY >= static_cast<float>(mHeight)))
+        visible = true;
+
+    if (!visible)
+    {
+        // Every pixel the box touches, not only the ones whose centers it covers.
+        int32_t pixelMinX = std::max(0, static_cast<int32_t>(std::floor(minX)));
+        int32_t pixelMaxX = std::min(static_cast<int32_t>(mWidth) - 1, static_cast<int32_t>(std::floor(maxX)));
+        int32_t pixelMinY = std::max(0, static_cast<int32_t>(std::floor(minY)));
+        int32_t pixelMaxY = std::min(static_cast<int32_t>(mHeight) - 1, static_cast<int32_t>(std::floor(maxY)));
+
+        for (int32_t ty = pixelMinY / cTileSize; ty <= pixelMaxY / static_cast<int32_t>(cTileSize) && !visible; ty++)
+        {
+            for (int32_t tx = pixelMinX / cTileSize; tx <= pixelMaxX / static_cast<int32_t>(cTileSize) && !visible; tx++)
+            {
+                // The whole tile is in front of the box.
+                if (mTileMaxDepth[ty * mTilesX + tx] < minZ)
+                    continue;
+
+                int32_t startX = std::max(pixelMinX, tx * static_cast<int32_t>(cTileSize));
+                int32_t endX = std::min(pixelMaxX, (tx + 1) * static_cast<int32_t>(cTileSize) - 1);
+                int32_t startY = std::max(pixelMinY, ty * static_cast<int32_t>(cTileSize));
+                int32_t endY = std::min(pixelMaxY, (ty + 1) * static_cast<int32_t>(cTileSize) - 1);
+                for (int32_t y = startY; y <= endY && !visible; y++)
+                {
+                    for (int32_t x = startX; x <= endX; x++)
+                    {
+                        if (mDepth[y * mWidth + x] >= minZ)
+                        {
+                            visible = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (!visible)
+        mCulledCount++;
+
+    auto end = std::chrono::high_resolution_clock::now();
+    mTestNs += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    return visible;
+}
+
+SlvnOcclusionStats SlvnOcclusionCuller::GetStats() const
+{
+    SlvnOcclusionStats stats = {};
+    stats.mOccluderCount = static_cast<uint32_t>(mOccluders.size());
+    stats.mOccluderTriangles = mOccluderTriangles;
+    for (auto& triangles : mThreadTriangles)
+    {
+        stats.mRasterizedTriangles += static_cast<uint32_t>(triangles.size());
+    }
+    stats.mTestedCount = mTestedCount;
+    stats.mCulledCount = mCulledCount;
+    stats.mRasterizeMs = mRasterizeMs;
+    stats.mTestMs = static_cast<float>(mTestNs.load()) / 1000000.0f;
+    return stats;
+}
+
+} // slvn_tech
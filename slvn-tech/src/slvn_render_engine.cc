@@ -26,6 +26,7 @@
 
 #include <assert.h>
 #include <vector>
+#include <algorithm>
 #include <random>
 
 #include <slvn_render_engine.h>
@@ -38,13 +39,16 @@
 #define MAX_FRAMES_ONGOING 3
 #define M_PI       3.14159265358979323846
 
+static constexpr const char* cMeshPath = "slvn-tech/resources/monkey_high.obj";
+
 namespace slvn_tech
 {
 
 SlvnRenderEngine::SlvnRenderEngine(int identif) : mInstance(),
 mDeviceManager(), mCmdManager(), mDisplay(), mIdentifier(0), mPipeline(), mFramebuffer(), mActiveFramebuffer(0), mCamera(),
 mMatrices(), mObjectsPerThread(1), mQueue(), mSemaphores(), mState(SlvnState::cNotInitialized),
-mSubmitInfo(), mVertexBuffer(), mInputManager(), mRenderFence(VK_NULL_HANDLE)
+mSubmitInfo(), mFrameNumber(0), mMeshAsset(SlvnAssetPipeline::cInvalidHandle), mMesh(SlvnGeometryPool::cInvalidMesh),
+mStreamedMesh(SlvnMeshStreamer::cInvalidMesh), mFallbackMesh(SlvnGeometryPool::cInvalidMesh), mDrawMesh(SlvnGeometryPool::cInvalidMesh), mVertexPulling(false), mInputManager(), mRenderFence(VK_NULL_HANDLE)
 {
     SLVN_PRINT("Constructing SlvnRenderEngine object");
 
@@ -69,6 +73,74 @@ SlvnResult SlvnRenderEngine::Initialize()
     result = mCmdManager.Initialize(mInstance.mVkInstance);
     SLVN_ASSERT_RESULT(result);
 
+    mVertexPulling = SlvnSettings::GetInstance().mVertexPulling && mDeviceManager.GetPrimaryDevice()->mBufferDeviceAddress;
+    if (SlvnSettings::GetInstance().mVertexPulling && !mVertexPulling)
+        SLVN_PRINT("bufferDeviceAddress not supported, using fixed function vertex fetch");
+
+    result = mMemoryAllocator.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
+        mDeviceManager.GetPrimaryDevice()->mPhysicalDevice,
+        SlvnMemoryAllocator::cDefaultBlockSize,
+        mVertexPulling);
+    SLVN_ASSERT_RESULT(result);
+    result = mMemoryReporter.Initialize(&mMemoryAllocator, SlvnSettings::GetInstance().mMemoryReportPath);
+    SLVN_ASSERT_RESULT(result);
+
+    VkQueue transferQueue;
+    result = mDeviceManager.GetPrimaryDevice()->GetTransferQueue(transferQueue);
+    SLVN_ASSERT_RESULT(result);
+    result = mUploadManager.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
+        &mMemoryAllocator,
+        transferQueue,
+        mDeviceManager.GetPrimaryDevice()->GetTransferQueueFamilyIndex(),
+        mDeviceManager.GetPrimaryDevice()->GetViableQueueFamilyIndex());
+    SLVN_ASSERT_RESULT(result);
+
+    result = mDeletionQueue.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, &mMemoryAllocator);
+    SLVN_ASSERT_RESULT(result);
+
+    result = mGeometryPool.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
+        &mMemoryAllocator,
+        &mUploadManager,
+        sizeof(SlvnVertex),
+        SlvnSettings::GetInstance().mGeometryPoolVertexCount,
+        SlvnSettings::GetInstance().mGeometryPoolIndexCount,
+        SlvnSettings::GetInstance().mDeviceLocalGeometry,
+        mVertexPulling,
+        SlvnSettings::GetInstance().mShortIndices);
+    SLVN_ASSERT_RESULT(result);
+
+    result = mDefragmenter.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, &mMemoryAllocator, &mDeletionQueue);
+    SLVN_ASSERT_RESULT(result);
+    mDefragmenter.mTimeBudgetMs = SlvnSettings::GetInstance().mDefragmentationBudgetMs;
+    mDefragmenter.mMaxBytesPerFrame = SlvnSettings::GetInstance().mDefragmentationMaxBytes;
+    mGeometryPool.Register(&mDefragmenter);
+
+    result = mMeshStreamer.Initialize(&mGeometryPool,
+        &mUploadManager,
+        &mDeletionQueue,
+        SlvnSettings::GetInstance().mStreamingBudget,
+        SlvnSettings::GetInstance().mStreamingMaxLoads);
+    SLVN_ASSERT_RESULT(result);
+
+    result = mAssetPipeline.Initialize(&mGeometryPool,
+        &mUploadManager,
+        &mDeletionQueue,
+        getVertexFormat(),
+        SlvnSettings::GetInstance().mAssetDecodeThreads,
+        SlvnSettings::GetInstance().mAssetUploadBudget);
+    SLVN_ASSERT_RESULT(result);
+    result = mAssetManager.Initialize(&mAssetPipeline, &mGeometryPool, SlvnSettings::GetInstance().mAssetCacheBudget);
+    SLVN_ASSERT_RESULT(result);
+
+    result = mFrameRing.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
+        mDeviceManager.GetPrimaryDevice()->mPhysicalDevice,
+        &mMemoryAllocator,
+        MAX_FRAMES_ONGOING,
+        SlvnSettings::GetInstance().mFrameRingSize,
+        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+        VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+    SLVN_ASSERT_RESULT(result);
+
     result = mDisplay.Initialize(mInstance.mVkInstance,
         mDeviceManager.GetPrimaryDevice()->mPhysicalDevice,
         mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
@@ -87,7 +159,8 @@ SlvnResult SlvnRenderEngine::Initialize()
     SLVN_ASSERT_RESULT(result);
 
     result = mPipeline.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
-        mRenderpass.mRenderpass);
+        mRenderpass.mRenderpass,
+        mVertexPulling ? SlvnVertexFetch::cPulling : SlvnVertexFetch::cFixedFunction);
 
     mFlags = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
 
@@ -95,6 +168,10 @@ SlvnResult SlvnRenderEngine::Initialize()
 
     result = initializeThreading();
     SLVN_ASSERT_RESULT(result);
+    result = mOcclusionCuller.Initialize(SlvnSettings::GetInstance().mOcclusionBufferWidth,
+        SlvnSettings::GetInstance().mOcclusionBufferHeight,
+        &mThreadpool);
+    SLVN_ASSERT_RESULT(result);
     result = initializeInput();
     SLVN_ASSERT_RESULT(result);
     result = initializeSemaphores();
@@ -105,7 +182,8 @@ SlvnResult SlvnRenderEngine::Initialize()
     mState = SlvnState::cInitialized;
 
     createCommandWorkers();
-    prepareBuffers();
+    requestAssets();
+    initializeScene();
     render();
 
     return SlvnResult::cOk;
@@ -116,9 +194,10 @@ SlvnResult SlvnRenderEngine::initializeThreading()
     SLVN_PRINT("ENTER");
 
     SlvnSettings& settings = SlvnSettings::GetInstance();
-    mObjectsPerThread = settings.mMaxThreads / settings.mMaxThreads;
+    mObjectsPerThread = std::max(1u, settings.mSceneObjectCount / settings.mMaxThreads);
     mThreadpool.SetThreadCount(settings.mMaxThreads);
     mSecondaryCmdWorkers.resize(settings.mMaxThreads);
+    mEncoders.resize(settings.mMaxThreads);
 
     SLVN_PRINT("EXIT");
     return SlvnResult::cOk;
@@ -210,7 +289,7 @@ void SlvnRenderEngine::createCommandWorkers()
         cmdPool->Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, cmdPoolFlags, mDeviceManager.GetPrimaryDevice()->GetViableQueueFamilyIndex());
 
         worker->Initialize(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice, cmdPoolFlags, mDeviceManager.GetPrimaryDevice()->GetViableQueueFamilyIndex(),
-            SlvnCmdBufferType::cSecondary, mObjectsPerThread, cmdPool);
+            SlvnCmdBufferType::cSecondary, 1, cmdPool);
 
         worker->mThreadData.mPushConstants.resize(mObjectsPerThread);
         worker->mThreadData.mObjData.resize(mObjectsPerThread);
@@ -233,104 +312,501 @@ void SlvnRenderEngine::createCommandWorkers()
     SLVN_PRINT("EXIT");
 }
 
-void SlvnRenderEngine::threadRender(uint32_t threadIndex, uint32_t cmdBufferIndex, uint32_t vertexesSize, VkCommandBufferInheritanceInfo inheritanceInfo)
+void SlvnRenderEngine::threadRender(uint32_t threadIndex, uint32_t firstPacket, uint32_t packetCount, VkCommandBufferInheritanceInfo inheritanceInfo)
 {
     SlvnCommandWorker* worker = &mSecondaryCmdWorkers[threadIndex];
-    SlvnThreadData* thread = &worker->mThreadData;
-    ObjectData* object = &worker->mThreadData.mObjData[cmdBufferIndex];
 
     VkCommandBufferBeginInfo cmdBufferBeginInfo = { };
     cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
     cmdBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
 
-    worker->BeginBuffer(SlvnCmdBufferType::cSecondary, &inheritanceInfo, cmdBufferIndex);
-    VkCommandBuffer cmdBuffer = worker->mCmdBuffers[cmdBufferIndex];
+    worker->BeginBuffer(SlvnCmdBufferType::cSecondary, &inheritanceInfo, 0);
+    VkCommandBuffer cmdBuffer = worker->mCmdBuffers[0];
+    SlvnCommandEncoder& encoder = mEncoders[threadIndex];
+    encoder.Begin(cmdBuffer);
 
     VkViewport viewport = {};
     viewport.height = static_cast<float>(mDisplay.GetExtent().height);
     viewport.width = static_cast<float>(mDisplay.GetExtent().width);
     viewport.maxDepth = 1.0f;
     viewport.minDepth = 0.0f;
-    vkCmdSetViewport(cmdBuffer, 0, 1, &viewport);
+    encoder.SetViewport(viewport);
 
     VkRect2D scissor = {};
     scissor.extent = mDisplay.GetExtent();
     scissor.offset = { 0, 0 };
-    vkCmdSetScissor(cmdBuffer, 0, 1, &scissor);
+    encoder.SetScissor(scissor);
 
-    mPipeline.BindPipeline(cmdBuffer);
+    // Every mesh lives in the pool buffers, so they are bound once per command buffer.
+    SlvnMeshRange mesh = mGeometryPool.GetMesh(mDrawMesh);
+    mGeometryPool.Bind(encoder, !mVertexPulling, mesh.mIndexType);
 
-    object->rotation.y += 2.5f * object->rotSpeed * mInputManager.CalculateDelta();
-    if (object->rotation.y > 360.0f)
+    for (uint32_t p = firstPacket; p < firstPacket + packetCount; p++)
     {
-        object->rotation.y -= 360.0f;
+        const SlvnDrawPacket& packet = mDrawPackets[p];
+        SlvnThreadData* thread = &mSecondaryCmdWorkers[packet.mWorker].mThreadData;
+        ObjectData* object = &thread->mObjData[packet.mObject];
+
+        encoder.BindPipeline(mPipeline.GetPipeline());
+
+        thread->mPushConstants[packet.mObject].mvp = mMatrices.projection * mMatrices.view * object->model;
+
+        if (mVertexPulling)
+        {
+            // The shader indexes from the first vertex of the mesh, in whatever format it was stored.
+            SlvnPullPushConstant pushConstant = {};
+            pushConstant.mvp = thread->mPushConstants[packet.mObject].mvp;
+            pushConstant.color = thread->mPushConstants[packet.mObject].color;
+            pushConstant.positionOffset = glm::vec4(mesh.mQuantization.mOffset, 0.0f);
+            pushConstant.positionScale = glm::vec4(mesh.mQuantization.mScale, 0.0f);
+            pushConstant.vertexFormat = static_cast<uint32_t>(mesh.mVertexFormat);
+            pushConstant.vertexAddress = mGeometryPool.GetVertexAddress() + mesh.mVertexByteOffset;
+            encoder.PushConstants(mPipeline.GetLayout(),
+                VK_SHADER_STAGE_VERTEX_BIT,
+                0,
+                sizeof(SlvnPullPushConstant),
+                &pushConstant);
+        }
+        else
+        {
+            encoder.PushConstants(mPipeline.GetLayout(),
+                VK_SHADER_STAGE_VERTEX_BIT,
+                0,
+                sizeof(SlvnThreadPushConstant),
+                &thread->mPushConstants[packet.mObject]);
+        }
+
+        int32_t vertexOffset = mVertexPulling ? 0 : packet.mVertexOffset;
+        if (packet.mRangeCount == 0)
+        {
+            encoder.DrawIndexed(packet.mIndexCount, packet.mFirstIndex, vertexOffset);
+            continue;
+        }
+        // Only the meshlets that survived culling, ranges are relative to the mesh.
+        for (uint32_t r = packet.mFirstRange; r < packet.mFirstRange + packet.mRangeCount; r++)
+        {
+            encoder.DrawIndexed(mDrawRanges[r].mIndexCount, mesh.mFirstIndex + mDrawRanges[r].mFirstIndex, vertexOffset);
+        }
     }
-    object->deltaT += 0.15f * mInputManager.CalculateDelta();
-    if (object->deltaT > 1.0f)
-        object->deltaT -= 1.0f;
 
+    VkResult res = vkEndCommandBuffer(cmdBuffer);
+    assert(res == VK_SUCCESS);
+}
+
+void SlvnRenderEngine::updateObjects(uint32_t threadIndex)
+{
     std::random_device rd;
     std::mt19937 mt(rd());
     std::uniform_int_distribution<int> dist(-2, 2);
 
-    object->pos.y += dist(mt);
-    object->pos.x += dist(mt);
-    object->pos.z += dist(mt);
+    for (auto& object : mSecondaryCmdWorkers[threadIndex].mThreadData.mObjData)
+    {
+        glm::mat4 previousModel = object.model;
+        object.rotation.y += 2.5f * object.rotSpeed * mInputManager.CalculateDelta();
+        if (object.rotation.y > 360.0f)
+        {
+            object.rotation.y -= 360.0f;
+        }
+        object.deltaT += 0.15f * mInputManager.CalculateDelta();
+        if (object.deltaT > 1.0f)
+            object.deltaT -= 1.0f;
+
+        object.pos.y += dist(mt);
+        object.pos.x += dist(mt);
+        object.pos.z += dist(mt);
+
+        object.model = glm::translate(glm::mat4(1.0f), object.pos);
+        //object.model = glm::rotate(object.model, -sinf(glm::radians(object.deltaT * 360.0f)) * 0.25f, glm::vec3(object.rotDir, 0.0f, 0.0f));
+        //object.model = glm::rotate(object.model, glm::radians(object.rotation.y), glm::vec3(0.0f, object.rotDir, 0.0f));
+        //object.model = glm::rotate(object.model, glm::radians(object.deltaT * 360.0f), glm::vec3(0.0f, object.rotDir, 0.0f));
+        object.model = glm::scale(object.model, glm::vec3(object.scale));
+        // Only objects that actually moved are uploaded to the scene buffer.
+        if (object.model != previousModel)
+            mSceneBuffer.Update(object.proxy, { object.model, mSceneBuffer.Get(object.proxy).mColor });
+
+        // Distinct proxies per object, so threads can update the hierarchy concurrently.
+        mSceneBvh.Update(object.proxy, SlvnTransformAabb(mMeshBounds, object.model));
+        object.visible = false;
+    }
+}
 
-    object->model = glm::translate(glm::mat4(1.0f), object->pos);
-    //object->model = glm::rotate(object->model, -sinf(glm::radians(object->deltaT * 360.0f)) * 0.25f, glm::vec3(object->rotDir, 0.0f, 0.0f));
-    //object->model = glm::rotate(object->model, glm::radians(object->rotation.y), glm::vec3(0.0f, object->rotDir, 0.0f));
-    //object->model = glm::rotate(object->model, glm::radians(object->deltaT * 360.0f), glm::vec3(0.0f, object->rotDir, 0.0f));
-    object->model = glm::scale(object->model, glm::vec3(object->scale));
+void SlvnRenderEngine::cullObjects()
+{
+    mSceneBvh.Refit();
+    mSceneBvh.PollRebuild();
+    if (mSceneBvh.NeedsRebuild())
+        mSceneBvh.RequestRebuild();
+
+    SlvnFrustum frustum = SlvnFrustum::FromMatrix(mMatrices.projection * mMatrices.view);
+    mVisibleProxies.clear();
+    mSceneBvh.QueryFrustum(frustum, mVisibleProxies);
+    for (uint32_t proxy : mVisibleProxies)
+    {
+        mProxyObjects[proxy]->visible = true;
+    }
 
-    thread->mPushConstants[cmdBufferIndex].mvp = mMatrices.projection * mMatrices.view * object->model;
+    if (SlvnSettings::GetInstance().mOcclusionCulling && !mVisibleProxies.empty())
+        occludeObjects();
 
-    vkCmdPushConstants(cmdBuffer,
-        mPipeline.GetLayout(),
-        VK_SHADER_STAGE_VERTEX_BIT,
-        0,
-        sizeof(SlvnThreadPushConstant),
-        &thread->mPushConstants[cmdBufferIndex]);
+    selectLods();
+}
 
-    VkBuffer vertexBuffers[] = { mVertexBuffer.GetBuffer() };
-    VkDeviceSize offsets[] = { 0 };
+void SlvnRenderEngine::occludeObjects()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
 
-    vkCmdBindVertexBuffers(cmdBuffer, 0, 1, vertexBuffers, offsets);
-    vkCmdBindIndexBuffer(cmdBuffer, mIndiceBuffer.GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(cmdBuffer, vertexesSize, 1, 0, 0, 0);
+    // Nearest visible objects are the most likely to hide something.
+    glm::vec3 cameraPos = mCamera.GetPos();
+    auto distance = [&](uint32_t proxy)
+    {
+        glm::vec3 d = mSceneBvh.GetBounds(proxy).GetCenter() - cameraPos;
+        return glm::dot(d, d);
+    };
+    uint32_t occluderCount = std::min(settings.mOccluderCount, static_cast<uint32_t>(mVisibleProxies.size()));
+    mOccluderProxies.resize(occluderCount);
+    std::partial_sort_copy(mVisibleProxies.begin(), mVisibleProxies.end(), mOccluderProxies.begin(), mOccluderProxies.end(),
+        [&](uint32_t a, uint32_t b) { return distance(a) < distance(b); });
+
+    mOcclusionCuller.BeginFrame(mMatrices.projection * mMatrices.view);
+    for (uint32_t proxy : mOccluderProxies)
+    {
+        // Only the full mesh is guaranteed to stay inside the real silhouette; a simplified level can
+        // cover pixels the object does not and cull what is actually visible behind them.
+        const SlvnLodLevel& level = mMeshLods.mLevels.front();
+        mOcclusionCuller.AddOccluder(mMeshPositions, mMeshIndices, level.mFirstIndex, level.mIndexCount, mProxyObjects[proxy]->model);
+    }
+    mOcclusionCuller.Rasterize();
 
-    VkResult res = vkEndCommandBuffer(cmdBuffer);
-    assert(res == VK_SUCCESS);
+    uint32_t threadCount = static_cast<uint32_t>(mThreadpool.mThreads.size());
+    uint32_t visibleCount = static_cast<uint32_t>(mVisibleProxies.size());
+    uint32_t chunk = (visibleCount + threadCount - 1) / threadCount;
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        mThreadpool.mThreads[t]->addJob([=]
+            {
+                for (uint32_t i = t * chunk; i < std::min(visibleCount, (t + 1) * chunk); i++)
+                {
+                    uint32_t proxy = mVisibleProxies[i];
+                    if (!mOcclusionCuller.IsVisible(mSceneBvh.GetBounds(proxy)))
+                        mProxyObjects[proxy]->visible = false;
+                }
+            });
+    }
+    mThreadpool.Wait();
+
+    SlvnOcclusionStats stats = mOcclusionCuller.GetStats();
+    if (isStatsFrame())
+        SLVN_PRINT("Occlusion culled " << stats.mCulledCount << "/" << stats.mTestedCount << " objects, raster " << stats.mRasterizeMs << "ms, test " << stats.mTestMs << "ms");
+}
+
+void SlvnRenderEngine::selectLods()
+{
+    mLodSelector.SetProjection(mCamera.GetFov(), static_cast<float>(mDisplay.GetExtent().height));
+
+    glm::vec3 cameraPos = mCamera.GetPos();
+    bool streaming = SlvnSettings::GetInstance().mMeshStreaming;
+    uint32_t threadCount = static_cast<uint32_t>(mThreadpool.mThreads.size());
+    uint32_t visibleCount = static_cast<uint32_t>(mVisibleProxies.size());
+    uint32_t chunk = (visibleCount + threadCount - 1) / threadCount;
+    std::vector<uint32_t> threadTriangles(threadCount, 0);
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        mThreadpool.mThreads[t]->addJob([=, &threadTriangles]
+            {
+                for (uint32_t i = t * chunk; i < std::min(visibleCount, (t + 1) * chunk); i++)
+                {
+                    ObjectData* object = mProxyObjects[mVisibleProxies[i]];
+                    if (!object->visible)
+                        continue;
+
+                    // Distance to the nearest point of the bounding sphere.
+                    const SlvnAabb& bounds = mSceneBvh.GetBounds(mVisibleProxies[i]);
+                    float distance = glm::length(bounds.GetCenter() - cameraPos) - glm::length(bounds.GetExtent());
+                    object->lod = mLodSelector.SelectLevel(mMeshLods, distance, object->scale, object->lod);
+                    if (streaming)
+                        mMeshStreamer.Request(mStreamedMesh, distance);
+                    threadTriangles[t] += mMeshLods.mLevels[object->lod].mIndexCount / 3;
+                }
+            });
+    }
+    mThreadpool.Wait();
+
+    uint32_t triangles = 0;
+    for (uint32_t count : threadTriangles)
+    {
+        triangles += count;
+    }
+    if (isStatsFrame())
+        SLVN_PRINT("Drawing " << triangles << " triangles");
 }
 
-SlvnResult SlvnRenderEngine::loadObjects(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+void SlvnRenderEngine::buildDrawPackets()
+{
+    glm::vec3 cameraPos = mCamera.GetPos();
+    float farPlane = mCamera.GetFar();
+    uint32_t threadCount = static_cast<uint32_t>(mThreadpool.mThreads.size());
+    uint32_t visibleCount = static_cast<uint32_t>(mVisibleProxies.size());
+    uint32_t chunk = (visibleCount + threadCount - 1) / threadCount;
+    // Until the streamed mesh is resident every object draws the single level of the fallback.
+    bool fallback = false;
+    mDrawMesh = mMesh;
+    if (SlvnSettings::GetInstance().mMeshStreaming)
+    {
+        mDrawMesh = mMeshStreamer.Resolve(mStreamedMesh);
+        fallback = !mMeshStreamer.IsResident(mStreamedMesh);
+    }
+    SlvnMeshRange mesh = mGeometryPool.GetMesh(mDrawMesh);
+    uint32_t fallbackLod = static_cast<uint32_t>(mMeshLods.mLevels.size() - 1);
+    bool meshletCulling = SlvnSettings::GetInstance().mMeshletCulling;
+    glm::mat4 viewProjection = mMatrices.projection * mMatrices.view;
+
+    mDrawPackets.resize(visibleCount);
+    mThreadRanges.resize(threadCount);
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        mThreadpool.mThreads[t]->addJob([=]
+            {
+                std::vector<SlvnIndexRange>& ranges = mThreadRanges[t];
+                ranges.clear();
+                for (uint32_t i = t * chunk; i < std::min(visibleCount, (t + 1) * chunk); i++)
+                {
+                    uint32_t proxy = mVisibleProxies[i];
+                    ObjectData* object = mProxyObjects[proxy];
+                    SlvnDrawPacket& packet = mDrawPackets[i];
+
+                    // Occluded objects sort past every valid key and are trimmed afterwards.
+                    if (!object->visible)
+                    {
+                        packet.mKey = UINT64_MAX;
+                        continue;
+                    }
+
+                    float depth = glm::length(mSceneBvh.GetBounds(proxy).GetCenter() - cameraPos) / farPlane;
+                    uint32_t worker = mProxyWorkers[proxy];
+                    packet.mKey = SlvnDrawKey::Opaque(0, 0, fallback ? fallbackLod : object->lod, depth);
+                    packet.mWorker = worker;
+                    packet.mObject = static_cast<uint32_t>(object - mSecondaryCmdWorkers[worker].mThreadData.mObjData.data());
+                    packet.mFirstIndex = mesh.mFirstIndex;
+                    packet.mIndexCount = mesh.mIndexCount;
+                    packet.mVertexOffset = mesh.mVertexOffset;
+                    packet.mFirstRange = 0;
+                    packet.mRangeCount = 0;
+                    if (fallback)
+                        continue;
+
+                    const SlvnLodLevel& level = mMeshLods.mLevels[object->lod];
+                    packet.mFirstIndex += level.mFirstIndex;
+                    packet.mIndexCount = level.mIndexCount;
+                    if (meshletCulling && level.mMeshletCount > 0)
+                    {
+                        // An object with every meshlet culled is dropped like an occluded one.
+                        packet.mFirstRange = static_cast<uint32_t>(ranges.size());
+                        packet.mRangeCount = mMeshletCuller.Cull(level.mFirstMeshlet, level.mMeshletCount, object->model, viewProjection, cameraPos, ranges);
+                        if (packet.mRangeCount == 0)
+                            packet.mKey = UINT64_MAX;
+                    }
+                }
+            });
+    }
+    mThreadpool.Wait();
+
+    // Ranges of all threads go into one list before sorting moves the packets around.
+    mDrawRanges.clear();
+    for (uint32_t t = 0; t < threadCount; t++)
+    {
+        uint32_t rangeBase = static_cast<uint32_t>(mDrawRanges.size());
+        for (uint32_t i = t * chunk; i < std::min(visibleCount, (t + 1) * chunk); i++)
+        {
+            mDrawPackets[i].mFirstRange += rangeBase;
+        }
+        mDrawRanges.insert(mDrawRanges.end(), mThreadRanges[t].begin(), mThreadRanges[t].end());
+    }
+    if (meshletCulling)
+    {
+        SlvnMeshletCullStats meshletStats = mMeshletCuller.GetStats();
+        if (isStatsFrame())
+            SLVN_PRINT("Meshlets culled " << meshletStats.mFrustumCulledCount + meshletStats.mBackfaceCulledCount << "/" << meshletStats.mTestedCount
+                << ", frustum " << meshletStats.mFrustumCulledCount << ", backface " << meshletStats.mBackfaceCulledCount << ", draw ranges "
+                << mDrawRanges.size() << ", cull " << meshletStats.mCullMs << "ms");
+        mMeshletCuller.ResetStats();
+    }
+
+    mDrawSorter.Sort(mDrawPackets, &mThreadpool);
+    while (!mDrawPackets.empty() && mDrawPackets.back().mKey == UINT64_MAX)
+    {
+        mDrawPackets.pop_back();
+    }
+
+    if (isStatsFrame())
+    {
+        SlvnDrawStats stats = mDrawSorter.CountStateChanges(mDrawPackets);
+        SLVN_PRINT("Draws " << stats.mPacketCount << ", pipeline changes " << stats.mPipelineChanges << ", material changes " << stats.mMaterialChanges
+            << ", mesh changes " << stats.mMeshChanges << ", sort " << stats.mSortMs << "ms");
+    }
+}
+
+SlvnResult SlvnRenderEngine::loadObjects(const std::string& path, std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices, SlvnLodMesh& lods,
+    std::vector<SlvnMeshlet>* meshlets, SlvnThreadpool* threadpool)
 {
     SlvnLoader loader;
-    return loader.Load("slvn-tech/resources/monkey_high.obj", vertices, indices);
+    return loader.Load(path, vertices, indices, threadpool, &lods, meshlets);
+}
+
+SlvnResult SlvnRenderEngine::requestAssets()
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+    mLodSelector.mPixelThreshold = settings.mLodPixelError;
+    mLodSelector.mHysteresis = settings.mLodHysteresis;
+
+    // Objects are points until their mesh has arrived.
+    mMeshBounds = SlvnAabb();
+    mMeshBounds.Grow(glm::vec3(0.0f));
+
+    // The detail levels are cooked by the loader and come with the mesh. With streaming on only the
+    // fallback is uploaded, the full mesh is loaded by the streamer once it is requested.
+    SlvnAssetDecodeHook hook = nullptr;
+    if (settings.mMeshStreaming)
+        hook = [this](SlvnMeshAsset& asset) { return buildFallbackMesh(asset); };
+    mMeshAsset = mAssetManager.Acquire(cMeshPath,
+        [this](SlvnAssetHandle handle, SlvnResult result, const SlvnMeshAsset& asset) { onMeshLoaded(handle, result, asset); },
+        hook);
+
+    return SlvnResult::cOk;
+}
+
+// Runs on the render thread from SlvnAssetPipeline::BeginFrame(), or SlvnAssetManager::BeginFrame() when the mesh was cached.
+void SlvnRenderEngine::onMeshLoaded(SlvnAssetHandle handle, SlvnResult result, const SlvnMeshAsset& asset)
+{
+    if (result != SlvnResult::cOk)
+        return;
+
+    mMeshLods = asset.mLods;
+    mMeshlets = asset.mMeshlets;
+    mMeshletCuller.SetMeshlets(mMeshlets);
+
+    mVerticesAmount = static_cast<uint32_t>(asset.mVertices.size());
+    mMeshBounds = asset.mBounds;
+    mMeshPositions.clear();
+    for (auto& vertex : asset.mVertices)
+    {
+        mMeshPositions.push_back(vertex.mPosition);
+    }
+    mMeshIndices = asset.mIndices;
+
+    if (SlvnSettings::GetInstance().mMeshStreaming)
+    {
+        mFallbackMesh = mAssetManager.GetMesh(handle);
+        mStreamedMesh = mMeshStreamer.AddMesh([this](SlvnStreamedMeshData& streamed) { return loadStreamedMesh(streamed); }, mFallbackMesh);
+    }
+    else
+    {
+        mMesh = mAssetManager.GetMesh(handle);
+    }
+
+    // The hierarchy was built over points, it is rebuilt once over the real bounds.
+    for (auto& worker : mSecondaryCmdWorkers)
+    {
+        for (auto& object : worker.mThreadData.mObjData)
+        {
+            mSceneBvh.Update(object.proxy, SlvnTransformAabb(mMeshBounds, object.model));
+        }
+    }
+    mSceneBvh.Rebuild();
+}
+
+// Runs on a decode thread; the fallback keeps only the vertices the coarsest level references.
+SlvnResult SlvnRenderEngine::buildFallbackMesh(SlvnMeshAsset& asset) const
+{
+    const SlvnLodLevel& coarsest = asset.mLods.mLevels.back();
+    std::vector<uint32_t> remap(asset.mVertices.size(), UINT32_MAX);
+    std::vector<SlvnVertex> fallbackVertices;
+    SlvnStreamedMeshData& upload = asset.mUpload;
+    upload.mIndices.clear();
+    for (uint32_t i = coarsest.mFirstIndex; i < coarsest.mFirstIndex + coarsest.mIndexCount; i++)
+    {
+        uint32_t vertex = asset.mIndices[i];
+        if (remap[vertex] == UINT32_MAX)
+        {
+            remap[vertex] = static_cast<uint32_t>(fallbackVertices.size());
+            fallbackVertices.push_back(asset.mVertices[vertex]);
+        }
+        upload.mIndices.push_back(remap[vertex]);
+    }
+    upload.mFormat = getVertexFormat();
+    upload.mVertexCount = static_cast<uint32_t>(fallbackVertices.size());
+    SlvnEncodeVertices(upload.mFormat, fallbackVertices, upload.mVertices, &upload.mQuantization);
+    return SlvnResult::cOk;
 }
 
-SlvnResult SlvnRenderEngine::prepareBuffers()
+// Runs on the streaming thread; the detail levels come out of the same cache as the ones of the asset pipeline.
+SlvnResult SlvnRenderEngine::loadStreamedMesh(SlvnStreamedMeshData& data)
 {
     std::vector<SlvnVertex> vertices;
     std::vector<uint32_t> indices;
+    SlvnLodMesh lods;
+    // The threadpool belongs to the frame jobs here, parse on this thread.
+    SlvnResult result = loadObjects(cMeshPath, vertices, indices, lods, nullptr, nullptr);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    data.mFormat = getVertexFormat();
+    data.mVertexCount = static_cast<uint32_t>(vertices.size());
+    SlvnEncodeVertices(data.mFormat, vertices, data.mVertices, &data.mQuantization);
+    data.mIndices = std::move(indices);
+    return SlvnResult::cOk;
+}
 
-    SlvnResult result = loadObjects(vertices, indices);
-    SLVN_ASSERT_RESULT(result);
+SlvnVertexFormat SlvnRenderEngine::getVertexFormat() const
+{
+    SlvnSettings& settings = SlvnSettings::GetInstance();
+    if (!mVertexPulling)
+        return SlvnVertexFormat::cFloat;
+    if (settings.mQuantizedVertices)
+        return SlvnVertexFormat::cQuantized;
+    return settings.mCompactVertices ? SlvnVertexFormat::cCompact : SlvnVertexFormat::cFloat;
+}
 
-    mVerticesAmount = static_cast<uint32_t>(vertices.size());
+bool SlvnRenderEngine::isStatsFrame() const
+{
+    uint32_t interval = SlvnSettings::GetInstance().mStatsInterval;
+    return interval > 0 && mFrameNumber % interval == 0;
+}
 
-    uint32_t verticesSize = sizeof(SlvnVertex) * static_cast<uint32_t>(vertices.size());
-    uint32_t indicesSize = sizeof(uint32_t) * static_cast<uint32_t>(indices.size());
-    mVertexBuffer = SlvnBuffer(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice, verticesSize, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE);
-    mIndiceBuffer = SlvnBuffer(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice, indicesSize, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_SHARING_MODE_EXCLUSIVE);
+SlvnResult SlvnRenderEngine::initializeScene()
+{
+    SLVN_PRINT("ENTER");
+
+    uint32_t objectCount = 0;
+    for (auto& worker : mSecondaryCmdWorkers)
+    {
+        objectCount += static_cast<uint32_t>(worker.mThreadData.mObjData.size());
+    }
+    SlvnResult result = mSceneBuffer.Initialize(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, &mMemoryAllocator, &mFrameRing, objectCount);
+    SLVN_ASSERT_RESULT(result);
 
-    uint32_t vertexBufferSize = sizeof(SlvnVertex) * static_cast<uint32_t>(vertices.size());
-    mVertexBuffer.Insert(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice, &mDeviceManager.GetPrimaryDevice()->mPhysicalDevice, vertexBufferSize, vertices.data());
+    for (auto& worker : mSecondaryCmdWorkers)
+    {
+        for (auto& object : worker.mThreadData.mObjData)
+        {
+            object.model = glm::scale(glm::translate(glm::mat4(1.0f), object.pos), glm::vec3(object.scale));
+            object.proxy = mSceneBvh.Insert(SlvnTransformAabb(mMeshBounds, object.model));
+            if (object.proxy >= mProxyObjects.size())
+            {
+                mProxyObjects.resize(object.proxy + 1);
+                mProxyWorkers.resize(object.proxy + 1);
+            }
+            mProxyObjects[object.proxy] = &object;
+            mProxyWorkers[object.proxy] = static_cast<uint32_t>(&worker - mSecondaryCmdWorkers.data());
 
-    uint32_t indiceBufferSize = sizeof(uint32_t) * static_cast<uint32_t>(indices.size());
-    mIndiceBuffer.Insert(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice, &mDeviceManager.GetPrimaryDevice()->mPhysicalDevice, indiceBufferSize, indices.data());
+            // Proxies of the fresh hierarchy are dense, so they double as scene buffer records.
+            uint32_t index = static_cast<uint32_t>(&object - worker.mThreadData.mObjData.data());
+            mSceneBuffer.Update(object.proxy, { object.model, glm::vec4(worker.mThreadData.mPushConstants[index].color, 1.0f) });
+        }
+    }
+    mSceneBvh.Rebuild();
 
+    SLVN_PRINT("EXIT");
     return SlvnResult::cOk;
 }
 
@@ -361,6 +837,12 @@ void SlvnRenderEngine::render()
 
         vkResetFences(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, 1, &mRenderFence);
 
+        // The render fence covers every frame submitted so far.
+        mDeletionQueue.Collect(mFrameNumber);
+        mFrameRing.BeginFrame(currentFrame);
+        mMemoryAllocator.UpdateBudget();
+        mMemoryReporter.Report(mFrameNumber);
+
         // Prepare frame
         VkResult res = vkAcquireNextImageKHR(mDeviceManager.GetPrimaryDevice()->mLogicalDevice,
             mDisplay.mSwapchain,
@@ -378,6 +860,47 @@ void SlvnRenderEngine::render()
         SlvnResult result = mPrimaryCmdWorker.BeginBuffer(SlvnCmdBufferType::cPrimary, nullptr, 0);
         SLVN_ASSERT_RESULT(result);
 
+        // Finished uploads are acquired outside of the render pass.
+        mUploadManager.RecordAcquire(mPrimaryCmdWorker.mCmdBuffers.front());
+        mAssetPipeline.BeginFrame(mFrameNumber + 1);
+        mAssetManager.BeginFrame();
+        bool geometryReady = mAssetManager.IsReady(mMeshAsset);
+        mMeshStreamer.BeginFrame(mFrameNumber + 1);
+        if (isStatsFrame())
+        {
+            SlvnAssetStats assets = mAssetPipeline.GetStats();
+            SLVN_PRINT("Assets pending io " << assets.mIo.mDepth << ", decode " << assets.mDecode.mDepth << ", upload " << assets.mUpload.mDepth
+                << "; latency io " << assets.mIo.mAverageLatencyMs << "ms, decode " << assets.mDecode.mAverageLatencyMs << "ms, upload "
+                << assets.mUpload.mAverageLatencyMs << "ms, total " << assets.mAverageLatencyMs << "ms avg " << assets.mMaxLatencyMs << "ms max; uploaded "
+                << assets.mUploadedCount << ", " << assets.mUploadedBytes << " bytes");
+            SlvnAssetCacheStats cache = mAssetManager.GetStats();
+            SLVN_PRINT("Asset cache referenced " << cache.mReferencedCount << "/" << cache.mAssetCount << ", cached " << cache.mCachedCount << ", "
+                << cache.mCachedBytes << "/" << cache.mBudgetBytes << " bytes; requests " << cache.mRequestCount << ", hits " << cache.mHitCount
+                << ", joined " << cache.mJoinCount << ", misses " << cache.mMissCount << ", evictions " << cache.mEvictionCount);
+        }
+
+        // Follows every geometry pool write of the frame. The pool holds its buffers in place while any of
+        // its uploads, from the asset pipeline or the streamer, is in flight; draws below bind the patched handles.
+        if (SlvnSettings::GetInstance().mDefragmentation)
+        {
+            if (mDefragmenter.Step(mPrimaryCmdWorker.mCmdBuffers.front(), mFrameNumber + 1) > 0)
+                mGeometryPool.UpdateVertexAddress();
+            const SlvnDefragmentationStats& defragmentation = mDefragmenter.GetStats();
+            if (isStatsFrame())
+                SLVN_PRINT("Defragmentation moved " << defragmentation.mMoveCount << " buffers, " << defragmentation.mBytesMoved << " bytes in "
+                    << defragmentation.mStepMs << "ms, fragmentation " << defragmentation.mFragmentationBefore << " -> " << defragmentation.mFragmentationAfter
+                    << ", blocks " << defragmentation.mBlockCountBefore << " -> " << defragmentation.mBlockCountAfter << "; total "
+                    << defragmentation.mTotalBytesMoved << " bytes, " << defragmentation.mTotalMoveCount << " moves, " << defragmentation.mFailedMoveCount << " failed");
+        }
+
+        // Records changed by the previous update, scattered before any draw of this frame.
+        result = mSceneBuffer.Flush(mPrimaryCmdWorker.mCmdBuffers.front(), VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+        if (result != SlvnResult::cOk)
+            SLVN_PRINT("WARNING; frame ring full, " << mSceneBuffer.GetDirtyCount() << " scene records postponed");
+        SlvnSceneBufferStats sceneStats = mSceneBuffer.GetStats();
+        if (isStatsFrame())
+            SLVN_PRINT("Scene records uploaded " << sceneStats.mDirtyCount << "/" << sceneStats.mCapacity << ", " << sceneStats.mUploadedBytes << " bytes");
+
         // Begin render pass        
         result = mRenderpass.BeginRenderpass(mFramebuffer.mFrameBuffers[currentFrame],
             mPrimaryCmdWorker.mCmdBuffers.front(),
@@ -395,26 +918,62 @@ void SlvnRenderEngine::render()
         SlvnSettings& settings = SlvnSettings::GetInstance();
         for (uint32_t t = 0; t < settings.mMaxThreads; t++)
         {
-            for (uint32_t i = 0; i < mObjectsPerThread; i++)
-            {
-                mThreadpool.mThreads[t]->addJob([=]
-                    {
-                        threadRender(t, i, mVerticesAmount, inheritanceInfo);
-                    });
-            }
+            mThreadpool.mThreads[t]->addJob([=]
+                {
+                    updateObjects(t);
+                });
         }
 
         mThreadpool.Wait();
 
+        // Frames are rendered from the start, objects get draw packets once their mesh has arrived
+        // and only when they intersect the view frustum.
+        if (geometryReady)
+        {
+            cullObjects();
+            buildDrawPackets();
+        }
+
+        if (settings.mMeshStreaming && geometryReady)
+        {
+            mMeshStreamer.EndFrame();
+            SlvnStreamingStats streaming = mMeshStreamer.GetStats();
+            if (isStatsFrame())
+                SLVN_PRINT("Streaming resident " << streaming.mResidentCount << "/" << streaming.mMeshCount << ", " << streaming.mResidentBytes << "/"
+                    << streaming.mBudgetBytes << " bytes, hit rate " << streaming.GetHitRate() << ", loads " << streaming.mLoadCount << ", evictions "
+                    << streaming.mEvictionCount << ", load latency " << streaming.mAverageLoadMs << "ms avg " << streaming.mMaxLoadMs << "ms max");
+        }
+
+        // Each thread records one contiguous range of the sorted packets into its secondary buffer.
+        uint32_t packetCount = geometryReady ? static_cast<uint32_t>(mDrawPackets.size()) : 0;
+        uint32_t packetsPerThread = (packetCount + settings.mMaxThreads - 1) / settings.mMaxThreads;
         for (uint32_t t = 0; t < settings.mMaxThreads; t++)
         {
-            for (uint32_t i = 0; i < mObjectsPerThread; i++)
-            {
-                commandBuffers.push_back(mSecondaryCmdWorkers[t].mCmdBuffers[i]);
-            }
+            uint32_t firstPacket = t * packetsPerThread;
+            if (firstPacket >= packetCount)
+                break;
+
+            uint32_t count = std::min(packetsPerThread, packetCount - firstPacket);
+            mThreadpool.mThreads[t]->addJob([=]
+                {
+                    threadRender(t, firstPacket, count, inheritanceInfo);
+                });
+            commandBuffers.push_back(mSecondaryCmdWorkers[t].mCmdBuffers.front());
         }
 
-        vkCmdExecuteCommands(mPrimaryCmdWorker.mCmdBuffers.front(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        mThreadpool.Wait();
+
+        SlvnEncoderStats encoderStats = {};
+        for (auto& encoder : mEncoders)
+        {
+            encoderStats.Add(encoder.GetStats());
+            encoder.ResetStats();
+        }
+        if (isStatsFrame())
+            SLVN_PRINT("Recorded commands issued " << encoderStats.GetIssued() << ", elided " << encoderStats.GetElided());
+
+        if (!commandBuffers.empty())
+            vkCmdExecuteCommands(mPrimaryCmdWorker.mCmdBuffers.front(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
 
         result = mRenderpass.EndRenderpass(mPrimaryCmdWorker.mCmdBuffers.front());
         SLVN_ASSERT_RESULT(result);
@@ -424,6 +983,7 @@ void SlvnRenderEngine::render()
 
         res = vkQueueSubmit(mQueue, 1, &mSubmitInfo, mRenderFence);
         assert(res == VK_SUCCESS);
+        mFrameNumber++;
 
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -446,8 +1006,12 @@ void SlvnRenderEngine::render()
         mMatrices.projection = mCamera.mMatrices.perspective;
         mMatrices.view = mCamera.mMatrices.view;
     }
-    mVertexBuffer.Deinitialize(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice);
-    mIndiceBuffer.Deinitialize(&mDeviceManager.GetPrimaryDevice()->mLogicalDevice);
+    if (SlvnSettings::GetInstance().mMeshStreaming)
+        mMeshStreamer.Deinitialize(mFrameNumber);
+    mAssetManager.Release(mMeshAsset, mFrameNumber);
+    mAssetManager.Deinitialize();
+    // Waits for loads still in flight and frees the scene mesh, or its fallback when streaming.
+    mAssetPipeline.Deinitialize(mFrameNumber);
 }
 
 SlvnResult SlvnRenderEngine::Deinitialize()
@@ -457,10 +1021,20 @@ SlvnResult SlvnRenderEngine::Deinitialize()
     // Call Deinitialize() in reverse order to get bottom-to-top destruction order
     SLVN_PRINT("ENTER");
 
+    // Everything still queued for deletion goes first, this is the only full device idle.
+    vkDeviceWaitIdle(mDeviceManager.GetPrimaryDevice()->mLogicalDevice);
+    mGeometryPool.Unregister(&mDefragmenter);
+    SlvnResult result = mDefragmenter.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mDeletionQueue.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+
     vkDestroySemaphore(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, mSemaphores.mPresentDone, nullptr);
     vkDestroySemaphore(mDeviceManager.GetPrimaryDevice()->mLogicalDevice, mSemaphores.mRenderDone, nullptr);
 
-    SlvnResult result = mPipeline.Deinitialize();
+    result = mOcclusionCuller.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mPipeline.Deinitialize();
     SLVN_ASSERT_RESULT(result);
     result = mFramebuffer.Deinitialize();
     SLVN_ASSERT_RESULT(result);
@@ -486,6 +1060,19 @@ SlvnResult SlvnRenderEngine::Deinitialize()
     result = mDisplay.Deinitialize(mInstance.mVkInstance, mDeviceManager.GetPrimaryDevice()->mLogicalDevice);
     SLVN_ASSERT_RESULT(result);
 
+    result = mSceneBuffer.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mFrameRing.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mGeometryPool.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mUploadManager.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mMemoryReporter.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+    result = mMemoryAllocator.Deinitialize();
+    SLVN_ASSERT_RESULT(result);
+
     for (auto& worker : mCmdManager.mWorkers)
     {
         VkDevice device = mDeviceManager.GetPrimaryDevice()->mLogicalDevice;
@@ -511,9 +1098,11 @@ SlvnResult SlvnRenderEngine::Deinitialize()
 
 } // slvn_tech
 
+#ifndef SLVN_BENCHMARK
 int main()
 {
     slvn_tech::SlvnRenderEngine engine = slvn_tech::SlvnRenderEngine(1);
     engine.Initialize();  
     engine.Deinitialize();
-}
\ No newline at end of file
+}
+#endif // SLVN_BENCHMARK
\ No newline at end of file
@@ -0,0 +1,257 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <cstring>
+#include <string>
+
+#include <slvn_scene_buffer.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnSceneBuffer::SlvnSceneBuffer() : mDevice(VK_NULL_HANDLE), mAllocator(nullptr), mFrameRing(nullptr), mCapacity(0),
+mBuffer(VK_NULL_HANDLE), mDirtyCount(0), mDescriptorSetLayout(VK_NULL_HANDLE), mDescriptorPool(VK_NULL_HANDLE),
+mDescriptorSet(VK_NULL_HANDLE), mPipelineLayout(VK_NULL_HANDLE), mPipeline(VK_NULL_HANDLE), mStats()
+{
+}
+
+SlvnSceneBuffer::~SlvnSceneBuffer()
+{
+}
+
+SlvnResult SlvnSceneBuffer::Initialize(VkDevice device, SlvnMemoryAllocator* allocator, SlvnFrameRing* frameRing, uint32_t capacity)
+{
+    SLVN_PRINT("ENTER");
+
+    mDevice = device;
+    mAllocator = allocator;
+    mFrameRing = frameRing;
+    mCapacity = capacity;
+
+    mRecords.assign(capacity, SlvnInstanceRecord{ glm::mat4(1.0f), glm::vec4(1.0f) });
+    mDirty.assign(capacity, 0);
+    mDirtyList.resize(capacity);
+    mDirtyCount = 0;
+    mStats = SlvnSceneBufferStats();
+    mStats.mCapacity = capacity;
+
+    VkBufferCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    info.size = static_cast<VkDeviceSize>(std::max(1u, capacity)) * sizeof(SlvnInstanceRecord);
+    info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult res = vkCreateBuffer(mDevice, &info, nullptr, &mBuffer);
+    assert(res == VK_SUCCESS);
+    SlvnResult result = mAllocator->AllocateBuffer(mBuffer, SlvnMemoryUsage::cGpuOnly, mAllocation, SlvnMemoryCategory::cOther);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    result = createPipeline();
+    if (result != SlvnResult::cOk)
+        return result;
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnSceneBuffer::createPipeline()
+{
+    // Bindings 0 and 1 alias the whole frame ring, the flush passes where its data starts.
+    VkDescriptorSetLayoutBinding bindings[3] = {};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = 3;
+    layoutInfo.pBindings = bindings;
+    VkResult res = vkCreateDescriptorSetLayout(mDevice, &layoutInfo, nullptr, &mDescriptorSetLayout);
+    assert(res == VK_SUCCESS);
+
+    VkDescriptorPoolSize poolSize = {};
+    poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    poolSize.descriptorCount = 3;
+    VkDescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.maxSets = 1;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+    res = vkCreateDescriptorPool(mDevice, &poolInfo, nullptr, &mDescriptorPool);
+    assert(res == VK_SUCCESS);
+
+    VkDescriptorSetAllocateInfo setInfo = {};
+    setInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    setInfo.descriptorPool = mDescriptorPool;
+    setInfo.descriptorSetCount = 1;
+    setInfo.pSetLayouts = &mDescriptorSetLayout;
+    res = vkAllocateDescriptorSets(mDevice, &setInfo, &mDescriptorSet);
+    assert(res == VK_SUCCESS);
+
+    VkDescriptorBufferInfo bufferInfos[3] = {};
+    bufferInfos[0].buffer = mFrameRing->GetBuffer();
+    bufferInfos[0].range = VK_WHOLE_SIZE;
+    bufferInfos[1].buffer = mFrameRing->GetBuffer();
+    bufferInfos[1].range = VK_WHOLE_SIZE;
+    bufferInfos[2].buffer = mBuffer;
+    bufferInfos[2].range = VK_WHOLE_SIZE;
+    VkWriteDescriptorSet writes[3] = {};
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstSet = mDescriptorSet;
+        writes[i].dstBinding = i;
+        writes[i].descriptorCount = 1;
+        writes[i].descriptorType = bindings[i].descriptorType;
+        writes[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(mDevice, 3, writes, 0, nullptr);
+
+    VkPushConstantRange pushRange = {};
+    pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    pushRange.size = sizeof(ScatterPushConstant);
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipelineLayoutInfo.setLayoutCount = 1;
+    pipelineLayoutInfo.pSetLayouts = &mDescriptorSetLayout;
+    pipelineLayoutInfo.pushConstantRangeCount = 1;
+    pipelineLayoutInfo.pPushConstantRanges = &pushRange;
+    res = vkCreatePipelineLayout(mDevice, &pipelineLayoutInfo, nullptr, &mPipelineLayout);
+    assert(res == VK_SUCCESS);
+
+    std::string shaderPath = "slvn-tech/shaders/scene_scatter.spv";
+    SlvnResult result = mShader.Initialize(mDevice, shaderPath);
+    SLVN_ASSERT_RESULT(result);
+
+    VkComputePipelineCreateInfo pipelineInfo = {};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineInfo.stage.module = mShader.mShader;
+    pipelineInfo.stage.pName = "main";
+    pipelineInfo.layout = mPipelineLayout;
+    res = vkCreateComputePipelines(mDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &mPipeline);
+    assert(res == VK_SUCCESS);
+
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnSceneBuffer::Deinitialize()
+{
+    vkDestroyPipeline(mDevice, mPipeline, nullptr);
+    vkDestroyPipelineLayout(mDevice, mPipelineLayout, nullptr);
+    mShader.Deinitialize();
+    vkDestroyDescriptorPool(mDevice, mDescriptorPool, nullptr);
+    vkDestroyDescriptorSetLayout(mDevice, mDescriptorSetLayout, nullptr);
+    vkDestroyBuffer(mDevice, mBuffer, nullptr);
+    mAllocator->Free(mAllocation);
+    mBuffer = VK_NULL_HANDLE;
+    mRecords.clear();
+    mDirty.clear();
+    mDirtyList.clear();
+    mDirtyCount = 0;
+    return SlvnResult::cOk;
+}
+
+void SlvnSceneBuffer::Update(uint32_t record, const SlvnInstanceRecord& data)
+{
+    assert(record < mCapacity);
+    mRecords[record] = data;
+    if (mDirty[record])
+        return;
+
+    mDirty[record] = 1;
+    mDirtyList[mDirtyCount.fetch_add(1, std::memory_order_relaxed)] = record;
+}
+
+SlvnResult SlvnSceneBuffer::Flush(VkCommandBuffer cmd, VkPipelineStageFlags dstStage)
+{
+    uint32_t dirtyCount = mDirtyCount.load(std::memory_order_relaxed);
+    mStats.mDirtyCount = dirtyCount;
+    mStats.mUploadedBytes = 0;
+    if (dirtyCount == 0)
+        return SlvnResult::cOk;
+
+    // Records first, starting on a whole record of the ring so the shader can index them, slots right after.
+    VkDeviceSize recordBytes = static_cast<VkDeviceSize>(dirtyCount) * sizeof(SlvnInstanceRecord);
+    VkDeviceSize indexBytes = static_cast<VkDeviceSize>(dirtyCount) * sizeof(uint32_t);
+    SlvnRingAllocation allocation;
+    if (mFrameRing->AllocateStorage(recordBytes + indexBytes + sizeof(SlvnInstanceRecord), allocation) != SlvnResult::cOk)
+    {
+        mStats.mFailedFlushes++;
+        return SlvnResult::cOutOfMemory;
+    }
+    VkDeviceSize recordOffset = (allocation.mOffset + sizeof(SlvnInstanceRecord) - 1) / sizeof(SlvnInstanceRecord) * sizeof(SlvnInstanceRecord);
+    VkDeviceSize indexOffset = recordOffset + recordBytes;
+    uint8_t* mapped = static_cast<uint8_t*>(allocation.mMapped) - allocation.mOffset;
+
+    SlvnInstanceRecord* records = reinterpret_cast<SlvnInstanceRecord*>(mapped + recordOffset);
+    uint32_t* indices = reinterpret_cast<uint32_t*>(mapped + indexOffset);
+    std::memcpy(indices, mDirtyList.data(), dirtyCount * sizeof(uint32_t));
+    for (uint32_t i = 0; i < dirtyCount; i++)
+    {
+        uint32_t record = mDirtyList[i];
+        records[i] = mRecords[record];
+        mDirty[record] = 0;
+    }
+    mDirtyCount.store(0, std::memory_order_relaxed);
+
+    // Earlier frames may still read the slots being overwritten.
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = mBuffer;
+    barrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, dstStage | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+        0, nullptr, 1, &barrier, 0, nullptr);
+
+    ScatterPushConstant pushConstant = {};
+    pushConstant.mCount = dirtyCount;
+    pushConstant.mFirstRecord = static_cast<uint32_t>(recordOffset / sizeof(SlvnInstanceRecord));
+    pushConstant.mFirstIndex = static_cast<uint32_t>(indexOffset / sizeof(uint32_t));
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPipeline);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, mPipelineLayout, 0, 1, &mDescriptorSet, 0, nullptr);
+    vkCmdPushConstants(cmd, mPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(ScatterPushConstant), &pushConstant);
+    vkCmdDispatch(cmd, (dirtyCount + cGroupSize - 1) / cGroupSize, 1, 1);
+
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, dstStage, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    mStats.mUploadedBytes = static_cast<uint64_t>(dirtyCount) * (sizeof(uint32_t) + sizeof(SlvnInstanceRecord));
+    mStats.mTotalUploadedBytes += mStats.mUploadedBytes;
+    return SlvnResult::cOk;
+}
+
+} // slvn_tech
@@ -42,6 +42,7 @@ SlvnSettings::SlvnSettings() : mWindowMode(SlvnWindowMode::cFullscreen)
     mWantedLayers.push_back(std::string("VK_LAYER_KHRONOS_validation"));
     mWantedLayers.push_back(std::string("VK_LAYER_RENDERDOC_Capture"));
     mWantedDeviceExtensions.push_back(std::string("VK_KHR_swapchain"));
+    mWantedDeviceExtensions.push_back(std::string("VK_EXT_memory_budget"));
 
 	uint32_t glfwExtensionCount = 0;
 	const char** glfwExtensions;
@@ -62,6 +63,47 @@ SlvnSettings::SlvnSettings() : mWindowMode(SlvnWindowMode::cFullscreen)
     mWindowWidth = 1920;
 
     mMaxThreads = std::thread::hardware_concurrency();
+    mSceneObjectCount = mMaxThreads;
+
+    mOcclusionCulling = true;
+    mOcclusionBufferWidth = 320;
+    mOcclusionBufferHeight = 180;
+    mOccluderCount = 8;
+
+    mLodTriangleRatios = { 1.0f, 0.5f, 0.25f, 0.125f, 0.0625f, 0.03125f };
+    mLodMaxError = 0.05f;
+
+    mMeshletCulling = true;
+    mMeshletMaxVertices = 64;
+    mMeshletMaxTriangles = 124;
+    mLodPixelError = 1.0f;
+    mLodHysteresis = 0.25f;
+
+    mDeviceLocalGeometry = true;
+    mGeometryPoolVertexCount = 1 << 20;
+    mGeometryPoolIndexCount = 1 << 22;
+    mVertexPulling = false;
+    mCompactVertices = true;
+    mQuantizedVertices = true;
+    mShortIndices = true;
+
+    mFrameRingSize = 4 * 1024 * 1024;
+
+    mStatsInterval = 120;
+
+    mMemoryReportPath = "";
+
+    mDefragmentation = true;
+    mDefragmentationBudgetMs = 0.25f;
+    mDefragmentationMaxBytes = 16 * 1024 * 1024;
+
+    mMeshStreaming = true;
+    mStreamingBudget = 64 * 1024 * 1024;
+    mStreamingMaxLoads = 2;
+
+    mAssetDecodeThreads = 2;
+    mAssetUploadBudget = 32 * 1024 * 1024;
+    mAssetCacheBudget = 128 * 1024 * 1024;
 }
 
 SlvnSettings::~SlvnSettings()
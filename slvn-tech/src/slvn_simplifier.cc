@@ -0,0 +1,392 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+#include <slvn_simplifier.h>
+#include <slvn_bounds.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline uint64_t edgeKey(uint32_t a, uint32_t b)
+{
+    return (static_cast<uint64_t>(a) << 32) | b;
+}
+
+inline uint32_t hashPosition(const glm::vec3& position)
+{
+    uint32_t words[3];
+    std::memcpy(words, &position, sizeof(words));
+    return (words[0] * 73856093u) ^ (words[1] * 19349663u) ^ (words[2] * 83492791u);
+}
+
+}
+
+SlvnMeshSimplifier::SlvnMeshSimplifier() : mScale(1.0f)
+{
+}
+
+SlvnMeshSimplifier::~SlvnMeshSimplifier()
+{
+}
+
+void SlvnMeshSimplifier::prepare(const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+
+    // Errors are measured in the unit cube so that the float quadrics keep their precision.
+    SlvnAabb bounds;
+    for (auto& vertex : vertices)
+    {
+        bounds.Grow(vertex.mPosition);
+    }
+    glm::vec3 size = bounds.IsEmpty() ? glm::vec3(1.0f) : bounds.mMax - bounds.mMin;
+    mScale = std::max(std::max(size.x, size.y), std::max(size.z, FLT_MIN));
+    mPositions.resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        mPositions[v] = (vertices[v].mPosition - bounds.mMin) / mScale;
+    }
+
+    // Group vertices by position with an open addressing table.
+    uint32_t tableSize = 16;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    std::vector<uint32_t> table(tableSize, cInvalid);
+    mCanonical.resize(vertexCount);
+    mLocked.assign(vertexCount, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        uint32_t slot = hashPosition(vertices[v].mPosition) & (tableSize - 1);
+        while (table[slot] != cInvalid && vertices[table[slot]].mPosition != vertices[v].mPosition)
+            slot = (slot + 1) & (tableSize - 1);
+        if (table[slot] == cInvalid)
+        {
+            table[slot] = v;
+            mCanonical[v] = v;
+        }
+        else
+        {
+            // A seam, the position has vertices with different attributes.
+            mCanonical[v] = table[slot];
+            mLocked[v] = 1;
+            mLocked[table[slot]] = 1;
+        }
+    }
+
+    // Border edges have no twin running the other way between the same positions. Edges are sorted
+    // undirected with the direction in the lowest bit, so both directions of an edge end up next to each other.
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (uint32_t e = 0; e < 3; e++)
+        {
+            uint32_t a = mCanonical[indices[i + e]];
+            uint32_t b = mCanonical[indices[i + (e + 1) % 3]];
+            edges.push_back(a < b ? edgeKey(a, b) << 1 : (edgeKey(b, a) << 1) | 1);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    for (size_t first = 0; first < edges.size();)
+    {
+        size_t last = first + 1;
+        while (last < edges.size() && (edges[last] >> 1) == (edges[first] >> 1))
+            last++;
+        // Sorted, so the run has both directions when its ends differ.
+        if ((edges[first] & 1) == (edges[last - 1] & 1))
+        {
+            mLocked[static_cast<uint32_t>(edges[first] >> 33)] = 1;
+            mLocked[static_cast<uint32_t>(edges[first] >> 1)] = 1;
+        }
+        first = last;
+    }
+    // Lock state and quadrics live with the canonical vertex of a position.
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        mLocked[v] = mLocked[mCanonical[v]] | mLocked[v];
+    }
+
+    mQuadrics.assign(vertexCount, Quadric());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const glm::vec3& p0 = mPositions[indices[i]];
+        const glm::vec3& p1 = mPositions[indices[i + 1]];
+        const glm::vec3& p2 = mPositions[indices[i + 2]];
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area <= 0.0f)
+            continue;
+        normal /= area;
+        float d = -glm::dot(normal, p0);
+
+        Quadric plane;
+        plane.mA00 = area * normal.x * normal.x;
+        plane.mA11 = area * normal.y * normal.y;
+        plane.mA22 = area * normal.z * normal.z;
+        plane.mA01 = area * normal.x * normal.y;
+        plane.mA02 = area * normal.x * normal.z;
+        plane.mA12 = area * normal.y * normal.z;
+        plane.mB0 = area * normal.x * d;
+        plane.mB1 = area * normal.y * d;
+        plane.mB2 = area * normal.z * d;
+        plane.mC = area * d * d;
+        plane.mWeight = area;
+        for (uint32_t c = 0; c < 3; c++)
+        {
+            Quadric& q = mQuadrics[mCanonical[indices[i + c]]];
+            q.mA00 += plane.mA00; q.mA11 += plane.mA11; q.mA22 += plane.mA22;
+            q.mA01 += plane.mA01; q.mA02 += plane.mA02; q.mA12 += plane.mA12;
+            q.mB0 += plane.mB0; q.mB1 += plane.mB1; q.mB2 += plane.mB2;
+            q.mC += plane.mC;
+            q.mWeight += plane.mWeight;
+        }
+    }
+}
+
+bool SlvnMeshSimplifier::flips(uint32_t vertex, uint32_t target, const std::vector<uint32_t>& indices) const
+{
+    const glm::vec3& moved = mPositions[target];
+    for (uint32_t a = mAdjacencyOffsets[vertex]; a < mAdjacencyOffsets[vertex + 1]; a++)
+    {
+        const uint32_t* triangle = &indices[mAdjacency[a] * 3];
+        if (triangle[0] == target || triangle[1] == target || triangle[2] == target)
+            continue;
+
+        // Rotate the moving corner first.
+        uint32_t corner = triangle[0] == vertex ? 0 : (triangle[1] == vertex ? 1 : 2);
+        const glm::vec3& p0 = mPositions[triangle[corner]];
+        const glm::vec3& p1 = mPositions[triangle[(corner + 1) % 3]];
+        const glm::vec3& p2 = mPositions[triangle[(corner + 2) % 3]];
+        glm::vec3 before = glm::cross(p1 - p0, p2 - p0);
+        glm::vec3 after = glm::cross(p1 - moved, p2 - moved);
+        if (glm::dot(before, after) <= 0.0f)
+            return true;
+    }
+    return false;
+}
+
+SlvnResult SlvnMeshSimplifier::Simplify(const std::vector<SlvnVertex>& vertices, const std::vector<uint32_t>& indices,
+    uint32_t targetIndexCount, float maxError, std::vector<uint32_t>& result, float& error)
+{
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    if (indices.size() % 3 != 0 || std::any_of(indices.begin(), indices.end(), [=](uint32_t index) { return index >= vertexCount; }))
+    {
+        SLVN_PRINT("ERROR; indices do not form triangles of the given vertices");
+        return SlvnResult::cUnexpectedError;
+    }
+
+    prepare(vertices, indices);
+    result = indices;
+    error = 0.0f;
+
+    float errorLimit = maxError / mScale;
+    errorLimit *= errorLimit;
+    float largestCost = 0.0f;
+    uint32_t triangleCount = static_cast<uint32_t>(result.size() / 3);
+    uint32_t targetTriangles = targetIndexCount / 3;
+
+    std::vector<uint32_t> collapseTarget(vertexCount, cInvalid);
+    std::vector<float> collapseCost(vertexCount);
+    std::vector<uint64_t> candidates;
+    std::vector<uint8_t> touched(vertexCount);
+    std::vector<uint32_t> remap(vertexCount);
+    while (triangleCount > targetTriangles)
+    {
+        // Vertex to triangle adjacency of the current triangles.
+        mAdjacencyOffsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : result)
+        {
+            mAdjacencyOffsets[index + 1]++;
+        }
+        std::partial_sum(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end(), mAdjacencyOffsets.begin());
+        mAdjacency.resize(result.size());
+        std::vector<uint32_t> fill(mAdjacencyOffsets.begin(), mAdjacencyOffsets.end() - 1);
+        for (uint32_t i = 0; i < result.size(); i++)
+        {
+            mAdjacency[fill[result[i]]++] = i / 3;
+        }
+
+        // Cheapest collapse of every free vertex onto a neighbour, cost is the mean squared distance.
+        std::fill(collapseTarget.begin(), collapseTarget.end(), cInvalid);
+        for (uint32_t i = 0; i < result.size(); i++)
+        {
+            uint32_t from = result[i];
+            if (mLocked[from])
+                continue;
+            for (uint32_t other = 1; other < 3; other++)
+            {
+                uint32_t to = result[i - i % 3 + (i % 3 + other) % 3];
+                const Quadric& q0 = mQuadrics[mCanonical[from]];
+                const Quadric& q1 = mQuadrics[mCanonical[to]];
+                const glm::vec3& p = mPositions[to];
+                float a00 = q0.mA00 + q1.mA00, a11 = q0.mA11 + q1.mA11, a22 = q0.mA22 + q1.mA22;
+                float a01 = q0.mA01 + q1.mA01, a02 = q0.mA02 + q1.mA02, a12 = q0.mA12 + q1.mA12;
+                float cost = p.x * (a00 * p.x + a01 * p.y + a02 * p.z) + p.y * (a01 * p.x + a11 * p.y + a12 * p.z) +
+                    p.z * (a02 * p.x + a12 * p.y + a22 * p.z) + 2.0f * (p.x * (q0.mB0 + q1.mB0) + p.y * (q0.mB1 + q1.mB1) + p.z * (q0.mB2 + q1.mB2)) +
+                    q0.mC + q1.mC;
+                float weight = q0.mWeight + q1.mWeight;
+                cost = weight > 0.0f ? std::max(cost, 0.0f) / weight : 0.0f;
+                if (collapseTarget[from] == cInvalid || cost < collapseCost[from])
+                {
+                    collapseTarget[from] = to;
+                    collapseCost[from] = cost;
+                }
+            }
+        }
+        // Costs are never negative, their bits sort like the floats.
+        candidates.clear();
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (collapseTarget[v] == cInvalid || collapseCost[v] > errorLimit)
+                continue;
+            uint32_t costBits;
+            std::memcpy(&costBits, &collapseCost[v], sizeof(costBits));
+            candidates.push_back(edgeKey(costBits, v));
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        // Apply independent collapses, every triangle around a moved vertex is left alone for the rest of the pass.
+        std::fill(touched.begin(), touched.end(), 0);
+        std::iota(remap.begin(), remap.end(), 0);
+        uint32_t removed = 0;
+        uint32_t collapsed = 0;
+        for (uint64_t candidate : candidates)
+        {
+            uint32_t from = static_cast<uint32_t>(candidate);
+            if (triangleCount - removed <= targetTriangles)
+                break;
+            uint32_t to = collapseTarget[from];
+            if (touched[from] || touched[to] || flips(from, to, result))
+                continue;
+
+            for (uint32_t a = mAdjacencyOffsets[from]; a < mAdjacencyOffsets[from + 1]; a++)
+            {
+                const uint32_t* triangle = &result[mAdjacency[a] * 3];
+                removed += (triangle[0] == to || triangle[1] == to || triangle[2] == to) ? 1 : 0;
+                touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = 1;
+            }
+            Quadric& q0 = mQuadrics[mCanonical[from]];
+            Quadric& q1 = mQuadrics[mCanonical[to]];
+            q1.mA00 += q0.mA00; q1.mA11 += q0.mA11; q1.mA22 += q0.mA22;
+            q1.mA01 += q0.mA01; q1.mA02 += q0.mA02; q1.mA12 += q0.mA12;
+            q1.mB0 += q0.mB0; q1.mB1 += q0.mB1; q1.mB2 += q0.mB2;
+            q1.mC += q0.mC;
+            q1.mWeight += q0.mWeight;
+            largestCost = std::max(largestCost, collapseCost[from]);
+            remap[from] = to;
+            collapsed++;
+        }
+        if (collapsed == 0)
+            break;
+
+        // Remap and drop the triangles that lost an edge, including ones folded onto a seam twin.
+        uint32_t written = 0;
+        for (uint32_t i = 0; i < result.size(); i += 3)
+        {
+            uint32_t corners[3] = { remap[result[i]], remap[result[i + 1]], remap[result[i + 2]] };
+            if (mCanonical[corners[0]] == mCanonical[corners[1]] || mCanonical[corners[1]] == mCanonical[corners[2]] ||
+                mCanonical[corners[2]] == mCanonical[corners[0]])
+                continue;
+            result[written++] = corners[0];
+            result[written++] = corners[1];
+            result[written++] = corners[2];
+        }
+        result.resize(written);
+        triangleCount = written / 3;
+    }
+
+    error = std::sqrt(largestCost) * mScale;
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnMeshSimplifier::BuildLodChain(const std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices,
+    const std::vector<float>& triangleRatios, float maxError, SlvnLodMesh& mesh, SlvnThreadpool* threadpool)
+{
+    uint32_t sourceCount = static_cast<uint32_t>(indices.size());
+    mesh.mLevels.clear();
+    mesh.mLevels.push_back({ 0, sourceCount, 0.0f, 0, 0 });
+    if (triangleRatios.size() < 2)
+        return SlvnResult::cOk;
+
+    uint32_t levelCount = static_cast<uint32_t>(triangleRatios.size()) - 1;
+    std::vector<std::vector<uint32_t>> levels(levelCount);
+    std::vector<float> errors(levelCount, 0.0f);
+    std::vector<SlvnResult> results(levelCount, SlvnResult::cOk);
+    auto simplifyLevel = [&](uint32_t level)
+    {
+        uint32_t target = static_cast<uint32_t>(triangleRatios[level + 1] * static_cast<float>(sourceCount / 3)) * 3;
+        SlvnMeshSimplifier simplifier;
+        results[level] = simplifier.Simplify(vertices, indices, target, maxError, levels[level], errors[level]);
+    };
+
+    if (threadpool == nullptr)
+    {
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            simplifyLevel(level);
+        }
+    }
+    else
+    {
+        uint32_t threadCount = static_cast<uint32_t>(threadpool->mThreads.size());
+        for (uint32_t level = 0; level < levelCount; level++)
+        {
+            threadpool->mThreads[level % threadCount]->addJob([&simplifyLevel, level] { simplifyLevel(level); });
+        }
+        threadpool->Wait();
+    }
+
+    // A level that is not clearly coarser than the one before means the error bound was hit.
+    for (uint32_t level = 0; level < levelCount; level++)
+    {
+        if (results[level] != SlvnResult::cOk)
+            return results[level];
+
+        const SlvnLodLevel& previous = mesh.mLevels.back();
+        uint32_t count = static_cast<uint32_t>(levels[level].size());
+        if (count == 0 || count > previous.mIndexCount * 9 / 10)
+            break;
+
+        SlvnLodLevel lod = {};
+        lod.mFirstIndex = static_cast<uint32_t>(indices.size());
+        lod.mIndexCount = count;
+        lod.mError = std::max(errors[level], previous.mError);
+        indices.insert(indices.end(), levels[level].begin(), levels[level].end());
+        mesh.mLevels.push_back(lod);
+    }
+    return SlvnResult::cOk;
+}
+
+} // slvn_tech
@@ -0,0 +1,319 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <slvn_tlsf.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline uint32_t mostSignificantBit(uint64_t value)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_WIN64))
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<uint32_t>(index);
+#elif defined(_MSC_VER)
+    // The 64-bit scans only exist on x64, scan the halves.
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        return static_cast<uint32_t>(index) + 32;
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return static_cast<uint32_t>(index);
+#else
+    return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+}
+
+inline uint32_t leastSignificantBit(uint64_t value)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_WIN64))
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return static_cast<uint32_t>(index);
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+        return static_cast<uint32_t>(index);
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    return static_cast<uint32_t>(index) + 32;
+#else
+    return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+inline void mapping(uint64_t size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+    uint32_t msb = mostSignificantBit(size);
+    firstLevel = msb - 4;
+    secondLevel = static_cast<uint32_t>(size >> (msb - 4)) & 15;
+}
+
+inline uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+SlvnTlsfAllocator::SlvnTlsfAllocator() : mFirstLevelBitmap(0), mSize(0), mUsed(0), mAllocationCount(0)
+{
+    static_assert(cMinShift == 4 && cSecondLevelBits == 4, "mapping() assumes 16 byte granularity and 16 subdivisions");
+}
+
+SlvnTlsfAllocator::~SlvnTlsfAllocator()
+{
+}
+
+void SlvnTlsfAllocator::Initialize(uint64_t size)
+{
+    mNodes.clear();
+    mUnusedNodes.clear();
+    for (auto& heads : mFreeHeads)
+    {
+        std::fill(std::begin(heads), std::end(heads), cInvalid);
+    }
+    std::fill(std::begin(mSecondLevelBitmap), std::end(mSecondLevelBitmap), 0);
+    mFirstLevelBitmap = 0;
+
+    mSize = size & ~(cMinSize - 1);
+    mUsed = 0;
+    mAllocationCount = 0;
+    if (mSize > 0)
+        insertFree(createNode(0, mSize));
+}
+
+uint32_t SlvnTlsfAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    size = alignUp(std::max<uint64_t>(size, 1), cMinSize);
+    alignment = std::max(alignment, cMinSize);
+
+    // Offsets are multiples of the minimum size, so the worst case padding is alignment - cMinSize.
+    uint64_t searchSize = size + alignment - cMinSize;
+    uint32_t node = findFree(searchSize);
+    if (node == cInvalid)
+        return cInvalid;
+
+    removeFree(node);
+
+    uint64_t padding = alignUp(mNodes[node].mOffset, alignment) - mNodes[node].mOffset;
+    if (padding > 0)
+    {
+        // The padding in front stays free as a region of its own.
+        split(node, padding, true);
+        node = mNodes[node].mNextPhysical;
+    }
+    if (mNodes[node].mSize - size >= cMinSize)
+        split(node, size, false);
+
+    mNodes[node].mFree = false;
+    mUsed += mNodes[node].mSize;
+    mAllocationCount++;
+    offset = mNodes[node].mOffset;
+    return node;
+}
+
+void SlvnTlsfAllocator::Free(uint32_t handle)
+{
+    assert(handle < mNodes.size() && !mNodes[handle].mFree);
+
+    mUsed -= mNodes[handle].mSize;
+    mAllocationCount--;
+    mNodes[handle].mFree = true;
+
+    uint32_t node = handle;
+    uint32_t previous = mNodes[node].mPrevPhysical;
+    if (previous != cInvalid && mNodes[previous].mFree)
+    {
+        removeFree(previous);
+        mNodes[previous].mSize += mNodes[node].mSize;
+        mNodes[previous].mNextPhysical = mNodes[node].mNextPhysical;
+        if (mNodes[node].mNextPhysical != cInvalid)
+            mNodes[mNodes[node].mNextPhysical].mPrevPhysical = previous;
+        releaseNode(node);
+        node = previous;
+    }
+
+    uint32_t next = mNodes[node].mNextPhysical;
+    if (next != cInvalid && mNodes[next].mFree)
+    {
+        removeFree(next);
+        mNodes[node].mSize += mNodes[next].mSize;
+        mNodes[node].mNextPhysical = mNodes[next].mNextPhysical;
+        if (mNodes[next].mNextPhysical != cInvalid)
+            mNodes[mNodes[next].mNextPhysical].mPrevPhysical = node;
+        releaseNode(next);
+    }
+
+    insertFree(node);
+}
+
+SlvnTlsfStats SlvnTlsfAllocator::GetStats() const
+{
+    SlvnTlsfStats stats = {};
+    stats.mSize = mSize;
+    stats.mUsed = mUsed;
+    stats.mAllocationCount = mAllocationCount;
+
+    for (uint32_t firstLevel = 0; firstLevel < cFirstLevelCount; firstLevel++)
+    {
+        for (uint32_t secondLevel = 0; secondLevel < cSecondLevelCount; secondLevel++)
+        {
+            for (uint32_t node = mFreeHeads[firstLevel][secondLevel]; node != cInvalid; node = mNodes[node].mNextFree)
+            {
+                stats.mFreeRegionCount++;
+                stats.mLargestFreeRegion = std::max(stats.mLargestFreeRegion, mNodes[node].mSize);
+            }
+        }
+    }
+    return stats;
+}
+
+uint32_t SlvnTlsfAllocator::createNode(uint64_t offset, uint64_t size)
+{
+    uint32_t node;
+    if (!mUnusedNodes.empty())
+    {
+        node = mUnusedNodes.back();
+        mUnusedNodes.pop_back();
+    }
+    else
+    {
+        node = static_cast<uint32_t>(mNodes.size());
+        mNodes.push_back(Node());
+    }
+    mNodes[node] = { offset, size, cInvalid, cInvalid, cInvalid, cInvalid, true };
+    return node;
+}
+
+void SlvnTlsfAllocator::releaseNode(uint32_t node)
+{
+    mUnusedNodes.push_back(node);
+}
+
+void SlvnTlsfAllocator::insertFree(uint32_t node)
+{
+    uint32_t firstLevel, secondLevel;
+    mapping(mNodes[node].mSize, firstLevel, secondLevel);
+
+    uint32_t head = mFreeHeads[firstLevel][secondLevel];
+    mNodes[node].mFree = true;
+    mNodes[node].mPrevFree = cInvalid;
+    mNodes[node].mNextFree = head;
+    if (head != cInvalid)
+        mNodes[head].mPrevFree = node;
+    mFreeHeads[firstLevel][secondLevel] = node;
+
+    mFirstLevelBitmap |= uint64_t(1) << firstLevel;
+    mSecondLevelBitmap[firstLevel] |= 1u << secondLevel;
+}
+
+void SlvnTlsfAllocator::removeFree(uint32_t node)
+{
+    uint32_t firstLevel, secondLevel;
+    mapping(mNodes[node].mSize, firstLevel, secondLevel);
+
+    uint32_t previous = mNodes[node].mPrevFree;
+    uint32_t next = mNodes[node].mNextFree;
+    if (previous != cInvalid)
+        mNodes[previous].mNextFree = next;
+    if (next != cInvalid)
+        mNodes[next].mPrevFree = previous;
+
+    if (mFreeHeads[firstLevel][secondLevel] == node)
+    {
+        mFreeHeads[firstLevel][secondLevel] = next;
+        if (next == cInvalid)
+        {
+            mSecondLevelBitmap[firstLevel] &= ~(1u << secondLevel);
+            if (mSecondLevelBitmap[firstLevel] == 0)
+                mFirstLevelBitmap &= ~(uint64_t(1) << firstLevel);
+        }
+    }
+    mNodes[node].mPrevFree = cInvalid;
+    mNodes[node].mNextFree = cInvalid;
+}
+
+uint32_t SlvnTlsfAllocator::findFree(uint64_t size) const
+{
+    // Round up to the next bucket boundary, so any region found is large enough.
+    uint32_t msb = mostSignificantBit(size);
+    uint64_t rounded = size + (uint64_t(1) << (msb - cSecondLevelBits)) - 1;
+    if (rounded < size || mostSignificantBit(rounded) - cMinShift >= cFirstLevelCount)
+        return cInvalid;
+
+    uint32_t firstLevel, secondLevel;
+    mapping(rounded, firstLevel, secondLevel);
+
+    uint32_t secondLevelMap = mSecondLevelBitmap[firstLevel] & (~0u << secondLevel);
+    if (secondLevelMap == 0)
+    {
+        uint64_t firstLevelMap = firstLevel + 1 < 64 ? mFirstLevelBitmap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+        if (firstLevelMap == 0)
+            return cInvalid;
+        firstLevel = leastSignificantBit(firstLevelMap);
+        secondLevelMap = mSecondLevelBitmap[firstLevel];
+    }
+    secondLevel = leastSignificantBit(secondLevelMap);
+    return mFreeHeads[firstLevel][secondLevel];
+}
+
+void SlvnTlsfAllocator::split(uint32_t node, uint64_t size, bool keepFront)
+{
+    // Splits the region after size bytes. The free remainder goes back into the
+    // free lists, when keepFront is set the front part is the free one instead.
+    uint32_t rest = createNode(mNodes[node].mOffset + size, mNodes[node].mSize - size);
+    mNodes[node].mSize = size;
+
+    mNodes[rest].mPrevPhysical = node;
+    mNodes[rest].mNextPhysical = mNodes[node].mNextPhysical;
+    if (mNodes[node].mNextPhysical != cInvalid)
+        mNodes[mNodes[node].mNextPhysical].mPrevPhysical = rest;
+    mNodes[node].mNextPhysical = rest;
+
+    if (keepFront)
+    {
+        insertFree(node);
+        mNodes[rest].mFree = false;
+    }
+    else
+    {
+        insertFree(rest);
+    }
+}
+
+} // slvn_tech
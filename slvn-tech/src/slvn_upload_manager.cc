@@ -0,0 +1,295 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <assert.h>
+#include <algorithm>
+#include <cstring>
+
+#include <slvn_upload_manager.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+SlvnUploadManager::SlvnUploadManager() : mDevice(VK_NULL_HANDLE), mAllocator(nullptr), mTransferQueue(VK_NULL_HANDLE),
+mTransferQueueFamilyIndex(0), mGraphicsQueueFamilyIndex(0), mCmdPool(VK_NULL_HANDLE), mRecording(false), mOpenBatch(),
+mPendingDstStages(0), mNextBatch(1), mCompletedBatch(0)
+{
+}
+
+SlvnUploadManager::~SlvnUploadManager()
+{
+}
+
+SlvnResult SlvnUploadManager::Initialize(VkDevice device, SlvnMemoryAllocator* allocator, VkQueue transferQueue,
+    uint32_t transferQueueFamilyIndex, uint32_t graphicsQueueFamilyIndex)
+{
+    SLVN_PRINT("ENTER");
+
+    mDevice = device;
+    mAllocator = allocator;
+    mTransferQueue = transferQueue;
+    mTransferQueueFamilyIndex = transferQueueFamilyIndex;
+    mGraphicsQueueFamilyIndex = graphicsQueueFamilyIndex;
+
+    VkCommandPoolCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    info.queueFamilyIndex = mTransferQueueFamilyIndex;
+    VkResult res = vkCreateCommandPool(mDevice, &info, nullptr, &mCmdPool);
+    assert(res == VK_SUCCESS);
+
+    SLVN_PRINT("Uploads use " << (IsDedicatedQueue() ? "a dedicated transfer queue" : "the graphics queue"));
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnUploadManager::Deinitialize()
+{
+    SLVN_PRINT("ENTER");
+
+    if (mRecording)
+        Submit();
+    while (!mInFlight.empty())
+    {
+        VkResult res = vkWaitForFences(mDevice, 1, &mInFlight.front().mFence, VK_TRUE, UINT64_MAX);
+        assert(res == VK_SUCCESS);
+        retire(mInFlight.front());
+        mFreeBatches.push_back(mInFlight.front());
+        mInFlight.pop_front();
+    }
+
+    for (auto& batch : mFreeBatches)
+    {
+        vkDestroyFence(mDevice, batch.mFence, nullptr);
+    }
+    mFreeBatches.clear();
+    vkDestroyCommandPool(mDevice, mCmdPool, nullptr);
+
+    SLVN_PRINT("EXIT");
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnUploadManager::Upload(VkBuffer buffer, VkDeviceSize offset, const void* data, VkDeviceSize size,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+    if (!mRecording)
+    {
+        SlvnResult result = beginBatch();
+        if (result != SlvnResult::cOk)
+            return result;
+    }
+
+    StagingChunk* chunk;
+    SlvnResult result = reserveStaging(size, chunk);
+    if (result != SlvnResult::cOk)
+        return result;
+
+    std::memcpy(static_cast<uint8_t*>(chunk->mAllocation.mMapped) + chunk->mUsed, data, size);
+
+    VkBufferCopy region = {};
+    region.srcOffset = chunk->mUsed;
+    region.dstOffset = offset;
+    region.size = size;
+    vkCmdCopyBuffer(mOpenBatch.mCmdBuffer, chunk->mBuffer, buffer, 1, &region);
+    chunk->mUsed += (size + 15) & ~VkDeviceSize(15);
+
+    // With a dedicated queue this is the release half of the ownership transfer,
+    // the same barrier with other access masks is the acquire on the graphics queue.
+    VkBufferMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = dstAccess;
+    barrier.srcQueueFamilyIndex = IsDedicatedQueue() ? mTransferQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = IsDedicatedQueue() ? mGraphicsQueueFamilyIndex : VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    mOpenBatch.mBarriers.push_back(barrier);
+    mOpenBatch.mDstStages |= dstStage;
+    return SlvnResult::cOk;
+}
+
+uint64_t SlvnUploadManager::Submit()
+{
+    if (!mRecording)
+        return mNextBatch - 1;
+
+    if (IsDedicatedQueue())
+    {
+        std::vector<VkBufferMemoryBarrier> releases = mOpenBatch.mBarriers;
+        for (auto& release : releases)
+        {
+            release.dstAccessMask = 0;
+        }
+        vkCmdPipelineBarrier(mOpenBatch.mCmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr, static_cast<uint32_t>(releases.size()), releases.data(), 0, nullptr);
+    }
+
+    VkResult res = vkEndCommandBuffer(mOpenBatch.mCmdBuffer);
+    assert(res == VK_SUCCESS);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &mOpenBatch.mCmdBuffer;
+    res = vkQueueSubmit(mTransferQueue, 1, &submitInfo, mOpenBatch.mFence);
+    assert(res == VK_SUCCESS);
+
+    mOpenBatch.mId = mNextBatch++;
+    mInFlight.push_back(std::move(mOpenBatch));
+    mOpenBatch = Batch();
+    mRecording = false;
+    return mInFlight.back().mId;
+}
+
+void SlvnUploadManager::RecordAcquire(VkCommandBuffer cmdBuffer)
+{
+    while (!mInFlight.empty() && vkGetFenceStatus(mDevice, mInFlight.front().mFence) == VK_SUCCESS)
+    {
+        Batch& batch = mInFlight.front();
+        mPendingAcquires.insert(mPendingAcquires.end(), batch.mBarriers.begin(), batch.mBarriers.end());
+        mPendingDstStages |= batch.mDstStages;
+        mCompletedBatch = batch.mId;
+        retire(batch);
+        mFreeBatches.push_back(std::move(batch));
+        mInFlight.pop_front();
+    }
+
+    if (mPendingAcquires.empty())
+        return;
+
+    VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    if (IsDedicatedQueue())
+    {
+        srcStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        for (auto& acquire : mPendingAcquires)
+        {
+            acquire.srcAccessMask = 0;
+        }
+    }
+    vkCmdPipelineBarrier(cmdBuffer, srcStage, mPendingDstStages, 0,
+        0, nullptr, static_cast<uint32_t>(mPendingAcquires.size()), mPendingAcquires.data(), 0, nullptr);
+    mPendingAcquires.clear();
+    mPendingDstStages = 0;
+}
+
+void SlvnUploadManager::Wait(uint64_t batch)
+{
+    for (auto& inFlight : mInFlight)
+    {
+        if (inFlight.mId > batch)
+            break;
+        VkResult res = vkWaitForFences(mDevice, 1, &inFlight.mFence, VK_TRUE, UINT64_MAX);
+        assert(res == VK_SUCCESS);
+    }
+}
+
+SlvnResult SlvnUploadManager::beginBatch()
+{
+    if (!mFreeBatches.empty())
+    {
+        mOpenBatch = std::move(mFreeBatches.back());
+        mFreeBatches.pop_back();
+
+        VkResult res = vkResetFences(mDevice, 1, &mOpenBatch.mFence);
+        assert(res == VK_SUCCESS);
+        res = vkResetCommandBuffer(mOpenBatch.mCmdBuffer, 0);
+        assert(res == VK_SUCCESS);
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo allocateInfo = {};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocateInfo.commandPool = mCmdPool;
+        allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocateInfo.commandBufferCount = 1;
+        VkResult res = vkAllocateCommandBuffers(mDevice, &allocateInfo, &mOpenBatch.mCmdBuffer);
+        assert(res == VK_SUCCESS);
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        res = vkCreateFence(mDevice, &fenceInfo, nullptr, &mOpenBatch.mFence);
+        assert(res == VK_SUCCESS);
+    }
+    mOpenBatch.mStaging.clear();
+    mOpenBatch.mBarriers.clear();
+    mOpenBatch.mDstStages = 0;
+
+    VkCommandBufferBeginInfo beginInfo = {};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VkResult res = vkBeginCommandBuffer(mOpenBatch.mCmdBuffer, &beginInfo);
+    assert(res == VK_SUCCESS);
+
+    mRecording = true;
+    return SlvnResult::cOk;
+}
+
+SlvnResult SlvnUploadManager::reserveStaging(VkDeviceSize size, StagingChunk*& chunk)
+{
+    if (!mOpenBatch.mStaging.empty())
+    {
+        chunk = &mOpenBatch.mStaging.back();
+        if (chunk->mUsed + size <= chunk->mSize)
+            return SlvnResult::cOk;
+    }
+
+    // Uploads larger than a chunk get a staging buffer of their own.
+    StagingChunk staging = {};
+    VkBufferCreateInfo info = {};
+    info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    staging.mSize = std::max(size, cStagingChunkSize);
+    info.size = staging.mSize;
+    info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkResult res = vkCreateBuffer(mDevice, &info, nullptr, &staging.mBuffer);
+    assert(res == VK_SUCCESS);
+
+    SlvnResult result = mAllocator->AllocateBuffer(staging.mBuffer, SlvnMemoryUsage::cCpuToGpu, staging.mAllocation,
+        SlvnMemoryCategory::cStaging);
+    if (result != SlvnResult::cOk)
+    {
+        vkDestroyBuffer(mDevice, staging.mBuffer, nullptr);
+        return result;
+    }
+
+    mOpenBatch.mStaging.push_back(staging);
+    chunk = &mOpenBatch.mStaging.back();
+    return SlvnResult::cOk;
+}
+
+void SlvnUploadManager::retire(Batch& batch)
+{
+    for (auto& staging : batch.mStaging)
+    {
+        vkDestroyBuffer(mDevice, staging.mBuffer, nullptr);
+        mAllocator->Free(staging.mAllocation);
+    }
+    batch.mStaging.clear();
+}
+
+} // slvn_tech
@@ -0,0 +1,144 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <slvn_vertex_format.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+inline uint32_t packSnorm16(float value)
+{
+    return static_cast<uint16_t>(static_cast<int16_t>(std::round(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f)));
+}
+
+inline float unpackSnorm16(uint32_t value)
+{
+    return std::max(static_cast<float>(static_cast<int16_t>(value & 0xffff)) / 32767.0f, -1.0f);
+}
+
+inline uint32_t packUnorm16(float value)
+{
+    return static_cast<uint32_t>(std::round(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+inline uint32_t packUnorm8(float value)
+{
+    return static_cast<uint32_t>(std::round(std::min(std::max(value, 0.0f), 1.0f) * 255.0f));
+}
+
+}
+
+uint32_t SlvnEncodeOctahedral(const glm::vec3& normal)
+{
+    float length = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (length == 0.0f)
+        return 0;
+    glm::vec3 n = normal / length;
+    glm::vec2 p(n.x, n.y);
+    if (n.z < 0.0f)
+    {
+        p.x = (1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f);
+        p.y = (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f);
+    }
+    return packSnorm16(p.x) | (packSnorm16(p.y) << 16);
+}
+
+glm::vec3 SlvnDecodeOctahedral(uint32_t packed)
+{
+    glm::vec2 p(unpackSnorm16(packed), unpackSnorm16(packed >> 16));
+    glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+    float t = std::max(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return glm::normalize(n);
+}
+
+void SlvnEncodeVertices(SlvnVertexFormat format, const std::vector<SlvnVertex>& vertices, std::vector<uint8_t>& data,
+    SlvnVertexQuantization* quantization)
+{
+    uint32_t stride = SlvnGetVertexStride(format);
+    data.resize(vertices.size() * stride);
+    if (quantization != nullptr)
+        *quantization = SlvnVertexQuantization();
+    if (format == SlvnVertexFormat::cFloat)
+    {
+        std::memcpy(data.data(), vertices.data(), data.size());
+        return;
+    }
+
+    if (format == SlvnVertexFormat::cQuantized)
+    {
+        glm::vec3 boundsMin(FLT_MAX);
+        glm::vec3 boundsMax(-FLT_MAX);
+        for (const SlvnVertex& vertex : vertices)
+        {
+            boundsMin = glm::min(boundsMin, vertex.mPosition);
+            boundsMax = glm::max(boundsMax, vertex.mPosition);
+        }
+        // Flat axes keep a non-zero scale so that the decode stays finite.
+        glm::vec3 extent = vertices.empty() ? glm::vec3(1.0f) : glm::max(boundsMax - boundsMin, glm::vec3(FLT_MIN));
+        glm::vec3 offset = vertices.empty() ? glm::vec3(0.0f) : boundsMin;
+        if (quantization != nullptr)
+        {
+            quantization->mOffset = offset;
+            quantization->mScale = extent;
+        }
+
+        uint8_t* out = data.data();
+        for (const SlvnVertex& vertex : vertices)
+        {
+            glm::vec3 position = (vertex.mPosition - offset) / extent;
+            uint32_t words[3];
+            words[0] = packUnorm16(position.x) | (packUnorm16(position.y) << 16);
+            words[1] = packUnorm16(position.z);
+            words[2] = SlvnEncodeOctahedral(vertex.mNormal);
+            std::memcpy(out, words, sizeof(words));
+            out += stride;
+        }
+        return;
+    }
+
+    uint8_t* out = data.data();
+    for (const SlvnVertex& vertex : vertices)
+    {
+        uint32_t normal = SlvnEncodeOctahedral(vertex.mNormal);
+        uint32_t color = packUnorm8(vertex.mColor.r) | (packUnorm8(vertex.mColor.g) << 8) | (packUnorm8(vertex.mColor.b) << 16) | (255u << 24);
+        std::memcpy(out, &vertex.mPosition, sizeof(glm::vec3));
+        std::memcpy(out + 12, &normal, sizeof(uint32_t));
+        std::memcpy(out + 16, &color, sizeof(uint32_t));
+        out += stride;
+    }
+}
+
+} // slvn_tech
@@ -0,0 +1,122 @@
+// BSD 2-Clause License
+//
+// Copyright (c) 2021, Antton Jokinen
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//   list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <chrono>
+#include <cstring>
+
+#include <slvn_vertex_weld.h>
+#include <slvn_debug.h>
+
+namespace slvn_tech
+{
+
+namespace
+{
+
+constexpr uint32_t cVertexWords = sizeof(SlvnVertex) / sizeof(uint32_t);
+
+// Negative zero is turned into zero so that the hash agrees with float comparison.
+inline uint32_t hashVertex(const SlvnVertex& vertex)
+{
+    const float* values = &vertex.mPosition.x;
+    uint32_t hash = 2166136261u;
+    for (uint32_t i = 0; i < cVertexWords; i++)
+    {
+        float value = values[i] == 0.0f ? 0.0f : values[i];
+        uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        hash = (hash ^ word) * 0x9E3779B1u;
+        hash ^= hash >> 15;
+    }
+    return hash;
+}
+
+inline bool isEqual(const SlvnVertex& a, const SlvnVertex& b)
+{
+    return a.mPosition == b.mPosition && a.mNormal == b.mNormal && a.mColor == b.mColor;
+}
+
+}
+
+SlvnVertexWelder::SlvnVertexWelder() : mStats()
+{
+}
+
+SlvnVertexWelder::~SlvnVertexWelder()
+{
+}
+
+SlvnResult SlvnVertexWelder::Weld(std::vector<SlvnVertex>& vertices, std::vector<uint32_t>& indices)
+{
+    static_assert(sizeof(SlvnVertex) == cVertexWords * sizeof(uint32_t), "SlvnVertex is hashed as 32-bit words");
+    auto start = std::chrono::high_resolution_clock::now();
+
+    uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+    for (uint32_t index : indices)
+    {
+        if (index >= vertexCount)
+        {
+            SLVN_PRINT("ERROR; index " << index << " is out of range");
+            return SlvnResult::cUnexpectedError;
+        }
+    }
+
+    uint32_t tableSize = 16;
+    while (tableSize < vertexCount * 2)
+        tableSize *= 2;
+    uint32_t mask = tableSize - 1;
+    mTable.assign(tableSize, cEmpty);
+    mRemap.resize(vertexCount);
+
+    // Unique vertices are moved down as they are found, the table points at their new place.
+    uint32_t uniqueCount = 0;
+    for (uint32_t v = 0; v < vertexCount; v++)
+    {
+        uint32_t slot = hashVertex(vertices[v]) & mask;
+        while (mTable[slot] != cEmpty && !isEqual(vertices[mTable[slot]], vertices[v]))
+            slot = (slot + 1) & mask;
+
+        if (mTable[slot] == cEmpty)
+        {
+            mTable[slot] = uniqueCount;
+            vertices[uniqueCount++] = vertices[v];
+        }
+        mRemap[v] = mTable[slot];
+    }
+    vertices.resize(uniqueCount);
+
+    for (uint32_t& index : indices)
+    {
+        index = mRemap[index];
+    }
+
+    mStats.mInputVertexCount = vertexCount;
+    mStats.mOutputVertexCount = uniqueCount;
+    mStats.mWeldMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return SlvnResult::cOk;
+}
+
+} // slvn_tech
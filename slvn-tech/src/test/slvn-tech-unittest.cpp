@@ -1,11 +1,44 @@
 #include "pch.h"
 
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
 #include <vulkan/vulkan.h>
 
 #include <slvn_render_engine.h>
 #include <slvn_instance.h>
 #include <slvn_device.h>
 #include <slvn_device_manager.h>
+#include <slvn_bvh.h>
+#include <slvn_occlusion_culler.h>
+#include <slvn_lod.h>
+#include <slvn_draw_packet.h>
+#include <slvn_command_encoder.h>
+#include <slvn_command_pool.h>
+#include <slvn_tlsf.h>
+#include <slvn_frame_ring.h>
+#include <slvn_deletion_queue.h>
+#include <slvn_scene_buffer.h>
+#include <slvn_vertex_format.h>
+#include <slvn_obj_parser.h>
+#include <slvn_vertex_weld.h>
+#include <slvn_mesh_cache.h>
+#include <slvn_mesh_optimizer.h>
+#include <slvn_simplifier.h>
+#include <slvn_meshlet.h>
+#include <slvn_memory_allocator.h>
+#include <slvn_memory_reporter.h>
+#include <slvn_upload_manager.h>
+#include <slvn_defragmenter.h>
+#include <slvn_buffer.h>
+#include <slvn_geometry_pool.h>
+#include <slvn_mesh_streamer.h>
+#include <slvn_asset_pipeline.h>
+#include <slvn_asset_manager.h>
 #include <core.h>
 
 using ::testing::AtLeast;
@@ -14,6 +47,106 @@ using ::testing::Return;
 namespace slvn_tech
 {
 
+namespace
+{
+
+// Host visible geometry pool on the primary device. Its meshes are written directly, so upload
+// batches are complete as soon as they are submitted and frames can be stepped without rendering.
+struct SlvnGeometryTestContext
+{
+	SlvnInstance mInstance;
+	SlvnDeviceManager mDeviceManager;
+	SlvnMemoryAllocator mAllocator;
+	SlvnUploadManager mUploader;
+	SlvnDeletionQueue mDeletionQueue;
+	SlvnGeometryPool mPool;
+
+	void Initialize(uint32_t vertexCapacity, uint32_t indexCapacity)
+	{
+		SlvnResult result = mInstance.Initialize();
+		SLVN_ASSERT_RESULT(result);
+		result = mDeviceManager.Initialize(mInstance.mVkInstance);
+		SLVN_ASSERT_RESULT(result);
+		SlvnDevice* device = mDeviceManager.GetPrimaryDevice();
+
+		result = mAllocator.Initialize(device->mLogicalDevice, device->mPhysicalDevice);
+		SLVN_ASSERT_RESULT(result);
+		VkQueue transferQueue;
+		result = device->GetTransferQueue(transferQueue);
+		SLVN_ASSERT_RESULT(result);
+		result = mUploader.Initialize(device->mLogicalDevice, &mAllocator, transferQueue, device->GetTransferQueueFamilyIndex(),
+			device->GetViableQueueFamilyIndex());
+		SLVN_ASSERT_RESULT(result);
+		result = mDeletionQueue.Initialize(device->mLogicalDevice, &mAllocator);
+		SLVN_ASSERT_RESULT(result);
+		result = mPool.Initialize(device->mLogicalDevice, &mAllocator, &mUploader, sizeof(SlvnVertex), vertexCapacity, indexCapacity, false);
+		SLVN_ASSERT_RESULT(result);
+	}
+
+	void Deinitialize()
+	{
+		mDeletionQueue.Deinitialize();
+		mPool.Deinitialize();
+		mUploader.Deinitialize();
+		mAllocator.Deinitialize();
+		for (auto& device : mDeviceManager.mDevices)
+		{
+			device->Deinitialize();
+		}
+		mDeviceManager.Deinitialize();
+		mInstance.Deinitialize();
+	}
+};
+
+// Loads a mesh of vertexCount vertices and three indices per vertex.
+SlvnMeshLoader makeTestMeshLoader(uint32_t vertexCount)
+{
+	return [vertexCount](SlvnStreamedMeshData& data)
+	{
+		std::vector<SlvnVertex> vertices(vertexCount);
+		data.mVertices.resize(vertexCount * sizeof(SlvnVertex));
+		std::memcpy(data.mVertices.data(), vertices.data(), data.mVertices.size());
+		data.mVertexCount = vertexCount;
+		data.mIndices.resize(vertexCount * 3);
+		for (uint32_t i = 0; i < data.mIndices.size(); i++)
+		{
+			data.mIndices[i] = i % vertexCount;
+		}
+		data.mFormat = SlvnVertexFormat::cFloat;
+		data.mQuantization = SlvnVertexQuantization();
+		return SlvnResult::cOk;
+	};
+}
+
+// Writes a quad to the temp directory, the mesh cache of the first load goes next to it.
+std::string writeTestObj(const std::string& name)
+{
+	std::filesystem::path path = std::filesystem::temp_directory_path() / name;
+	std::ofstream file(path, std::ios::binary);
+	file << "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1 4//1\n";
+	return path.string();
+}
+
+void removeTestObj(const std::string& path)
+{
+	std::filesystem::remove(path);
+	std::filesystem::remove(SlvnMeshCache::GetCachePath(path));
+}
+
+// Steps frames until the condition holds; the worker stages run on their own threads.
+template <typename Condition>
+bool stepAssetFrames(SlvnAssetPipeline& pipeline, uint64_t& frame, Condition condition)
+{
+	for (uint32_t attempt = 0; attempt < 5000 && !condition(); attempt++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		pipeline.BeginFrame(++frame);
+	}
+	return condition();
+}
+
+}
+
 TEST(SLVN_TECH_UT_GRAPHICS_RENDER_ENGINE, 001)
 {
 	const uint8_t engineIdentifier = 1;
@@ -22,6 +155,1336 @@ TEST(SLVN_TECH_UT_GRAPHICS_RENDER_ENGINE, 001)
 	EXPECT_EQ(engine.GetIdentifier(), engineIdentifier);
 	engine.Deinitialize();
 }
+TEST(SLVN_TECH_UT_BVH, 001)
+{
+	SlvnBvh bvh;
+	std::vector<uint32_t> proxies;
+	for (int x = 0; x < 32; x++)
+	{
+		for (int z = 0; z < 32; z++)
+		{
+			SlvnAabb box;
+			box.mMin = glm::vec3(x * 4.0f, 0.0f, z * 4.0f);
+			box.mMax = box.mMin + glm::vec3(1.0f);
+			proxies.push_back(bvh.Insert(box));
+		}
+	}
+	bvh.Rebuild();
+
+	SlvnAabb query;
+	query.mMin = glm::vec3(-0.5f, -0.5f, -0.5f);
+	query.mMax = glm::vec3(8.5f, 0.5f, 8.5f);
+	std::vector<uint32_t> result;
+	bvh.QueryAabb(query, result);
+	EXPECT_EQ(result.size(), 9);
+
+	// Moving a proxy out of the query region must be picked up by a refit.
+	SlvnAabb moved;
+	moved.mMin = glm::vec3(-100.0f);
+	moved.mMax = glm::vec3(-99.0f);
+	bvh.Update(proxies[0], moved);
+	bvh.Refit();
+	result.clear();
+	bvh.QueryAabb(query, result);
+	EXPECT_EQ(result.size(), 8);
+
+	std::optional<SlvnBvhRayHit> hit = bvh.Raycast(SlvnRay(glm::vec3(0.5f, 0.5f, -10.0f), glm::vec3(0.0f, 0.0f, 1.0f)), 1000.0f);
+	ASSERT_TRUE(hit.has_value());
+	EXPECT_EQ(hit->mProxy, proxies[1]);
+}
+TEST(SLVN_TECH_UT_BVH, 002)
+{
+	// Two identical trees, one refit along the moved paths and one swept whole.
+	SlvnBvh incremental;
+	SlvnBvh swept;
+	std::vector<SlvnAabb> boxes;
+	for (int x = 0; x < 32; x++)
+	{
+		for (int z = 0; z < 32; z++)
+		{
+			SlvnAabb box;
+			box.mMin = glm::vec3(x * 4.0f, 0.0f, z * 4.0f);
+			box.mMax = box.mMin + glm::vec3(1.0f);
+			boxes.push_back(box);
+			incremental.Insert(box);
+			swept.Insert(box);
+		}
+	}
+	incremental.Rebuild();
+	swept.Rebuild();
+
+	SlvnAabb moved;
+	moved.mMin = glm::vec3(200.0f, 0.0f, 200.0f);
+	moved.mMax = glm::vec3(203.0f);
+	for (uint32_t proxy = 0; proxy < boxes.size(); proxy++)
+	{
+		if (proxy % 300 == 0)
+		{
+			incremental.Update(proxy, moved);
+			swept.Update(proxy, moved);
+		}
+		else
+		{
+			swept.Update(proxy, boxes[proxy]);
+		}
+	}
+	incremental.Refit();
+	swept.Refit();
+	EXPECT_GT(incremental.GetStats().mCurrentCost, incremental.GetStats().mBuildCost);
+	EXPECT_NEAR(incremental.GetStats().mCurrentCost, swept.GetStats().mCurrentCost, swept.GetStats().mCurrentCost * 1e-4f);
+
+	// Every proxy is listed once however often it is updated, and a refit leaves nothing dirty behind.
+	for (int i = 0; i < 4; i++)
+	{
+		incremental.Update(1, moved);
+	}
+	incremental.Refit();
+	float cost = incremental.GetStats().mCurrentCost;
+	incremental.Refit();
+	EXPECT_EQ(incremental.GetStats().mCurrentCost, cost);
+
+	std::vector<uint32_t> result;
+	incremental.QueryAabb(moved, result);
+	EXPECT_EQ(result.size(), 5);
+}
+TEST(SLVN_TECH_UT_OCCLUSION, 001)
+{
+	SlvnThreadpool threadpool;
+	threadpool.SetThreadCount(2);
+	SlvnOcclusionCuller culler;
+	SlvnResult result = culler.Initialize(320, 180, &threadpool);
+	EXPECT_EQ(static_cast<int>(result), static_cast<int>(SlvnResult::cOk));
+
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 16.0f / 9.0f, 1.0f, 1000.0f);
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, -50.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	std::vector<glm::vec3> positions = { { -10.0f, -10.0f, 0.0f }, { 10.0f, -10.0f, 0.0f }, { 10.0f, 10.0f, 0.0f }, { -10.0f, 10.0f, 0.0f } };
+	std::vector<uint32_t> indices = { 0, 1, 2, 0, 2, 3 };
+
+	culler.BeginFrame(projection * view);
+	culler.AddOccluder(positions, indices, 0, static_cast<uint32_t>(indices.size()), glm::mat4(1.0f));
+	culler.Rasterize();
+
+	SlvnAabb behind;
+	behind.mMin = glm::vec3(-2.0f, -2.0f, 18.0f);
+	behind.mMax = glm::vec3(2.0f, 2.0f, 22.0f);
+	SlvnAabb inFront;
+	inFront.mMin = glm::vec3(-2.0f, -2.0f, -12.0f);
+	inFront.mMax = glm::vec3(2.0f, 2.0f, -8.0f);
+	SlvnAabb beside;
+	beside.mMin = glm::vec3(23.0f, -2.0f, 18.0f);
+	beside.mMax = glm::vec3(27.0f, 2.0f, 22.0f);
+	EXPECT_FALSE(culler.IsVisible(behind));
+	EXPECT_TRUE(culler.IsVisible(inFront));
+	EXPECT_TRUE(culler.IsVisible(beside));
+	EXPECT_EQ(culler.GetStats().mCulledCount, 1);
+
+	culler.Deinitialize();
+}
+TEST(SLVN_TECH_UT_LOD, 001)
+{
+	SlvnLodMesh mesh;
+	mesh.mLevels.push_back({ 0, 300, 0.0f, 0, 0 });
+	mesh.mLevels.push_back({ 300, 90, 0.1f, 0, 0 });
+	mesh.mLevels.push_back({ 390, 30, 0.4f, 0, 0 });
+
+	SlvnLodSelector selector;
+	selector.mPixelThreshold = 1.0f;
+	selector.mHysteresis = 0.25f;
+	selector.SetProjection(90.0f, 1080.0f);
+
+	EXPECT_EQ(selector.SelectLevel(mesh, 60.0f, 1.0f, 0), 0);
+	EXPECT_EQ(selector.SelectLevel(mesh, 80.0f, 1.0f, 0), 1);
+	// Inside the hysteresis band the current level is kept.
+	EXPECT_EQ(selector.SelectLevel(mesh, 60.0f, 1.0f, 1), 1);
+	EXPECT_EQ(selector.SelectLevel(mesh, 40.0f, 1.0f, 1), 0);
+	EXPECT_EQ(selector.SelectLevel(mesh, 1000.0f, 1.0f, 0), 2);
+
+	// Grid of 64x64 quads simplifies into progressively smaller index ranges.
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= 64; y++)
+	{
+		for (uint32_t x = 0; x <= 64; x++)
+		{
+			vertices.push_back(SlvnVertex(glm::vec3(x, y, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	}
+	for (uint32_t y = 0; y < 64; y++)
+	{
+		for (uint32_t x = 0; x < 64; x++)
+		{
+			uint32_t a = y * 65 + x;
+			indices.insert(indices.end(), { a, a + 1, a + 65, a + 1, a + 66, a + 65 });
+		}
+	}
+	SlvnLodMesh gridMesh;
+	SlvnResult result = SlvnMeshSimplifier::BuildLodChain(vertices, indices, { 1.0f, 0.5f, 0.25f, 0.125f }, 1.0f, gridMesh);
+	EXPECT_EQ(static_cast<int>(result), static_cast<int>(SlvnResult::cOk));
+	ASSERT_GT(gridMesh.mLevels.size(), 1);
+	for (size_t i = 1; i < gridMesh.mLevels.size(); i++)
+	{
+		EXPECT_LT(gridMesh.mLevels[i].mIndexCount, gridMesh.mLevels[i - 1].mIndexCount);
+		EXPECT_GE(gridMesh.mLevels[i].mError, gridMesh.mLevels[i - 1].mError);
+		EXPECT_EQ(gridMesh.mLevels[i].mFirstIndex, gridMesh.mLevels[i - 1].mFirstIndex + gridMesh.mLevels[i - 1].mIndexCount);
+	}
+	EXPECT_EQ(indices.size(), gridMesh.mLevels.back().mFirstIndex + gridMesh.mLevels.back().mIndexCount);
+}
+TEST(SLVN_TECH_UT_DRAW_SORT, 001)
+{
+	std::vector<SlvnDrawPacket> packets;
+	packets.push_back({ SlvnDrawKey::Transparent(0, 0, 0, 0.2f), 0, 0, 0, 0, 0, 0, 0 });
+	packets.push_back({ SlvnDrawKey::Opaque(1, 0, 0, 0.1f), 0, 1, 0, 0, 0, 0, 0 });
+	packets.push_back({ SlvnDrawKey::Opaque(0, 0, 0, 0.9f), 0, 2, 0, 0, 0, 0, 0 });
+	packets.push_back({ SlvnDrawKey::Transparent(0, 0, 0, 0.8f), 0, 3, 0, 0, 0, 0, 0 });
+	packets.push_back({ SlvnDrawKey::Opaque(0, 0, 0, 0.3f), 0, 4, 0, 0, 0, 0, 0 });
+
+	SlvnDrawSorter sorter;
+	sorter.Sort(packets, nullptr);
+
+	// Opaque grouped by state and front to back, then transparent back to front.
+	const uint32_t expected[] = { 4, 2, 1, 3, 0 };
+	for (uint32_t i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(packets[i].mObject, expected[i]);
+	}
+
+	SlvnDrawStats stats = sorter.CountStateChanges(packets);
+	EXPECT_EQ(stats.mPacketCount, 5);
+	EXPECT_EQ(stats.mPipelineChanges, 3);
+	EXPECT_EQ(SlvnDrawKey::GetPipeline(packets[2].mKey), 1);
+}
+TEST(SLVN_TECH_UT_COMMAND_ENCODER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 1024);
+	SlvnDevice* device = context.mDeviceManager.GetPrimaryDevice();
+
+	SlvnCommandPool cmdPool;
+	SlvnResult result = cmdPool.Initialize(device->mLogicalDevice, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, device->GetViableQueueFamilyIndex());
+	SLVN_ASSERT_RESULT(result);
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = cmdPool.mVkCmdPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	VkCommandBuffer cmdBuffer;
+	ASSERT_EQ(vkAllocateCommandBuffers(device->mLogicalDevice, &allocateInfo, &cmdBuffer), VK_SUCCESS);
+
+	VkPushConstantRange pushConstantRange = {};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::mat4);
+	VkPipelineLayoutCreateInfo layoutInfo = {};
+	layoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	layoutInfo.pushConstantRangeCount = 1;
+	layoutInfo.pPushConstantRanges = &pushConstantRange;
+	VkPipelineLayout layout;
+	ASSERT_EQ(vkCreatePipelineLayout(device->mLogicalDevice, &layoutInfo, nullptr, &layout), VK_SUCCESS);
+
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	ASSERT_EQ(vkBeginCommandBuffer(cmdBuffer, &beginInfo), VK_SUCCESS);
+
+	SlvnCommandEncoder encoder;
+	auto issued = [&](SlvnEncoderCall call) { return encoder.GetStats().mIssued[static_cast<uint32_t>(call)]; };
+	auto elided = [&](SlvnEncoderCall call) { return encoder.GetStats().mElided[static_cast<uint32_t>(call)]; };
+	encoder.Begin(cmdBuffer);
+
+	VkViewport viewport = { 0.0f, 0.0f, 1920.0f, 1080.0f, 0.0f, 1.0f };
+	encoder.SetViewport(viewport);
+	encoder.SetViewport(viewport);
+	viewport.width = 1280.0f;
+	encoder.SetViewport(viewport);
+	EXPECT_EQ(issued(SlvnEncoderCall::cSetViewport), 2);
+	EXPECT_EQ(elided(SlvnEncoderCall::cSetViewport), 1);
+
+	encoder.BindVertexBuffer(context.mPool.GetVertexBuffer(), 0);
+	encoder.BindVertexBuffer(context.mPool.GetVertexBuffer(), 0);
+	encoder.BindVertexBuffer(context.mPool.GetVertexBuffer(), sizeof(SlvnVertex));
+	encoder.BindIndexBuffer(context.mPool.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	encoder.BindIndexBuffer(context.mPool.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	encoder.BindIndexBuffer(context.mPool.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
+	EXPECT_EQ(issued(SlvnEncoderCall::cBindVertexBuffer), 2);
+	EXPECT_EQ(elided(SlvnEncoderCall::cBindVertexBuffer), 1);
+	EXPECT_EQ(issued(SlvnEncoderCall::cBindIndexBuffer), 2);
+	EXPECT_EQ(elided(SlvnEncoderCall::cBindIndexBuffer), 1);
+
+	// Push constants are compared by contents, not by the pointer they come from.
+	glm::mat4 first(1.0f);
+	glm::mat4 second(1.0f);
+	encoder.PushConstants(layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &first);
+	encoder.PushConstants(layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &second);
+	EXPECT_EQ(issued(SlvnEncoderCall::cPushConstants), 1);
+	EXPECT_EQ(elided(SlvnEncoderCall::cPushConstants), 1);
+	second[3][0] = 1.0f;
+	encoder.PushConstants(layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &second);
+	encoder.PushConstants(layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &first);
+	EXPECT_EQ(issued(SlvnEncoderCall::cPushConstants), 3);
+	EXPECT_EQ(elided(SlvnEncoderCall::cPushConstants), 1);
+
+	// Draws are never elided.
+	encoder.DrawIndexed(3, 0, 0);
+	encoder.DrawIndexed(3, 0, 0);
+	EXPECT_EQ(issued(SlvnEncoderCall::cDrawIndexed), 2);
+	EXPECT_EQ(elided(SlvnEncoderCall::cDrawIndexed), 0);
+	EXPECT_EQ(encoder.GetStats().GetIssued(), 11);
+	EXPECT_EQ(encoder.GetStats().GetElided(), 4);
+
+	// After Begin nothing counts as bound, the same state is issued again.
+	encoder.Begin(cmdBuffer);
+	encoder.SetViewport(viewport);
+	encoder.BindVertexBuffer(context.mPool.GetVertexBuffer(), sizeof(SlvnVertex));
+	encoder.BindIndexBuffer(context.mPool.GetIndexBuffer(), 0, VK_INDEX_TYPE_UINT16);
+	encoder.PushConstants(layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &first);
+	EXPECT_EQ(encoder.GetStats().GetIssued(), 15);
+	EXPECT_EQ(encoder.GetStats().GetElided(), 4);
+	encoder.ResetStats();
+	EXPECT_EQ(encoder.GetStats().GetIssued(), 0);
+	EXPECT_EQ(encoder.GetStats().GetElided(), 0);
+
+	EXPECT_EQ(vkEndCommandBuffer(cmdBuffer), VK_SUCCESS);
+	vkDestroyPipelineLayout(device->mLogicalDevice, layout, nullptr);
+	vkFreeCommandBuffers(device->mLogicalDevice, cmdPool.mVkCmdPool, 1, &cmdBuffer);
+	cmdPool.Deinitialize(device->mLogicalDevice);
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_TLSF, 001)
+{
+	SlvnTlsfAllocator tlsf;
+	tlsf.Initialize(1024 * 1024);
+
+	uint64_t a, b, c;
+	uint32_t first = tlsf.Allocate(100, 256, a);
+	uint32_t second = tlsf.Allocate(1000, 4096, b);
+	uint32_t third = tlsf.Allocate(64 * 1024, 16, c);
+	ASSERT_NE(first, SlvnTlsfAllocator::cInvalid);
+	ASSERT_NE(second, SlvnTlsfAllocator::cInvalid);
+	ASSERT_NE(third, SlvnTlsfAllocator::cInvalid);
+	EXPECT_EQ(a % 256, 0);
+	EXPECT_EQ(b % 4096, 0);
+	auto disjoint = [](uint64_t x, uint64_t xSize, uint64_t y, uint64_t ySize) { return x + xSize <= y || y + ySize <= x; };
+	EXPECT_TRUE(disjoint(a, 100, b, 1000));
+	EXPECT_TRUE(disjoint(b, 1000, c, 64 * 1024));
+	EXPECT_TRUE(disjoint(a, 100, c, 64 * 1024));
+
+	uint64_t tooLarge;
+	EXPECT_EQ(tlsf.Allocate(2 * 1024 * 1024, 16, tooLarge), SlvnTlsfAllocator::cInvalid);
+
+	// Freeing everything merges the regions back into one.
+	tlsf.Free(second);
+	tlsf.Free(first);
+	tlsf.Free(third);
+	SlvnTlsfStats stats = tlsf.GetStats();
+	EXPECT_TRUE(tlsf.IsEmpty());
+	EXPECT_EQ(stats.mUsed, 0);
+	EXPECT_EQ(stats.mFreeRegionCount, 1);
+	EXPECT_EQ(stats.mLargestFreeRegion, 1024 * 1024);
+}
+TEST(SLVN_TECH_UT_FRAME_RING, 001)
+{
+	SlvnFrameRegion region;
+	region.mCapacity = 1024;
+
+	uint64_t a, b, c;
+	ASSERT_TRUE(region.Allocate(100, 256, a));
+	ASSERT_TRUE(region.Allocate(100, 256, b));
+	EXPECT_EQ(a, 0);
+	EXPECT_EQ(b, 256);
+	EXPECT_FALSE(region.Allocate(800, 256, c));
+	ASSERT_TRUE(region.Allocate(400, 16, c));
+	EXPECT_EQ(c, 368);
+
+	// Reset hands out the region from the start again and keeps the high water mark.
+	region.Reset();
+	ASSERT_TRUE(region.Allocate(1024, 256, a));
+	EXPECT_EQ(a, 0);
+	EXPECT_EQ(region.mHighWater, 768);
+}
+TEST(SLVN_TECH_UT_DELETION_QUEUE, 001)
+{
+	SlvnDeletionQueue queue;
+	queue.Initialize(VK_NULL_HANDLE, nullptr);
+
+	std::vector<uint32_t> destroyed;
+	queue.Defer(1, [&] { destroyed.push_back(1); });
+	queue.Defer(2, [&] { destroyed.push_back(2); });
+	queue.Defer(3, [&] { destroyed.push_back(3); });
+
+	// Nothing goes before the GPU has passed its last use.
+	EXPECT_EQ(queue.Collect(0), 0);
+	EXPECT_EQ(queue.Collect(2), 2);
+	ASSERT_EQ(destroyed.size(), 2);
+	EXPECT_EQ(destroyed[0], 1);
+	EXPECT_EQ(destroyed[1], 2);
+	EXPECT_EQ(queue.GetPendingCount(), 1);
+
+	queue.Deinitialize();
+	EXPECT_EQ(destroyed.size(), 3);
+	EXPECT_EQ(queue.GetPendingCount(), 0);
+}
+TEST(SLVN_TECH_UT_SCENE_BUFFER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 1024);
+	SlvnDevice* device = context.mDeviceManager.GetPrimaryDevice();
+
+	// A frame of the ring holds fewer than 16 dirty records with their slots.
+	SlvnFrameRing frameRing;
+	SlvnResult result = frameRing.Initialize(device->mLogicalDevice, device->mPhysicalDevice, &context.mAllocator, 1, 1024,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+	SLVN_ASSERT_RESULT(result);
+	SlvnSceneBuffer sceneBuffer;
+	result = sceneBuffer.Initialize(device->mLogicalDevice, &context.mAllocator, &frameRing, 32);
+	SLVN_ASSERT_RESULT(result);
+
+	// Updating a record twice keeps one dirty entry holding the latest data.
+	SlvnInstanceRecord data = {};
+	data.mColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+	sceneBuffer.Update(3, data);
+	data.mColor = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+	sceneBuffer.Update(3, data);
+	EXPECT_EQ(sceneBuffer.GetDirtyCount(), 1);
+	EXPECT_EQ(sceneBuffer.Get(3).mColor, data.mColor);
+	for (uint32_t i = 16; i < 31; i++)
+		sceneBuffer.Update(i, data);
+	EXPECT_EQ(sceneBuffer.GetDirtyCount(), 16);
+
+	// A flush the ring has no room for records nothing and keeps every record dirty.
+	frameRing.BeginFrame(0);
+	EXPECT_EQ(sceneBuffer.Flush(VK_NULL_HANDLE, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT), SlvnResult::cOutOfMemory);
+	EXPECT_EQ(sceneBuffer.GetDirtyCount(), 16);
+	EXPECT_EQ(sceneBuffer.GetStats().mDirtyCount, 16);
+	EXPECT_EQ(sceneBuffer.GetStats().mUploadedBytes, 0);
+	EXPECT_EQ(sceneBuffer.GetStats().mFailedFlushes, 1);
+	sceneBuffer.Update(3, data);
+	EXPECT_EQ(sceneBuffer.GetDirtyCount(), 16);
+
+	sceneBuffer.Deinitialize();
+	frameRing.Deinitialize();
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_UPLOAD_MANAGER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 1024);
+	SlvnDevice* device = context.mDeviceManager.GetPrimaryDevice();
+	SlvnUploadManager& uploader = context.mUploader;
+	EXPECT_EQ(uploader.IsDedicatedQueue(), device->GetTransferQueueFamilyIndex() != device->GetViableQueueFamilyIndex());
+
+	// Host readable destination, so the copies can be checked.
+	std::vector<uint32_t> data(1024);
+	for (uint32_t i = 0; i < data.size(); i++)
+	{
+		data[i] = i * 7 + 1;
+	}
+	const uint32_t size = static_cast<uint32_t>(data.size() * sizeof(uint32_t));
+	SlvnBuffer destination(&device->mLogicalDevice, size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_SHARING_MODE_EXCLUSIVE);
+	SlvnResult result = destination.Allocate(&context.mAllocator, SlvnMemoryUsage::cGpuToCpu);
+	SLVN_ASSERT_RESULT(result);
+
+	SlvnCommandPool cmdPool;
+	result = cmdPool.Initialize(device->mLogicalDevice, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, device->GetViableQueueFamilyIndex());
+	SLVN_ASSERT_RESULT(result);
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = cmdPool.mVkCmdPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	VkCommandBuffer cmdBuffer;
+	ASSERT_EQ(vkAllocateCommandBuffers(device->mLogicalDevice, &allocateInfo, &cmdBuffer), VK_SUCCESS);
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	ASSERT_EQ(vkBeginCommandBuffer(cmdBuffer, &beginInfo), VK_SUCCESS);
+
+	// Both halves go into the open batch and share one staging chunk.
+	uint64_t batch = uploader.GetOpenBatch();
+	EXPECT_EQ(uploader.Upload(destination.GetBuffer(), 0, data.data(), size / 2, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT), SlvnResult::cOk);
+	EXPECT_EQ(uploader.Upload(destination.GetBuffer(), size / 2, data.data() + data.size() / 2, size / 2, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT), SlvnResult::cOk);
+	EXPECT_EQ(uploader.GetOpenBatch(), batch);
+	EXPECT_EQ(context.mAllocator.GetCategoryUsage(SlvnMemoryCategory::cStaging).mCurrent, SlvnUploadManager::cStagingChunkSize);
+	EXPECT_EQ(uploader.Submit(), batch);
+	EXPECT_EQ(uploader.GetOpenBatch(), batch + 1);
+	// Nothing pending, the last batch is returned again.
+	EXPECT_EQ(uploader.Submit(), batch);
+
+	// A finished batch only completes once its acquire is recorded, which also frees its staging memory.
+	uploader.Wait(batch);
+	EXPECT_FALSE(uploader.IsComplete(batch));
+	uploader.RecordAcquire(cmdBuffer);
+	EXPECT_TRUE(uploader.IsComplete(batch));
+	EXPECT_EQ(context.mAllocator.GetCategoryUsage(SlvnMemoryCategory::cStaging).mCurrent, 0);
+	EXPECT_EQ(std::memcmp(destination.GetAllocation().mMapped, data.data(), size), 0);
+
+	// Uploads larger than a chunk get staging of their own; the retired batch is reused.
+	std::vector<uint8_t> large(SlvnUploadManager::cStagingChunkSize + 256, 0x5a);
+	SlvnBuffer largeDestination(&device->mLogicalDevice, static_cast<uint32_t>(large.size()), VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_SHARING_MODE_EXCLUSIVE);
+	result = largeDestination.Allocate(&context.mAllocator, SlvnMemoryUsage::cGpuOnly);
+	SLVN_ASSERT_RESULT(result);
+	EXPECT_EQ(uploader.Upload(largeDestination.GetBuffer(), 0, large.data(), large.size(), VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT), SlvnResult::cOk);
+	EXPECT_GE(context.mAllocator.GetCategoryUsage(SlvnMemoryCategory::cStaging).mCurrent, large.size());
+	EXPECT_EQ(uploader.Submit(), batch + 1);
+	uploader.Wait(batch + 1);
+	uploader.RecordAcquire(cmdBuffer);
+	EXPECT_TRUE(uploader.IsComplete(batch + 1));
+	EXPECT_EQ(context.mAllocator.GetCategoryUsage(SlvnMemoryCategory::cStaging).mCurrent, 0);
+
+	EXPECT_EQ(vkEndCommandBuffer(cmdBuffer), VK_SUCCESS);
+	vkFreeCommandBuffers(device->mLogicalDevice, cmdPool.mVkCmdPool, 1, &cmdBuffer);
+	cmdPool.Deinitialize(device->mLogicalDevice);
+	largeDestination.Deinitialize(&device->mLogicalDevice);
+	destination.Deinitialize(&device->mLogicalDevice);
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_MEMORY_ALLOCATOR, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 1024);
+	SlvnDevice* device = context.mDeviceManager.GetPrimaryDevice();
+
+	// Allocator of its own with smallBuffer blocks, so a buffer above half a block is dedicated.
+	const VkDeviceSize blockSize = 1024 * 1024;
+	SlvnMemoryAllocator allocator;
+	SlvnResult result = allocator.Initialize(device->mLogicalDevice, device->mPhysicalDevice, blockSize);
+	SLVN_ASSERT_RESULT(result);
+
+	SlvnBuffer smallBuffer(&device->mLogicalDevice, 4096, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE);
+	SlvnBuffer largeBuffer(&device->mLogicalDevice, 768 * 1024, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_SHARING_MODE_EXCLUSIVE);
+
+	// Category and heap counters follow the allocations, the heap in units of VkDeviceMemory.
+	result = smallBuffer.Allocate(&allocator, SlvnMemoryUsage::cCpuToGpu, SlvnMemoryCategory::cFrame);
+	SLVN_ASSERT_RESULT(result);
+	uint32_t heap = allocator.GetMemoryProperties().memoryTypes[smallBuffer.GetAllocation().mMemoryType].heapIndex;
+	VkDeviceSize smallBytes = smallBuffer.GetAllocation().mSize;
+	EXPECT_EQ(allocator.GetCategoryUsage(SlvnMemoryCategory::cFrame).mCurrent, smallBytes);
+	SlvnHeapBudget before = allocator.GetHeapBudget(heap);
+	EXPECT_EQ(before.mAllocated.mCurrent, smallBuffer.GetAllocation().IsDedicated() ? smallBytes : blockSize);
+
+	result = largeBuffer.Allocate(&allocator, SlvnMemoryUsage::cCpuToGpu, SlvnMemoryCategory::cFrame);
+	SLVN_ASSERT_RESULT(result);
+	VkDeviceSize largeBytes = largeBuffer.GetAllocation().mSize;
+	EXPECT_TRUE(largeBuffer.GetAllocation().IsDedicated());
+	EXPECT_EQ(allocator.GetCategoryUsage(SlvnMemoryCategory::cFrame).mCurrent, smallBytes + largeBytes);
+	SlvnHeapBudget after = allocator.GetHeapBudget(heap);
+	EXPECT_EQ(after.mAllocated.mCurrent, before.mAllocated.mCurrent + largeBytes);
+	// Usage between driver queries is estimated from what was allocated since.
+	EXPECT_EQ(after.mUsage, before.mUsage + largeBytes);
+
+	largeBuffer.Deinitialize(&device->mLogicalDevice);
+	EXPECT_EQ(allocator.GetCategoryUsage(SlvnMemoryCategory::cFrame).mCurrent, smallBytes);
+	EXPECT_EQ(allocator.GetCategoryUsage(SlvnMemoryCategory::cFrame).mPeak, smallBytes + largeBytes);
+	after = allocator.GetHeapBudget(heap);
+	EXPECT_EQ(after.mAllocated.mCurrent, before.mAllocated.mCurrent);
+	EXPECT_EQ(after.mAllocated.mPeak, before.mAllocated.mCurrent + largeBytes);
+	EXPECT_EQ(after.mUsage, before.mUsage);
+
+	EXPECT_TRUE(allocator.IsNearBudget(SlvnMemoryUsage::cCpuToGpu, 0.0f));
+	EXPECT_EQ(allocator.IsNearBudget(SlvnMemoryUsage::cCpuToGpu),
+		after.mUsage >= static_cast<VkDeviceSize>(after.mBudget * static_cast<double>(SlvnMemoryAllocator::cBudgetWarning)));
+
+	// The report row holds the same counters: four columns per heap, then current and peak per category.
+	std::string path = (std::filesystem::temp_directory_path() / "slvn_memory_report.csv").string();
+	SlvnMemoryReporter reporter;
+	result = reporter.Initialize(&allocator, path);
+	SLVN_ASSERT_RESULT(result);
+	reporter.Report(7);
+	reporter.Deinitialize();
+
+	std::ifstream file(path);
+	std::string header;
+	std::string row;
+	std::getline(file, header);
+	std::getline(file, row);
+	file.close();
+	std::filesystem::remove(path);
+	std::vector<std::string> columns;
+	std::stringstream stream(row);
+	for (std::string column; std::getline(stream, column, ',');)
+	{
+		columns.push_back(column);
+	}
+	uint32_t heapCount = allocator.GetMemoryProperties().memoryHeapCount;
+	uint32_t frameColumn = 1 + 4 * heapCount + 2 * static_cast<uint32_t>(SlvnMemoryCategory::cFrame);
+	ASSERT_EQ(columns.size(), 1 + 4 * heapCount + 2 * static_cast<uint32_t>(SlvnMemoryCategory::cCount));
+	EXPECT_EQ(header.rfind("frame,", 0), 0);
+	EXPECT_EQ(columns[0], "7");
+	EXPECT_EQ(columns[1 + 4 * heap + 2], std::to_string(after.mAllocated.mCurrent));
+	EXPECT_EQ(columns[1 + 4 * heap + 3], std::to_string(after.mAllocated.mPeak));
+	EXPECT_EQ(columns[frameColumn], std::to_string(smallBytes));
+	EXPECT_EQ(columns[frameColumn + 1], std::to_string(smallBytes + largeBytes));
+
+	smallBuffer.Deinitialize(&device->mLogicalDevice);
+	allocator.Deinitialize();
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_DEFRAGMENTER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 1024);
+	SlvnDevice* device = context.mDeviceManager.GetPrimaryDevice();
+
+	// Blocks of five buffers each, on an allocator and deletion queue of their own.
+	const VkDeviceSize blockSize = 1024 * 1024;
+	const uint32_t bufferSize = 192 * 1024;
+	SlvnMemoryAllocator allocator;
+	SlvnResult result = allocator.Initialize(device->mLogicalDevice, device->mPhysicalDevice, blockSize);
+	SLVN_ASSERT_RESULT(result);
+	SlvnDeletionQueue deletionQueue;
+	result = deletionQueue.Initialize(device->mLogicalDevice, &allocator);
+	SLVN_ASSERT_RESULT(result);
+	SlvnDefragmenter defragmenter;
+	result = defragmenter.Initialize(device->mLogicalDevice, &allocator, &deletionQueue);
+	SLVN_ASSERT_RESULT(result);
+	defragmenter.mMaxSourceUtilization = 0.5f;
+
+	std::vector<SlvnBuffer> buffers;
+	buffers.reserve(10);
+	for (uint32_t i = 0; i < 10; i++)
+	{
+		buffers.emplace_back(&device->mLogicalDevice, bufferSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_SHARING_MODE_EXCLUSIVE);
+		result = buffers.back().Allocate(&allocator, SlvnMemoryUsage::cCpuToGpu);
+		SLVN_ASSERT_RESULT(result);
+		defragmenter.Register(&buffers.back());
+	}
+	uint32_t first = buffers[0].GetAllocation().mBlock;
+	uint32_t second = buffers[5].GetAllocation().mBlock;
+	ASSERT_NE(first, second);
+	for (uint32_t i = 0; i < 5; i++)
+	{
+		EXPECT_EQ(buffers[i].GetAllocation().mBlock, first);
+		EXPECT_EQ(buffers[i + 5].GetAllocation().mBlock, second);
+	}
+
+	SlvnCommandPool cmdPool;
+	result = cmdPool.Initialize(device->mLogicalDevice, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, device->GetViableQueueFamilyIndex());
+	SLVN_ASSERT_RESULT(result);
+	VkCommandBufferAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	allocateInfo.commandPool = cmdPool.mVkCmdPool;
+	allocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocateInfo.commandBufferCount = 1;
+	VkCommandBuffer cmdBuffer;
+	ASSERT_EQ(vkAllocateCommandBuffers(device->mLogicalDevice, &allocateInfo, &cmdBuffer), VK_SUCCESS);
+	VkCommandBufferBeginInfo beginInfo = {};
+	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	ASSERT_EQ(vkBeginCommandBuffer(cmdBuffer, &beginInfo), VK_SUCCESS);
+
+	// Both blocks are too full to be worth draining.
+	EXPECT_EQ(defragmenter.Step(cmdBuffer, 1), 0);
+
+	// The second block is nearly empty, but the first has no room for what is left in it.
+	for (uint32_t i = 6; i < 10; i++)
+	{
+		defragmenter.Unregister(&buffers[i]);
+		buffers[i].Deinitialize(&device->mLogicalDevice);
+	}
+	EXPECT_EQ(defragmenter.Step(cmdBuffer, 1), 0);
+
+	// With room in the first block the second one is drained, though only while its buffer may move.
+	defragmenter.Unregister(&buffers[4]);
+	buffers[4].Deinitialize(&device->mLogicalDevice);
+	bool movable = false;
+	defragmenter.Unregister(&buffers[5]);
+	defragmenter.Register(&buffers[5], [&movable] { return movable; });
+	EXPECT_EQ(defragmenter.Step(cmdBuffer, 1), 0);
+
+	std::memset(buffers[5].GetAllocation().mMapped, 0x3c, bufferSize);
+	movable = true;
+	EXPECT_EQ(defragmenter.Step(cmdBuffer, 1), 1);
+	EXPECT_EQ(buffers[5].GetAllocation().mBlock, first);
+	EXPECT_EQ(defragmenter.GetStats().mMoveCount, 1);
+	EXPECT_EQ(defragmenter.GetStats().mBytesMoved, buffers[5].GetAllocation().mSize);
+	EXPECT_EQ(defragmenter.GetStats().mTotalMoveCount, 1);
+	// Nothing movable is left in the drained block.
+	EXPECT_EQ(defragmenter.Step(cmdBuffer, 1), 0);
+	EXPECT_EQ(defragmenter.GetStats().mTotalMoveCount, 1);
+
+	// Once the copy has run and the old buffer is retired, the drained block is released.
+	ASSERT_EQ(vkEndCommandBuffer(cmdBuffer), VK_SUCCESS);
+	VkQueue queue;
+	result = device->GetDeviceQueue(queue, 0);
+	SLVN_ASSERT_RESULT(result);
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &cmdBuffer;
+	ASSERT_EQ(vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE), VK_SUCCESS);
+	ASSERT_EQ(vkQueueWaitIdle(queue), VK_SUCCESS);
+	deletionQueue.Collect(1);
+	EXPECT_EQ(allocator.GetBlockInfos().size(), 1);
+	const uint8_t* moved = static_cast<const uint8_t*>(buffers[5].GetAllocation().mMapped);
+	EXPECT_TRUE(std::all_of(moved, moved + bufferSize, [](uint8_t value) { return value == 0x3c; }));
+
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		if (i == 4)
+			continue;
+		defragmenter.Unregister(&buffers[i]);
+		buffers[i].Deinitialize(&device->mLogicalDevice);
+	}
+	defragmenter.Deinitialize();
+	deletionQueue.Deinitialize();
+	vkFreeCommandBuffers(device->mLogicalDevice, cmdPool.mVkCmdPool, 1, &cmdBuffer);
+	cmdPool.Deinitialize(device->mLogicalDevice);
+	allocator.Deinitialize();
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_VERTEX_FORMAT, 001)
+{
+	EXPECT_EQ(SlvnGetVertexStride(SlvnVertexFormat::cFloat), sizeof(SlvnVertex));
+	EXPECT_EQ(SlvnGetVertexStride(SlvnVertexFormat::cCompact), 20);
+
+	const glm::vec3 normals[] = { glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+		glm::normalize(glm::vec3(1.0f, -2.0f, 3.0f)), glm::normalize(glm::vec3(-0.3f, 0.9f, -0.1f)) };
+	for (auto& normal : normals)
+	{
+		glm::vec3 decoded = SlvnDecodeOctahedral(SlvnEncodeOctahedral(normal));
+		EXPECT_GT(glm::dot(normal, decoded), 0.9999f);
+	}
+}
+TEST(SLVN_TECH_UT_VERTEX_FORMAT, 002)
+{
+	EXPECT_EQ(SlvnGetVertexStride(SlvnVertexFormat::cQuantized), 12);
+
+	std::vector<SlvnVertex> vertices = { SlvnVertex(glm::vec3(-2.0f, 1.0f, 5.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
+		SlvnVertex(glm::vec3(3.0f, 1.0f, 7.0f), glm::vec3(1.0f, 0.0f, 0.0f)), SlvnVertex(glm::vec3(0.5f, 1.0f, 6.0f), glm::vec3(0.0f, 0.0f, 1.0f)) };
+	std::vector<uint8_t> data;
+	SlvnVertexQuantization quantization;
+	SlvnEncodeVertices(SlvnVertexFormat::cQuantized, vertices, data, &quantization);
+	ASSERT_EQ(data.size(), vertices.size() * 12);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		// Decoded the way the pulling shader does it.
+		uint32_t words[3];
+		std::memcpy(words, data.data() + i * 12, sizeof(words));
+		glm::vec3 unorm((words[0] & 0xffff) / 65535.0f, (words[0] >> 16) / 65535.0f, (words[1] & 0xffff) / 65535.0f);
+		glm::vec3 position = quantization.mOffset + unorm * quantization.mScale;
+		EXPECT_NEAR(glm::length(position - vertices[i].mPosition), 0.0f, 1e-4f);
+		EXPECT_GT(glm::dot(SlvnDecodeOctahedral(words[2]), vertices[i].mNormal), 0.9999f);
+	}
+}
+TEST(SLVN_TECH_UT_OBJ_PARSER, 001)
+{
+	const std::string obj =
+		"# quad and a relative triangle\n"
+		"v 0 0 0\nv 1 0 0\r\nv 1 1 0\nv 0 1 0\n"
+		"vn 0 0 1\nvt 0 0\n"
+		"f 1/1/1 2/1/1 3/1/1 4/1/1\n"
+		"f -4 -3 -2\n";
+
+	SlvnObjParser parser;
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	EXPECT_EQ(parser.Parse(obj.data(), obj.size(), vertices, indices), SlvnResult::cOk);
+	ASSERT_EQ(vertices.size(), 7);
+	ASSERT_EQ(indices.size(), 9);
+	EXPECT_EQ(parser.GetStats().mTriangleCount, 3);
+	EXPECT_EQ(indices[3], 0);
+	EXPECT_EQ(indices[5], 3);
+	EXPECT_FLOAT_EQ(vertices[2].mPosition.y, 1.0f);
+	EXPECT_FLOAT_EQ(vertices[0].mNormal.z, 1.0f);
+	// No normals given, the face normal is used.
+	EXPECT_FLOAT_EQ(std::abs(vertices[4].mNormal.z), 1.0f);
+
+	const std::string broken = "v 0 0 0\nf 1 2 3\n";
+	EXPECT_NE(parser.Parse(broken.data(), broken.size(), vertices, indices), SlvnResult::cOk);
+}
+TEST(SLVN_TECH_UT_OBJ_PARSER, 002)
+{
+	// Large enough for several chunks, relative indices reach back across chunk borders.
+	std::string obj;
+	for (uint32_t i = 0; obj.size() < 4 * SlvnObjParser::cMinChunkSize; i++)
+	{
+		std::string x = std::to_string(i);
+		obj += "v " + x + " 0 0\nv " + x + " 1 0\nv " + x + " 1 1\nvn 0 0 1\nf -3//-1 -2//-1 -1//-1\nf " +
+			std::to_string(i * 3 + 1) + " " + std::to_string(i * 3 + 2) + " " + std::to_string(i * 3 + 3) + "\n";
+	}
+
+	SlvnThreadpool threadpool;
+	threadpool.SetThreadCount(4);
+	SlvnObjParser parser;
+	std::vector<SlvnVertex> vertices, chunkedVertices;
+	std::vector<uint32_t> indices, chunkedIndices;
+	EXPECT_EQ(parser.Parse(obj.data(), obj.size(), vertices, indices), SlvnResult::cOk);
+	EXPECT_EQ(parser.Parse(obj.data(), obj.size(), chunkedVertices, chunkedIndices, &threadpool), SlvnResult::cOk);
+	ASSERT_EQ(vertices.size(), chunkedVertices.size());
+	EXPECT_EQ(indices, chunkedIndices);
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		EXPECT_EQ(vertices[i].mPosition, chunkedVertices[i].mPosition);
+		EXPECT_EQ(vertices[i].mNormal, chunkedVertices[i].mNormal);
+	}
+}
+TEST(SLVN_TECH_UT_VERTEX_WELD, 001)
+{
+	// Quad as two triangles with a vertex per corner, the shared edge welds.
+	const std::string obj = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nvn 0 0 1\nf 1//1 2//1 3//1\nf 1//1 3//1 4//1\n";
+	SlvnObjParser parser;
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	EXPECT_EQ(parser.Parse(obj.data(), obj.size(), vertices, indices), SlvnResult::cOk);
+	std::vector<SlvnVertex> corners = vertices;
+	std::vector<uint32_t> cornerIndices = indices;
+
+	SlvnVertexWelder welder;
+	EXPECT_EQ(welder.Weld(vertices, indices), SlvnResult::cOk);
+	ASSERT_EQ(vertices.size(), 4);
+	ASSERT_EQ(indices.size(), 6);
+	EXPECT_FLOAT_EQ(welder.GetStats().GetRatio(), 1.5f);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		EXPECT_EQ(vertices[indices[i]].mPosition, corners[cornerIndices[i]].mPosition);
+	}
+
+	indices.push_back(4);
+	EXPECT_NE(welder.Weld(vertices, indices), SlvnResult::cOk);
+}
+TEST(SLVN_TECH_UT_MESH_CACHE, 001)
+{
+	std::vector<SlvnVertex> vertices = { SlvnVertex(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
+		SlvnVertex(glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)), SlvnVertex(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)) };
+	std::vector<uint32_t> indices = { 0, 1, 2 };
+	const std::string source = "v 0 0 0";
+	uint64_t hash = SlvnHashBytes(source.data(), source.size());
+	EXPECT_NE(hash, SlvnHashBytes(source.data(), source.size() - 1));
+
+	std::string path = (std::filesystem::temp_directory_path() / "slvn_unittest.slvnmesh").string();
+	SlvnMeshCache cache;
+	ASSERT_EQ(cache.Write(path, hash, source.size(), vertices, indices), SlvnResult::cOk);
+
+	// Reads append like the parser, indices are moved past the vertices already there.
+	std::vector<SlvnVertex> loadedVertices(1);
+	std::vector<uint32_t> loadedIndices;
+	EXPECT_EQ(cache.Read(path, hash, source.size(), loadedVertices, loadedIndices), SlvnResult::cOk);
+	ASSERT_EQ(loadedVertices.size(), 4);
+	EXPECT_EQ(loadedIndices, std::vector<uint32_t>({ 1, 2, 3 }));
+	EXPECT_FLOAT_EQ(loadedVertices[3].mPosition.y, 2.0f);
+	EXPECT_FLOAT_EQ(cache.GetBounds().mMax.y, 2.0f);
+	ASSERT_EQ(cache.GetSubmeshes().size(), 1);
+	EXPECT_EQ(cache.GetSubmeshes()[0].mIndexCount, 3);
+
+	// A changed source makes the cache stale.
+	EXPECT_NE(cache.Read(path, hash + 1, source.size(), loadedVertices, loadedIndices), SlvnResult::cOk);
+	std::filesystem::remove(path);
+	EXPECT_EQ(cache.Read(path, hash, source.size(), loadedVertices, loadedIndices), SlvnResult::cInvalidPath);
+}
+TEST(SLVN_TECH_UT_MESH_OPTIMIZER, 001)
+{
+	// Two triangles sharing an edge miss four vertices.
+	SlvnVertexCacheStats stats = SlvnAnalyzeVertexCache({ 0, 1, 2, 2, 1, 3 }, 4, 16);
+	EXPECT_FLOAT_EQ(stats.mAcmr, 2.0f);
+	EXPECT_FLOAT_EQ(stats.mAtvr, 1.0f);
+
+	// A grid with its rows in reverse order, every triangle has to survive the reordering.
+	const uint32_t size = 32;
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		for (uint32_t x = 0; x <= size; x++)
+		{
+			vertices.push_back(SlvnVertex(glm::vec3(x, y, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	}
+	for (uint32_t y = size; y-- > 0;)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			uint32_t a = y * (size + 1) + x;
+			indices.insert(indices.end(), { a, a + 1, a + size + 1, a + 1, a + size + 2, a + size + 1 });
+		}
+	}
+	float area = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		area += glm::cross(vertices[indices[i + 1]].mPosition - vertices[indices[i]].mPosition, vertices[indices[i + 2]].mPosition - vertices[indices[i]].mPosition).z;
+	}
+
+	SlvnMeshOptimizer optimizer;
+	EXPECT_EQ(optimizer.Optimize(vertices, indices), SlvnResult::cOk);
+	ASSERT_EQ(indices.size(), size * size * 6);
+	EXPECT_EQ(vertices.size(), (size + 1) * (size + 1));
+	EXPECT_LT(optimizer.GetStats().mAfter.mAcmr, optimizer.GetStats().mBefore.mAcmr);
+	// Vertices are numbered in order of first use.
+	EXPECT_EQ(indices[0], 0);
+	float optimizedArea = 0.0f;
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		optimizedArea += glm::cross(vertices[indices[i + 1]].mPosition - vertices[indices[i]].mPosition, vertices[indices[i + 2]].mPosition - vertices[indices[i]].mPosition).z;
+	}
+	EXPECT_FLOAT_EQ(optimizedArea, area);
+}
+TEST(SLVN_TECH_UT_SIMPLIFIER, 001)
+{
+	// Flat grid split by a normal seam down the middle, the right half has its own seam vertices.
+	const uint32_t size = 32;
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		for (uint32_t x = 0; x <= size; x++)
+		{
+			vertices.push_back(SlvnVertex(glm::vec3(x, y, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	}
+	std::vector<uint32_t> seam(size + 1);
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		seam[y] = static_cast<uint32_t>(vertices.size());
+		vertices.push_back(SlvnVertex(glm::vec3(size / 2, y, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+	auto vertex = [&](uint32_t x, uint32_t y, bool right) { return right && x == size / 2 ? seam[y] : y * (size + 1) + x; };
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			bool right = x >= size / 2;
+			indices.insert(indices.end(), { vertex(x, y, right), vertex(x + 1, y, right), vertex(x, y + 1, right),
+				vertex(x + 1, y, right), vertex(x + 1, y + 1, right), vertex(x, y + 1, right) });
+		}
+	}
+
+	SlvnMeshSimplifier simplifier;
+	std::vector<uint32_t> result;
+	float error = 1.0f;
+	EXPECT_EQ(simplifier.Simplify(vertices, indices, 0, 0.01f, result, error), SlvnResult::cOk);
+	EXPECT_LT(result.size(), indices.size() / 4);
+	EXPECT_LE(error, 0.01f);
+	// Collapses inside a plane that flip nothing keep the area, and the seam and border stay.
+	float area = 0.0f;
+	std::vector<uint8_t> used(vertices.size(), 0);
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		area += glm::cross(vertices[result[i + 1]].mPosition - vertices[result[i]].mPosition, vertices[result[i + 2]].mPosition - vertices[result[i]].mPosition).z;
+		used[result[i]] = used[result[i + 1]] = used[result[i + 2]] = 1;
+	}
+	EXPECT_NEAR(area, 2.0f * size * size, 0.01f);
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		EXPECT_TRUE(used[vertex(size / 2, y, false)] && used[vertex(size / 2, y, true)]);
+		EXPECT_TRUE(used[vertex(0, y, false)] && used[vertex(size, y, true)]);
+	}
+
+	// A curved surface stops coarsening at the error bound.
+	for (auto& v : vertices)
+	{
+		v.mPosition.z = 4.0f * std::sin(v.mPosition.x * 0.3f) * std::cos(v.mPosition.y * 0.3f);
+	}
+	SlvnLodMesh mesh;
+	std::vector<uint32_t> chain(indices);
+	EXPECT_EQ(SlvnMeshSimplifier::BuildLodChain(vertices, chain, { 1.0f, 0.5f, 0.25f, 0.01f }, 0.05f, mesh), SlvnResult::cOk);
+	ASSERT_GE(mesh.mLevels.size(), 2);
+	EXPECT_LT(mesh.mLevels.size(), 4);
+	for (uint32_t level = 1; level < mesh.mLevels.size(); level++)
+	{
+		EXPECT_LT(mesh.mLevels[level].mIndexCount, mesh.mLevels[level - 1].mIndexCount);
+		EXPECT_GE(mesh.mLevels[level].mError, mesh.mLevels[level - 1].mError);
+		EXPECT_LE(mesh.mLevels[level].mError, 0.05f);
+	}
+	EXPECT_EQ(chain.size(), mesh.mLevels.back().mFirstIndex + mesh.mLevels.back().mIndexCount);
+}
+
+TEST(SLVN_TECH_UT_MESHLET, 001)
+{
+	// Counter clockwise grid facing +z.
+	const uint32_t size = 24;
+	std::vector<SlvnVertex> vertices;
+	std::vector<uint32_t> indices;
+	for (uint32_t y = 0; y <= size; y++)
+	{
+		for (uint32_t x = 0; x <= size; x++)
+		{
+			vertices.push_back(SlvnVertex(glm::vec3(x, y, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f)));
+		}
+	}
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			uint32_t a = y * (size + 1) + x;
+			indices.insert(indices.end(), { a, a + 1, a + size + 1, a + 1, a + size + 2, a + size + 1 });
+		}
+	}
+	std::vector<uint32_t> sorted(indices);
+	std::sort(sorted.begin(), sorted.end());
+
+	SlvnMeshletBuilder builder;
+	std::vector<SlvnMeshlet> meshlets;
+	EXPECT_EQ(builder.Build(vertices, indices, 0, static_cast<uint32_t>(indices.size()), meshlets), SlvnResult::cOk);
+	ASSERT_GT(meshlets.size(), 1);
+	uint32_t nextIndex = 0;
+	for (auto& meshlet : meshlets)
+	{
+		EXPECT_EQ(meshlet.mFirstIndex, nextIndex);
+		nextIndex += meshlet.mIndexCount;
+		std::vector<uint32_t> meshletVertices(indices.begin() + meshlet.mFirstIndex, indices.begin() + meshlet.mFirstIndex + meshlet.mIndexCount);
+		std::sort(meshletVertices.begin(), meshletVertices.end());
+		meshletVertices.erase(std::unique(meshletVertices.begin(), meshletVertices.end()), meshletVertices.end());
+		EXPECT_LE(meshletVertices.size(), builder.mMaxVertices);
+		EXPECT_LE(meshlet.mIndexCount / 3, builder.mMaxTriangles);
+		// A flat meshlet has a zero width cone along its normal.
+		EXPECT_NEAR(meshlet.mConeAxis.z, 1.0f, 1e-4f);
+		EXPECT_NEAR(meshlet.mConeCutoff, 0.0f, 1e-3f);
+	}
+	EXPECT_EQ(nextIndex, indices.size());
+	std::vector<uint32_t> reordered(indices);
+	std::sort(reordered.begin(), reordered.end());
+	EXPECT_EQ(reordered, sorted);
+
+	SlvnMeshletCuller culler;
+	culler.SetMeshlets(meshlets);
+	glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 100.0f);
+	glm::vec3 center(size * 0.5f, size * 0.5f, 0.0f);
+	uint32_t meshletCount = static_cast<uint32_t>(meshlets.size());
+
+	// In front, every meshlet is visible and the neighbours merge into one range.
+	std::vector<SlvnIndexRange> ranges;
+	glm::vec3 eye = center + glm::vec3(0.0f, 0.0f, 20.0f);
+	EXPECT_EQ(culler.Cull(0, meshletCount, glm::mat4(1.0f), projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)), eye, ranges), 1);
+	ASSERT_EQ(ranges.size(), 1);
+	EXPECT_EQ(ranges[0].mIndexCount, indices.size());
+
+	// Behind, every meshlet faces away.
+	ranges.clear();
+	eye = center - glm::vec3(0.0f, 0.0f, 20.0f);
+	EXPECT_EQ(culler.Cull(0, meshletCount, glm::mat4(1.0f), projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)), eye, ranges), 0);
+	EXPECT_EQ(culler.GetStats().mBackfaceCulledCount, meshletCount);
+
+	// In front but looking away, every meshlet is outside the frustum, also when moved and scaled.
+	eye = center + glm::vec3(0.0f, 0.0f, 20.0f);
+	glm::mat4 model = glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, -3.0f)), glm::vec3(0.5f));
+	EXPECT_EQ(culler.Cull(0, meshletCount, model, projection * glm::lookAt(eye, eye + glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f)), eye, ranges), 0);
+	EXPECT_EQ(culler.GetStats().mFrustumCulledCount, meshletCount);
+	EXPECT_EQ(culler.GetStats().mTestedCount, 3 * meshletCount);
+}
+
+TEST(SLVN_TECH_UT_MESH_STREAMER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 4096);
+
+	// Budget of two meshes.
+	const uint64_t meshBytes = 16 * sizeof(SlvnVertex) + 48 * sizeof(uint32_t);
+	SlvnMeshStreamer streamer;
+	streamer.Initialize(&context.mPool, &context.mUploader, &context.mDeletionQueue, 2 * meshBytes, 3);
+	uint32_t a = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+	uint32_t b = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+	uint32_t c = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+
+	uint64_t frame = 0;
+	auto step = [&](std::vector<uint32_t> meshes)
+	{
+		frame++;
+		context.mDeletionQueue.Collect(frame - 1);
+		streamer.BeginFrame(frame);
+		for (uint32_t mesh : meshes)
+		{
+			streamer.Request(mesh, 1.0f);
+		}
+		streamer.EndFrame();
+		streamer.Wait();
+	};
+
+	// Meshes placed this frame stay even past the budget.
+	step({ a, b, c });
+	step({ a, b });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(b) && streamer.IsResident(c));
+	EXPECT_EQ(streamer.GetStats().mResidentBytes, 3 * meshBytes);
+
+	// The one no longer requested goes first.
+	step({ a, b });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(b));
+	EXPECT_FALSE(streamer.IsResident(c));
+	EXPECT_EQ(streamer.GetStats().mResidentBytes, 2 * meshBytes);
+	EXPECT_EQ(streamer.GetStats().mTotalEvictionCount, 1);
+
+	// Bringing it back evicts the least recently used one.
+	step({ a, c });
+	step({ a, c });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(c));
+	EXPECT_FALSE(streamer.IsResident(b));
+	EXPECT_EQ(streamer.GetStats().mResidentBytes, 2 * meshBytes);
+	EXPECT_EQ(streamer.GetStats().mTotalEvictionCount, 2);
+
+	streamer.Deinitialize(frame);
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_MESH_STREAMER, 002)
+{
+	SlvnGeometryTestContext context;
+	// Room for two meshes, the budget is never the limit.
+	context.Initialize(32, 96);
+
+	SlvnMeshStreamer streamer;
+	streamer.Initialize(&context.mPool, &context.mUploader, &context.mDeletionQueue, UINT64_MAX, 2);
+	uint32_t a = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+	uint32_t b = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+	uint32_t c = streamer.AddMesh(makeTestMeshLoader(16), SlvnGeometryPool::cInvalidMesh);
+
+	uint64_t frame = 0;
+	auto step = [&](std::vector<uint32_t> meshes)
+	{
+		frame++;
+		context.mDeletionQueue.Collect(frame - 1);
+		streamer.BeginFrame(frame);
+		for (uint32_t mesh : meshes)
+		{
+			streamer.Request(mesh, 1.0f);
+		}
+		streamer.EndFrame();
+		streamer.Wait();
+	};
+
+	step({ a, b });
+	step({ a, b });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(b));
+
+	// A mesh that does not fit never evicts the ones drawn last frame.
+	step({ a, b, c });
+	step({ a, b, c });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(b));
+	EXPECT_FALSE(streamer.IsResident(c));
+	EXPECT_EQ(streamer.GetStats().mTotalEvictionCount, 0);
+
+	// Once one of them is off screen only that one is evicted, its ranges come back a frame later.
+	step({ a, c });
+	step({ a, c });
+	EXPECT_TRUE(streamer.IsResident(a));
+	EXPECT_FALSE(streamer.IsResident(b) || streamer.IsResident(c));
+	EXPECT_EQ(streamer.GetStats().mTotalEvictionCount, 1);
+	step({ a, c });
+	EXPECT_TRUE(streamer.IsResident(a) && streamer.IsResident(c));
+	EXPECT_EQ(streamer.GetStats().mTotalEvictionCount, 1);
+
+	streamer.Deinitialize(frame);
+	context.Deinitialize();
+}
+TEST(SLVN_TECH_UT_ASSET_PIPELINE, 001)
+{
+	// Failing and shutting down never reach the pool or the uploader.
+	SlvnAssetPipeline pipeline;
+	pipeline.Initialize(nullptr, nullptr, nullptr, SlvnVertexFormat::cFloat, 1, UINT64_MAX);
+
+	std::string missing = (std::filesystem::temp_directory_path() / "slvn_unittest_missing.obj").string();
+	std::filesystem::remove(missing);
+	uint32_t callbackCount = 0;
+	SlvnResult callbackResult = SlvnResult::cOk;
+	SlvnAssetHandle failed = pipeline.Load(missing, [&](SlvnAssetHandle, SlvnResult result, SlvnMeshAsset&)
+		{
+			callbackCount++;
+			callbackResult = result;
+		});
+	std::shared_future<SlvnResult> failedFuture = pipeline.GetFuture(failed);
+
+	uint64_t frame = 0;
+	ASSERT_TRUE(stepAssetFrames(pipeline, frame, [&] { return pipeline.GetState(failed) == SlvnAssetState::cFailed; }));
+	EXPECT_EQ(callbackCount, 1);
+	EXPECT_NE(callbackResult, SlvnResult::cOk);
+	ASSERT_EQ(failedFuture.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	EXPECT_EQ(failedFuture.get(), callbackResult);
+	EXPECT_EQ(pipeline.GetMesh(failed), SlvnGeometryPool::cInvalidMesh);
+	EXPECT_EQ(pipeline.GetStats().mFailedCount, 1);
+
+	// Shutting down before the asset is placed resolves its future with an error.
+	std::string path = writeTestObj("slvn_unittest_pipeline.obj");
+	SlvnAssetHandle pending = pipeline.Load(path);
+	std::shared_future<SlvnResult> pendingFuture = pipeline.GetFuture(pending);
+	pipeline.Deinitialize(frame);
+	ASSERT_EQ(pendingFuture.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+	EXPECT_EQ(pendingFuture.get(), SlvnResult::cUnexpectedError);
+	EXPECT_EQ(failedFuture.get(), callbackResult);
+	removeTestObj(path);
+}
+TEST(SLVN_TECH_UT_ASSET_PIPELINE, 002)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 4096);
+	std::string first = writeTestObj("slvn_unittest_pipeline_a.obj");
+	std::string second = writeTestObj("slvn_unittest_pipeline_b.obj");
+
+	// A budget smaller than any mesh uploads one per frame.
+	SlvnAssetPipeline pipeline;
+	pipeline.Initialize(&context.mPool, &context.mUploader, &context.mDeletionQueue, SlvnVertexFormat::cFloat, 2, 1);
+	uint32_t readyCount = 0;
+	auto callback = [&](SlvnAssetHandle, SlvnResult result, SlvnMeshAsset& asset)
+	{
+		EXPECT_EQ(result, SlvnResult::cOk);
+		EXPECT_FALSE(asset.mIndices.empty());
+		readyCount++;
+	};
+	SlvnAssetHandle a = pipeline.Load(first, callback);
+	SlvnAssetHandle b = pipeline.Load(second, callback);
+
+	// Nothing is placed before BeginFrame(), so both wait in the upload stage.
+	for (uint32_t attempt = 0; attempt < 5000 && pipeline.GetStats().mUpload.mDepth < 2; attempt++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	ASSERT_EQ(pipeline.GetStats().mUpload.mDepth, 2);
+
+	// The host visible pool completes its batches right away.
+	pipeline.BeginFrame(1);
+	EXPECT_EQ(pipeline.GetStats().mUploadedCount, 1);
+	EXPECT_EQ(readyCount, 1);
+	EXPECT_NE(pipeline.IsReady(a), pipeline.IsReady(b));
+	pipeline.BeginFrame(2);
+	EXPECT_EQ(pipeline.GetStats().mUploadedCount, 1);
+	EXPECT_EQ(readyCount, 2);
+	EXPECT_TRUE(pipeline.IsReady(a) && pipeline.IsReady(b));
+	EXPECT_NE(pipeline.GetMesh(a), pipeline.GetMesh(b));
+	EXPECT_EQ(pipeline.GetFuture(a).get(), SlvnResult::cOk);
+	EXPECT_EQ(pipeline.GetStats().mReadyCount, 2);
+
+	// Shutting down frees both pool meshes once the frame has completed.
+	pipeline.Deinitialize(2);
+	context.mDeletionQueue.Collect(2);
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 0);
+	context.Deinitialize();
+	removeTestObj(first);
+	removeTestObj(second);
+}
+TEST(SLVN_TECH_UT_ASSET_MANAGER, 001)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 4096);
+	std::string path = writeTestObj("slvn_unittest_manager.obj");
+	std::string otherSpelling = (std::filesystem::temp_directory_path() / "." / "slvn_unittest_manager.obj").string();
+
+	SlvnAssetPipeline pipeline;
+	pipeline.Initialize(&context.mPool, &context.mUploader, &context.mDeletionQueue, SlvnVertexFormat::cFloat, 1, UINT64_MAX);
+	SlvnAssetManager manager;
+	manager.Initialize(&pipeline, &context.mPool, UINT64_MAX);
+
+	uint64_t frame = 0;
+	auto step = [&]()
+	{
+		frame++;
+		context.mDeletionQueue.Collect(frame - 1);
+		pipeline.BeginFrame(frame);
+		manager.BeginFrame();
+	};
+
+	uint32_t callbackCount = 0;
+	auto callback = [&](SlvnAssetHandle, SlvnResult result, const SlvnMeshAsset& asset)
+	{
+		EXPECT_EQ(result, SlvnResult::cOk);
+		EXPECT_FALSE(asset.mIndices.empty());
+		callbackCount++;
+	};
+
+	// Both spellings share one key, the second request joins the load of the first.
+	EXPECT_EQ(SlvnAssetManager::MakeKey(path), SlvnAssetManager::MakeKey(otherSpelling));
+	SlvnAssetHandle first = manager.Acquire(path, callback);
+	SlvnAssetHandle joined = manager.Acquire(otherSpelling, callback);
+	EXPECT_EQ(first, joined);
+	EXPECT_EQ(manager.GetReferenceCount(first), 2);
+	for (uint32_t attempt = 0; attempt < 5000 && !manager.IsReady(first); attempt++)
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		step();
+	}
+	ASSERT_TRUE(manager.IsReady(first));
+	EXPECT_EQ(callbackCount, 2);
+	EXPECT_EQ(manager.GetStats().mMissCount, 1);
+	EXPECT_EQ(manager.GetStats().mJoinCount, 1);
+	EXPECT_EQ(pipeline.GetStats().mRequestCount, 1);
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 1);
+
+	// A ready asset is handed out again without a new pool mesh, its callback runs next frame.
+	uint32_t mesh = manager.GetMesh(first);
+	SlvnAssetHandle hit = manager.Acquire(path, callback);
+	EXPECT_EQ(hit, first);
+	EXPECT_EQ(callbackCount, 2);
+	step();
+	EXPECT_EQ(callbackCount, 3);
+	EXPECT_EQ(manager.GetStats().mHitCount, 1);
+	EXPECT_EQ(manager.GetMesh(hit), mesh);
+	EXPECT_EQ(pipeline.GetStats().mRequestCount, 1);
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 1);
+	EXPECT_EQ(manager.GetReferenceCount(first), 3);
+
+	manager.Deinitialize();
+	pipeline.Deinitialize(frame);
+	context.Deinitialize();
+	removeTestObj(path);
+}
+TEST(SLVN_TECH_UT_ASSET_MANAGER, 002)
+{
+	SlvnGeometryTestContext context;
+	context.Initialize(1024, 4096);
+	std::string pathA = writeTestObj("slvn_unittest_manager_a.obj");
+	std::string pathB = writeTestObj("slvn_unittest_manager_b.obj");
+
+	SlvnAssetPipeline pipeline;
+	pipeline.Initialize(&context.mPool, &context.mUploader, &context.mDeletionQueue, SlvnVertexFormat::cFloat, 1, UINT64_MAX);
+	SlvnAssetManager manager;
+	manager.Initialize(&pipeline, &context.mPool, UINT64_MAX);
+
+	uint64_t frame = 0;
+	auto step = [&]()
+	{
+		frame++;
+		context.mDeletionQueue.Collect(frame - 1);
+		pipeline.BeginFrame(frame);
+		manager.BeginFrame();
+	};
+	auto stepUntilReady = [&](SlvnAssetHandle handle)
+	{
+		for (uint32_t attempt = 0; attempt < 5000 && !manager.IsReady(handle); attempt++)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			step();
+		}
+		return manager.IsReady(handle);
+	};
+
+	SlvnAssetHandle a = manager.Acquire(pathA);
+	SlvnAssetHandle b = manager.Acquire(pathB);
+	ASSERT_TRUE(stepUntilReady(a) && stepUntilReady(b));
+
+	// Released assets stay cached while they fit the budget.
+	manager.Release(a, frame);
+	manager.Release(b, frame + 1);
+	step();
+	EXPECT_TRUE(manager.IsReady(a) && manager.IsReady(b));
+	SlvnAssetCacheStats stats = manager.GetStats();
+	EXPECT_EQ(stats.mCachedCount, 2);
+	EXPECT_EQ(stats.mCachedBytes, stats.mResidentBytes);
+
+	// Past the budget the least recently used one goes, its pool mesh once the frame has completed.
+	manager.mCacheBudgetBytes = stats.mCachedBytes / 2;
+	step();
+	EXPECT_FALSE(manager.IsReady(a));
+	EXPECT_TRUE(manager.IsReady(b));
+	EXPECT_EQ(manager.GetStats().mEvictionCount, 1);
+	EXPECT_EQ(manager.GetStats().mResidentBytes, stats.mResidentBytes / 2);
+	step();
+	step();
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 1);
+
+	// An evicted asset is loaded again on the next request.
+	manager.mCacheBudgetBytes = UINT64_MAX;
+	SlvnAssetHandle reloaded = manager.Acquire(pathA);
+	EXPECT_EQ(reloaded, a);
+	EXPECT_EQ(manager.GetStats().mMissCount, 3);
+	ASSERT_TRUE(stepUntilReady(a));
+	EXPECT_EQ(pipeline.GetStats().mRequestCount, 3);
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 2);
+
+	// Shutting down frees every pool mesh, referenced or cached.
+	manager.Deinitialize();
+	pipeline.Deinitialize(frame);
+	context.mDeletionQueue.Collect(frame);
+	EXPECT_EQ(context.mPool.GetStats().mMeshCount, 0);
+	context.Deinitialize();
+	removeTestObj(pathA);
+	removeTestObj(pathB);
+}
+
 //TEST(SLVN_TECH_UT_GRAPHICS_RENDER_ENGINE, 002)
 //{
 //	const uint8_t engineIdentifier = 1;